@@ -25,6 +25,7 @@
 #include "arch/io/disk/conflict_resolving.hpp"
 #include "arch/io/disk/stats.hpp"
 #include "arch/io/disk/accounting.hpp"
+#include "arch/io/disk/uring.hpp"
 #include "backtrace.hpp"
 #include "config/args.hpp"
 #include "do_on_thread.hpp"
@@ -50,14 +51,39 @@ public:
     linux_disk_manager_t(linux_event_queue_t *queue,
                          int batch_factor,
                          int max_concurrent_io_requests,
+                         file_io_backend_t io_backend,
                          perfmon_collection_t *stats) :
         stack_stats(stats, "stack"),
         conflict_resolver(stats),
         accounter(batch_factor),
         backend_stats(stats, "backend", accounter.producer),
-        backend(queue, backend_stats.producer, max_concurrent_io_requests),
         outstanding_txn(0)
     {
+        std::function<void(pool_diskmgr_t::action_t *)> backend_done_fun
+            = std::bind(&stats_diskmgr_2_t::done, &backend_stats, ph::_1);
+#if USE_IO_URING
+        if (io_backend == file_io_backend_t::io_uring_desired) {
+            if (uring_diskmgr_t::is_supported()) {
+                uring_backend.init(new uring_diskmgr_t(queue, backend_stats.producer,
+                                                       max_concurrent_io_requests));
+                uring_backend->done_fun = backend_done_fun;
+            } else {
+                logWRN("io_uring is not available on this system, falling back to "
+                       "the blocker pool for disk I/O.");
+            }
+        }
+#else
+        if (io_backend == file_io_backend_t::io_uring_desired) {
+            logWRN("io_uring is not supported on this platform, falling back to "
+                   "the blocker pool for disk I/O.");
+        }
+#endif
+        if (!has_uring_backend()) {
+            pool_backend.init(new pool_diskmgr_t(queue, backend_stats.producer,
+                                                 max_concurrent_io_requests));
+            pool_backend->done_fun = backend_done_fun;
+        }
+
         /* Hook up the `submit_fun`s of the parts of the IO stack that are above the
         queue. (The parts below the queue use the `passive_producer_t` interface instead
         of a callback function.) */
@@ -66,8 +92,7 @@ public:
         conflict_resolver.submit_fun = std::bind(&accounting_diskmgr_t::submit,
                                                  &accounter, ph::_1);
 
-        /* Hook up everything's `done_fun`. */
-        backend.done_fun = std::bind(&stats_diskmgr_2_t::done, &backend_stats, ph::_1);
+        /* Hook up everything's `done_fun`. (The backend's was hooked up above.) */
         backend_stats.done_fun = std::bind(&accounting_diskmgr_t::done, &accounter, ph::_1);
         accounter.done_fun = std::bind(&conflict_resolving_diskmgr_t::done,
                                        &conflict_resolver, ph::_1);
@@ -155,6 +180,14 @@ public:
                                a));
     }
 
+    bool has_uring_backend() const {
+#if USE_IO_URING
+        return uring_backend.has();
+#else
+        return false;
+#endif
+    }
+
     void done(stats_diskmgr_t::action_t *a) {
         assert_thread();
         outstanding_txn--;
@@ -187,13 +220,19 @@ private:
     will tell you how many IO operations are queued. The "backend stats" will tell you
     how long the OS takes to perform the operations. Note that it's not perfect, because
     it counts operations that have been queued by the backend but not sent to the OS yet
-    as having been sent to the OS. */
+    as having been sent to the OS.
+
+    The backend is either a `pool_diskmgr_t`, which runs each operation on a blocker
+    thread, or a `uring_diskmgr_t`, which batches them into an io_uring. */
 
     stats_diskmgr_t stack_stats;
     conflict_resolving_diskmgr_t conflict_resolver;
     accounting_diskmgr_t accounter;
     stats_diskmgr_2_t backend_stats;
-    pool_diskmgr_t backend;
+    scoped_ptr_t<pool_diskmgr_t> pool_backend;
+#if USE_IO_URING
+    scoped_ptr_t<uring_diskmgr_t> uring_backend;
+#endif
 
 
     intptr_t outstanding_txn;
@@ -202,11 +241,13 @@ private:
 };
 
 io_backender_t::io_backender_t(file_direct_io_mode_t _direct_io_mode,
-                               int max_concurrent_io_requests)
+                               int max_concurrent_io_requests,
+                               file_io_backend_t io_backend)
     : direct_io_mode(_direct_io_mode),
       diskmgr(new linux_disk_manager_t(&linux_thread_pool_t::get_thread()->queue,
                                        DEFAULT_IO_BATCH_FACTOR,
                                        max_concurrent_io_requests,
+                                       io_backend,
                                        &stats)) { }
 
 io_backender_t::~io_backender_t() { }
@@ -0,0 +1,437 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#include "arch/io/disk/uring.hpp"
+
+#if USE_IO_URING
+
+#include <limits.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#include <algorithm>
+
+#include "arch/io/disk.hpp"
+#include "logger.hpp"
+
+// Older C libraries don't know about the io_uring syscalls.  The numbers are the same
+// on all architectures that we support.
+#ifndef __NR_io_uring_setup
+#define __NR_io_uring_setup 425
+#endif
+#ifndef __NR_io_uring_enter
+#define __NR_io_uring_enter 426
+#endif
+#ifndef __NR_io_uring_register
+#define __NR_io_uring_register 427
+#endif
+
+// The largest submission queue we set up, no matter how many concurrent requests
+// were asked for.  The kernel refuses anything above 32768 entries.
+const int MAX_URING_ENTRIES = 4096;
+
+int sys_io_uring_setup(unsigned int entries, io_uring_params *params) {
+    return syscall(__NR_io_uring_setup, entries, params);
+}
+
+int sys_io_uring_enter(int fd, unsigned int to_submit, unsigned int min_complete,
+                       unsigned int flags) {
+    return syscall(__NR_io_uring_enter, fd, to_submit, min_complete, flags,
+                   nullptr, 0);
+}
+
+int sys_io_uring_register(int fd, unsigned int opcode, const void *arg,
+                          unsigned int nr_args) {
+    return syscall(__NR_io_uring_register, fd, opcode, arg, nr_args);
+}
+
+int uring_queue_depth(int max_concurrent_io_requests) {
+    guarantee(max_concurrent_io_requests > 0);
+    guarantee(max_concurrent_io_requests < MAXIMUM_MAX_CONCURRENT_IO_REQUESTS);
+    // There are no blocker threads to keep busy, so unlike `pool_diskmgr_t` we don't
+    // need to queue up more requests than we allow to run concurrently.
+    return std::min(max_concurrent_io_requests, MAX_URING_ENTRIES);
+}
+
+/* A `request_t` tracks the progress of one action through the ring.  At most one SQE
+is outstanding for any request at a time, which bounds the number of SQEs (and CQEs)
+in flight to `queue_depth`. */
+struct uring_diskmgr_t::request_t {
+    enum step_t { PRE_SYNC, OPERATION, POST_SYNC };
+
+    explicit request_t(action_t *_action)
+        : action(_action),
+          step(_action->wrap_in_datasyncs ? PRE_SYNC : OPERATION),
+          cur_vecs(nullptr),
+          cur_count(0),
+          done_bytes(0) {
+        if (action->type != action_t::ACTION_RESIZE) {
+            // Copy the io vectors because we modify them on partial reads and writes.
+            action->copy_vectors(&vecs);
+            cur_vecs = vecs.data();
+            cur_count = vecs.size();
+        }
+    }
+
+    action_t *action;
+    step_t step;
+    scoped_array_t<iovec> vecs;
+    iovec *cur_vecs;
+    size_t cur_count;
+    int64_t done_bytes;
+};
+
+bool uring_diskmgr_t::is_supported() {
+    io_uring_params params;
+    memset(&params, 0, sizeof(params));
+    scoped_fd_t fd(sys_io_uring_setup(1, &params));
+    if (fd.get() == INVALID_FD) {
+        // Typically ENOSYS on old kernels, or EPERM if io_uring has been disabled
+        // through sysctl or a seccomp filter.
+        return false;
+    }
+    // We rely on eventfd notifications (Linux 5.2).
+    system_event_t event;
+    int notify_fd = event.get_notify_fd();
+    return sys_io_uring_register(fd.get(), IORING_REGISTER_EVENTFD, &notify_fd, 1) == 0;
+}
+
+uring_diskmgr_t::uring_diskmgr_t(linux_event_queue_t *_queue,
+                                 passive_producer_t<action_t *> *_source,
+                                 int max_concurrent_io_requests)
+    : queue(_queue),
+      queue_depth(uring_queue_depth(max_concurrent_io_requests)),
+      source(_source),
+      sq_ring_ptr(MAP_FAILED),
+      cq_ring_ptr(MAP_FAILED),
+      sqes(nullptr),
+      sqes_to_submit(0),
+      n_pending(0),
+      defer_submit(false),
+      fallback_pool(_queue, &fallback_queue, 1) {
+    setup_ring(queue_depth);
+    fallback_pool.done_fun = std::bind(&uring_diskmgr_t::on_fallback_done, this, ph::_1);
+
+    queue->watch_event(&completion_event, this);
+
+    if (source->available->get()) { pump(); }
+    source->available->set_callback(this);
+}
+
+uring_diskmgr_t::~uring_diskmgr_t() {
+    assert_thread();
+    source->available->unset_callback();
+    rassert(n_pending == 0);
+    queue->forget_event(&completion_event, this);
+
+    // Closing the ring fd before unmapping is fine, the mappings hold their own
+    // reference to the ring.
+    ring_fd.reset();
+    munmap(sqes, sqes_size);
+    if (cq_ring_ptr != sq_ring_ptr) {
+        munmap(cq_ring_ptr, cq_ring_size);
+    }
+    munmap(sq_ring_ptr, sq_ring_size);
+}
+
+void uring_diskmgr_t::setup_ring(int entries) {
+    io_uring_params params;
+    memset(&params, 0, sizeof(params));
+    ring_fd.reset(sys_io_uring_setup(entries, &params));
+    guarantee_err(ring_fd.get() != INVALID_FD, "Could not set up io_uring");
+
+    sq_entries = params.sq_entries;
+    cq_entries = params.cq_entries;
+    guarantee(static_cast<int>(sq_entries) >= queue_depth);
+    guarantee(cq_entries >= sq_entries);
+
+    sq_ring_size = params.sq_off.array + params.sq_entries * sizeof(unsigned int);
+    cq_ring_size = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+    const bool single_mmap = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+    if (single_mmap) {
+        sq_ring_size = std::max(sq_ring_size, cq_ring_size);
+        cq_ring_size = sq_ring_size;
+    }
+
+    sq_ring_ptr = mmap(nullptr, sq_ring_size, PROT_READ | PROT_WRITE,
+                       MAP_SHARED | MAP_POPULATE, ring_fd.get(), IORING_OFF_SQ_RING);
+    guarantee_err(sq_ring_ptr != MAP_FAILED, "Could not map io_uring submission queue");
+    if (single_mmap) {
+        cq_ring_ptr = sq_ring_ptr;
+    } else {
+        cq_ring_ptr = mmap(nullptr, cq_ring_size, PROT_READ | PROT_WRITE,
+                           MAP_SHARED | MAP_POPULATE, ring_fd.get(), IORING_OFF_CQ_RING);
+        guarantee_err(cq_ring_ptr != MAP_FAILED,
+                      "Could not map io_uring completion queue");
+    }
+
+    sqes_size = params.sq_entries * sizeof(io_uring_sqe);
+    void *sqes_ptr = mmap(nullptr, sqes_size, PROT_READ | PROT_WRITE,
+                          MAP_SHARED | MAP_POPULATE, ring_fd.get(), IORING_OFF_SQES);
+    guarantee_err(sqes_ptr != MAP_FAILED, "Could not map io_uring submission entries");
+    sqes = static_cast<io_uring_sqe *>(sqes_ptr);
+
+    char *sq = static_cast<char *>(sq_ring_ptr);
+    sq_head = reinterpret_cast<unsigned int *>(sq + params.sq_off.head);
+    sq_tail = reinterpret_cast<unsigned int *>(sq + params.sq_off.tail);
+    sq_ring_mask = reinterpret_cast<unsigned int *>(sq + params.sq_off.ring_mask);
+    sq_array = reinterpret_cast<unsigned int *>(sq + params.sq_off.array);
+
+    char *cq = static_cast<char *>(cq_ring_ptr);
+    cq_head = reinterpret_cast<unsigned int *>(cq + params.cq_off.head);
+    cq_tail = reinterpret_cast<unsigned int *>(cq + params.cq_off.tail);
+    cq_ring_mask = reinterpret_cast<unsigned int *>(cq + params.cq_off.ring_mask);
+    cqes = reinterpret_cast<io_uring_cqe *>(cq + params.cq_off.cqes);
+
+    int notify_fd = completion_event.get_notify_fd();
+    int res = sys_io_uring_register(ring_fd.get(), IORING_REGISTER_EVENTFD,
+                                    &notify_fd, 1);
+    guarantee_err(res == 0, "Could not register eventfd with io_uring");
+}
+
+io_uring_sqe *uring_diskmgr_t::get_sqe() {
+    // We are the only one who ever advances the tail, and the kernel consumes all
+    // submitted entries in `io_uring_enter`, so this can only fail if we have more
+    // than `sq_entries` requests in flight, which `queue_depth` prevents.
+    const unsigned int head = __atomic_load_n(sq_head, __ATOMIC_ACQUIRE);
+    const unsigned int tail = *sq_tail;
+    guarantee(tail - head < sq_entries, "io_uring submission queue overflow");
+
+    const unsigned int index = tail & *sq_ring_mask;
+    io_uring_sqe *sqe = &sqes[index];
+    memset(sqe, 0, sizeof(*sqe));
+    sq_array[index] = index;
+    __atomic_store_n(sq_tail, tail + 1, __ATOMIC_RELEASE);
+    ++sqes_to_submit;
+    return sqe;
+}
+
+void uring_diskmgr_t::submit_pending() {
+    while (sqes_to_submit > 0) {
+        int res = sys_io_uring_enter(ring_fd.get(), sqes_to_submit, 0, 0);
+        if (res == -1) {
+            guarantee_err(get_errno() == EINTR || get_errno() == EAGAIN,
+                          "io_uring_enter failed");
+            continue;
+        }
+        guarantee(static_cast<unsigned int>(res) <= sqes_to_submit);
+        sqes_to_submit -= res;
+    }
+}
+
+void uring_diskmgr_t::advance(request_t *req) {
+    action_t *a = req->action;
+    if (req->step == request_t::OPERATION
+        && a->type == action_t::ACTION_RESIZE
+        && a->size_change == 0) {
+        // Nothing to do, skip right to the trailing datasync.
+        a->io_result = 0;
+        if (!a->wrap_in_datasyncs) {
+            finish(req);
+            return;
+        }
+        req->step = request_t::POST_SYNC;
+    }
+
+    io_uring_sqe *sqe = get_sqe();
+    sqe->fd = a->fd;
+    sqe->user_data = reinterpret_cast<uintptr_t>(req);
+
+    switch (req->step) {
+    case request_t::PRE_SYNC:
+    case request_t::POST_SYNC:
+        sqe->opcode = IORING_OP_FSYNC;
+        sqe->fsync_flags = IORING_FSYNC_DATASYNC;
+        break;
+    case request_t::OPERATION:
+        switch (a->type) {
+        case action_t::ACTION_READ:
+        case action_t::ACTION_WRITE:
+            sqe->opcode = a->type == action_t::ACTION_READ
+                ? IORING_OP_READV
+                : IORING_OP_WRITEV;
+            sqe->addr = reinterpret_cast<uintptr_t>(req->cur_vecs);
+            sqe->len = std::min<size_t>(req->cur_count, IOV_MAX);
+            sqe->off = a->offset + req->done_bytes;
+            break;
+        case action_t::ACTION_RESIZE:
+            // `fallocate` with a mode of 0 extends the file size, just like the
+            // `ftruncate` done by `pool_diskmgr_t`, but also reserves the space.
+            rassert(a->size_change > 0);
+            sqe->opcode = IORING_OP_FALLOCATE;
+            sqe->off = a->offset - a->size_change;
+            sqe->addr = a->size_change;
+            sqe->len = 0;
+            break;
+        default:
+            unreachable("Unknown I/O action");
+        }
+        break;
+    default:
+        unreachable();
+    }
+
+    if (!defer_submit) {
+        submit_pending();
+    }
+}
+
+void uring_diskmgr_t::handle_completion(request_t *req, int32_t res) {
+    action_t *a = req->action;
+
+    if (res == -EINTR || res == -EAGAIN) {
+        advance(req);
+        return;
+    }
+
+    switch (req->step) {
+    case request_t::PRE_SYNC:
+        if (res < 0) {
+            a->io_result = res;
+            finish(req);
+            return;
+        }
+        req->step = request_t::OPERATION;
+        advance(req);
+        return;
+    case request_t::OPERATION:
+        if (a->type == action_t::ACTION_RESIZE) {
+            if (res == -EOPNOTSUPP || res == -EINVAL) {
+                // Either the kernel is too old for `IORING_OP_FALLOCATE`, or the file
+                // system doesn't support `fallocate`.  Let the pool `ftruncate` it.
+                delete req;
+                fallback_queue.push(a);
+                return;
+            }
+            if (res < 0) {
+                a->io_result = res;
+                finish(req);
+                return;
+            }
+            a->io_result = 0;
+        } else {
+            const int64_t total_bytes = a->get_count();
+            if (res < 0) {
+                a->io_result = res;
+                finish(req);
+                return;
+            } else if (res == 0 && a->type == action_t::ACTION_WRITE) {
+                // See the comment in `pool_diskmgr_t::action_t::perform_read_write`.
+                logERR("Failed I/O: vectored write of %" PRIi64 " bytes stopped after "
+                       "%" PRIi64 " bytes. Assuming we ran out of disk space.",
+                       total_bytes, req->done_bytes);
+                a->io_result = -ENOSPC;
+                finish(req);
+                return;
+            } else if (res == 0) {
+                logERR("Failed I/O: we tried to read from behind the end of the file. "
+                       "Either the file got truncated, or there is a bug in RethinkDB.");
+                a->io_result = -EINVAL;
+                finish(req);
+                return;
+            }
+
+            req->done_bytes += action_t::advance_vector(&req->cur_vecs,
+                                                        &req->cur_count, res);
+            if (req->done_bytes < total_bytes) {
+                // Partial read or write, submit the rest.
+                advance(req);
+                return;
+            }
+            a->io_result = total_bytes;
+        }
+
+        if (a->wrap_in_datasyncs) {
+            req->step = request_t::POST_SYNC;
+            advance(req);
+        } else {
+            finish(req);
+        }
+        return;
+    case request_t::POST_SYNC:
+        if (res < 0) {
+            a->io_result = res;
+        }
+        finish(req);
+        return;
+    default:
+        unreachable();
+    }
+}
+
+void uring_diskmgr_t::finish(request_t *req) {
+    action_t *a = req->action;
+    delete req;
+    n_pending--;
+    pump();
+    done_fun(a);
+}
+
+void uring_diskmgr_t::on_fallback_done(action_t *a) {
+    assert_thread();
+    n_pending--;
+    pump();
+    done_fun(a);
+}
+
+void uring_diskmgr_t::reap_completions() {
+    rassert(!defer_submit);
+    defer_submit = true;
+    for (;;) {
+        const unsigned int head = *cq_head;
+        const unsigned int tail = __atomic_load_n(cq_tail, __ATOMIC_ACQUIRE);
+        if (head == tail) {
+            break;
+        }
+        const io_uring_cqe *cqe = &cqes[head & *cq_ring_mask];
+        request_t *req = reinterpret_cast<request_t *>(cqe->user_data);
+        const int32_t res = cqe->res;
+        // Hand the slot back to the kernel before handling the completion, so
+        // it can be reused right away.
+        __atomic_store_n(cq_head, head + 1, __ATOMIC_RELEASE);
+
+        handle_completion(req, res);
+    }
+    defer_submit = false;
+
+    // Submit everything that resulted from handling the completions in one go.
+    submit_pending();
+}
+
+void uring_diskmgr_t::on_event(DEBUG_VAR int events) {
+    assert_thread();
+    rassert(events == poll_event_in);
+    completion_event.consume_wakey_wakeys();
+    reap_completions();
+}
+
+void uring_diskmgr_t::on_source_availability_changed() {
+    assert_thread();
+    if (source->available->get()) {
+        pump();
+    }
+}
+
+void uring_diskmgr_t::pump() {
+    assert_thread();
+    const bool was_deferring = defer_submit;
+    // Batch all the submissions we make in this loop into one `io_uring_enter` call.
+    defer_submit = true;
+    while (source->available->get() && n_pending < queue_depth) {
+        action_t *a = source->pop();
+        n_pending++;
+        if (a->type == action_t::ACTION_RESIZE && a->size_change < 0) {
+            // io_uring has no way to shrink a file.
+            fallback_queue.push(a);
+            continue;
+        }
+        advance(new request_t(a));
+    }
+    defer_submit = was_deferring;
+    if (!defer_submit) {
+        submit_pending();
+    }
+}
+
+#endif  // USE_IO_URING
@@ -0,0 +1,125 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#ifndef ARCH_IO_DISK_URING_HPP_
+#define ARCH_IO_DISK_URING_HPP_
+
+#include <functional>
+
+#include "arch/io/disk/pool.hpp"
+#include "arch/io/io_utils.hpp"
+#include "arch/runtime/event_queue.hpp"
+#include "arch/runtime/system_event.hpp"
+#include "concurrency/queue/passive_producer.hpp"
+#include "concurrency/queue/unlimited_fifo.hpp"
+#include "containers/scoped.hpp"
+
+#if defined(__linux) && !defined(NO_IO_URING) && defined(__has_include)
+#if __has_include(<linux/io_uring.h>)
+#include <linux/io_uring.h>
+#endif
+#endif
+
+// We need the opcodes and features from Linux 5.6 (`IORING_OP_FALLOCATE`,
+// `IORING_FEAT_SINGLE_MMAP`).  The opcodes are enum values, so we test for
+// `IORING_FEAT_RW_CUR_POS`, which is a macro that first appeared in the same release.
+#if defined(__linux) && !defined(NO_IO_URING) && defined(IORING_FEAT_RW_CUR_POS)
+#define USE_IO_URING 1
+#else
+#define USE_IO_URING 0
+#endif
+
+#if USE_IO_URING
+
+struct io_uring_sqe;
+struct io_uring_cqe;
+
+/* The io_uring disk manager is a drop-in replacement for `pool_diskmgr_t`.  Instead of
+handing each action to a blocker thread, it batches reads, writes, datasyncs and
+growing resizes into an io_uring submission queue owned by the event loop thread that
+created it.  The kernel signals completions through an eventfd that is watched by the
+same `linux_event_queue_t`, so no extra threads or context switches are involved.
+
+Operations that io_uring cannot express (shrinking a file, or `fallocate` on a file
+system that doesn't support it) are passed on to a small internal `pool_diskmgr_t`. */
+
+class uring_diskmgr_t : private availability_callback_t,
+                        private linux_event_callback_t,
+                        public home_thread_mixin_debug_only_t {
+public:
+    typedef pool_diskmgr_action_t action_t;
+
+    /* Returns true if the running kernel lets us set up an io_uring.  If this returns
+    false, use `pool_diskmgr_t` instead. */
+    static bool is_supported();
+
+    /* Same interface as `pool_diskmgr_t`.  Crashes if `is_supported()` is false. */
+    uring_diskmgr_t(linux_event_queue_t *queue, passive_producer_t<action_t *> *source,
+                    int max_concurrent_io_requests);
+    std::function<void(action_t *)> done_fun;
+    ~uring_diskmgr_t();
+
+private:
+    struct request_t;
+
+    void setup_ring(int entries);
+
+    void on_source_availability_changed();
+    void on_event(int events);
+    void pump();
+
+    // Starts the next step of `req`, or finishes it if there are no steps left.
+    void advance(request_t *req);
+    void finish(request_t *req);
+    void handle_completion(request_t *req, int32_t res);
+
+    io_uring_sqe *get_sqe();
+    void submit_pending();
+    void reap_completions();
+
+    void on_fallback_done(action_t *action);
+
+    linux_event_queue_t *const queue;
+    const int queue_depth;
+    passive_producer_t<action_t *> *source;
+
+    scoped_fd_t ring_fd;
+    unsigned int sq_entries;
+    unsigned int cq_entries;
+
+    // The memory mapped rings, and pointers into them.
+    void *sq_ring_ptr;
+    size_t sq_ring_size;
+    void *cq_ring_ptr;
+    size_t cq_ring_size;
+    io_uring_sqe *sqes;
+    size_t sqes_size;
+
+    unsigned int *sq_head;
+    unsigned int *sq_tail;
+    unsigned int *sq_ring_mask;
+    unsigned int *sq_array;
+    unsigned int *cq_head;
+    unsigned int *cq_tail;
+    unsigned int *cq_ring_mask;
+    io_uring_cqe *cqes;
+
+    // The number of SQEs we've filled in, but not passed to `io_uring_enter` yet.
+    unsigned int sqes_to_submit;
+
+    system_event_t completion_event;
+
+    // Number of actions that we've popped from `source` and not finished yet.
+    int n_pending;
+
+    // While this is set, `advance` leaves new SQEs for the caller to submit.  Used
+    // to batch submissions into a single `io_uring_enter` call.
+    bool defer_submit;
+
+    unlimited_fifo_queue_t<action_t *> fallback_queue;
+    pool_diskmgr_t fallback_pool;
+
+    DISABLE_COPYING(uring_diskmgr_t);
+};
+
+#endif  // USE_IO_URING
+
+#endif  // ARCH_IO_DISK_URING_HPP_
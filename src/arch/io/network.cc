@@ -309,6 +309,8 @@ void linux_tcp_conn_t::release_write_buffer(write_buffer_t *buffer) {
 
 void linux_tcp_conn_t::release_write_queue_op(write_queue_op_t *op) {
     op->keepalive = auto_drainer_t::lock_t();
+    // Free the data instead of keeping its capacity around.
+    std::vector<char>().swap(op->owned_data);
     unused_write_queue_ops.push_front(op);
 }
 
@@ -521,19 +523,43 @@ linux_tcp_conn_t::write_handler_t::write_handler_t(linux_tcp_conn_t *_parent) :
 { }
 
 void linux_tcp_conn_t::write_handler_t::coro_pool_callback(write_queue_op_t *operation, UNUSED signal_t *interruptor) {
-    if (operation->buffer != nullptr) {
-        parent->perform_write(operation->buffer, operation->size);
-        if (operation->dealloc != nullptr) {
-            parent->release_write_buffer(operation->dealloc);
-            parent->write_queue_limiter.unlock(operation->size);
+    /* Take whatever else is waiting in the queue along with `operation`, so that a
+    message header in the write buffer and the large message body behind it go out
+    in a single system call. */
+    write_queue_op_t *operations[MAX_GATHERED_WRITES];
+    const_charslice slices[MAX_GATHERED_WRITES];
+    size_t num_operations = 0;
+    size_t num_slices = 0;
+    operations[num_operations++] = operation;
+    while (num_operations < MAX_GATHERED_WRITES
+           && parent->write_queue.available->get()) {
+        operations[num_operations++] = parent->write_queue.pop();
+    }
+    for (size_t i = 0; i < num_operations; ++i) {
+        if (operations[i]->buffer != nullptr && operations[i]->size > 0) {
+            const char *buffer = static_cast<const char *>(operations[i]->buffer);
+            slices[num_slices++] = const_charslice(buffer, buffer + operations[i]->size);
         }
     }
-
-    if (operation->cond != nullptr) {
-        operation->cond->pulse();
+    if (num_slices > 0) {
+        parent->perform_gathered_write(slices, num_slices);
     }
-    if (operation->dealloc != nullptr) {
-        parent->release_write_queue_op(operation);
+
+    for (size_t i = 0; i < num_operations; ++i) {
+        write_queue_op_t *op = operations[i];
+        if (op->dealloc != nullptr) {
+            parent->release_write_buffer(op->dealloc);
+        }
+        if (op->is_queued_asynchronously()) {
+            parent->write_queue_limiter.unlock(op->limiter_count);
+        }
+        if (op->cond != nullptr) {
+            op->cond->pulse();
+        }
+        if (op->is_queued_asynchronously()) {
+            op->dealloc = nullptr;
+            parent->release_write_queue_op(op);
+        }
     }
 }
 
@@ -547,6 +573,7 @@ void linux_tcp_conn_t::internal_flush_write_buffer() {
     op->buffer = current_write_buffer->buffer;
     op->size = current_write_buffer->size;
     op->dealloc = current_write_buffer.release();
+    op->limiter_count = op->size;
     op->cond = nullptr;
     op->keepalive = auto_drainer_t::lock_t(drainer.get());
     current_write_buffer.init(get_write_buffer());
@@ -555,7 +582,7 @@ void linux_tcp_conn_t::internal_flush_write_buffer() {
        to be released once the write is completed by the coroutine pool */
     rassert(op->size <= WRITE_CHUNK_SIZE);
     rassert(WRITE_CHUNK_SIZE < WRITE_QUEUE_MAX_SIZE);
-    write_queue_limiter.co_lock(op->size);
+    write_queue_limiter.co_lock(op->limiter_count);
 
     write_queue.push(op);
 }
@@ -598,8 +625,46 @@ void linux_tcp_conn_t::perform_write(const void *buf, size_t size) {
         rassert(op.nb_bytes == size);  // TODO WINDOWS: does windows guarantee this?
     }
 #else
-    while (size > 0) {
-        ssize_t res = ::write(sock.get(), buf, size);
+    struct iovec iov;
+    iov.iov_base = const_cast<void *>(buf);
+    iov.iov_len = size;
+    perform_writev(&iov, 1);
+#endif
+}
+
+void linux_tcp_conn_t::perform_gathered_write(const const_charslice *slices,
+                                              size_t count) {
+#ifdef _WIN32
+    for (size_t i = 0; i < count; ++i) {
+        perform_write(slices[i].beg, slices[i].end - slices[i].beg);
+    }
+#else
+    struct iovec iov[MAX_GATHERED_WRITES];
+    guarantee(count <= MAX_GATHERED_WRITES);
+    for (size_t i = 0; i < count; ++i) {
+        iov[i].iov_base = const_cast<char *>(slices[i].beg);
+        iov[i].iov_len = slices[i].end - slices[i].beg;
+    }
+    perform_writev(iov, count);
+#endif
+}
+
+#ifndef _WIN32
+void linux_tcp_conn_t::perform_writev(struct iovec *iov, int iovcnt) {
+    assert_thread();
+
+    if (write_closed.is_pulsed()) {
+        return;
+    }
+
+    /* Skip over buffers that have been written completely. */
+    while (iovcnt > 0 && iov->iov_len == 0) {
+        ++iov;
+        --iovcnt;
+    }
+
+    while (iovcnt > 0) {
+        ssize_t res = ::writev(sock.get(), iov, iovcnt);
 
         if (res == -1 && (get_errno() == EAGAIN || get_errno() == EWOULDBLOCK)) {
             /* Wait for a notification from the event queue, or for an order to
@@ -637,16 +702,26 @@ void linux_tcp_conn_t::perform_write(const void *buf, size_t size) {
             break;
 
         } else {
-            rassert(res <= static_cast<ssize_t>(size));
-            buf = reinterpret_cast<const void *>(reinterpret_cast<const char *>(buf) + res);
-            size -= res;
             if (write_perfmon) {
                 write_perfmon->record(res);
             }
+            /* Advance past what has been written, which might end in the middle of
+               a buffer. */
+            size_t written = res;
+            while (iovcnt > 0 && written >= iov->iov_len) {
+                written -= iov->iov_len;
+                ++iov;
+                --iovcnt;
+            }
+            rassert(iovcnt > 0 || written == 0);
+            if (iovcnt > 0) {
+                iov->iov_base = static_cast<char *>(iov->iov_base) + written;
+                iov->iov_len -= written;
+            }
         }
     }
-#endif
 }
+#endif
 
 void linux_tcp_conn_t::write(const void *buf, size_t size, signal_t *closer) THROWS_ONLY(tcp_conn_write_closed_exc_t) {
     write_op_wrapper_t sentry(this, closer);
@@ -711,6 +786,45 @@ void linux_tcp_conn_t::write_buffered(const void *vbuf, size_t size, signal_t *c
     }
 }
 
+void linux_tcp_conn_t::write_buffered_vector(std::vector<char> &&data, signal_t *closer) THROWS_ONLY(tcp_conn_write_closed_exc_t) {
+    /* Copying small messages into the write buffer is cheaper than giving them
+       their own entry in the write queue. */
+    if (data.size() < WRITE_CHUNK_SIZE) {
+        write_buffered(data.data(), data.size(), closer);
+        return;
+    }
+
+    write_op_wrapper_t sentry(this, closer);
+
+    /* Whatever has been buffered so far has to go out first. It usually ends up in
+       the same `writev()` call as `data`. */
+    if (current_write_buffer->size > 0) {
+        internal_flush_write_buffer();
+    }
+    if (write_closed.is_pulsed()) {
+        throw tcp_conn_write_closed_exc_t();
+    }
+
+    write_queue_op_t *op = get_write_queue_op();
+    op->owned_data = std::move(data);
+    op->buffer = op->owned_data.data();
+    op->size = op->owned_data.size();
+    op->dealloc = nullptr;
+    op->cond = nullptr;
+    op->keepalive = auto_drainer_t::lock_t(drainer.get());
+
+    /* Large messages count towards the write queue limit like the write buffers do,
+       but a single one may take up all of it. */
+    op->limiter_count = op->size < WRITE_QUEUE_MAX_SIZE ? op->size : WRITE_QUEUE_MAX_SIZE;
+    write_queue_limiter.co_lock(op->limiter_count);
+
+    write_queue.push(op);
+
+    if (write_closed.is_pulsed()) {
+        throw tcp_conn_write_closed_exc_t();
+    }
+}
+
 void linux_tcp_conn_t::writef(signal_t *closer, const char *format, ...) THROWS_ONLY(tcp_conn_write_closed_exc_t) {
     va_list ap;
     va_start(ap, format);
@@ -1044,6 +1158,13 @@ size_t linux_secure_tcp_conn_t::read_internal(void *buffer, size_t size)
     }
 }
 
+void linux_secure_tcp_conn_t::perform_gathered_write(const const_charslice *slices,
+                                                     size_t count) {
+    for (size_t i = 0; i < count; ++i) {
+        perform_write(slices[i].beg, slices[i].end - slices[i].beg);
+    }
+}
+
 void linux_secure_tcp_conn_t::perform_write(const void *buffer, size_t size) {
     assert_thread();
 
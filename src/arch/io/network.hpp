@@ -17,6 +17,7 @@
 #include <ifaddrs.h>
 #include <arpa/inet.h>
 #include <netinet/in.h>
+#include <sys/uio.h>
 #endif
 
 #include <functional>
@@ -142,6 +143,13 @@ public:
     void write_buffered(const void *buf, size_t size, signal_t *closer)
         THROWS_ONLY(tcp_conn_write_closed_exc_t);
 
+    /* write_buffered_vector() is like write_buffered(), but takes ownership of `data`
+    instead of copying it into the write buffer, unless it's small enough that copying
+    is cheaper. The data is written out with `writev()` together with the buffered
+    data in front of it, and freed once it has been sent. */
+    void write_buffered_vector(std::vector<char> &&data, signal_t *closer)
+        THROWS_ONLY(tcp_conn_write_closed_exc_t);
+
     void writef(signal_t *closer, const char *format, ...)
         THROWS_ONLY(tcp_conn_write_closed_exc_t) ATTR_FORMAT(printf, 3, 4);
 
@@ -275,14 +283,28 @@ private:
         size_t size;
     };
 
+    /* An operation that comes from `get_write_queue_op()` has either `dealloc` set or
+    `owned_data` filled; it gets released once it has been written. Operations with
+    neither live on the stack of whoever is waiting for `cond`. */
     struct write_queue_op_t : public intrusive_list_node_t<write_queue_op_t> {
         write_buffer_t *dealloc;
+        std::vector<char> owned_data;
         const void *buffer;
         size_t size;
+        // How much of `write_queue_limiter` the operation holds.
+        size_t limiter_count;
         cond_t *cond;
         auto_drainer_t::lock_t keepalive;
+
+        bool is_queued_asynchronously() const {
+            return dealloc != nullptr || !owned_data.empty();
+        }
     };
 
+    /* How many queued write operations the write coroutine takes at once, and hands
+    to `perform_gathered_write()` together. */
+    static const size_t MAX_GATHERED_WRITES = 64;
+
     class write_handler_t : public coro_pool_callback_t<write_queue_op_t*> {
     public:
         explicit write_handler_t(linux_tcp_conn_t *_parent);
@@ -345,6 +367,16 @@ private:
     /* Used to actually perform a write. If the write end of the connection is open, then
     writes `size` bytes from `buffer` to the socket. */
     virtual void perform_write(const void *buffer, size_t size);
+
+    /* Like `perform_write()`, but writes several buffers one after the other. On
+    Linux and OS X, they are written with as few `writev()` calls as possible. */
+    virtual void perform_gathered_write(const const_charslice *slices, size_t count);
+
+#ifndef _WIN32
+    /* Writes the given buffers to the socket. Modifies `iov` to keep track of
+    partial writes. */
+    void perform_writev(struct iovec *iov, int iovcnt);
+#endif
 };
 
 #ifdef ENABLE_TLS
@@ -409,6 +441,9 @@ private:
     writes `size` bytes from `buffer` to the socket. */
     virtual void perform_write(const void *buffer, size_t size);
 
+    /* OpenSSL can't gather writes, so we encrypt the buffers one at a time. */
+    virtual void perform_gathered_write(const const_charslice *slices, size_t count);
+
     void shutdown();
     void shutdown_socket();
 
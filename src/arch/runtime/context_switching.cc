@@ -183,6 +183,7 @@ void context_switch(fiber_context_ref_t *curr_context_out, fiber_context_ref_t *
 
 #include "arch/runtime/thread_pool.hpp"
 #include "arch/runtime/coroutines.hpp"
+#include "arch/runtime/coro_stack_pool.hpp"
 #include "arch/io/concurrency.hpp"
 #include "containers/scoped.hpp"
 #include "errors.hpp"
@@ -207,18 +208,19 @@ bool artificial_stack_context_ref_t::is_nil() {
 }
 
 artificial_stack_t::artificial_stack_t(void (*initial_fun)(void), size_t _stack_size)
-    : stack(_stack_size), stack_size(_stack_size), overflow_protection_enabled(false) {
+    : stack_size(_stack_size) {
 
-    // Tell the operating system that it can unmap the stack space
-    // (except for the first page, which we are definitely going to need).
-    // This is an optimization to keep memory consumption in check.
-    guarantee(stack_size >= static_cast<size_t>(getpagesize()));
-    madvise(stack.get(), stack_size - getpagesize(), MADV_DONTNEED);
+    // The stack might have been used by another coroutine before, in which case its
+    // guard page might still be protected.
+    coro_stack_pool_t::stack_memory_t memory
+        = coro_stack_pool_t::get()->acquire(stack_size);
+    stack = memory.memory;
+    overflow_protection_enabled = memory.guard_page_protected;
 
     // Register our stack with Valgrind so that it understands what's going on
     // and doesn't create spurious errors.
 #ifdef VALGRIND
-    valgrind_stack_id = VALGRIND_STACK_REGISTER(stack.get(), (intptr_t)stack.get() + stack_size);
+    valgrind_stack_id = VALGRIND_STACK_REGISTER(stack, (intptr_t)stack + stack_size);
 #endif
 
     // Setup the new stack (grows downwards).
@@ -241,7 +243,7 @@ artificial_stack_t::artificial_stack_t(void (*initial_fun)(void), size_t _stack_
     uintptr_t *sp;
 
     // (1) initialize sp to point at the top of the stack.
-    sp = reinterpret_cast<uintptr_t *>(uintptr_t(stack.get()) + stack_size);
+    sp = reinterpret_cast<uintptr_t *>(uintptr_t(stack) + stack_size);
 
     // (2) align sp to meet platform ABI requirements.
     // Note: not all platforms require 16-byte alignment, but it is easier to do it
@@ -324,35 +326,14 @@ artificial_stack_t::~artificial_stack_t() {
 #endif
 #endif
 
-    /* Undo protections changes */
-    disable_overflow_protection();
-
-    /* Return the memory to the operating system right away. This makes
-    sense because we keep our own cache of coroutine stacks around and
-    don't need to rely on the allocator to optimize for the case of
-    us quickly re-allocating an object of the same size.
-    On OS X we use MADV_FREE. On Linux MADV_FREE is not available,
-    and we use MADV_DONTNEED instead. */
-#ifdef __MACH__
-    madvise(stack.get(), stack_size, MADV_FREE);
-#else
-    madvise(stack.get(), stack_size, MADV_DONTNEED);
-#endif
-}
-
-/* Wrapper around `mprotect` that checks the return code. */
-void checked_mprotect_page(void *page_addr, int prot) {
-    int res = mprotect(page_addr, getpagesize(), prot);
-    if (res != 0) {
-#ifdef __linux__
-        if (get_errno() == ENOMEM) {
-            crash("Failed to (un-)protect a coroutine stack (`mprotect` failed with "
-                  "`ENOMEM`). Try increasing the value of `/proc/sys/vm/max_map_count`.");
-        }
-#endif
-        crash("Failed to (un-)protect a coroutine stack. `mprotect` failed with error "
-              "code %d.", get_errno());
-    }
+    /* Hand the stack to the pool, guard page protection included, so that the next
+    coroutine that gets it doesn't have to protect it again. The pool takes care of
+    returning the memory to the operating system if it doesn't need it. */
+    coro_stack_pool_t::stack_memory_t memory;
+    memory.memory = stack;
+    memory.size = stack_size;
+    memory.guard_page_protected = overflow_protection_enabled;
+    coro_stack_pool_t::get()->release(memory);
 }
 
 void artificial_stack_t::enable_overflow_protection() {
@@ -364,7 +345,7 @@ void artificial_stack_t::enable_overflow_protection() {
     /* OS X Instruments hangs when running with mprotect and having object identification
     enabled. We don't need it for THREADED_COROUTINES anyway, so don't use it then. */
 #ifndef THREADED_COROUTINES
-    checked_mprotect_page(stack.get(), PROT_NONE);
+    checked_mprotect_page(stack, PROT_NONE);
     overflow_protection_enabled = true;
 #endif
 }
@@ -374,7 +355,7 @@ void artificial_stack_t::disable_overflow_protection() {
         return;
     }
 #ifndef THREADED_COROUTINES
-    checked_mprotect_page(stack.get(), PROT_READ | PROT_WRITE);
+    checked_mprotect_page(stack, PROT_READ | PROT_WRITE);
     overflow_protection_enabled = false;
 #endif
 }
@@ -95,10 +95,10 @@ public:
     bool address_is_stack_overflow(const void *addr) const;
 
     /* Returns the base of the stack */
-    void *get_stack_base() const { return stack.get() + stack_size; }
+    void *get_stack_base() const { return stack + stack_size; }
 
     /* Returns the end of the stack */
-    void *get_stack_bound() const { return stack.get(); }
+    void *get_stack_bound() const { return stack; }
 
     /* Returns how many more bytes below the given address can be used */
     size_t free_space_below(const void *addr) const;
@@ -109,12 +109,15 @@ public:
     void disable_overflow_protection();
 
 private:
-    scoped_page_aligned_ptr_t<char> stack;
+    // Comes from `coro_stack_pool_t`, and goes back there when we're destroyed.
+    char *stack;
     size_t stack_size;
     bool overflow_protection_enabled;
 #ifdef VALGRIND
     int valgrind_stack_id;
 #endif
+
+    DISABLE_COPYING(artificial_stack_t);
 };
 
 /* `context_switch()` switches from one context to another.
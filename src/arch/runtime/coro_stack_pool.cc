@@ -0,0 +1,220 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#ifndef _WIN32
+
+#include "arch/runtime/coro_stack_pool.hpp"
+
+#include <errno.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#ifdef __linux__
+#include <sys/syscall.h>
+#endif
+
+#include "memory_utils.hpp"
+#include "thread_local.hpp"
+#include "utils.hpp"
+
+void checked_mprotect_page(void *page_addr, int prot) {
+    int res = mprotect(page_addr, getpagesize(), prot);
+    if (res != 0) {
+#ifdef __linux__
+        if (get_errno() == ENOMEM) {
+            crash("Failed to (un-)protect a coroutine stack (`mprotect` failed with "
+                  "`ENOMEM`). Try increasing the value of `/proc/sys/vm/max_map_count`.");
+        }
+#endif
+        crash("Failed to (un-)protect a coroutine stack. `mprotect` failed with error "
+              "code %d.", get_errno());
+    }
+}
+
+namespace {
+
+/* Lets the OS take the memory of a stack that we keep around but don't expect to use
+soon.  `MADV_FREE` only takes effect when the OS runs short on memory, so reusing the
+stack before then is as cheap as reusing a hot one.  Older Linux kernels don't support
+it, in which case we fall back to `MADV_DONTNEED`. */
+void madvise_cold(char *memory, size_t size) {
+#ifdef MADV_FREE
+    if (madvise(memory, size, MADV_FREE) == 0) {
+        return;
+    }
+#endif
+    madvise(memory, size, MADV_DONTNEED);
+}
+
+// How many stacks a thread acquires before it checks which NUMA node it's on again,
+// in case the OS moved it.
+const int numa_node_refresh_interval = 1024;
+
+int current_numa_node() {
+    static THREAD_LOCAL int cached_node = 0;
+    static THREAD_LOCAL int acquisitions_until_refresh = 0;
+    if (acquisitions_until_refresh-- <= 0) {
+        acquisitions_until_refresh = numa_node_refresh_interval;
+#if defined(__linux__) && defined(SYS_getcpu)
+        unsigned int cpu, node;
+        if (syscall(SYS_getcpu, &cpu, &node, nullptr) == 0) {
+            cached_node = node % COROUTINE_STACK_POOL_MAX_NUMA_NODES;
+        }
+#endif
+    }
+    return cached_node;
+}
+
+}  // namespace
+
+coro_stack_pool_t *coro_stack_pool_t::get() {
+    // Stacks can get released while static objects are being destroyed, so the pool
+    // is never destroyed.
+    static coro_stack_pool_t *pool = new coro_stack_pool_t();
+    return pool;
+}
+
+coro_stack_pool_t::coro_stack_pool_t()
+    : num_stacks_(0),
+      stack_bytes_(0),
+      num_pooled_stacks_(0),
+      pooled_stack_bytes_(0),
+      num_cold_pooled_stacks_(0),
+      num_protected_pooled_stacks_(0) { }
+
+coro_stack_pool_t::size_class_t *coro_stack_pool_t::node_pool_t::get_size_class(
+        size_t size) {
+    for (size_class_t &size_class : size_classes) {
+        if (size_class.size == size) {
+            return &size_class;
+        }
+    }
+    size_classes.push_back(size_class_t(size));
+    return &size_classes.back();
+}
+
+coro_stack_pool_t::node_pool_t *coro_stack_pool_t::get_node_pool() {
+    return &nodes_[current_numa_node()];
+}
+
+bool coro_stack_pool_t::reserve_protected_stack() {
+    const size_t max_protected_stacks = MAX_PROTECTED_COROS / 4;
+    if (num_protected_pooled_stacks_.fetch_add(1, std::memory_order_relaxed)
+            < max_protected_stacks) {
+        return true;
+    }
+    num_protected_pooled_stacks_.fetch_sub(1, std::memory_order_relaxed);
+    return false;
+}
+
+coro_stack_pool_t::stack_memory_t coro_stack_pool_t::acquire(size_t size) {
+    guarantee(size >= static_cast<size_t>(getpagesize()));
+    num_stacks_.fetch_add(1, std::memory_order_relaxed);
+    stack_bytes_.fetch_add(size, std::memory_order_relaxed);
+
+    stack_memory_t stack;
+    node_pool_t *node = get_node_pool();
+    {
+        spinlock_acq_t acq(&node->lock);
+        size_class_t *size_class = node->get_size_class(size);
+        if (!size_class->hot.empty()) {
+            stack = size_class->hot.back();
+            size_class->hot.pop_back();
+            --node->num_hot;
+            --node->num_stacks;
+        } else if (!size_class->cold.empty()) {
+            stack.memory = size_class->cold.back();
+            stack.size = size;
+            size_class->cold.pop_back();
+            --node->num_stacks;
+            num_cold_pooled_stacks_.fetch_sub(1, std::memory_order_relaxed);
+        }
+    }
+    if (stack.memory != nullptr) {
+        if (stack.guard_page_protected) {
+            num_protected_pooled_stacks_.fetch_sub(1, std::memory_order_relaxed);
+        }
+        num_pooled_stacks_.fetch_sub(1, std::memory_order_relaxed);
+        pooled_stack_bytes_.fetch_sub(size, std::memory_order_relaxed);
+        return stack;
+    }
+
+    stack.memory = static_cast<char *>(raw_malloc_page_aligned(size));
+    stack.size = size;
+    // Tell the operating system that it can unmap the stack space
+    // (except for the first page, which we are definitely going to need).
+    // This is an optimization to keep memory consumption in check.
+    madvise(stack.memory, size - getpagesize(), MADV_DONTNEED);
+    return stack;
+}
+
+void coro_stack_pool_t::release(const stack_memory_t &released_stack) {
+    rassert(released_stack.memory != nullptr);
+    num_stacks_.fetch_sub(1, std::memory_order_relaxed);
+    stack_bytes_.fetch_sub(released_stack.size, std::memory_order_relaxed);
+
+    // Protected stacks in the pool count against MAX_PROTECTED_COROS, so we can only
+    // keep the protection of a few of them.
+    stack_memory_t stack = released_stack;
+    if (stack.guard_page_protected && !reserve_protected_stack()) {
+        checked_mprotect_page(stack.memory, PROT_READ | PROT_WRITE);
+        stack.guard_page_protected = false;
+    }
+
+    node_pool_t *node = get_node_pool();
+    {
+        spinlock_acq_t acq(&node->lock);
+        if (node->num_hot < COROUTINE_STACK_POOL_HOT_STACKS) {
+            node->get_size_class(stack.size)->hot.push_back(stack);
+            ++node->num_hot;
+            ++node->num_stacks;
+            num_pooled_stacks_.fetch_add(1, std::memory_order_relaxed);
+            pooled_stack_bytes_.fetch_add(stack.size, std::memory_order_relaxed);
+            return;
+        }
+    }
+
+    // The stack goes cold or gets freed, so its guard page has to become a normal
+    // page again.  We do that and the `madvise` without holding the lock.
+    if (stack.guard_page_protected) {
+        checked_mprotect_page(stack.memory, PROT_READ | PROT_WRITE);
+        num_protected_pooled_stacks_.fetch_sub(1, std::memory_order_relaxed);
+    }
+    madvise_cold(stack.memory, stack.size);
+    {
+        spinlock_acq_t acq(&node->lock);
+        if (node->num_stacks < COROUTINE_STACK_POOL_MAX_STACKS) {
+            node->get_size_class(stack.size)->cold.push_back(stack.memory);
+            ++node->num_stacks;
+            num_pooled_stacks_.fetch_add(1, std::memory_order_relaxed);
+            pooled_stack_bytes_.fetch_add(stack.size, std::memory_order_relaxed);
+            num_cold_pooled_stacks_.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+    }
+    raw_free_aligned(stack.memory);
+}
+
+int64_t coro_stack_pool_t::num_stacks() const {
+    return num_stacks_.load(std::memory_order_relaxed);
+}
+
+int64_t coro_stack_pool_t::stack_bytes() const {
+    return stack_bytes_.load(std::memory_order_relaxed);
+}
+
+int64_t coro_stack_pool_t::num_pooled_stacks() const {
+    return num_pooled_stacks_.load(std::memory_order_relaxed);
+}
+
+int64_t coro_stack_pool_t::pooled_stack_bytes() const {
+    return pooled_stack_bytes_.load(std::memory_order_relaxed);
+}
+
+int64_t coro_stack_pool_t::num_cold_pooled_stacks() const {
+    return num_cold_pooled_stacks_.load(std::memory_order_relaxed);
+}
+
+size_t coro_stack_pool_t::num_protected_pooled_stacks() const {
+    return num_protected_pooled_stacks_.load(std::memory_order_relaxed);
+}
+
+#endif  // _WIN32
@@ -0,0 +1,118 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#ifndef ARCH_RUNTIME_CORO_STACK_POOL_HPP_
+#define ARCH_RUNTIME_CORO_STACK_POOL_HPP_
+
+#include <stddef.h>
+#include <stdint.h>
+
+// The maximum (global) number of stack-protected coroutine stacks, including the ones
+// in `coro_stack_pool_t`.
+// On Linux, this number is limited by the setting in `/proc/sys/vm/max_map_count`,
+// which is 65536 by default. We use a quarter of that, to leave enough room for the
+// memory allocator and other things that might fragment the memory space (note that
+// a single protected coroutine consumes two mapped memory regions).
+// Exception: debug-mode, where we use a smaller value to exercise the code path more
+// often.
+#ifdef NDEBUG
+const size_t MAX_PROTECTED_COROS = 16384;
+#else
+const size_t MAX_PROTECTED_COROS = 128;
+#endif
+
+#ifndef _WIN32
+
+#include <atomic>
+#include <vector>
+
+#include "arch/spinlock.hpp"
+#include "config/args.hpp"
+#include "errors.hpp"
+
+/* Wrapper around `mprotect` for a single page that crashes if it fails. */
+void checked_mprotect_page(void *page_addr, int prot);
+
+/* The memory of the coroutine stacks of all threads comes from `coro_stack_pool_t`.
+Each thread keeps a list of unused coroutines (and their stacks) around, but when a
+burst of coroutines ends, most of them get destroyed.  Their stacks then go to this
+pool, where any thread on the same NUMA node can pick them up again.
+
+The lowest page of each stack is its guard page, which `artificial_stack_t` protects
+to catch stack overflows.  The pool keeps up to COROUTINE_STACK_POOL_HOT_STACKS stacks
+per node as they are, so that reusing them doesn't take any system calls.  Up to a
+quarter of MAX_PROTECTED_COROS of them keep their guard page protection; the rest of
+the hot stacks are unprotected when they are released.  Stacks beyond that are unprotected and given back to the OS with
+`MADV_FREE`, which lets it take their memory only when it runs short.  Beyond
+COROUTINE_STACK_POOL_MAX_STACKS per node, stacks are freed. */
+class coro_stack_pool_t {
+public:
+    struct stack_memory_t {
+        stack_memory_t() : memory(nullptr), size(0), guard_page_protected(false) { }
+
+        char *memory;
+        size_t size;
+        bool guard_page_protected;
+    };
+
+    static coro_stack_pool_t *get();
+
+    // Returns a stack of the given size, preferably one that was released recently on
+    // the current NUMA node.
+    stack_memory_t acquire(size_t size);
+    void release(const stack_memory_t &stack);
+
+    // The stacks that are in use by coroutines.
+    int64_t num_stacks() const;
+    int64_t stack_bytes() const;
+    // The stacks in the pool, and how many of those are cold.
+    int64_t num_pooled_stacks() const;
+    int64_t pooled_stack_bytes() const;
+    int64_t num_cold_pooled_stacks() const;
+    // The stacks in the pool whose guard page is still protected, which count against
+    // MAX_PROTECTED_COROS.
+    size_t num_protected_pooled_stacks() const;
+
+private:
+    coro_stack_pool_t();
+
+    struct size_class_t {
+        explicit size_class_t(size_t _size) : size(_size) { }
+        size_t size;
+        // Both are used last in, first out, so that we reuse the stacks whose memory
+        // is most likely to be in the cache.
+        std::vector<stack_memory_t> hot;
+        std::vector<char *> cold;
+    };
+
+    struct node_pool_t {
+        node_pool_t() : num_hot(0), num_stacks(0) { }
+
+        size_class_t *get_size_class(size_t size);
+
+        spinlock_t lock;
+        // There are only ever a few different stack sizes.
+        std::vector<size_class_t> size_classes;
+        size_t num_hot;
+        size_t num_stacks;
+    };
+
+    node_pool_t *get_node_pool();
+
+    // Reserves one of the protected stacks that the pool may keep, or returns false if
+    // it already keeps as many as it may.
+    bool reserve_protected_stack();
+
+    node_pool_t nodes_[COROUTINE_STACK_POOL_MAX_NUMA_NODES];
+
+    std::atomic<int64_t> num_stacks_;
+    std::atomic<int64_t> stack_bytes_;
+    std::atomic<int64_t> num_pooled_stacks_;
+    std::atomic<int64_t> pooled_stack_bytes_;
+    std::atomic<int64_t> num_cold_pooled_stacks_;
+    std::atomic<size_t> num_protected_pooled_stacks_;
+
+    DISABLE_COPYING(coro_stack_pool_t);
+};
+
+#endif  // _WIN32
+
+#endif  // ARCH_RUNTIME_CORO_STACK_POOL_HPP_
@@ -13,6 +13,7 @@
 
 #include "arch/runtime/context_switching.hpp"
 #include "arch/runtime/coro_profiler.hpp"
+#include "arch/runtime/coro_stack_pool.hpp"
 #include "arch/runtime/runtime.hpp"
 #include "arch/runtime/thread_pool.hpp"
 #include "config/args.hpp"
@@ -37,19 +38,6 @@ const size_t COROUTINE_FREE_LIST_SIZE = 64;
 const int COROS_PER_THREAD_WARN_LEVEL = 10000;
 #endif
 
-// The maximum (global) number of stack-protected coroutine stacks.
-// On Linux, this number is limited by the setting in `/proc/sys/vm/max_map_count`,
-// which is 65536 by default. We use a quarter of that, to leave enough room for the
-// memory allocator and other things that might fragment the memory space (note that
-// a single protected coroutine consumes two mapped memory regions).
-// Exception: debug-mode, where we use a smaller value to exercise the code path more
-// often.
-#ifdef NDEBUG
-const size_t MAX_PROTECTED_COROS = 16384;
-#else
-const size_t MAX_PROTECTED_COROS = 128;
-#endif
-
 
 
 /* `coro_globals_t` holds all of the thread-local variables that coroutines need
@@ -138,6 +126,30 @@ static perfmon_multi_membership_t pm_coroutines_membership(&get_global_perfmon_c
     &pm_active_coroutines, "active_coroutines",
     &pm_allocated_coroutines, "allocated_coroutines");
 
+#ifndef _WIN32
+/* Report how much memory the coroutine stacks of all threads take, and how much of that
+is in `coro_stack_pool_t`.  The stacks in the pool aren't used by any coroutine; the
+cold ones might not even be backed by memory any more. */
+static perfmon_function_t pm_coroutine_stack_bytes([]() {
+    return coro_stack_pool_t::get()->stack_bytes();
+});
+static perfmon_function_t pm_pooled_coroutine_stacks([]() {
+    return coro_stack_pool_t::get()->num_pooled_stacks();
+});
+static perfmon_function_t pm_pooled_coroutine_stack_bytes([]() {
+    return coro_stack_pool_t::get()->pooled_stack_bytes();
+});
+static perfmon_function_t pm_cold_pooled_coroutine_stacks([]() {
+    return coro_stack_pool_t::get()->num_cold_pooled_stacks();
+});
+static perfmon_multi_membership_t pm_coroutine_stacks_membership(
+    &get_global_perfmon_collection(),
+    &pm_coroutine_stack_bytes, "coroutine_stack_bytes",
+    &pm_pooled_coroutine_stacks, "pooled_coroutine_stacks",
+    &pm_pooled_coroutine_stack_bytes, "pooled_coroutine_stack_bytes",
+    &pm_cold_pooled_coroutine_stacks, "cold_pooled_coroutine_stacks");
+#endif
+
 coro_runtime_t::coro_runtime_t() {
     rassert(!TLS_get_cglobals(), "coro runtime initialized twice on this thread");
     TLS_set_cglobals(new coro_globals_t);
@@ -231,8 +243,14 @@ void coro_t::switch_to_coro_with_protection(coro_context_ref_t *current_context)
 
     /* If there are too many protected coroutines, unprotect the oldest one and pop it of
     the list. */
+    size_t max_protected_coros = MAX_PROTECTED_COROS;
+#ifndef _WIN32
+    /* The stacks in `coro_stack_pool_t` that are still protected count against the
+    limit too. */
+    max_protected_coros -= coro_stack_pool_t::get()->num_protected_pooled_stacks();
+#endif
     size_t max_protected_coros_per_thread =
-        MAX_PROTECTED_COROS / static_cast<size_t>(get_num_threads());
+        max_protected_coros / static_cast<size_t>(get_num_threads());
     while (cglobals->protected_coros_lru.size() > max_protected_coros_per_thread) {
         cglobals->protected_coros_lru.head()->coro->stack.disable_overflow_protection();
         cglobals->protected_coros_lru.pop_front();
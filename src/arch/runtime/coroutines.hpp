@@ -168,8 +168,10 @@ public:
 private:
     /* When called from within a coroutine, schedules the coroutine to be run on
     the given thread and then suspends the coroutine until that other thread
-    picks it up again. Do not call this directly; use `on_thread_t` instead. */
+    picks it up again. Do not call this directly; use `on_thread_t` (or
+    `migratable_section_t`) instead. */
     friend class on_thread_t;
+    friend class migratable_section_t;
     static void move_to_thread(threadnum_t thread);
 
     // Constructor sets up the stack, get_and_init_coro will load a function to be run
@@ -11,6 +11,7 @@
 #include "arch/runtime/thread_pool.hpp"
 #include "logger.hpp"
 #include "random.hpp"
+#include "time.hpp"
 #include "utils.hpp"
 
 // Set this to 1 if you would like some "unordered" messages to be unordered.
@@ -23,7 +24,10 @@ linux_message_hub_t::linux_message_hub_t(linux_event_queue_t *queue,
                                          threadnum_t current_thread)
     : queue_(queue),
       thread_pool_(thread_pool),
-      is_woken_up_(false),
+      incoming_messages_(nullptr),
+      processing_messages_(false),
+      busy_nanos_(0),
+      recent_backlog_(0),
       current_thread_(current_thread) {
 
 #ifndef NDEBUG
@@ -47,7 +51,7 @@ linux_message_hub_t::~linux_message_hub_t() {
         guarantee(get_priority_msg_list(p).empty());
     }
 
-    guarantee(incoming_messages_.empty());
+    guarantee(incoming_messages_.load() == nullptr);
 }
 
 void linux_message_hub_t::do_store_message(threadnum_t nthread, linux_thread_message_t *msg) {
@@ -94,19 +98,54 @@ void linux_message_hub_t::store_message_sometime(threadnum_t nthread, linux_thre
 
 
 void linux_message_hub_t::insert_external_message(linux_thread_message_t *msg) {
-    bool do_wake_up;
-    {
-        spinlock_acq_t acq(&incoming_messages_lock_);
-        do_wake_up = !check_and_set_is_woken_up();
-        incoming_messages_.push_back(msg);
-    }
+    push_incoming_messages(msg, msg);
+}
 
-    // Wakey wakey eggs and bakey
-    if (do_wake_up) {
+void linux_message_hub_t::push_incoming_messages(linux_thread_message_t *newest,
+                                                 linux_thread_message_t *oldest) {
+    linux_thread_message_t *head = incoming_messages_.load(std::memory_order_relaxed);
+    do {
+        oldest->incoming_next_ = head;
+    } while (!incoming_messages_.compare_exchange_weak(head, newest,
+                                                       std::memory_order_release,
+                                                       std::memory_order_relaxed));
+
+    // We only need to do a wake up if we're the first people to do a wake up, i.e.
+    // if the receiver has taken all messages pushed before ours.
+    if (head == nullptr) {
+        // Wakey wakey eggs and bakey
         event_.wakey_wakey();
     }
 }
 
+bool linux_message_hub_t::has_waiting_messages() const {
+    // That includes the messages that our thread sent itself since the current event
+    // loop pass began.
+    if (incoming_messages_.load(std::memory_order_relaxed) != nullptr
+        || !queues_[current_thread_.threadnum].msg_local_list.empty()) {
+        return true;
+    }
+    for (int i = 0; i < NUM_SCHEDULER_PRIORITIES; ++i) {
+        if (!priority_msg_lists_[i].empty()) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool linux_message_hub_t::looks_idle() const {
+    return !processing_messages_.load(std::memory_order_relaxed)
+        && incoming_messages_.load(std::memory_order_relaxed) == nullptr;
+}
+
+uint64_t linux_message_hub_t::busy_nanos() const {
+    return busy_nanos_.load(std::memory_order_relaxed);
+}
+
+int64_t linux_message_hub_t::recent_backlog() const {
+    return recent_backlog_.load(std::memory_order_relaxed);
+}
+
 linux_message_hub_t::msg_list_t &linux_message_hub_t::get_priority_msg_list(int priority) {
     rassert(priority >= MESSAGE_SCHEDULER_MIN_PRIORITY);
     rassert(priority <= MESSAGE_SCHEDULER_MAX_PRIORITY);
@@ -122,6 +161,9 @@ void linux_message_hub_t::on_event(int events) {
     // up and so that poll-based event triggering doesn't infinite-loop.
     event_.consume_wakey_wakeys();
 
+    const ticks_t start_ticks = get_ticks();
+    processing_messages_.store(true, std::memory_order_relaxed);
+
     // Sort incoming messages into the respective priority_msg_lists_
     sort_incoming_messages_by_priority();
 
@@ -133,6 +175,7 @@ void linux_message_hub_t::on_event(int events) {
     for (int i = 0; i < NUM_SCHEDULER_PRIORITIES; ++i) {
         total_pending_msgs += priority_msg_lists_[i].size();
     }
+    recent_backlog_.store(total_pending_msgs, std::memory_order_relaxed);
     const size_t effective_granularity = std::min(total_pending_msgs,
                                                   static_cast<size_t>(MESSAGE_SCHEDULER_GRANULARITY));
 
@@ -171,6 +214,11 @@ void linux_message_hub_t::on_event(int events) {
         }
     }
 
+    processing_messages_.store(false, std::memory_order_relaxed);
+    busy_nanos_.store(busy_nanos_.load(std::memory_order_relaxed)
+                      + (get_ticks().nanos - start_ticks.nanos),
+                      std::memory_order_relaxed);
+
     // We might have left some messages unprocessed.
     // Check if that is the case, and if yes, make sure we are called again.
     for (int i = 0; i < NUM_SCHEDULER_PRIORITIES; ++i) {
@@ -178,12 +226,10 @@ void linux_message_hub_t::on_event(int events) {
             // Place wakey_wakey and then yield to the event processing.
             // It will wake us up again immediately, but can handle a few
             // OS events (such as timers, network messages etc.) in the meantime.
-            bool do_wake_up;
-            {
-                spinlock_acq_t acq(&incoming_messages_lock_);
-                do_wake_up = !check_and_set_is_woken_up();
-            }
-            if (do_wake_up) {
+            // If there are incoming messages, whoever pushed the first of them has
+            // already woken us up.  (If one gets pushed right after we check, we just
+            // get woken up twice.)
+            if (incoming_messages_.load(std::memory_order_relaxed) == nullptr) {
                 event_.wakey_wakey();
             }
             break;
@@ -192,22 +238,21 @@ void linux_message_hub_t::on_event(int events) {
 }
 
 void linux_message_hub_t::sort_incoming_messages_by_priority() {
-    // We do this in two steps to release the spinlock faster.
-    // append_and_clear is a very cheap operation, while
-    // assigning each message to a different priority queue
-    // is more expensive.
-
-    // 1. Pull the messages
-    msg_list_t new_messages;
-    {
-        spinlock_acq_t acq(&incoming_messages_lock_);
-        new_messages.append_and_clear(&incoming_messages_);
-        is_woken_up_ = false;
+    // 1. Take all the messages, newest first, and reverse their order.
+    linux_thread_message_t *newest
+        = incoming_messages_.exchange(nullptr, std::memory_order_acquire);
+    linux_thread_message_t *oldest = nullptr;
+    while (newest != nullptr) {
+        linux_thread_message_t *next = newest->incoming_next_;
+        newest->incoming_next_ = oldest;
+        oldest = newest;
+        newest = next;
     }
 
     // 2. Sort the messages into their respective priority queues
-    while (linux_thread_message_t *m = new_messages.head()) {
-        new_messages.remove(m);
+    while (linux_thread_message_t *m = oldest) {
+        oldest = m->incoming_next_;
+        m->incoming_next_ = nullptr;
         int effective_priority = m->priority;
         if (m->is_ordered) {
             // Ordered messages are treated as if they had
@@ -221,38 +266,22 @@ void linux_message_hub_t::sort_incoming_messages_by_priority() {
     }
 }
 
-bool linux_message_hub_t::check_and_set_is_woken_up() {
-    const bool was_woken_up = is_woken_up_;
-    is_woken_up_ = true;
-    return was_woken_up;
-}
-
-// Pushes messages collected locally global lists available to all
-// threads.
+// Pushes messages collected locally onto the incoming message stacks of the
+// threads they are for.
 void linux_message_hub_t::push_messages() {
     for (int i = 0; i < thread_pool_->n_threads; i++) {
-        // Append the local list for ith thread to that thread's global
-        // message list.
         thread_queue_t *queue = &queues_[i];
         if (!queue->msg_local_list.empty()) {
-            // Transfer messages to the other core
-
-            bool do_wake_up;
-            {
-                spinlock_acq_t acq(&thread_pool_->threads[i]->message_hub.incoming_messages_lock_);
-
-                // We only need to do a wake up if we're the first people to do a
-                // wake up.
-                do_wake_up =
-                    !thread_pool_->threads[i]->message_hub.check_and_set_is_woken_up();
-
-                thread_pool_->threads[i]->message_hub.incoming_messages_.append_and_clear(&queue->msg_local_list);
-            }
-
-            // Wakey wakey, perhaps eggs and bakey
-            if (do_wake_up) {
-                thread_pool_->threads[i]->message_hub.event_.wakey_wakey();
+            // Chain the messages up from the oldest to the newest, and transfer them
+            // to the other core all at once.
+            linux_thread_message_t *oldest = queue->msg_local_list.head();
+            linux_thread_message_t *newest = nullptr;
+            while (linux_thread_message_t *m = queue->msg_local_list.head()) {
+                queue->msg_local_list.remove(m);
+                m->incoming_next_ = newest;
+                newest = m;
             }
+            thread_pool_->threads[i]->message_hub.push_incoming_messages(newest, oldest);
         }
     }
 }
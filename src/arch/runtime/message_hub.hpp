@@ -4,10 +4,11 @@
 
 #include <pthread.h>
 
+#include <atomic>
+
 #include "arch/runtime/event_queue.hpp"
 #include "arch/runtime/runtime_utils.hpp"
 #include "arch/runtime/system_event.hpp"
-#include "arch/spinlock.hpp"
 #include "config/args.hpp"
 #include "containers/intrusive_list.hpp"
 #include "threading.hpp"
@@ -23,7 +24,15 @@ class linux_thread_pool_t;
 /* There is one message hub per thread, NOT one message hub for the entire program.
 
 Each message hub stores messages that are going from that message hub's home thread to
-other threads. It keeps a separate queue for messages destined for each other thread. */
+other threads. It keeps a separate queue for messages destined for each other thread.
+
+Once per event loop pass, `push_messages()` hands each of those queues to the
+destination thread's hub in one go.  Every hub receives messages through a lock-free
+stack (`incoming_messages_`) that the senders push whole batches onto with a single
+compare-and-swap.  The receiver takes the entire stack with one exchange, and puts it
+back in the order in which the messages were sent, so messages from any one thread
+are still received in the order in which that thread sent them.  Only a sender that
+finds the stack empty wakes up the receiver. */
 
 class linux_message_hub_t : private linux_event_callback_t {
 public:
@@ -48,6 +57,21 @@ public:
     // (which does not have an event queue)
     void insert_external_message(linux_thread_message_t *msg);
 
+    // Whether there are messages for our thread that wait to be processed.  Must be
+    // called on our thread.
+    bool has_waiting_messages() const;
+
+    // Whether our thread appears to have nothing to do, i.e. it isn't processing
+    // messages and has none waiting.  Can be called on any thread, but the answer may
+    // be out of date by the time the caller looks at it.
+    bool looks_idle() const;
+
+    // The total time our thread has spent processing messages, in nanoseconds, and
+    // the number of messages that were waiting for it when it last started.  Both can
+    // be read on any thread, to get an idea of how busy our thread is.
+    uint64_t busy_nanos() const;
+    int64_t recent_backlog() const;
+
     ~linux_message_hub_t();
 
 private:
@@ -55,6 +79,12 @@ private:
     // debug mode.
     void do_store_message(threadnum_t nthread, linux_thread_message_t *msg);
 
+    // Pushes a chain of messages onto incoming_messages_, and wakes up our thread if
+    // there were no incoming messages yet.  `newest` must link to the older messages
+    // through `incoming_next_`, down to `oldest`.
+    void push_incoming_messages(linux_thread_message_t *newest,
+                                linux_thread_message_t *oldest);
+
     // Moves messages from incoming_messages_ into the respective entries of
     // priority_msg_lists, depending on the messages' priorities.
     void sort_incoming_messages_by_priority();
@@ -73,11 +103,16 @@ private:
         msg_list_t msg_local_list;
     } queues_[MAX_THREADS];
 
-    // Must only be used with acquired incoming_messages_lock_
-    bool check_and_set_is_woken_up();
-    bool is_woken_up_;
-    msg_list_t incoming_messages_;
-    spinlock_t incoming_messages_lock_;
+    // The most recently pushed incoming message, which links to the ones before it
+    // through `incoming_next_`.  Null if there are no incoming messages.
+    std::atomic<linux_thread_message_t *> incoming_messages_;
+
+    // True while `on_event()` is processing messages.
+    std::atomic<bool> processing_messages_;
+
+    // Only written by our thread, see `busy_nanos()` and `recent_backlog()`.
+    std::atomic<uint64_t> busy_nanos_;
+    std::atomic<int64_t> recent_backlog_;
 
     // Use `sort_incoming_messages_by_priority()` to sort incoming_messages_ into
     // these lists.
@@ -90,7 +125,7 @@ private:
     void on_event(int events);
 
     // The eventfd (or pipe-based alternative) notified after the first incoming
-    // message is put onto incoming_messages_.
+    // message is put onto an empty incoming_messages_.
     system_event_t event_;
 
     /* The thread that we queue messages originating from. (Recall that there is one
@@ -0,0 +1,52 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#include "arch/runtime/migratable_section.hpp"
+
+#include <atomic>
+
+#include "arch/runtime/coroutines.hpp"
+#include "arch/runtime/thread_pool.hpp"
+
+namespace {
+std::atomic<int64_t> migrations(0);
+}  // namespace
+
+migratable_section_t::migratable_section_t() {
+    maybe_migrate();
+}
+
+migratable_section_t::~migratable_section_t() {
+    coro_t::move_to_thread(home_thread());
+}
+
+void migratable_section_t::yield_point() {
+    if (!maybe_migrate()) {
+        coro_t::yield();
+    }
+}
+
+int64_t migratable_section_t::num_migrations() {
+    return migrations.load(std::memory_order_relaxed);
+}
+
+bool migratable_section_t::maybe_migrate() {
+    rassert(coro_t::self() != nullptr);
+    linux_thread_pool_t *pool = linux_thread_pool_t::get_thread_pool();
+    const int current = linux_thread_pool_t::get_thread_id();
+    if (!pool->threads[current]->message_hub.has_waiting_messages()) {
+        return false;
+    }
+
+    // We start looking at the thread after ours, so that sections on different busy
+    // threads are less likely to all pick the same idle thread.
+    const int num_db_threads = get_num_db_threads();
+    for (int i = 1; i < num_db_threads; ++i) {
+        const int candidate = (current + i) % num_db_threads;
+        if (candidate != current
+            && pool->threads[candidate]->message_hub.looks_idle()) {
+            migrations.fetch_add(1, std::memory_order_relaxed);
+            coro_t::move_to_thread(threadnum_t(candidate));
+            return true;
+        }
+    }
+    return false;
+}
@@ -0,0 +1,39 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#ifndef ARCH_RUNTIME_MIGRATABLE_SECTION_HPP_
+#define ARCH_RUNTIME_MIGRATABLE_SECTION_HPP_
+
+#include "threading.hpp"
+
+/* Coroutines normally stay on the thread they were spawned on, so a CPU-heavy query
+can keep one thread busy while the others are idle.  A `migratable_section_t` marks a
+stretch of work that doesn't touch anything that is bound to a thread (such as the
+cache, stores, signals or the ReQL environment), for example serializing or sorting
+datums.  While it exists, the coroutine may get moved to an idle thread if there is
+other work waiting on the one it's running on.  When the section ends, the coroutine
+moves back to the thread on which the section began.
+
+Idle threads don't actively take work from others; instead a section checks at its
+yield points whether its thread has waiting messages, and if so, moves over to the
+first other DB thread that has neither waiting messages nor any that it's currently
+processing. */
+class migratable_section_t : public home_thread_mixin_t {
+public:
+    // Already moves the coroutine if the thread is busy.
+    migratable_section_t();
+    ~migratable_section_t();
+
+    // Call this where the work would otherwise call `coro_t::yield()`.  Either moves
+    // the coroutine to an idle thread, or yields.
+    void yield_point();
+
+    // The number of times that sections on any thread moved their coroutine.
+    static int64_t num_migrations();
+
+private:
+    // Returns true if it moved the coroutine.
+    bool maybe_migrate();
+
+    DISABLE_COPYING(migratable_section_t);
+};
+
+#endif  // ARCH_RUNTIME_MIGRATABLE_SECTION_HPP_
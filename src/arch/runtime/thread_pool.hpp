@@ -13,6 +13,7 @@
 #include "arch/runtime/event_queue.hpp"
 #include "arch/runtime/system_event.hpp"
 #include "arch/runtime/message_hub.hpp"
+#include "arch/spinlock.hpp"
 #include "arch/runtime/coroutines.hpp"
 #include "arch/io/blocker_pool.hpp"
 #include "arch/io/timer_provider.hpp"
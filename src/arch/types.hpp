@@ -105,6 +105,13 @@ enum class file_direct_io_mode_t {
     buffered_desired
 };
 
+// Which mechanism the disk manager uses to run I/O requests.  If `io_uring_desired` is
+// chosen but the kernel doesn't support io_uring, we fall back to the blocker pool.
+enum class file_io_backend_t {
+    blocker_pool,
+    io_uring_desired
+};
+
 // A linux file.  It expects reads and writes and buffers to have an
 // alignment of DEVICE_BLOCK_SIZE.
 class file_t {
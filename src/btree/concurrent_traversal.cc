@@ -7,6 +7,8 @@
 #include <functional>
 
 #include "arch/runtime/coroutines.hpp"
+#include "btree/operations.hpp"
+#include "buffer_cache/alt.hpp"
 #include "concurrency/auto_drainer.hpp"
 #include "concurrency/semaphore.hpp"
 #include "concurrency/fifo_enforcer.hpp"
@@ -177,12 +179,37 @@ void concurrent_traversal_fifo_enforcer_signal_t::wait_with_interruptor(
     ::wait_interruptible(eval_exclusivity_signal_, interruptor);
 }
 
+/* Switches a transaction to the cache's scan account, if it uses the default one,
+and switches it back when it goes out of scope, even if the traversal throws. */
+class scan_account_switcher_t {
+public:
+    explicit scan_account_switcher_t(txn_t *_txn)
+        : txn(_txn), original_account(txn->account()) {
+        if (original_account == txn->cache()->default_reads_account()) {
+            txn->set_account(txn->cache()->scan_reads_account());
+        }
+    }
+    ~scan_account_switcher_t() {
+        txn->set_account(original_account);
+    }
+private:
+    txn_t *const txn;
+    cache_account_t *const original_account;
+    DISABLE_COPYING(scan_account_switcher_t);
+};
+
 continue_bool_t btree_concurrent_traversal(
         superblock_t *superblock,
         const key_range_t &range,
         concurrent_traversal_callback_t *cb,
         direction_t direction,
         release_superblock_t release_superblock) {
+    scoped_ptr_t<scan_account_switcher_t> account_switcher;
+    if (cb->is_scan()) {
+        account_switcher.init(
+            new scan_account_switcher_t(superblock->expose_buf().txn()));
+    }
+
     cond_t failure_cond;
     bool failure_seen;
     {
@@ -56,6 +56,12 @@ public:
 
     virtual profile::trace_t *get_trace() THROWS_NOTHING { return nullptr; }
 
+    /* Returns true if the traversal is going to load a lot of pages that nobody is
+    likely to need again soon, like a full table scan.  Unless the transaction has
+    been given a non-default cache account, the traversal then acquires its pages
+    through the cache's scan account, so that it doesn't evict the working set. */
+    virtual bool is_scan() THROWS_NOTHING { return false; }
+
 protected:
     virtual ~concurrent_traversal_callback_t() { }
 private:
@@ -0,0 +1,165 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#include "btree/internal_node_search.hpp"
+
+#include <algorithm>
+#include <limits>
+
+#if defined(__x86_64__)
+#include <immintrin.h>
+#endif
+
+#include "btree/internal_node.hpp"
+#include "btree/node.hpp"
+#include "buffer_cache/alt.hpp"
+#include "math.hpp"
+
+namespace {
+
+const size_t HEADS_PER_STEP = 4;
+
+int64_t key_head(const btree_key_t *key) {
+    uint64_t head = 0;
+    for (int i = 0; i < static_cast<int>(sizeof(head)); ++i) {
+        head <<= 8;
+        if (i < key->size) {
+            head |= key->contents[i];
+        }
+    }
+    return static_cast<int64_t>(head ^ (uint64_t(1) << 63));
+}
+
+typedef void (*count_heads_fn_t)(const int64_t *, size_t, int64_t, size_t *, size_t *);
+
+// Counts the heads less than and greater than `head`.  `count` is a multiple of
+// HEADS_PER_STEP.
+void count_heads_scalar(const int64_t *heads, size_t count, int64_t head,
+                        size_t *less_out, size_t *greater_out) {
+    size_t less = 0;
+    size_t greater = 0;
+    for (size_t i = 0; i < count; ++i) {
+        less += heads[i] < head;
+        greater += heads[i] > head;
+    }
+    *less_out = less;
+    *greater_out = greater;
+}
+
+#if defined(__x86_64__)
+
+__attribute__((target("sse4.2")))
+void count_heads_sse42(const int64_t *heads, size_t count, int64_t head,
+                       size_t *less_out, size_t *greater_out) {
+    const __m128i needle = _mm_set1_epi64x(head);
+    // The compares give -1 for every true lane, so we subtract them.
+    __m128i less = _mm_setzero_si128();
+    __m128i greater = _mm_setzero_si128();
+    for (size_t i = 0; i < count; i += 2) {
+        __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i *>(heads + i));
+        less = _mm_sub_epi64(less, _mm_cmpgt_epi64(needle, x));
+        greater = _mm_sub_epi64(greater, _mm_cmpgt_epi64(x, needle));
+    }
+    int64_t lanes[2];
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(lanes), less);
+    *less_out = lanes[0] + lanes[1];
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(lanes), greater);
+    *greater_out = lanes[0] + lanes[1];
+}
+
+__attribute__((target("avx2")))
+void count_heads_avx2(const int64_t *heads, size_t count, int64_t head,
+                      size_t *less_out, size_t *greater_out) {
+    const __m256i needle = _mm256_set1_epi64x(head);
+    __m256i less = _mm256_setzero_si256();
+    __m256i greater = _mm256_setzero_si256();
+    for (size_t i = 0; i < count; i += HEADS_PER_STEP) {
+        __m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(heads + i));
+        less = _mm256_sub_epi64(less, _mm256_cmpgt_epi64(needle, x));
+        greater = _mm256_sub_epi64(greater, _mm256_cmpgt_epi64(x, needle));
+    }
+    int64_t lanes[HEADS_PER_STEP];
+    _mm256_storeu_si256(reinterpret_cast<__m256i *>(lanes), less);
+    *less_out = lanes[0] + lanes[1] + lanes[2] + lanes[3];
+    _mm256_storeu_si256(reinterpret_cast<__m256i *>(lanes), greater);
+    *greater_out = lanes[0] + lanes[1] + lanes[2] + lanes[3];
+}
+
+count_heads_fn_t detect_count_heads() {
+    // We run during static initialization, so we need to call this first.
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) {
+        return &count_heads_avx2;
+    } else if (__builtin_cpu_supports("sse4.2")) {
+        return &count_heads_sse42;
+    } else {
+        return &count_heads_scalar;
+    }
+}
+
+const count_heads_fn_t count_heads = detect_count_heads();
+
+#else
+
+const count_heads_fn_t count_heads = &count_heads_scalar;
+
+#endif
+
+}  // namespace
+
+internal_node_search_index_t::internal_node_search_index_t(const internal_node_t *node)
+    : num_keys_(node->npairs - 1) {
+    rassert(node->npairs >= 1);
+    heads_.init(ceil_aligned(num_keys_, HEADS_PER_STEP));
+    for (int i = 0; i < num_keys_; ++i) {
+        heads_[i] = key_head(&internal_node::get_pair_by_index(node, i)->key);
+    }
+    std::fill(heads_.data() + num_keys_, heads_.data() + heads_.size(),
+              std::numeric_limits<int64_t>::max());
+}
+
+int internal_node_search_index_t::get_offset_index(const internal_node_t *node,
+                                                   const btree_key_t *key) const {
+    rassert(node->npairs - 1 == num_keys_);
+
+    size_t less, greater;
+    count_heads(heads_.data(), heads_.size(), key_head(key), &less, &greater);
+
+    // The keys before `lo` are less than `key` and the keys from `hi` on are greater
+    // (the padding counts as greater, unless `key`'s head is INT64_MAX itself).  The
+    // keys in between have the same head as `key`.
+    const int lo = less;
+    const int hi = std::min<int>(heads_.size() - greater, num_keys_);
+    if (lo == hi) {
+        return lo;
+    }
+    return std::lower_bound(node->pair_offsets + lo, node->pair_offsets + hi,
+                            static_cast<uint16_t>(internal_key_comp::faux_offset),
+                            internal_key_comp(node, key))
+        - node->pair_offsets;
+}
+
+size_t internal_node_search_index_t::memory_usage() const {
+    return sizeof(*this) + heads_.size() * sizeof(int64_t);
+}
+
+bool internal_node_search_index_t::is_avx2_accelerated() {
+#if defined(__x86_64__)
+    return count_heads == &count_heads_avx2;
+#else
+    return false;
+#endif
+}
+
+block_id_t internal_node_lookup_with_index(buf_read_t *read,
+                                           const internal_node_t *node,
+                                           const btree_key_t *key) {
+    const internal_node_search_index_t *index
+        = static_cast<internal_node_search_index_t *>(read->get_derived_data());
+    if (index == nullptr) {
+        scoped_ptr_t<internal_node_search_index_t> new_index(
+            new internal_node_search_index_t(node));
+        index = new_index.get();
+        read->set_derived_data(std::move(new_index));
+    }
+    return internal_node::get_pair_by_index(
+        node, index->get_offset_index(node, key))->lnode;
+}
@@ -0,0 +1,59 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#ifndef BTREE_INTERNAL_NODE_SEARCH_HPP_
+#define BTREE_INTERNAL_NODE_SEARCH_HPP_
+
+#include <stdint.h>
+
+#include "buffer_cache/page.hpp"
+#include "containers/scoped.hpp"
+#include "serializer/types.hpp"
+
+class buf_read_t;
+struct btree_key_t;
+struct internal_node_t;
+
+/* An in-memory search index for an internal node.  It packs the first eight bytes
+of every key into one array, big-endian, so that comparing two of them as integers
+orders them like the keys.  A lookup counts how many of these key heads are below
+and above the search key's head with SSE4.2 or AVX2 compares, and only compares full
+keys among the ones that tie.  `internal_node::get_offset_index()` instead binary
+searches through `pair_offsets`, touching a cold cache line on every step.
+
+The index is kept as the node's `alt::page_derived_data_t`, so it gets built the
+first time a read looks something up in the cached node, and is dropped when the
+node is modified or evicted. */
+class internal_node_search_index_t : public alt::page_derived_data_t {
+public:
+    explicit internal_node_search_index_t(const internal_node_t *node);
+
+    // Equivalent to `internal_node::get_offset_index(node, key)`.  `node` must be the
+    // node the index was built from.
+    int get_offset_index(const internal_node_t *node, const btree_key_t *key) const;
+
+    size_t memory_usage() const;
+
+    // Returns true if the CPU lets us use AVX2 compares (otherwise we use SSE4.2, or
+    // plain integer compares).
+    static bool is_avx2_accelerated();
+
+private:
+    // The number of keys, not counting the last pair's empty key.
+    int num_keys_;
+
+    // The key heads, with their top bit flipped so that the signed compares that SSE
+    // and AVX2 offer order them like unsigned ones.  Padded with INT64_MAX up to a
+    // multiple of four entries.
+    scoped_array_t<int64_t> heads_;
+
+    DISABLE_COPYING(internal_node_search_index_t);
+};
+
+/* Returns the child of the internal node in `read` that `key` belongs under, like
+`internal_node::lookup()`, but through the node's search index, which it builds if
+the cached node doesn't have one yet.  `read` must be on a block acquired for
+read. */
+block_id_t internal_node_lookup_with_index(buf_read_t *read,
+                                           const internal_node_t *node,
+                                           const btree_key_t *key);
+
+#endif  // BTREE_INTERNAL_NODE_SEARCH_HPP_
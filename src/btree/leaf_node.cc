@@ -1177,6 +1177,34 @@ bool is_mergable(value_sizer_t *sizer, const leaf_node_t *node, const leaf_node_
     return is_underfull(sizer, node) && is_underfull(sizer, sibling);
 }
 
+// Compares left and right, which are known to agree on their first `skip` bytes,
+// and sets *common_prefix_out to the length of their common prefix.
+int btree_key_cmp_after_prefix(const btree_key_t *left, const btree_key_t *right,
+                               int skip, int *common_prefix_out) {
+    const int n = std::min(left->size, right->size);
+    rassert(skip <= n);
+    int i = skip;
+    // Skip over equal words first, since with long shared prefixes (as sindex keys
+    // have) that's where the time goes.
+    for (; i + static_cast<int>(sizeof(uint64_t)) <= n; i += sizeof(uint64_t)) {
+        uint64_t x, y;
+        memcpy(&x, left->contents + i, sizeof(x));
+        memcpy(&y, right->contents + i, sizeof(y));
+        if (x != y) {
+            break;
+        }
+    }
+    while (i < n && left->contents[i] == right->contents[i]) {
+        ++i;
+    }
+    *common_prefix_out = i;
+    if (i < n) {
+        return static_cast<int>(left->contents[i]) - static_cast<int>(right->contents[i]);
+    } else {
+        return static_cast<int>(left->size) - static_cast<int>(right->size);
+    }
+}
+
 // Sets *index_out to the index for the live entry or deletion entry
 // for the key, or to the index the key would have if it were
 // inserted.  Returns true if the key at said index is actually equal.
@@ -1187,20 +1215,30 @@ bool find_key(const leaf_node_t *node, const btree_key_t *key, int *index_out) {
     // beg == 0 or key > *(beg - 1).
     // end == num_pairs or key < *end.
 
+    // The lengths of key's common prefixes with *(beg - 1) and *end (or 0).  Every
+    // key in [beg, end) shares the first min(beg_prefix, end_prefix) bytes with key,
+    // so we don't need to compare those again.
+    int beg_prefix = 0;
+    int end_prefix = 0;
+
     while (beg < end) {
         // when (end - beg) > 0, (end - beg) / 2 is always less than (end - beg).  So beg <= test_point < end.
         int test_point = beg + (end - beg) / 2;
 
         const btree_key_t *ek = entry_key(get_entry(node, node->pair_offsets[test_point]));
 
-        int res = btree_key_cmp(key, ek);
+        int prefix;
+        int res = btree_key_cmp_after_prefix(key, ek, std::min(beg_prefix, end_prefix),
+                                             &prefix);
 
         if (res < 0) {
             // key < *test_point.
             end = test_point;
+            end_prefix = prefix;
         } else if (res > 0) {
             // key > *test_point.  Since test_point < end, we have test_point + 1 <= end.
             beg = test_point + 1;
+            beg_prefix = prefix;
         } else {
             // We found the key!
             *index_out = test_point;
@@ -4,6 +4,7 @@
 #include <stdint.h>
 
 #include "btree/internal_node.hpp"
+#include "btree/internal_node_search.hpp"
 #include "buffer_cache/alt.hpp"
 #include "buffer_cache/blob.hpp"
 #include "containers/archive/vector_stream.hpp"
@@ -515,8 +516,8 @@ void find_keyvalue_location_for_read(
                 break;
             }
 
-            node_id = internal_node::lookup(static_cast<const internal_node_t *>(data),
-                                            key);
+            node_id = internal_node_lookup_with_index(
+                &read, static_cast<const internal_node_t *>(data), key);
         }
         rassert(node_id != NULL_BLOCK_ID && node_id != SUPERBLOCK_ID);
 
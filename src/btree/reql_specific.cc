@@ -172,7 +172,8 @@ btree_slice_t::btree_slice_t(cache_t *c, perfmon_collection_t *parent,
     : stats(parent,
             (index_type == index_type_t::SECONDARY ? "index-" : "") + identifier),
       cache_(c),
-      backfill_account_(cache()->create_cache_account(BACKFILL_CACHE_PRIORITY)) { }
+      backfill_account_(cache()->create_cache_account(BACKFILL_CACHE_PRIORITY,
+                                                      cache_access_pattern_t::scan)) { }
 
 btree_slice_t::~btree_slice_t() { }
 
@@ -14,6 +14,7 @@ using alt::block_version_t;
 using alt::current_page_acq_t;
 using alt::page_acq_t;
 using alt::page_cache_t;
+using alt::page_derived_data_t;
 using alt::page_t;
 using alt::page_txn_t;
 using alt::throttler_acq_t;
@@ -111,8 +112,9 @@ cache_t::~cache_t() {
     guarantee(snapshot_nodes_by_block_id_.empty());
 }
 
-cache_account_t cache_t::create_cache_account(int priority) {
-    return page_cache_.create_cache_account(priority);
+cache_account_t cache_t::create_cache_account(
+        int priority, cache_access_pattern_t access_pattern) {
+    return page_cache_.create_cache_account(priority, access_pattern);
 }
 
 alt_snapshot_node_t *
@@ -774,7 +776,7 @@ void buf_lock_t::set_recency(repli_timestamp_t recency) {
     current_page_acq_->set_recency(recency);
 }
 
-page_t *buf_lock_t::get_held_page_for_read() {
+page_t *buf_lock_t::get_held_page_for_read(cache_account_t *account) {
     guarantee(!empty());
     current_page_acq_t *cpa = current_page_acq();
     guarantee(cpa != nullptr);
@@ -783,7 +785,7 @@ page_t *buf_lock_t::get_held_page_for_read() {
 
     ASSERT_FINITE_CORO_WAITING;
     guarantee(!empty());
-    return cpa->current_page_for_read(txn()->account());
+    return cpa->current_page_for_read(account);
 }
 
 page_t *buf_lock_t::get_held_page_for_write() {
@@ -798,7 +800,10 @@ page_t *buf_lock_t::get_held_page_for_write() {
 }
 
 buf_read_t::buf_read_t(buf_lock_t *lock)
-    : lock_(lock) {
+    : buf_read_t(lock, lock->txn()->account()) { }
+
+buf_read_t::buf_read_t(buf_lock_t *lock, cache_account_t *account)
+    : lock_(lock), account_(account) {
     guarantee(!lock_->empty());
     lock_->access_ref_count_++;
 }
@@ -809,16 +814,29 @@ buf_read_t::~buf_read_t() {
 }
 
 const void *buf_read_t::get_data_read(uint16_t *block_size_out) {
-    page_t *page = lock_->get_held_page_for_read();
+    page_t *page = lock_->get_held_page_for_read(account_);
     if (!page_acq_.has()) {
-        page_acq_.init(page, &lock_->cache()->page_cache_,
-                       lock_->txn()->account());
+        page_acq_.init(page, &lock_->cache()->page_cache_, account_);
     }
     page_acq_.buf_ready_signal()->wait();
     *block_size_out = page_acq_.get_buf_size().value();
     return page_acq_.get_buf_read();
 }
 
+page_derived_data_t *buf_read_t::get_derived_data() {
+    guarantee(lock_->access() == access_t::read);
+    uint16_t block_size;
+    get_data_read(&block_size);
+    return page_acq_.get_derived_data();
+}
+
+void buf_read_t::set_derived_data(scoped_ptr_t<page_derived_data_t> &&data) {
+    guarantee(lock_->access() == access_t::read);
+    uint16_t block_size;
+    get_data_read(&block_size);
+    page_acq_.set_derived_data(std::move(data));
+}
+
 buf_write_t::buf_write_t(buf_lock_t *lock)
     : lock_(lock) {
     guarantee(lock_->access() == access_t::write);
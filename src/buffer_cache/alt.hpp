@@ -53,7 +53,23 @@ public:
     // throttling systems.  TODO: Come up with a consistent priority scheme,
     // i.e. define a "default" priority etc.  TODO: As soon as we can support it, we
     // might consider supporting a mem_cap parameter.
-    cache_account_t create_cache_account(int priority);
+    cache_account_t create_cache_account(
+        int priority,
+        cache_access_pattern_t access_pattern = cache_access_pattern_t::normal);
+
+    // The accounts that transactions use unless they're given another one with
+    // `txn_t::set_account()`, for normal reads and for scans.
+    cache_account_t *default_reads_account() {
+        return page_cache_.default_reads_account();
+    }
+    cache_account_t *scan_reads_account() {
+        return page_cache_.scan_reads_account();
+    }
+
+    // The memory limit that the cache balancer currently gives this cache.
+    uint64_t memory_limit() {
+        return page_cache_.evicter().memory_limit();
+    }
 
 private:
     friend class txn_t;
@@ -265,7 +281,7 @@ private:
     friend class buf_read_t;  // for get_held_page_for_read, access_ref_count_.
     friend class buf_write_t;  // for get_held_page_for_write, access_ref_count_.
 
-    alt::page_t *get_held_page_for_read();
+    alt::page_t *get_held_page_for_read(cache_account_t *account);
     alt::page_t *get_held_page_for_write();
 
     txn_t *txn_;
@@ -325,6 +341,8 @@ private:
 class buf_read_t {
 public:
     explicit buf_read_t(buf_lock_t *lock);
+    // Loads the block through `account` instead of the transaction's account.
+    buf_read_t(buf_lock_t *lock, cache_account_t *account);
     ~buf_read_t();
 
     const void *get_data_read(uint16_t *block_size_out);
@@ -335,8 +353,15 @@ public:
         return data;
     }
 
+    // The alt::page_derived_data_t cached with the block, or nullptr.  Only
+    // available if the block was acquired for read, because a writer could still
+    // change the block after we derived something from it.
+    alt::page_derived_data_t *get_derived_data();
+    void set_derived_data(scoped_ptr_t<alt::page_derived_data_t> &&data);
+
 private:
     buf_lock_t *lock_;
+    cache_account_t *account_;
     alt::page_acq_t page_acq_;
 
     DISABLE_COPYING(buf_read_t);
@@ -8,6 +8,7 @@
 
 #include "buffer_cache/alt.hpp"
 #include "concurrency/pmap.hpp"
+#include "config/args.hpp"
 #include "containers/buffer_group.hpp"
 #include "containers/scoped.hpp"
 #include "math.hpp"
@@ -19,6 +20,11 @@
 // can allocate.
 const int64_t BLOB_TRAVERSAL_CONCURRENCY = 8;
 
+// The number of leaf blocks that blob_t::read_region loads concurrently for a large
+// value.  Having many adjacent blocks in flight lets the disk merge them into big
+// sequential reads.
+const int64_t BLOB_LARGE_VALUE_READ_CONCURRENCY = 64;
+
 template <class T>
 void clear_and_delete(std::vector<T *> *vec) {
     while (!vec->empty()) {
@@ -58,6 +64,11 @@ void expose_tree_from_block_ids(buf_parent_t parent, access_t mode,
                                 buffer_group_t *buffer_group_out,
                                 blob_acq_t *acq_group_out);
 
+void read_tree_from_block_ids(buf_parent_t parent, cache_account_t *account,
+                              int64_t concurrency, int levels,
+                              int64_t offset, int64_t size,
+                              const block_id_t *block_ids, char *dest);
+
 
 int small_size(const char *ref, int maxreflen) {
     // small value sizes range from 0 to maxreflen - big_size_offset(maxreflen), and
@@ -217,6 +228,8 @@ int64_t value_size(const char *ref, int maxreflen) {
 }
 
 
+const int64_t large_value_threshold = MEGABYTE;
+
 int btree_maxreflen = 251;
 block_magic_t internal_node_magic = { { 'l', 'a', 'r', 'i' } };
 block_magic_t leaf_node_magic = { { 'l', 'a', 'r', 'l' } };
@@ -362,6 +375,39 @@ void blob_t::expose_all(buf_parent_t parent, access_t mode,
     expose_region(parent, mode, 0, valuesize(), buffer_group_out, acq_group_out);
 }
 
+void blob_t::read_region(buf_parent_t parent, int64_t offset, int64_t size,
+                         char *dest) {
+    if (size == 0) {
+        return;
+    }
+
+    if (blob::is_small(ref_, maxreflen_)) {
+        rassert(0 <= offset && offset + size <= blob::small_size(ref_, maxreflen_));
+        memcpy(dest, blob::small_buffer(ref_, maxreflen_) + offset, size);
+        return;
+    }
+
+    txn_t *txn = parent.txn();
+    cache_account_t *account = txn->account();
+    int64_t concurrency = BLOB_TRAVERSAL_CONCURRENCY;
+    if (valuesize() >= blob::large_value_threshold) {
+        if (account == txn->cache()->default_reads_account()) {
+            account = txn->cache()->scan_reads_account();
+        }
+        concurrency = BLOB_LARGE_VALUE_READ_CONCURRENCY;
+    }
+
+    const int levels = blob::ref_info(parent.cache()->max_block_size(),
+                                      ref_, maxreflen_).levels;
+    blob::read_tree_from_block_ids(parent, account, concurrency, levels,
+                                   offset, size,
+                                   blob::block_ids(ref_, maxreflen_), dest);
+}
+
+void blob_t::read_all(buf_parent_t parent, char *dest) {
+    read_region(parent, 0, valuesize(), dest);
+}
+
 namespace blob {
 
 struct region_tree_filler_t {
@@ -488,6 +534,41 @@ void expose_tree_from_block_ids(buf_parent_t parent, access_t mode,
     delete[] tree;
 }
 
+// Copies [offset, offset + size) of the subtree with the given block ids to dest.
+void read_tree_from_block_ids(buf_parent_t parent, cache_account_t *account,
+                              int64_t concurrency, int levels,
+                              int64_t offset, int64_t size,
+                              const block_id_t *block_ids, char *dest) {
+    rassert(size > 0);
+    const max_block_size_t block_size = parent.cache()->max_block_size();
+
+    int lo, hi;
+    compute_acquisition_offsets(block_size, levels, offset, size, &lo, &hi);
+    const int64_t step = stepsize(block_size, levels);
+
+    auto read_index = [&](int i) {
+        int64_t suboffset, subsize;
+        shrink(block_size, levels, offset, size, lo + i, &suboffset, &subsize);
+        char *subdest = dest + ((lo + i) * step + suboffset - offset);
+
+        buf_lock_t lock(parent, block_ids[lo + i], access_t::read);
+        buf_read_t lock_read(&lock, account);
+        if (levels > 1) {
+            read_tree_from_block_ids(buf_parent_t(&lock), account, concurrency,
+                                     levels - 1, suboffset, subsize,
+                                     internal_node_block_ids(lock_read.get_data_read()),
+                                     subdest);
+        } else {
+            uint16_t unused_block_size;
+            const char *data = leaf_node_data(lock_read.get_data_read(&unused_block_size));
+            memcpy(subdest, data + suboffset, subsize);
+        }
+    };
+
+    // As in make_tree_from_block_ids, we only parallelize on the lowest level.
+    throttled_pmap(hi - lo, read_index, levels > 1 ? 1 : concurrency);
+}
+
 }  // namespace blob
 
 void blob_t::append_region(buf_parent_t parent, int64_t size) {
@@ -119,6 +119,9 @@ const block_id_t *internal_node_block_ids(const void *buf);
 // Returns offset and size, clamped to and relative to the index'th subtree.
 void shrink(max_block_size_t block_size, int levels, int64_t offset, int64_t size, int index, int64_t *suboffset_out, int64_t *subsize_out);
 
+// Blobs at least this large take the large value path in blob_t::read_region.
+extern const int64_t large_value_threshold;
+
 // The maxreflen value (allegedly) appropriate for use with rdb_protocol btrees.
 // It's 251.  This should be renamed.
 extern int btree_maxreflen;
@@ -184,6 +187,16 @@ public:
                     buffer_group_t *buffer_group_out,
                     blob_acq_t *acq_group_out);
 
+    // Copies the size bytes of the blob starting at offset into dest.  Unlike
+    // expose_region, this doesn't hold on to the blob's buffers: leaf blocks are
+    // acquired a few at a time, copied out and released.  Blobs of at least
+    // blob::large_value_threshold bytes are loaded through the cache's scan account
+    // (unless the transaction has its own account), so that reading them doesn't
+    // push the btree's working set out of the cache, and with more blocks in
+    // flight at once.
+    void read_region(buf_parent_t root, int64_t offset, int64_t size, char *dest);
+    void read_all(buf_parent_t root, char *dest);
+
     // Appends size bytes of garbage data to the blob.
     void append_region(buf_parent_t root, int64_t size);
 
@@ -9,6 +9,12 @@ namespace alt {
 class page_cache_t;
 }
 
+/* Whether the pages acquired through an account are likely to be acquired again
+soon.  The evicter doesn't count acquisitions through `scan` accounts as a sign that a
+page is part of the working set, so that a large scan doesn't push the working set
+out of the cache. */
+enum class cache_access_pattern_t { normal, scan };
+
 class cache_account_t {
 public:
     cache_account_t();
@@ -19,17 +25,23 @@ public:
     file_account_t *get() const {
         return io_account_;
     }
+    cache_access_pattern_t access_pattern() const {
+        return access_pattern_;
+    }
 private:
     friend class alt::page_cache_t;
     // Takes ownership of the file_account_t pointee.
-    void init(threadnum_t thread, file_account_t *io_account);
-    cache_account_t(threadnum_t thread, file_account_t *io_account);
+    void init(threadnum_t thread, file_account_t *io_account,
+              cache_access_pattern_t access_pattern);
+    cache_account_t(threadnum_t thread, file_account_t *io_account,
+                    cache_access_pattern_t access_pattern);
     void reset();
 
     // I hate having this thread_ variable.  The file_account_t does need to be
     // destroyed on the right thread, though.
     threadnum_t thread_;
     file_account_t *io_account_;
+    cache_access_pattern_t access_pattern_;
     DISABLE_COPYING(cache_account_t);
 };
 
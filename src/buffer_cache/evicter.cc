@@ -8,9 +8,14 @@
 
 namespace alt {
 
+// With the `scan_resistant` policy, we only evict hot pages while cold pages use less
+// than this fraction of the memory limit.
+const double MIN_COLD_PAGES_FRACTION = 0.25;
+
 evicter_t::evicter_t()
     : initialized_(false),
       page_cache_(nullptr),
+      eviction_policy_(eviction_policy_t::random_sampling),
       balancer_(nullptr),
       balancer_notify_activity_boolean_(nullptr),
       throttler_(nullptr),
@@ -30,11 +35,13 @@ evicter_t::~evicter_t() {
 
 void evicter_t::initialize(page_cache_t *page_cache,
                            cache_balancer_t *balancer,
-                           alt_txn_throttler_t *throttler) {
+                           alt_txn_throttler_t *throttler,
+                           eviction_policy_t eviction_policy) {
     assert_thread();
     guarantee(balancer != nullptr);
     initialized_ = true;  // Can you really say this class is 'initialized_'?
     page_cache_ = page_cache;
+    eviction_policy_ = eviction_policy;
     memory_limit_ = balancer->base_mem_per_store();
     page_cache_ = page_cache;
     throttler_ = throttler;
@@ -154,7 +161,10 @@ void evicter_t::add_to_evictable_unbacked(page_t *page) {
 void evicter_t::add_to_evictable_disk_backed(page_t *page) {
     assert_thread();
     guarantee(initialized_);
-    evictable_disk_backed_.add(page, page->hypothetical_memory_usage(page_cache_));
+    eviction_bag_t *bag = correct_eviction_category(page);
+    rassert(bag == &evictable_disk_backed_cold_
+            || bag == &evictable_disk_backed_hot_);
+    bag->add(page, page->hypothetical_memory_usage(page_cache_));
     evict_if_necessary();
     notify_bytes_loading(page->hypothetical_memory_usage(page_cache_));
 }
@@ -165,7 +175,8 @@ void evicter_t::move_unevictable_to_evictable(page_t *page) {
     rassert(unevictable_.has_page(page));
     unevictable_.remove(page, page->hypothetical_memory_usage(page_cache_));
     eviction_bag_t *new_bag = correct_eviction_category(page);
-    rassert(new_bag == &evictable_disk_backed_
+    rassert(new_bag == &evictable_disk_backed_cold_
+            || new_bag == &evictable_disk_backed_hot_
             || new_bag == &evictable_unbacked_);
     new_bag->add(page, page->hypothetical_memory_usage(page_cache_));
     evict_if_necessary();
@@ -190,7 +201,9 @@ eviction_bag_t *evicter_t::correct_eviction_category(page_t *page) {
     } else if (!page->is_loaded()) {
         return &evicted_;
     } else if (page->is_disk_backed()) {
-        return &evictable_disk_backed_;
+        return eviction_policy_ == eviction_policy_t::scan_resistant && page->is_hot()
+            ? &evictable_disk_backed_hot_
+            : &evictable_disk_backed_cold_;
     } else {
         return &evictable_unbacked_;
     }
@@ -208,10 +221,22 @@ uint64_t evicter_t::in_memory_size() const {
     assert_thread();
     guarantee(initialized_);
     return unevictable_.size()
-        + evictable_disk_backed_.size()
+        + evictable_disk_backed_cold_.size()
+        + evictable_disk_backed_hot_.size()
         + evictable_unbacked_.size();
 }
 
+eviction_bag_t *evicter_t::bag_to_evict_from() {
+    if (evictable_disk_backed_hot_.size() == 0
+        || (evictable_disk_backed_cold_.size() > 0
+            && evictable_disk_backed_cold_.size()
+               >= memory_limit_ * MIN_COLD_PAGES_FRACTION)) {
+        return &evictable_disk_backed_cold_;
+    } else {
+        return &evictable_disk_backed_hot_;
+    }
+}
+
 void evicter_t::evict_if_necessary() THROWS_NOTHING {
     assert_thread();
     guarantee(initialized_);
@@ -230,10 +255,12 @@ void evicter_t::evict_if_necessary() THROWS_NOTHING {
     evict_if_necessary_active_ = true;
     page_t *page;
     while (in_memory_size() > memory_limit_
-           && evictable_disk_backed_.remove_oldish(&page, access_time_counter_,
-                                                   page_cache_)) {
-        evicted_.add(page, page->hypothetical_memory_usage(page_cache_));
+           && bag_to_evict_from()->remove_oldish(&page, access_time_counter_,
+                                                 page_cache_)) {
+        // Evicting the page drops its derived data, which changes its memory usage,
+        // so we add it to `evicted_` afterwards.
         page->evict_self(page_cache_);
+        evicted_.add(page, page->hypothetical_memory_usage(page_cache_));
         page_cache_->consider_evicting_current_page(page->block_id());
     }
     evict_if_necessary_active_ = false;
@@ -18,6 +18,20 @@ namespace alt {
 
 class page_cache_t;
 
+// How the evicter picks the pages to evict.
+enum class eviction_policy_t {
+    // Samples a few evictable pages at random and evicts the one that was accessed
+    // least recently.
+    random_sampling,
+    // Like `random_sampling`, but keeps the pages that have been acquired more than
+    // once (not counting scans) separate from the others, and evicts from the
+    // others first for as long as they use more than a quarter of the memory limit.
+    // A scan then only cycles through that quarter instead of evicting the working
+    // set.  This is the "2Q" algorithm, with random sampling in place of its LRU
+    // queues.
+    scan_resistant
+};
+
 class evicter_t : public home_thread_mixin_debug_only_t {
 public:
     void add_not_yet_loaded(page_t *page);
@@ -41,7 +55,8 @@ public:
 
     void initialize(page_cache_t *page_cache,
                     cache_balancer_t *balancer,
-                    alt_txn_throttler_t *throttler);
+                    alt_txn_throttler_t *throttler,
+                    eviction_policy_t eviction_policy);
     void update_memory_limit(uint64_t new_memory_limit,
                              int64_t bytes_loaded_accounted_for,
                              uint64_t access_count_accounted_for,
@@ -71,8 +86,12 @@ private:
     // Evicts any evictable pages until under the memory limit
     void evict_if_necessary() THROWS_NOTHING;
 
+    // The bag that the next page to evict should come from.
+    eviction_bag_t *bag_to_evict_from();
+
     bool initialized_;
     page_cache_t *page_cache_;
+    eviction_policy_t eviction_policy_;
     cache_balancer_t *balancer_;
     bool *balancer_notify_activity_boolean_;
 
@@ -93,9 +112,12 @@ private:
     // It avoids reentrant calls to that function.
     bool evict_if_necessary_active_;
 
-    // These track every page's eviction status.
+    // These track every page's eviction status.  Disk backed pages are split up by
+    // whether they're hot, i.e. have been acquired more than once.  With the
+    // `random_sampling` policy, `evictable_disk_backed_hot_` stays empty.
     eviction_bag_t unevictable_;
-    eviction_bag_t evictable_disk_backed_;
+    eviction_bag_t evictable_disk_backed_cold_;
+    eviction_bag_t evictable_disk_backed_hot_;
     eviction_bag_t evictable_unbacked_;
     eviction_bag_t evicted_;
 
@@ -56,6 +56,8 @@ page_t::page_t(block_id_t _block_id, page_cache_t *page_cache)
     : block_id_(_block_id),
       loader_(nullptr),
       access_time_(page_cache->evicter().next_access_time()),
+      derived_data_size_(0),
+      num_acquisitions_(0),
       snapshot_refcount_(0) {
     page_cache->evicter().add_deferred_loaded(this);
 
@@ -70,6 +72,8 @@ page_t::page_t(block_id_t _block_id, page_cache_t *page_cache,
     : block_id_(_block_id),
       loader_(nullptr),
       access_time_(page_cache->evicter().next_access_time()),
+      derived_data_size_(0),
+      num_acquisitions_(0),
       snapshot_refcount_(0) {
     page_cache->evicter().add_not_yet_loaded(this);
 
@@ -86,6 +90,8 @@ page_t::page_t(block_id_t _block_id, buf_ptr_t buf,
       loader_(nullptr),
       buf_(std::move(buf)),
       access_time_(page_cache->evicter().next_access_time()),
+      derived_data_size_(0),
+      num_acquisitions_(0),
       snapshot_refcount_(0) {
     rassert(buf_.has());
     page_cache->evicter().add_to_evictable_unbacked(this);
@@ -100,6 +106,8 @@ page_t::page_t(block_id_t _block_id,
       buf_(std::move(buf)),
       block_token_(_block_token),
       access_time_(READ_AHEAD_ACCESS_TIME),
+      derived_data_size_(0),
+      num_acquisitions_(0),
       snapshot_refcount_(0) {
     rassert(buf_.has());
     page_cache->evicter().add_to_evictable_disk_backed(this);
@@ -109,6 +117,8 @@ page_t::page_t(page_t *copyee, page_cache_t *page_cache, cache_account_t *accoun
     : block_id_(copyee->block_id_),
       loader_(nullptr),
       access_time_(page_cache->evicter().next_access_time()),
+      derived_data_size_(0),
+      num_acquisitions_(copyee->num_acquisitions_),
       snapshot_refcount_(0) {
     page_cache->evicter().add_not_yet_loaded(this);
     coro_t::spawn_now_dangerously(std::bind(&page_t::load_from_copyee,
@@ -274,6 +284,7 @@ void page_t::catch_up_with_deferred_load(
         buf = serializer->block_read(block_token_ptr->token,
                                      account->get());
     }
+    page_cache->check_block_checksum(block_token_ptr->token, buf);
 
     ASSERT_FINITE_CORO_WAITING;
     if (our_loader.abandon_page()) {
@@ -357,6 +368,7 @@ void page_t::load_with_block_id(page_t *page, block_id_t block_id,
         buf = serializer->block_read(block_token,
                                      account->get());
     }
+    page_cache->check_block_checksum(block_token, buf);
 
     ASSERT_FINITE_CORO_WAITING;
     if (loader.abandon_page()) {
@@ -413,6 +425,11 @@ void page_t::pulse_waiters_or_make_evictable(page_cache_t *page_cache) {
 void page_t::add_waiter(page_acq_t *acq, cache_account_t *account) {
     eviction_bag_t *old_bag
         = acq->page_cache()->evicter().correct_eviction_category(this);
+    if (num_acquisitions_ < 2
+        && (account == nullptr
+            || account->access_pattern() == cache_access_pattern_t::normal)) {
+        ++num_acquisitions_;
+    }
     waiters_.push_front(acq);
     acq->page_cache()->evicter().change_to_correct_eviction_bag(old_bag, this);
     if (buf_.has()) {
@@ -453,6 +470,7 @@ void page_t::load_using_block_token(page_t *page, page_cache_t *page_cache,
         buf = serializer->block_read(block_token,
                                      account->get());
     }
+    page_cache->check_block_checksum(block_token, buf);
 
     ASSERT_FINITE_CORO_WAITING;
     if (loader.abandon_page()) {
@@ -497,7 +515,7 @@ uint32_t page_t::hypothetical_memory_usage(page_cache_t *page_cache) const {
     // that assume that `hypothetical_memory_usage` doesn't change after setting
     // the block token.
     size_t base_size = sizeof(current_page_t) + sizeof(page_t) +
-        sizeof(block_token_t);
+        sizeof(block_token_t) + derived_data_size_;
     if (buf_.has()) {
         return base_size + buf_.aligned_block_size();
     } else if (block_token_.has()) {
@@ -551,6 +569,10 @@ void page_t::evict_self(DEBUG_VAR page_cache_t *page_cache) {
     rassert(block_token_.has());
     rassert(buf_.has());
     rassert(block_token_->block_size() == buf_.block_size());
+    // The page has already been taken out of its eviction bag, so we can drop the
+    // derived data without adjusting the bag's size.
+    derived_data_.reset();
+    derived_data_size_ = 0;
 #ifndef NDEBUG
     const uint32_t usage_before = hypothetical_memory_usage(page_cache);
 #endif
@@ -560,6 +582,14 @@ void page_t::evict_self(DEBUG_VAR page_cache_t *page_cache) {
     rassert(usage_before == hypothetical_memory_usage(page_cache));
 }
 
+void page_t::set_derived_data(scoped_ptr_t<page_derived_data_t> &&data,
+                              page_cache_t *page_cache) {
+    rassert(buf_.has());
+    usage_adjuster_t adjuster(page_cache, this);
+    derived_data_ = std::move(data);
+    derived_data_size_ = derived_data_.has() ? derived_data_->memory_usage() : 0;
+}
+
 ser_buffer_t *page_t::get_loaded_ser_buffer() {
     rassert(buf_.has());
     return buf_.ser_buffer();
@@ -622,6 +652,7 @@ block_size_t page_acq_t::get_buf_size() {
 
 void *page_acq_t::get_buf_write(block_size_t block_size) {
     buf_ready_signal_.wait();
+    page_->set_derived_data(scoped_ptr_t<page_derived_data_t>(), page_cache_);
     page_->reset_block_token(page_cache_);
     page_->set_page_buf_size(block_size, page_cache_);
     return page_->get_page_buf(page_cache_);
@@ -632,6 +663,16 @@ const void *page_acq_t::get_buf_read() {
     return page_->get_page_buf(page_cache_);
 }
 
+page_derived_data_t *page_acq_t::get_derived_data() {
+    buf_ready_signal_.wait();
+    return page_->derived_data();
+}
+
+void page_acq_t::set_derived_data(scoped_ptr_t<page_derived_data_t> &&data) {
+    buf_ready_signal_.wait();
+    page_->set_derived_data(std::move(data), page_cache_);
+}
+
 page_ptr_t::page_ptr_t() : page_(nullptr) {
 }
 
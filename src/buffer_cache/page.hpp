@@ -4,6 +4,7 @@
 #include "concurrency/cond_var.hpp"
 #include "containers/backindex_bag.hpp"
 #include "containers/half_intrusive_list.hpp"
+#include "containers/scoped.hpp"
 #include "repli_timestamp.hpp"
 #include "serializer/buf_ptr.hpp"
 #include "serializer/types.hpp"
@@ -19,6 +20,18 @@ class page_loader_t;
 class deferred_page_loader_t;
 class deferred_block_token_t;
 
+// An in-memory structure computed from a page's contents, such as a search index
+// for a btree node.  The page owns it and drops it whenever the page's buffer is
+// acquired for write or evicted, so it never outlives the contents it describes.
+class page_derived_data_t {
+public:
+    virtual ~page_derived_data_t() { }
+
+    // How many bytes the structure takes.  This counts towards the page's memory
+    // usage, so it must not change while the page holds it.
+    virtual size_t memory_usage() const = 0;
+};
+
 // A page_t represents a page (a byte buffer of a specific size), having a definite
 // value known at the construction of the page_t (and possibly later modified
 // in-place, but still a definite known value).
@@ -56,6 +69,10 @@ public:
     uint32_t hypothetical_memory_usage(page_cache_t *page_cache) const;
     uint64_t access_time() const { return access_time_; }
 
+    // True if the page has been acquired more than once, not counting acquisitions
+    // through scan accounts.  See `eviction_policy_t`.
+    bool is_hot() const { return num_acquisitions_ > 1; }
+
     bool is_loading() const {
         return loader_ != nullptr && page_t::loader_is_loading(loader_);
     }
@@ -76,6 +93,10 @@ public:
         return block_token_;
     }
 
+    page_derived_data_t *derived_data() const { return derived_data_.get(); }
+    void set_derived_data(scoped_ptr_t<page_derived_data_t> &&data,
+                          page_cache_t *page_cache);
+
     ser_buffer_t *get_loaded_ser_buffer();
     void init_block_token(counted_t<block_token_t> token,
                           page_cache_t *page_cache);
@@ -132,6 +153,15 @@ private:
 
     uint64_t access_time_;
 
+    // See page_derived_data_t.  Null if nobody has computed any yet.
+    scoped_ptr_t<page_derived_data_t> derived_data_;
+    // The `memory_usage()` of `derived_data_`, as of when it was attached.
+    uint32_t derived_data_size_;
+
+    // How many times the page has been acquired through a `cache_access_pattern_t::
+    // normal` account, up to 2.  Copies of a page inherit this.
+    uint8_t num_acquisitions_;
+
     // How many page_ptr_t's point at this page, expecting nothing to modify it,
     // other than themselves.
     size_t snapshot_refcount_;
@@ -146,7 +176,9 @@ private:
     // if loader_ is non-null:  unevictable_
     // else if waiters_ is non-empty: unevictable_
     // else if buf_ is null: evicted_ (and block_token_ is non-null)
-    // else if block_token_ is non-null: evictable_disk_backed_
+    // else if block_token_ is non-null: evictable_disk_backed_hot_ if the page is
+    //   hot (and the evicter is scan resistant), evictable_disk_backed_cold_
+    //   otherwise
     // else: evictable_unbacked_ (buf_ is non-null, block_token_ is null)
     //
     // So, when loader_, waiters_, buf_, or block_token_ is touched, we might
@@ -243,6 +275,11 @@ public:
     void *get_buf_write(block_size_t block_size);
     const void *get_buf_read();
 
+    // Get and attach the page's page_derived_data_t.  Only use these when the page
+    // can't be modified while the data is in use, i.e. through a read acquisition.
+    page_derived_data_t *get_derived_data();
+    void set_derived_data(scoped_ptr_t<page_derived_data_t> &&data);
+
 private:
     friend class page_t;
 
@@ -144,9 +144,31 @@ void page_cache_t::add_read_ahead_buf(block_id_t block_id,
     // no useful work to be done).
 
     buf_ptr_t buf(token->block_size(), std::move(ptr));
+    check_block_checksum(token, buf);
     current_pages_[block_id] = new current_page_t(block_id, std::move(buf), token, this);
 }
 
+void page_cache_t::check_block_checksum(const counted_t<block_token_t> &token,
+                                        const buf_ptr_t &buf) {
+    if (!block_checksum_matches(token->checksum(), buf.ser_buffer(),
+                                buf.block_size())
+        && !drainer_->is_draining()) {
+        // This may be called where we mustn't block, so we report the block in a
+        // separate coroutine.  If we're shutting down, the scrubber will find the
+        // block again.
+        const block_id_t block_id = buf.ser_buffer()->ser_header.block_id;
+        coro_t::spawn_sometime(std::bind(&page_cache_t::report_corrupt_block, this,
+                                         block_id, token, drainer_->lock()));
+    }
+}
+
+void page_cache_t::report_corrupt_block(block_id_t block_id,
+                                        const counted_t<block_token_t> &token,
+                                        auto_drainer_t::lock_t) {
+    on_thread_t thread_switcher(serializer_->home_thread());
+    serializer_->report_corrupt_block(block_id, token);
+}
+
 void page_cache_t::have_read_ahead_cb_destroyed() {
     assert_thread();
 
@@ -203,7 +225,8 @@ public:
 
 page_cache_t::page_cache_t(serializer_t *_serializer,
                            cache_balancer_t *balancer,
-                           alt_txn_throttler_t *throttler)
+                           alt_txn_throttler_t *throttler,
+                           eviction_policy_t eviction_policy)
     : max_block_size_(_serializer->max_block_size()),
       serializer_(_serializer),
       free_list_(_serializer),
@@ -223,7 +246,11 @@ page_cache_t::page_cache_t(serializer_t *_serializer,
             local_read_ahead_cb = new page_read_ahead_cb_t(_serializer, this);
         }
         default_reads_account_.init(_serializer->home_thread(),
-                                    _serializer->make_io_account(CACHE_READS_IO_PRIORITY));
+                                    _serializer->make_io_account(CACHE_READS_IO_PRIORITY),
+                                    cache_access_pattern_t::normal);
+        scan_reads_account_.init(_serializer->home_thread(),
+                                 _serializer->make_io_account(CACHE_READS_IO_PRIORITY),
+                                 cache_access_pattern_t::scan);
         index_write_sink_.init(new page_cache_index_write_sink_t);
         recencies_ = _serializer->get_all_recencies();
     }
@@ -235,7 +262,7 @@ page_cache_t::page_cache_t(serializer_t *_serializer,
     // initialize the read_ahead_cb_ after the evicter_ because that way reentrant
     // usage by the balancer (before page_cache_t construction completes) would be
     // more likely to trip an assertion.
-    evicter_.initialize(this, balancer, throttler);
+    evicter_.initialize(this, balancer, throttler, eviction_policy);
     read_ahead_cb_ = local_read_ahead_cb;
 }
 
@@ -259,10 +286,11 @@ page_cache_t::~page_cache_t() {
         /* IO accounts and a few other fields must be destroyed on the serializer
         thread. */
         on_thread_t thread_switcher(serializer_->home_thread());
-        // Resetting default_reads_account_ is opportunistically done here, instead
-        // of making its destructor switch back to the serializer thread a second
-        // time.
+        // Resetting default_reads_account_ and scan_reads_account_ is
+        // opportunistically done here, instead of making their destructors switch
+        // back to the serializer thread a second time.
         default_reads_account_.reset();
+        scan_reads_account_.reset();
         index_write_sink_.reset();
     }
 }
@@ -413,7 +441,8 @@ current_page_t *page_cache_t::internal_page_for_new_chosen(block_id_t block_id)
     return inserted_page.first->second;
 }
 
-cache_account_t page_cache_t::create_cache_account(int priority) {
+cache_account_t page_cache_t::create_cache_account(
+        int priority, cache_access_pattern_t access_pattern) {
     // We assume that a priority of 100 means that the transaction should have the
     // same priority as all the non-accounted transactions together. Not sure if this
     // makes sense.
@@ -435,7 +464,7 @@ cache_account_t page_cache_t::create_cache_account(int priority) {
                                                   outstanding_requests_limit);
     }
 
-    return cache_account_t(serializer_->home_thread(), io_account);
+    return cache_account_t(serializer_->home_thread(), io_account, access_pattern);
 }
 
 
@@ -1240,7 +1269,24 @@ void page_cache_t::do_flush_changes(page_cache_t *page_cache,
     {
         ASSERT_NO_CORO_WAITING;
 
+        // We visit the changes in block id order, because the serializer lays out the
+        // blocks we write in the order we pass them.  Blocks that were created
+        // together, like the leaf blocks of a large blob, usually have consecutive
+        // block ids, so this way they end up next to each other on disk and can be
+        // read back sequentially.
+        std::vector<std::unordered_map<block_id_t, block_change_t>::iterator>
+            sorted_changes;
+        sorted_changes.reserve(changes.size());
         for (auto it = changes.begin(); it != changes.end(); ++it) {
+            sorted_changes.push_back(it);
+        }
+        std::sort(sorted_changes.begin(), sorted_changes.end(),
+                  [](const std::unordered_map<block_id_t, block_change_t>::iterator &x,
+                     const std::unordered_map<block_id_t, block_change_t>::iterator &y) {
+                      return x->first < y->first;
+                  });
+
+        for (auto it : sorted_changes) {
             if (it->second.modified) {
                 if (it->second.page == nullptr) {
                     // The block is deleted.
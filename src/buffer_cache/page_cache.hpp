@@ -329,7 +329,9 @@ class page_cache_t : public home_thread_mixin_t {
 public:
     page_cache_t(serializer_t *serializer,
                  cache_balancer_t *balancer,
-                 alt_txn_throttler_t *throttler);
+                 alt_txn_throttler_t *throttler,
+                 eviction_policy_t eviction_policy
+                     = eviction_policy_t::scan_resistant);
     ~page_cache_t();
 
     // Takes a txn to be flushed.  Calls on_flush_complete() (which resets the
@@ -353,12 +355,19 @@ public:
 
     max_block_size_t max_block_size() const { return max_block_size_; }
 
-    cache_account_t create_cache_account(int priority);
+    cache_account_t create_cache_account(
+        int priority,
+        cache_access_pattern_t access_pattern = cache_access_pattern_t::normal);
 
     cache_account_t *default_reads_account() {
         return &default_reads_account_;
     }
 
+    // Like `default_reads_account()`, but for reads that are part of a scan.
+    cache_account_t *scan_reads_account() {
+        return &scan_reads_account_;
+    }
+
     // Considers wiping out the current_page_t (and its page_t pointee) for a
     // particular block id, to save memory, if the right conditions are met.  (This
     // should only be called by things "outside" of current_page_t, like
@@ -374,6 +383,12 @@ public:
     auto_drainer_t::lock_t drainer_lock() { return drainer_->lock(); }
     serializer_t *serializer() { return serializer_; }
 
+    // Checks a block we've loaded against the checksum that was computed when it was
+    // written.  A mismatch is reported to the serializer, which logs it and raises a
+    // data corruption issue for the table.  It doesn't crash the server.
+    void check_block_checksum(const counted_t<block_token_t> &token,
+                              const buf_ptr_t &buf);
+
 private:
     friend class page_read_ahead_cb_t;
     void add_read_ahead_buf(block_id_t block_id,
@@ -382,6 +397,9 @@ private:
 
     void read_ahead_cb_is_destroyed();
 
+    void report_corrupt_block(block_id_t block_id,
+                              const counted_t<block_token_t> &token,
+                              auto_drainer_t::lock_t);
 
     current_page_t *internal_page_for_new_chosen(block_id_t block_id);
 
@@ -458,6 +476,7 @@ private:
     // merger_serializer_t (as long as you use one, otherwise they use the
     // default account).
     cache_account_t default_reads_account_;
+    cache_account_t scan_reads_account_;
 
     // This fifo enforcement pair ensures ordering of index_write operations after we
     // move to the serializer thread and get a bunch of blocks written.
@@ -2,17 +2,22 @@
 #include "client_protocol/json.hpp"
 
 #include "arch/io/network.hpp"
+#include "arch/runtime/coroutines.hpp"
+#include "arch/runtime/migratable_section.hpp"
 #include "arch/timing.hpp"
 #include "client_protocol/protocols.hpp"
 #include "concurrency/pmap.hpp"
+#include "containers/archive/archive.hpp"
 #include "containers/scoped.hpp"
 #include "rapidjson/document.h"
 #include "rapidjson/stringbuffer.h"
 #include "rapidjson/writer.h"
+#include "rdb_protocol/datum_json_writer.hpp"
 #include "rdb_protocol/rdb_backtrace.hpp"
 #include "rdb_protocol/ql2.pb.h"
 #include "rdb_protocol/query_params.hpp"
 #include "rdb_protocol/response.hpp"
+#include "rdb_protocol/streamed_term_storage.hpp"
 #include "rdb_protocol/term_storage.hpp"
 #include "utils.hpp"
 
@@ -45,6 +50,51 @@ scoped_ptr_t<ql::query_params_t> json_protocol_t::parse_query_from_buffer(
     return res;
 }
 
+scoped_ptr_t<ql::query_params_t> json_protocol_t::parse_query_from_stream(
+        read_stream_t *stream, size_t size,
+        ql::query_cache_t *query_cache, int64_t token,
+        ql::response_t *error_out) {
+    scoped_ptr_t<ql::streamed_term_storage_t> term_storage(
+        new ql::streamed_term_storage_t());
+
+    scoped_ptr_t<ql::query_params_t> res;
+    try {
+        if (term_storage->parse(stream, size)) {
+            res = make_scoped<ql::query_params_t>(token, query_cache,
+                    scoped_ptr_t<ql::term_storage_t>(term_storage.release()));
+        } else {
+            error_out->fill_error(Response::CLIENT_ERROR,
+                                  Response::RESOURCE_LIMIT,
+                                  wire_protocol_t::unparseable_query_message,
+                                  ql::backtrace_registry_t::EMPTY_BACKTRACE);
+        }
+    } catch (const ql::bt_exc_t &ex) {
+        error_out->fill_error(Response::CLIENT_ERROR,
+                              ex.error_type,
+                              strprintf("Server could not parse query: %s",
+                                        ex.message.c_str()),
+                              ex.bt_datum);
+    }
+    return res;
+}
+
+// Reads the body of a query straight from the connection.
+class query_read_stream_t : public read_stream_t {
+public:
+    query_read_stream_t(tcp_conn_t *_conn, signal_t *_interruptor) :
+        conn(_conn), interruptor(_interruptor) { }
+
+    MUST_USE int64_t read(void *p, int64_t n) {
+        return conn->read_some(p, n, interruptor);
+    }
+
+private:
+    tcp_conn_t *conn;
+    signal_t *interruptor;
+
+    DISABLE_COPYING(query_read_stream_t);
+};
+
 scoped_ptr_t<ql::query_params_t> json_protocol_t::parse_query(
         tcp_conn_t *conn,
         signal_t *interruptor,
@@ -79,16 +129,23 @@ scoped_ptr_t<ql::query_params_t> json_protocol_t::parse_query(
         throw tcp_conn_read_closed_exc_t();
     }
 
-    scoped_array_t<char> data(size + 1);
-    // It's *usually* more efficient to do an un-buffered read here. The client is
-    // usually not going to group multiple queries into the same network package
-    // (especially not with tcp_nodelay set), and using the non-buffered `read` can
-    // avoid an extra copy.
-    conn->read(data.data(), size, interruptor);
-    data[size] = 0; // Null terminate the string, which the json parser requires
+    scoped_ptr_t<ql::query_params_t> res;
+    if (size >= wire_protocol_t::MIN_STREAMED_QUERY_SIZE) {
+        // Large queries are usually bulk inserts.  Parsing them as they are read
+        // saves holding both the query text and a `rapidjson::Document` for it.
+        query_read_stream_t stream(conn, interruptor);
+        res = parse_query_from_stream(&stream, size, query_cache, token, &error);
+    } else {
+        scoped_array_t<char> data(size + 1);
+        // It's *usually* more efficient to do an un-buffered read here. The client
+        // is usually not going to group multiple queries into the same network
+        // package (especially not with tcp_nodelay set), and using the
+        // non-buffered `read` can avoid an extra copy.
+        conn->read(data.data(), size, interruptor);
+        data[size] = 0; // Null terminate the string, which the json parser requires
 
-    scoped_ptr_t<ql::query_params_t> res =
-        parse_query_from_buffer(std::move(data), 0, query_cache, token, &error);
+        res = parse_query_from_buffer(std::move(data), 0, query_cache, token, &error);
+    }
 
     if (!res.has()) {
         send_response(&error, token, conn, interruptor);
@@ -96,82 +153,113 @@ scoped_ptr_t<ql::query_params_t> json_protocol_t::parse_query(
     return res;
 }
 
+// Responses with more items than this are encoded on several threads.
+const size_t PARALLELIZATION_THRESHOLD = 500;
+
+// Large responses are written to the connection as they are encoded, this many
+// bytes at a time.
+const size_t RESPONSE_CHUNK_SIZE = 64 * KILOBYTE;
+
+int64_t num_response_threads() {
+    return std::min<int64_t>(16, get_num_db_threads());
+}
+
+// Writes `response` as JSON, calling `write_data` to write the items of its `r`
+// array.
+template <class callable_t>
+void write_response_fields(ql::response_t *response,
+                           ql::datum_json_writer_t *writer,
+                           callable_t &&write_data) {
+    writer->StartObject();
+    writer->Key("t", 1);
+    writer->Int(response->type());
+    if (response->type() == Response::RUNTIME_ERROR &&
+        response->error_type()) {
+        writer->Key("e", 1);
+        writer->Int(*response->error_type());
+    }
+
+    writer->Key("r", 1);
+    writer->StartArray();
+    write_data();
+    writer->EndArray();
+    if (response->backtrace()) {
+        writer->Key("b", 1);
+        response->backtrace()->write_json(writer);
+    }
+    if (response->profile()) {
+        writer->Key("p", 1);
+        response->profile()->write_json(writer);
+    }
+    if (response->type() == Response::SUCCESS_PARTIAL ||
+        response->type() == Response::SUCCESS_SEQUENCE) {
+        writer->Key("n", 1);
+        writer->StartArray();
+        for (const auto &note : response->notes()) {
+            writer->Int(note);
+        }
+        writer->EndArray();
+    }
+    writer->EndObject();
+}
+
+// Splits `data` into `buffers->size()` slices and writes each one as a JSON array
+// into its buffer, on a different thread.  `after_item(m)` is called on that thread
+// after each item of the `m`th slice is written.
+template <class callable_t>
+void write_data_slices(const std::vector<ql::datum_t> &data,
+                       std::vector<rapidjson::StringBuffer> *buffers,
+                       callable_t &&after_item) {
+    int64_t num_threads = buffers->size();
+    int32_t thread_offset = get_thread_id().threadnum;
+    size_t per_thread = data.size() / num_threads;
+    pmap(num_threads, [&](int64_t m) {
+            int32_t target_thread =
+                (thread_offset + static_cast<int32_t>(m)) % get_num_db_threads();
+            on_thread_t rethreader((threadnum_t(target_thread)));
+            // Writing datums doesn't depend on the thread, so if the target
+            // thread is busy, we let an idle one do it.
+            migratable_section_t migratable;
+            rapidjson::StringBuffer *thread_buffer = &(*buffers)[m];
+            ql::datum_json_writer_t thread_writer(*thread_buffer);
+
+            thread_writer.StartArray();
+            size_t offset = per_thread * m;
+            size_t end = (m == num_threads - 1) ? data.size() : (per_thread * (m + 1));
+
+            for (size_t i = offset; i < end; ++i) {
+                const size_t YIELD_INTERVAL = 2000;
+                if ((i + 1) % YIELD_INTERVAL == 0) {
+                    migratable.yield_point();
+                }
+                data[i].write_json(&thread_writer);
+                after_item(m);
+            }
+
+            thread_writer.EndArray();
+        });
+}
+
 void write_response_internal(ql::response_t *response,
                              rapidjson::StringBuffer *buffer_out,
                              bool throw_errors) {
-    rapidjson::Writer<rapidjson::StringBuffer> writer(*buffer_out);
+    ql::datum_json_writer_t writer(*buffer_out);
     size_t start_offset = buffer_out->GetSize();
 
     try {
-        writer.StartObject();
-        writer.Key("t", 1);
-        writer.Int(response->type());
-        if (response->type() == Response::RUNTIME_ERROR &&
-            response->error_type()) {
-            writer.Key("e", 1);
-            writer.Int(*response->error_type());
-        }
-
-        writer.Key("r", 1);
-        writer.StartArray();
-        const size_t PARALLELIZATION_THRESHOLD = 500;
-        if (response->data().size() > PARALLELIZATION_THRESHOLD) {
-            int64_t num_threads = std::min<int64_t>(16, get_num_db_threads());
-            int32_t thread_offset = get_thread_id().threadnum;
-            std::vector<rapidjson::StringBuffer> buffers(num_threads);
-
-            size_t per_thread = response->data().size() / num_threads;
-            pmap(num_threads, [&](int64_t m) {
-                    int32_t target_thread =
-                        (thread_offset + static_cast<int32_t>(m)) % get_num_db_threads();
-                    on_thread_t rethreader((threadnum_t(target_thread)));
-                    rapidjson::StringBuffer *thread_buffer = &buffers[m];
-                    rapidjson::Writer<rapidjson::StringBuffer>
-                        thread_writer(*thread_buffer);
-
-                    thread_writer.StartArray();
-                    size_t offset = per_thread * m;
-                    size_t end = (m == num_threads - 1) ?
-                        response->data().size() : (per_thread * (m + 1));
-
-                    for (size_t i = offset; i < end; ++i) {
-                        const size_t YIELD_INTERVAL = 2000;
-                        if ((i + 1) % YIELD_INTERVAL == 0) {
-                            coro_t::yield();
-                        }
-                        response->data()[i].write_json(&thread_writer);
-                    }
-
-                    thread_writer.EndArray();
-                });
-
-            for (const auto &buffer : buffers) {
-                writer.SpliceArray(buffer);
+        write_response_fields(response, &writer, [&]() {
+            if (response->data().size() > PARALLELIZATION_THRESHOLD) {
+                std::vector<rapidjson::StringBuffer> buffers(num_response_threads());
+                write_data_slices(response->data(), &buffers, [](int64_t) { });
+                for (const auto &buffer : buffers) {
+                    writer.SpliceArray(buffer);
+                }
+            } else {
+                for (const auto &item : response->data()) {
+                    item.write_json(&writer);
+                }
             }
-        } else {
-            for (const auto &item : response->data()) {
-                item.write_json(&writer);
-            }
-        }
-        writer.EndArray();
-        if (response->backtrace()) {
-            writer.Key("b", 1);
-            response->backtrace()->write_json(&writer);
-        }
-        if (response->profile()) {
-            writer.Key("p", 1);
-            response->profile()->write_json(&writer);
-        }
-        if (response->type() == Response::SUCCESS_PARTIAL ||
-            response->type() == Response::SUCCESS_SEQUENCE) {
-            writer.Key("n", 1);
-            writer.StartArray();
-            for (const auto &note : response->notes()) {
-                writer.Int(note);
-            }
-            writer.EndArray();
-        }
-        writer.EndObject();
+        });
         guarantee(writer.IsComplete());
     } catch (const ql::base_exc_t &ex) {
         buffer_out->Pop(buffer_out->GetSize() - start_offset);
@@ -201,10 +289,138 @@ void json_protocol_t::write_response_to_buffer(ql::response_t *response,
 #endif
 }
 
+// Returns the size of the JSON that `write_response_to_buffer` would write for
+// `response`, without keeping all of it in memory.  The items are encoded on
+// several threads, into buffers that are emptied as they fill up.
+size_t encoded_response_size(ql::response_t *response) {
+    rapidjson::StringBuffer buffer;
+    ql::datum_json_writer_t writer(buffer);
+    write_response_fields(response, &writer, []() { });
+    size_t size = buffer.GetSize();
+
+    std::vector<rapidjson::StringBuffer> buffers(num_response_threads());
+    std::vector<size_t> flushed_sizes(buffers.size(), 0);
+    write_data_slices(response->data(), &buffers, [&](int64_t m) {
+            if (buffers[m].GetSize() >= RESPONSE_CHUNK_SIZE) {
+                flushed_sizes[m] += buffers[m].GetSize();
+                buffers[m].Clear();
+            }
+        });
+
+    // Each slice was written as an array, so we drop its brackets, and add the
+    // commas that go between the slices that aren't empty.
+    size_t num_nonempty_slices = 0;
+    for (size_t m = 0; m < buffers.size(); ++m) {
+        const size_t slice_size = flushed_sizes[m] + buffers[m].GetSize();
+        if (slice_size > 2) {
+            size += slice_size - 2;
+            ++num_nonempty_slices;
+        }
+    }
+    if (num_nonempty_slices > 0) {
+        size += num_nonempty_slices - 1;
+    }
+    return size;
+}
+
+// Writes the token and the size that go before a response.
+void write_response_header(int64_t token, uint32_t data_size, char *out) {
+#ifdef __s390x__
+    token = __builtin_bswap64(token);
+#endif
+    for (size_t i = 0; i < sizeof(token); ++i) {
+        out[i] = reinterpret_cast<const char *>(&token)[i];
+    }
+
+#ifdef __s390x__
+    data_size = __builtin_bswap32(data_size);
+#endif
+    for (size_t i = 0; i < sizeof(data_size); ++i) {
+        out[i + sizeof(token)] = reinterpret_cast<const char *>(&data_size)[i];
+    }
+}
+
+bool json_protocol_t::write_response_in_chunks(ql::response_t *response,
+                                               int64_t token,
+                                               write_stream_t *stream) {
+    size_t payload_size;
+    try {
+        payload_size = encoded_response_size(response);
+    } catch (const std::exception &) {
+        return false;
+    }
+    if (payload_size >= wire_protocol_t::TOO_LARGE_RESPONSE_SIZE) {
+        return false;
+    }
+
+    const size_t prefix_size = sizeof(token) + sizeof(uint32_t);
+    rapidjson::StringBuffer buffer;
+    write_response_header(token, static_cast<uint32_t>(payload_size),
+                          buffer.Push(prefix_size));
+
+    size_t written = 0;
+    auto flush = [&]() {
+        int64_t res = stream->write(buffer.GetString(), buffer.GetSize());
+        if (res == -1) {
+            throw tcp_conn_write_closed_exc_t();
+        }
+        written += buffer.GetSize();
+        buffer.Clear();
+    };
+
+    // This encodes the response again, in the same way, so it can't fail now.
+    ql::datum_json_writer_t writer(buffer);
+    write_response_fields(response, &writer, [&]() {
+            const std::vector<ql::datum_t> &data = response->data();
+            for (size_t i = 0; i < data.size(); ++i) {
+                data[i].write_json(&writer);
+                if (buffer.GetSize() >= RESPONSE_CHUNK_SIZE) {
+                    flush();
+                }
+                const size_t YIELD_INTERVAL = 2000;
+                if ((i + 1) % YIELD_INTERVAL == 0) {
+                    coro_t::yield();
+                }
+            }
+        });
+    flush();
+    guarantee(written == prefix_size + payload_size);
+    return true;
+}
+
+// Writes a response into the connection's write buffer.
+class response_write_stream_t : public write_stream_t {
+public:
+    response_write_stream_t(tcp_conn_t *_conn, signal_t *_interruptor) :
+        conn(_conn), interruptor(_interruptor) { }
+
+    MUST_USE int64_t write(const void *p, int64_t n) {
+        conn->write_buffered(p, n, interruptor);
+        return n;
+    }
+
+private:
+    tcp_conn_t *conn;
+    signal_t *interruptor;
+
+    DISABLE_COPYING(response_write_stream_t);
+};
+
 void json_protocol_t::send_response(ql::response_t *response,
                                     int64_t token,
                                     tcp_conn_t *conn,
                                     signal_t *interruptor) {
+    // Large responses are sent as they are encoded, rather than encoded into a
+    // buffer first, which would have to hold all of the response (twice over, when
+    // the items are encoded on several threads).
+    if (response->data().size() > PARALLELIZATION_THRESHOLD) {
+        response_write_stream_t stream(conn, interruptor);
+        if (write_response_in_chunks(response, token, &stream)) {
+            conn->flush_buffer(interruptor);
+            return;
+        }
+    }
+
     uint32_t data_size; // filled in below
     const size_t prefix_size = sizeof(token) + sizeof(data_size);
 
@@ -230,23 +446,8 @@ void json_protocol_t::send_response(ql::response_t *response,
     }
 
     // Fill in the token and size
-    char *mutable_buffer = buffer.GetMutableBuffer();
-#ifdef __s390x__
-    token = __builtin_bswap64(token);
-#endif
-    for (size_t i = 0; i < sizeof(token); ++i) {
-        mutable_buffer[i] = reinterpret_cast<const char *>(&token)[i];
-    }
-
     data_size = static_cast<uint32_t>(payload_size);
-#ifdef __s390x__
-    data_size = __builtin_bswap32(data_size);
-#endif
-    for (size_t i = 0; i < sizeof(data_size); ++i) {
-        mutable_buffer[i + sizeof(token)] =
-            reinterpret_cast<const char *>(&data_size)[i];
-    }
+    write_response_header(token, data_size, buffer.GetMutableBuffer());
 
     conn->write(buffer.GetString(), buffer.GetSize(), interruptor);
 }
-
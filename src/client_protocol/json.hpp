@@ -8,7 +8,9 @@
 #include "containers/scoped.hpp"
 #include "rapidjson/stringbuffer.h"
 
+class read_stream_t;
 class signal_t;
+class write_stream_t;
 
 namespace ql {
 class response_t;
@@ -25,6 +27,13 @@ public:
             ql::query_cache_t *query_cache, int64_t token,
             ql::response_t *error_out);
 
+    // Parses a query of `size` bytes while reading it from `stream`, without
+    // reading it into a buffer first.  This is used for large queries.
+    static scoped_ptr_t<ql::query_params_t> parse_query_from_stream(
+            read_stream_t *stream, size_t size,
+            ql::query_cache_t *query_cache, int64_t token,
+            ql::response_t *error_out);
+
     static scoped_ptr_t<ql::query_params_t> parse_query(tcp_conn_t *conn,
                                                         signal_t *interruptor,
                                                         ql::query_cache_t *query_cache);
@@ -33,6 +42,14 @@ public:
     static void write_response_to_buffer(ql::response_t *response,
                                          rapidjson::StringBuffer *buffer_out);
 
+    // Writes `response` to `stream` with the token and size in front of it, like
+    // `send_response` does, but a chunk at a time as it is encoded.  To get the size,
+    // the response is encoded once before without keeping the result.  Returns false
+    // without writing anything if the response can't be encoded or is too large.
+    static MUST_USE bool write_response_in_chunks(ql::response_t *response,
+                                                  int64_t token,
+                                                  write_stream_t *stream);
+
     static void send_response(ql::response_t *response,
                               int64_t token,
                               tcp_conn_t *conn,
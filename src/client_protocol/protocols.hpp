@@ -16,6 +16,8 @@ public:
     static const uint32_t HARD_LIMIT_TOO_LARGE_QUERY_SIZE;
     static const uint32_t TOO_LONG_QUERY_TIME;
     static const uint32_t TOO_LARGE_QUERY_SIZE;
+    // Queries at least this large are parsed as they are read.
+    static const uint32_t MIN_STREAMED_QUERY_SIZE;
     static const uint32_t TOO_LARGE_RESPONSE_SIZE;
 
     static const std::string unparseable_query_message;
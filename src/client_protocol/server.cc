@@ -192,12 +192,14 @@ query_server_t::query_server_t(rdb_context_t *_rdb_ctx,
                                int port,
                                query_handler_t *_handler,
                                uint32_t http_timeout_sec,
-                               tls_ctx_t *_tls_ctx) :
+                               tls_ctx_t *_tls_ctx,
+                               bool _rebalance_connections) :
         tls_ctx(_tls_ctx),
         rdb_ctx(_rdb_ctx),
         handler(_handler),
-        http_conn_cache(http_timeout_sec),
-        next_thread(0) {
+        thread_load(&rdb_ctx->stats.qe_stats_collection),
+        rebalance_connections(_rebalance_connections),
+        http_conn_cache(http_timeout_sec) {
     rassert(rdb_ctx != nullptr);
     try {
         tcp_listener.init(new tcp_listener_t(local_addresses, port,
@@ -250,10 +252,34 @@ ql::datum_t read_datum(tcp_conn_t *connection, signal_t *interruptor) {
     }
 }
 
+/* Moves a connection from the current thread to another one for as long as it exists,
+along with the coroutine that creates it. */
+class connection_rethreader_t {
+public:
+    connection_rethreader_t(tcp_conn_t *conn, threadnum_t thread)
+        : conn_(conn), original_thread_(get_thread_id()) {
+        conn_->rethread(INVALID_THREAD);
+        thread_switcher_.init(new on_thread_t(thread));
+        conn_->rethread(thread);
+    }
+    ~connection_rethreader_t() {
+        conn_->rethread(INVALID_THREAD);
+        thread_switcher_.reset();
+        conn_->rethread(original_thread_);
+    }
+
+private:
+    tcp_conn_t *conn_;
+    threadnum_t original_thread_;
+    scoped_ptr_t<on_thread_t> thread_switcher_;
+
+    DISABLE_COPYING(connection_rethreader_t);
+};
+
 void query_server_t::handle_conn(const scoped_ptr_t<tcp_conn_descriptor_t> &nconn,
                                  auto_drainer_t::lock_t keepalive) {
-    threadnum_t chosen_thread = threadnum_t(next_thread);
-    next_thread = (next_thread + 1) % get_num_db_threads();
+    client_thread_load_t::connection_t connection_load(&thread_load);
+    threadnum_t chosen_thread = connection_load.get_thread();
 
     cross_thread_signal_t ct_keepalive(keepalive.get_drain_signal(), chosen_thread);
     on_thread_t rethreader(chosen_thread);
@@ -451,21 +477,41 @@ void query_server_t::handle_conn(const scoped_ptr_t<tcp_conn_descriptor_t> &ncon
         UNUSED bool peer_res = conn->getpeername(&client_addr_port);
 
         guarantee(authenticator != nullptr);
-        ql::query_cache_t query_cache(
-            rdb_ctx,
-            client_addr_port,
-            (version < 4)
-                ? ql::return_empty_normal_batches_t::YES
-                : ql::return_empty_normal_batches_t::NO,
-            auth::user_context_t(authenticator->get_authenticated_username()));
-
-        connection_loop<json_protocol_t>(
-            conn.get(),
-            (version < 4)
-                ? 1
-                : 1024,
-            &query_cache,
-            &ct_keepalive);
+        auth::user_context_t user_context(authenticator->get_authenticated_username());
+
+        // Every time `connection_loop` stops because the connection should move, we
+        // move it to the thread that `connection_load` picked, with a fresh query
+        // cache.  It only stops when the old query cache is empty.
+        bool move = false;
+        do {
+            signal_t *thread_keepalive = &ct_keepalive;
+            scoped_ptr_t<cross_thread_signal_t> ct_thread_keepalive;
+            scoped_ptr_t<connection_rethreader_t> rethreader;
+            if (move) {
+                ct_thread_keepalive.init(new cross_thread_signal_t(
+                    &ct_keepalive, connection_load.get_thread()));
+                thread_keepalive = ct_thread_keepalive.get();
+                rethreader.init(new connection_rethreader_t(
+                    conn.get(), connection_load.get_thread()));
+            }
+
+            ql::query_cache_t query_cache(
+                rdb_ctx,
+                client_addr_port,
+                (version < 4)
+                    ? ql::return_empty_normal_batches_t::YES
+                    : ql::return_empty_normal_batches_t::NO,
+                user_context);
+
+            move = connection_loop<json_protocol_t>(
+                conn.get(),
+                (version < 4)
+                    ? 1
+                    : 1024,
+                &query_cache,
+                &connection_load,
+                thread_keepalive);
+        } while (move);
     } catch (client_protocol::client_server_error_t const &error) {
         // We can't write the response here due to coroutine switching inside an
         // exception handler
@@ -560,9 +606,10 @@ void save_exception(std::exception_ptr *err,
 }
 
 template <class protocol_t>
-void query_server_t::connection_loop(tcp_conn_t *conn,
+bool query_server_t::connection_loop(tcp_conn_t *conn,
                                      size_t max_concurrent_queries,
                                      ql::query_cache_t *query_cache,
+                                     client_thread_load_t::connection_t *connection_load,
                                      signal_t *drain_signal) {
     std::exception_ptr err;
     std::string err_str;
@@ -578,20 +625,47 @@ void query_server_t::connection_loop(tcp_conn_t *conn,
     wait_any_t interruptor(drain_signal, &abort);
 #endif  // __linux
 
+    // The number of queries whose coroutines haven't finished yet.
+    size_t running_queries = 0;
+
     new_semaphore_t sem(max_concurrent_queries);
     auto_drainer_t coro_drainer;
+    bool move = false;
     while (!err) {
+        if (rebalance_connections && connection_load->wants_rebalance()) {
+            // We can only move while no queries are running and there are no open
+            // cursors or prepared queries, and we never hold up reading for that.  If
+            // a query is still running, we buffer the next request, which `parse_query`
+            // would wait for anyway, and check again.  Clients that send one query at
+            // a time have their reply by then.  The buffered data moves with `conn`.
+            if (running_queries > 0) {
+                const const_charslice buffered = conn->peek();
+                if (buffered.beg == buffered.end) {
+                    conn->read_more_buffered(&interruptor);
+                }
+            }
+            if (running_queries == 0
+                && query_cache->begin() == query_cache->end()
+                && !query_cache->has_prepared_queries()
+                && connection_load->rebalance()) {
+                move = true;
+                break;
+            }
+        }
+
         scoped_ptr_t<ql::query_params_t> outer_query =
             protocol_t::parse_query(conn, &interruptor, query_cache);
         if (outer_query.has()) {
             outer_query->throttler.init(&sem, 1);
             wait_interruptible(outer_query->throttler.acquisition_signal(),
                                &interruptor);
+            ++running_queries;
             coro_t::spawn_now_dangerously([&]() {
                 // We grab this right away while it's still valid.
                 scoped_ptr_t<ql::query_params_t> query = std::move(outer_query);
                 // Since we `spawn_now_dangerously` it's always safe to acquire this.
                 auto_drainer_t::lock_t coro_drainer_lock(&coro_drainer);
+                client_thread_load_t::running_query_t running_query(&thread_load);
                 wait_any_t cb_interruptor(coro_drainer_lock.get_drain_signal(),
                                           &interruptor);
                 ql::response_t response;
@@ -615,6 +689,8 @@ void query_server_t::connection_loop(tcp_conn_t *conn,
                                                   conn, &cb_interruptor);
                     }
                 });
+
+                --running_queries;
             });
             guarantee(!outer_query.has());
             // Since we're using `spawn_now_dangerously` above, we need to yield
@@ -627,6 +703,7 @@ void query_server_t::connection_loop(tcp_conn_t *conn,
     if (err) {
         std::rethrow_exception(err);
     }
+    return move;
 }
 
 void query_server_t::handle(const http_req_t &req,
@@ -14,6 +14,7 @@
 #include "arch/io/openssl.hpp"
 #include "arch/runtime/runtime.hpp"
 #include "arch/timing.hpp"
+#include "client_protocol/thread_load.hpp"
 #include "concurrency/auto_drainer.hpp"
 #include "concurrency/cross_thread_signal.hpp"
 #include "containers/archive/archive.hpp"
@@ -103,7 +104,8 @@ public:
         int port,
         query_handler_t *_handler,
         uint32_t http_timeout_sec,
-        tls_ctx_t* tls_ctx);
+        tls_ctx_t* tls_ctx,
+        bool _rebalance_connections);
     ~query_server_t();
 
     int get_port() const;
@@ -118,11 +120,14 @@ private:
     void handle_conn(const scoped_ptr_t<tcp_conn_descriptor_t> &nconn,
                      auto_drainer_t::lock_t);
 
-    // This is templatized based on the wire protocol requested by the client
+    // This is templatized based on the wire protocol requested by the client.  Returns
+    // true if it stopped reading queries because the connection should move to
+    // another thread, which it can only do if `rebalance_connections` is set.
     template<class protocol_t>
-    void connection_loop(tcp_conn_t *conn,
+    bool connection_loop(tcp_conn_t *conn,
                          size_t max_concurrent_queries,
                          ql::query_cache_t *query_cache,
+                         client_thread_load_t::connection_t *connection_load,
                          signal_t *interruptor);
 
     // For HTTP server
@@ -134,12 +139,16 @@ private:
     rdb_context_t *const rdb_ctx;
     query_handler_t *const handler;
 
+    // Picks the thread for each new client connection.  If `rebalance_connections`
+    // is set, idle connections also move away from threads that have become much
+    // busier than the others.
+    client_thread_load_t thread_load;
+    const bool rebalance_connections;
+
     /* WARNING: The order here is fragile. */
     auto_drainer_t drainer;
     http_conn_cache_t http_conn_cache;
     scoped_ptr_t<tcp_listener_t> tcp_listener;
-
-    int next_thread;
 };
 
 #endif /* CLIENT_PROTOCOL_SERVER_HPP_ */
@@ -0,0 +1,172 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#include "client_protocol/thread_load.hpp"
+
+#include <algorithm>
+
+#include "arch/runtime/thread_pool.hpp"
+#include "config/args.hpp"
+#include "rdb_protocol/datum.hpp"
+
+client_thread_load_t::thread_state_t::thread_state_t()
+    : connections(0),
+      running_queries(0),
+      busy_permille(0),
+      backlog(0),
+      rebalance_target(-1),
+      last_busy_nanos(0) { }
+
+client_thread_load_t::client_thread_load_t(perfmon_collection_t *parent)
+    : threads_(get_num_db_threads()),
+      last_sample_ticks_(get_ticks()),
+      next_thread_(0),
+      rebalances_left_(0),
+      num_rebalanced_(0),
+      stats_(this),
+      stats_membership_(parent, &stats_, "threads"),
+      timer_(CLIENT_LOAD_SAMPLE_INTERVAL_MS, this) {
+    linux_thread_pool_t *pool = linux_thread_pool_t::get_thread_pool();
+    for (size_t i = 0; i < threads_.size(); ++i) {
+        threads_[i].value.last_busy_nanos = pool->threads[i]->message_hub.busy_nanos();
+    }
+}
+
+client_thread_load_t::thread_state_t *client_thread_load_t::get_state(
+        threadnum_t thread) {
+    guarantee(thread.threadnum >= 0
+              && static_cast<size_t>(thread.threadnum) < threads_.size());
+    return &threads_[thread.threadnum].value;
+}
+
+int64_t client_thread_load_t::get_load(threadnum_t thread) const {
+    guarantee(thread.threadnum >= 0
+              && static_cast<size_t>(thread.threadnum) < threads_.size());
+    const thread_state_t &state = threads_[thread.threadnum].value;
+    return state.busy_permille.load(std::memory_order_relaxed)
+        + CLIENT_LOAD_PER_WAITING_MESSAGE
+          * state.backlog.load(std::memory_order_relaxed)
+        + CLIENT_LOAD_PER_RUNNING_QUERY
+          * state.running_queries.load(std::memory_order_relaxed)
+        + CLIENT_LOAD_PER_CONNECTION
+          * state.connections.load(std::memory_order_relaxed);
+}
+
+int64_t client_thread_load_t::num_rebalanced_connections() const {
+    return num_rebalanced_.load(std::memory_order_relaxed);
+}
+
+void client_thread_load_t::on_ring() {
+    assert_thread();
+    linux_thread_pool_t *pool = linux_thread_pool_t::get_thread_pool();
+    const ticks_t now = get_ticks();
+    const int64_t elapsed_nanos = std::max<int64_t>(
+        now.nanos - last_sample_ticks_.nanos, 1);
+    last_sample_ticks_ = now;
+
+    for (size_t i = 0; i < threads_.size(); ++i) {
+        thread_state_t *state = &threads_[i].value;
+        const linux_message_hub_t &hub = pool->threads[i]->message_hub;
+        const uint64_t busy_nanos = hub.busy_nanos();
+        state->busy_permille.store(
+            std::min<int64_t>((busy_nanos - state->last_busy_nanos) * 1000
+                              / elapsed_nanos, 1000),
+            std::memory_order_relaxed);
+        state->last_busy_nanos = busy_nanos;
+        state->backlog.store(hub.recent_backlog(), std::memory_order_relaxed);
+    }
+
+    // Connections on threads that are much busier than the least loaded one should
+    // move there.  A thread's last connection stays, since moving it would only move
+    // the load along with it.
+    threadnum_t least_loaded(0);
+    for (size_t i = 1; i < threads_.size(); ++i) {
+        if (get_load(threadnum_t(i)) < get_load(least_loaded)) {
+            least_loaded = threadnum_t(i);
+        }
+    }
+    const int64_t min_load = get_load(least_loaded);
+    for (size_t i = 0; i < threads_.size(); ++i) {
+        thread_state_t *state = &threads_[i].value;
+        const bool overloaded =
+            get_load(threadnum_t(i)) - min_load >= CLIENT_REBALANCE_MIN_LOAD_DIFFERENCE
+            && state->connections.load(std::memory_order_relaxed) > 1;
+        state->rebalance_target.store(overloaded ? least_loaded.threadnum : -1,
+                                      std::memory_order_relaxed);
+    }
+    rebalances_left_.store(CLIENT_MAX_REBALANCES_PER_SAMPLE, std::memory_order_relaxed);
+}
+
+client_thread_load_t::connection_t::connection_t(client_thread_load_t *parent)
+    : parent_(parent), thread_(parent->next_thread_) {
+    parent_->assert_thread();
+    const int num_threads = parent_->threads_.size();
+    for (int i = 1; i < num_threads; ++i) {
+        threadnum_t candidate((parent_->next_thread_ + i) % num_threads);
+        if (parent_->get_load(candidate) < parent_->get_load(thread_)) {
+            thread_ = candidate;
+        }
+    }
+    parent_->next_thread_ = (parent_->next_thread_ + 1) % num_threads;
+    parent_->get_state(thread_)->connections.fetch_add(1, std::memory_order_relaxed);
+}
+
+client_thread_load_t::connection_t::~connection_t() {
+    parent_->get_state(thread_)->connections.fetch_sub(1, std::memory_order_relaxed);
+}
+
+bool client_thread_load_t::connection_t::wants_rebalance() const {
+    return parent_->get_state(thread_)->rebalance_target.load(
+        std::memory_order_relaxed) != -1;
+}
+
+bool client_thread_load_t::connection_t::rebalance() {
+    thread_state_t *state = parent_->get_state(thread_);
+    const int32_t target = state->rebalance_target.load(std::memory_order_relaxed);
+    if (target == -1 || target == thread_.threadnum) {
+        return false;
+    }
+    if (parent_->rebalances_left_.fetch_sub(1, std::memory_order_relaxed) <= 0) {
+        return false;
+    }
+    state->connections.fetch_sub(1, std::memory_order_relaxed);
+    thread_ = threadnum_t(target);
+    parent_->get_state(thread_)->connections.fetch_add(1, std::memory_order_relaxed);
+    parent_->num_rebalanced_.fetch_add(1, std::memory_order_relaxed);
+    return true;
+}
+
+client_thread_load_t::running_query_t::running_query_t(client_thread_load_t *parent)
+    : parent_(parent), thread_(get_thread_id()) {
+    parent_->get_state(thread_)->running_queries.fetch_add(
+        1, std::memory_order_relaxed);
+}
+
+client_thread_load_t::running_query_t::~running_query_t() {
+    parent_->get_state(thread_)->running_queries.fetch_sub(
+        1, std::memory_order_relaxed);
+}
+
+void *client_thread_load_t::stats_t::begin_stats() {
+    return nullptr;
+}
+
+void client_thread_load_t::stats_t::visit_stats(void *) { }
+
+ql::datum_t client_thread_load_t::stats_t::end_stats(void *) {
+    ql::datum_array_builder_t builder(ql::configured_limits_t::unlimited);
+    for (size_t i = 0; i < parent_->threads_.size(); ++i) {
+        const thread_state_t &state = parent_->threads_[i].value;
+        ql::datum_object_builder_t thread_builder;
+        thread_builder.overwrite("load", ql::datum_t(static_cast<double>(
+            parent_->get_load(threadnum_t(i)))));
+        thread_builder.overwrite("busy_fraction", ql::datum_t(
+            state.busy_permille.load(std::memory_order_relaxed) / 1000.0));
+        thread_builder.overwrite("waiting_messages", ql::datum_t(static_cast<double>(
+            state.backlog.load(std::memory_order_relaxed))));
+        thread_builder.overwrite("client_connections", ql::datum_t(static_cast<double>(
+            state.connections.load(std::memory_order_relaxed))));
+        thread_builder.overwrite("running_queries", ql::datum_t(static_cast<double>(
+            state.running_queries.load(std::memory_order_relaxed))));
+        builder.add(std::move(thread_builder).to_datum());
+    }
+    return std::move(builder).to_datum();
+}
@@ -0,0 +1,132 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#ifndef CLIENT_PROTOCOL_THREAD_LOAD_HPP_
+#define CLIENT_PROTOCOL_THREAD_LOAD_HPP_
+
+#include <stdint.h>
+
+#include <atomic>
+
+#include "arch/runtime/runtime_utils.hpp"
+#include "arch/timing.hpp"
+#include "concurrency/cache_line_padded.hpp"
+#include "containers/scoped.hpp"
+#include "perfmon/core.hpp"
+#include "threading.hpp"
+#include "time.hpp"
+
+/* Keeps track of how busy each db thread is, so that `query_server_t` can put new
+client connections on the least loaded thread instead of going round-robin, and move
+idle connections away from threads that have become much busier than the others.
+
+A thread's load combines the fraction of time its event loop spent processing
+messages during the last sampling interval and the number of messages that were
+waiting for it (both sampled from the thread's message hub every
+CLIENT_LOAD_SAMPLE_INTERVAL_MS), and the number of connections and running queries
+that the query server has on it (which are always up to date, so that a burst of new
+connections doesn't all end up on the thread that was least loaded at the last sample).
+
+The per-thread loads show up in the stats as `query_engine/threads`. */
+class client_thread_load_t : public repeating_timer_callback_t,
+                             public home_thread_mixin_t {
+public:
+    explicit client_thread_load_t(perfmon_collection_t *parent);
+
+    // Counts a client connection towards the thread it's on, from the moment it's
+    // accepted until it's closed.
+    class connection_t {
+    public:
+        // Picks the least loaded db thread for the connection.  Must be called on the
+        // home thread of `parent`.
+        explicit connection_t(client_thread_load_t *parent);
+        ~connection_t();
+
+        threadnum_t get_thread() const { return thread_; }
+
+        // Whether the connection's thread has been much busier than another db thread
+        // lately.  Cheap enough to call before every query.
+        bool wants_rebalance() const;
+
+        // Counts the connection towards the least loaded thread instead, and returns
+        // true, unless too many connections have moved recently.  The caller must then
+        // move the connection to `get_thread()`.
+        bool rebalance();
+
+    private:
+        client_thread_load_t *parent_;
+        threadnum_t thread_;
+
+        DISABLE_COPYING(connection_t);
+    };
+
+    // Counts a query towards the thread it starts on while it runs.
+    class running_query_t {
+    public:
+        explicit running_query_t(client_thread_load_t *parent);
+        ~running_query_t();
+
+    private:
+        client_thread_load_t *parent_;
+        threadnum_t thread_;
+
+        DISABLE_COPYING(running_query_t);
+    };
+
+    // Takes a new sample of the threads' busy time.  Called by our timer.
+    void on_ring();
+
+    // The load of the given db thread, as described above.
+    int64_t get_load(threadnum_t thread) const;
+
+    // The number of connections that `rebalance()` has moved so far.
+    int64_t num_rebalanced_connections() const;
+
+private:
+    struct thread_state_t {
+        thread_state_t();
+
+        std::atomic<int64_t> connections;
+        std::atomic<int64_t> running_queries;
+
+        // Written by `on_ring()`.
+        std::atomic<int64_t> busy_permille;
+        std::atomic<int64_t> backlog;
+        // The thread that connections on this thread should move to, or -1 if they
+        // should stay.
+        std::atomic<int32_t> rebalance_target;
+
+        // Only accessed on the home thread.
+        uint64_t last_busy_nanos;
+    };
+
+    // Reports the per-thread loads.
+    class stats_t : public perfmon_t {
+    public:
+        explicit stats_t(client_thread_load_t *parent) : parent_(parent) { }
+        void *begin_stats();
+        void visit_stats(void *);
+        ql::datum_t end_stats(void *);
+    private:
+        client_thread_load_t *parent_;
+    };
+
+    thread_state_t *get_state(threadnum_t thread);
+
+    scoped_array_t<cache_line_padded_t<thread_state_t> > threads_;
+    ticks_t last_sample_ticks_;
+
+    // Where `connection_t` starts looking for the least loaded thread, so that it
+    // goes round-robin between threads that are equally loaded.
+    int next_thread_;
+
+    std::atomic<int64_t> rebalances_left_;
+    std::atomic<int64_t> num_rebalanced_;
+
+    stats_t stats_;
+    perfmon_membership_t stats_membership_;
+
+    repeating_timer_t timer_;
+
+    DISABLE_COPYING(client_thread_load_t);
+};
+
+#endif  // CLIENT_PROTOCOL_THREAD_LOAD_HPP_
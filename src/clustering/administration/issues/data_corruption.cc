@@ -0,0 +1,151 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#include "clustering/administration/issues/data_corruption.hpp"
+
+#include <map>
+
+#include "arch/runtime/coroutines.hpp"
+#include "clustering/administration/datum_adapter.hpp"
+#include "clustering/administration/metadata.hpp"
+
+const datum_string_t data_corruption_issue_t::data_corruption_issue_type =
+    datum_string_t("data_corruption");
+const uuid_u data_corruption_issue_t::base_issue_id =
+    str_to_uuid("4c2f1e5a-0f7b-4b7e-9d3a-6a81d52e3c17");
+
+data_corruption_issue_t::data_corruption_issue_t()
+    : issue_t(nil_uuid()), corrupt_blocks(0) { }
+
+data_corruption_issue_t::data_corruption_issue_t(const namespace_id_t &_table_id,
+                                                 uint64_t _corrupt_blocks) :
+    issue_t(from_hash(base_issue_id, _table_id)),
+    table_id(_table_id),
+    corrupt_blocks(_corrupt_blocks) { }
+
+bool data_corruption_issue_t::build_info_and_description(
+        const metadata_t &metadata,
+        server_config_client_t *server_config_client,
+        table_meta_client_t *table_meta_client,
+        admin_identifier_format_t identifier_format,
+        ql::datum_t *info_out,
+        datum_string_t *description_out) const {
+    ql::datum_t table_name_or_uuid;
+    name_string_t table_name;
+    ql::datum_t db_name_or_uuid;
+    name_string_t db_name;
+    if (!convert_table_id_to_datums(table_id, identifier_format, metadata,
+            table_meta_client, &table_name_or_uuid, &table_name, &db_name_or_uuid,
+            &db_name)) {
+        /* The table's data files get deleted along with the table. */
+        return false;
+    }
+
+    ql::datum_array_builder_t servers_builder(ql::configured_limits_t::unlimited);
+    std::string servers_string;
+    for (auto const &server_id : reporting_server_ids) {
+        ql::datum_t server_name_or_uuid;
+        name_string_t server_name;
+        if (!convert_connected_server_id_to_datum(server_id,
+                                                  identifier_format,
+                                                  server_config_client,
+                                                  &server_name_or_uuid,
+                                                  &server_name)) {
+            continue;
+        }
+        servers_builder.add(server_name_or_uuid);
+        if (!servers_string.empty()) {
+            servers_string += ", ";
+        }
+        servers_string += server_name.str();
+    }
+
+    ql::datum_object_builder_t info_builder;
+    info_builder.overwrite("table", table_name_or_uuid);
+    info_builder.overwrite("db", db_name_or_uuid);
+    info_builder.overwrite("servers", std::move(servers_builder).to_datum());
+    info_builder.overwrite("corrupt_blocks",
+                           ql::datum_t(static_cast<double>(corrupt_blocks)));
+    *info_out = std::move(info_builder).to_datum();
+    *description_out = datum_string_t(strprintf(
+        "The data file of table `%s.%s` is corrupted on the following server%s: %s.  "
+        "%" PRIu64 " block%s did not match %s checksum, probably because of a disk or "
+        "file system failure.  Queries that read the affected data may fail or see "
+        "damaged documents.  "
+        "You should replace the damaged copy of the table, for example by removing "
+        "the server from the table's replicas and adding it back once the other "
+        "replicas are up to date.",
+        db_name.c_str(), table_name.c_str(),
+        reporting_server_ids.size() == 1 ? "" : "s",
+        servers_string.c_str(),
+        corrupt_blocks,
+        corrupt_blocks == 1 ? "" : "s",
+        corrupt_blocks == 1 ? "its" : "their"));
+    return true;
+}
+
+RDB_IMPL_SERIALIZABLE_4_FOR_CLUSTER(data_corruption_issue_t,
+                                    issue_id,
+                                    reporting_server_ids,
+                                    table_id,
+                                    corrupt_blocks);
+
+RDB_IMPL_EQUALITY_COMPARABLE_4(data_corruption_issue_t,
+                               issue_id,
+                               reporting_server_ids,
+                               table_id,
+                               corrupt_blocks);
+
+data_corruption_issue_tracker_t::table_reporter_t::table_reporter_t(
+        data_corruption_issue_tracker_t *_parent,
+        const namespace_id_t &_table_id) :
+    parent(_parent), table_id(_table_id), corrupt_blocks(0) {
+    on_thread_t thread_switcher(parent->home_thread());
+    parent->reporters.insert(this);
+}
+
+data_corruption_issue_tracker_t::table_reporter_t::~table_reporter_t() {
+    on_thread_t thread_switcher(parent->home_thread());
+    parent->reporters.erase(this);
+}
+
+void data_corruption_issue_tracker_t::table_reporter_t::on_corrupt_block(
+        UNUSED block_id_t block_id, UNUSED int64_t offset) {
+    // The serializer has already logged the details.
+    ++corrupt_blocks;
+}
+
+data_corruption_issue_tracker_t::~data_corruption_issue_tracker_t() {
+    guarantee(reporters.empty());
+}
+
+std::vector<data_corruption_issue_t> data_corruption_issue_tracker_t::get_issues() {
+    assert_thread();
+    std::vector<data_corruption_issue_t> issues;
+    for (table_reporter_t *reporter : reporters) {
+        const uint64_t count = reporter->corrupt_blocks.load();
+        if (count > 0) {
+            issues.push_back(data_corruption_issue_t(reporter->table_id, count));
+        }
+    }
+    return issues;
+}
+
+void data_corruption_issue_tracker_t::combine(
+    std::vector<data_corruption_issue_t> &&issues,
+    std::vector<scoped_ptr_t<issue_t> > *issues_out) {
+    std::map<namespace_id_t, data_corruption_issue_t *> combined_issues;
+    for (auto &issue : issues) {
+        auto combined_it = combined_issues.find(issue.table_id);
+        if (combined_it == combined_issues.end()) {
+            combined_issues.insert(std::make_pair(issue.table_id, &issue));
+        } else {
+            rassert(issue.reporting_server_ids.size() == 1);
+            combined_it->second->add_server(*issue.reporting_server_ids.begin());
+            combined_it->second->corrupt_blocks += issue.corrupt_blocks;
+        }
+    }
+
+    for (auto const &it : combined_issues) {
+        issues_out->push_back(
+            scoped_ptr_t<issue_t>(new data_corruption_issue_t(*it.second)));
+    }
+}
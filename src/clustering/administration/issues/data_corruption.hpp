@@ -0,0 +1,86 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved
+#ifndef CLUSTERING_ADMINISTRATION_ISSUES_DATA_CORRUPTION_HPP_
+#define CLUSTERING_ADMINISTRATION_ISSUES_DATA_CORRUPTION_HPP_
+
+#include <atomic>
+#include <set>
+#include <vector>
+
+#include "clustering/administration/issues/issue.hpp"
+#include "containers/uuid.hpp"
+#include "serializer/log/log_serializer.hpp"
+
+/* Reported when the serializer's scrubber finds blocks in a table's data file that
+don't match their checksums. */
+class data_corruption_issue_t : public issue_t {
+public:
+    data_corruption_issue_t();
+    data_corruption_issue_t(const namespace_id_t &_table_id, uint64_t _corrupt_blocks);
+
+    const datum_string_t &get_name() const { return data_corruption_issue_type; }
+    bool is_critical() const final { return true; }
+
+    void add_server(const server_id_t &server) {
+        reporting_server_ids.insert(server);
+    }
+
+    namespace_id_t table_id;
+    uint64_t corrupt_blocks;
+    std::set<server_id_t> reporting_server_ids;
+
+private:
+    bool build_info_and_description(
+        const metadata_t &metadata,
+        server_config_client_t *server_config_client,
+        table_meta_client_t *table_meta_client,
+        admin_identifier_format_t identifier_format,
+        ql::datum_t *info_out,
+        datum_string_t *description_out) const;
+
+    static const datum_string_t data_corruption_issue_type;
+    static const uuid_u base_issue_id;
+};
+
+RDB_DECLARE_SERIALIZABLE(data_corruption_issue_t);
+RDB_DECLARE_EQUALITY_COMPARABLE(data_corruption_issue_t);
+
+class data_corruption_issue_tracker_t :
+    public home_thread_mixin_t {
+public:
+    /* Each table's serializer reports corrupted blocks through one of these.  The
+    serializer runs on a different thread than the tracker, so the reporter only
+    counts the blocks, and the tracker reads the counts in `get_issues()`. */
+    class table_reporter_t : public log_serializer_scrub_callback_t {
+    public:
+        // The constructor and destructor block, to visit the tracker's thread.
+        table_reporter_t(data_corruption_issue_tracker_t *parent,
+                         const namespace_id_t &table_id);
+        ~table_reporter_t();
+
+        void on_corrupt_block(block_id_t block_id, int64_t offset);
+
+    private:
+        friend class data_corruption_issue_tracker_t;
+
+        data_corruption_issue_tracker_t *const parent;
+        const namespace_id_t table_id;
+        std::atomic<uint64_t> corrupt_blocks;
+
+        DISABLE_COPYING(table_reporter_t);
+    };
+
+    data_corruption_issue_tracker_t() { }
+    ~data_corruption_issue_tracker_t();
+
+    std::vector<data_corruption_issue_t> get_issues();
+
+    static void combine(std::vector<data_corruption_issue_t> &&issues,
+                        std::vector<scoped_ptr_t<issue_t> > *issues_out);
+
+private:
+    std::set<table_reporter_t *> reporters;
+
+    DISABLE_COPYING(data_corruption_issue_tracker_t);
+};
+
+#endif // CLUSTERING_ADMINISTRATION_ISSUES_DATA_CORRUPTION_HPP_
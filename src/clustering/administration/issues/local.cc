@@ -5,16 +5,19 @@
 #include "clustering/administration/metadata.hpp"
 #include "utils.hpp"
 
-RDB_MAKE_SERIALIZABLE_2_FOR_CLUSTER(local_issues_t, log_write_issues, memory_issues);
+RDB_MAKE_SERIALIZABLE_3_FOR_CLUSTER(local_issues_t,
+    log_write_issues, memory_issues, data_corruption_issues);
 RDB_MAKE_SERIALIZABLE_1_FOR_CLUSTER(local_issue_bcard_t, get_mailbox);
 
 local_issue_server_t::local_issue_server_t(
         mailbox_manager_t *mm,
         log_write_issue_tracker_t *_log_write_issue_tracker,
-        memory_issue_tracker_t *_memory_issue_tracker) :
+        memory_issue_tracker_t *_memory_issue_tracker,
+        data_corruption_issue_tracker_t *_data_corruption_issue_tracker) :
     mailbox_manager(mm),
     log_write_issue_tracker(_log_write_issue_tracker),
     memory_issue_tracker(_memory_issue_tracker),
+    data_corruption_issue_tracker(_data_corruption_issue_tracker),
     get_mailbox(mailbox_manager,
         std::bind(&local_issue_server_t::on_get, this, ph::_1, ph::_2))
     { }
@@ -24,6 +27,7 @@ void local_issue_server_t::on_get(
     local_issues_t issues;
     issues.log_write_issues = log_write_issue_tracker->get_issues();
     issues.memory_issues = memory_issue_tracker->get_issues();
+    issues.data_corruption_issues = data_corruption_issue_tracker->get_issues();
     send(mailbox_manager, reply, issues);
 }
 
@@ -60,6 +64,11 @@ std::vector<scoped_ptr_t<issue_t> > local_issue_client_t::get_issues(
                         copy.add_server(bcards[i].first);
                         aggregator.memory_issues.push_back(copy);
                     }
+                    for (const auto &issue : issues.data_corruption_issues) {
+                        data_corruption_issue_t copy = issue;
+                        copy.add_server(bcards[i].first);
+                        aggregator.data_corruption_issues.push_back(copy);
+                    }
                     got_reply.pulse();
                 });
             disconnect_watcher_t disconnect_watcher(
@@ -80,6 +89,8 @@ std::vector<scoped_ptr_t<issue_t> > local_issue_client_t::get_issues(
         std::move(aggregator.log_write_issues), &res);
     memory_issue_tracker_t::combine(
         std::move(aggregator.memory_issues), &res);
+    data_corruption_issue_tracker_t::combine(
+        std::move(aggregator.data_corruption_issues), &res);
     return res;
 }
 
@@ -5,6 +5,7 @@
 #include <string>
 #include <vector>
 
+#include "clustering/administration/issues/data_corruption.hpp"
 #include "clustering/administration/issues/log_write.hpp"
 #include "clustering/administration/issues/memory.hpp"
 #include "concurrency/watchable.hpp"
@@ -21,6 +22,7 @@ class local_issues_t {
 public:
     std::vector<log_write_issue_t> log_write_issues;
     std::vector<memory_issue_t> memory_issues;
+    std::vector<data_corruption_issue_t> data_corruption_issues;
 };
 
 RDB_DECLARE_SERIALIZABLE(local_issues_t);
@@ -38,7 +40,8 @@ public:
     local_issue_server_t(
         mailbox_manager_t *mm,
         log_write_issue_tracker_t *log_write_issue_tracker,
-        memory_issue_tracker_t *memory_issue_tracker);
+        memory_issue_tracker_t *memory_issue_tracker,
+        data_corruption_issue_tracker_t *data_corruption_issue_tracker);
 
     local_issue_bcard_t get_bcard() {
         return local_issue_bcard_t { get_mailbox.get_address() };
@@ -50,6 +53,7 @@ private:
     mailbox_manager_t *const mailbox_manager;
     log_write_issue_tracker_t *const log_write_issue_tracker;
     memory_issue_tracker_t *const memory_issue_tracker;
+    data_corruption_issue_tracker_t *const data_corruption_issue_tracker;
     local_issue_bcard_t::get_mailbox_t get_mailbox;
     DISABLE_COPYING(local_issue_server_t);
 };
@@ -92,7 +92,7 @@ void jobs_manager_t::on_get_job_reports(
 
                     std::string render = pprint::pretty_print_as_js(
                         printed_query_columns,
-                        pair.second->term_storage->root_term());
+                        pair.second->get_term_storage()->root_term());
 
                     query_job_reports_inner.emplace_back(
                         pair.second->job_id,
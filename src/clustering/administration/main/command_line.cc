@@ -481,6 +481,53 @@ optional<int> parse_node_reconnect_timeout_secs_option(
     return optional<int>();
 }
 
+cluster_compression_t parse_cluster_compression_option(
+        const std::map<std::string, options::values_t> &opts) {
+    const std::string compression_opt = get_single_option(opts, "--cluster-compression");
+    if (compression_opt == "none") {
+        return cluster_compression_t::NONE;
+    } else if (compression_opt == "fast") {
+        return cluster_compression_t::FAST;
+    } else if (compression_opt == "adaptive") {
+        return cluster_compression_t::ADAPTIVE;
+    } else {
+        throw std::runtime_error(strprintf(
+                "ERROR: cluster-compression should be 'none', 'fast' or 'adaptive', "
+                "got '%s'", compression_opt.c_str()));
+    }
+}
+
+block_codec_t parse_block_compression_option(
+        const std::map<std::string, options::values_t> &opts) {
+    const std::string compression_opt = get_single_option(opts, "--block-compression");
+    if (compression_opt == "none") {
+        return block_codec_t::none;
+    } else if (compression_opt == "zlib") {
+        return block_codec_t::zlib;
+    } else {
+        throw std::runtime_error(strprintf(
+                "ERROR: block-compression should be 'none' or 'zlib', got '%s'",
+                compression_opt.c_str()));
+    }
+}
+
+int64_t parse_scrub_rate_option(
+        const std::map<std::string, options::values_t> &opts) {
+    const std::string scrub_rate_opt = get_single_option(opts, "--scrub-rate");
+    uint64_t scrub_rate_megs;
+    if (!strtou64_strict(scrub_rate_opt, 10, &scrub_rate_megs)) {
+        throw std::runtime_error(strprintf(
+                "ERROR: scrub-rate should be a number, got '%s'",
+                scrub_rate_opt.c_str()));
+    }
+    if (scrub_rate_megs > MAX_SCRUB_RATE_MEGS) {
+        throw std::runtime_error(strprintf(
+                "ERROR: scrub-rate is too large. Must be at most %d",
+                MAX_SCRUB_RATE_MEGS));
+    }
+    return static_cast<int64_t>(scrub_rate_megs * MEGABYTE);
+}
+
 /* An empty outer `optional` means the `--cache-size` parameter is not present. An
 empty inner `optional` means the cache size is set to `auto`. */
 optional<optional<uint64_t> > parse_total_cache_size_option(
@@ -1045,6 +1092,7 @@ void run_rethinkdb_create(const base_path_t &base_path,
                           optional<uint64_t> total_cache_size,
                           const file_direct_io_mode_t direct_io_mode,
                           const int max_concurrent_io_requests,
+                          const file_io_backend_t io_backend,
                           bool *const result_out) {
     server_id_t our_server_id = server_id_t::generate_server_id();
 
@@ -1058,7 +1106,7 @@ void run_rethinkdb_create(const base_path_t &base_path,
     server_config.config.cache_size_bytes = total_cache_size;
     server_config.version = 1;
 
-    io_backender_t io_backender(direct_io_mode, max_concurrent_io_requests);
+    io_backender_t io_backender(direct_io_mode, max_concurrent_io_requests, io_backend);
 
     perfmon_collection_t metadata_perfmon_collection;
     perfmon_membership_t metadata_perfmon_membership(&get_global_perfmon_collection(), &metadata_perfmon_collection, "metadata");
@@ -1139,6 +1187,7 @@ void run_rethinkdb_serve(const base_path_t &base_path,
                          const std::string &initial_password,
                          const file_direct_io_mode_t direct_io_mode,
                          const int max_concurrent_io_requests,
+                         const file_io_backend_t io_backend,
                          const optional<optional<uint64_t> >
                             &total_cache_size,
                          const server_id_t *our_server_id,
@@ -1156,7 +1205,7 @@ void run_rethinkdb_serve(const base_path_t &base_path,
 
     logNTC("Loading data from directory %s\n", base_path.path().c_str());
 
-    io_backender_t io_backender(direct_io_mode, max_concurrent_io_requests);
+    io_backender_t io_backender(direct_io_mode, max_concurrent_io_requests, io_backend);
 
     perfmon_collection_t metadata_perfmon_collection;
     perfmon_membership_t metadata_perfmon_membership(&get_global_perfmon_collection(), &metadata_perfmon_collection, "metadata");
@@ -1284,6 +1333,7 @@ void run_rethinkdb_porcelain(const base_path_t &base_path,
                              const std::string &initial_password,
                              const file_direct_io_mode_t direct_io_mode,
                              const int max_concurrent_io_requests,
+                             const file_io_backend_t io_backend,
                              const optional<optional<uint64_t> >
                                 &total_cache_size,
                              const bool new_directory,
@@ -1292,7 +1342,7 @@ void run_rethinkdb_porcelain(const base_path_t &base_path,
                              bool *const result_out) {
     if (!new_directory) {
         run_rethinkdb_serve(base_path, serve_info, initial_password, direct_io_mode,
-                            max_concurrent_io_requests, total_cache_size,
+                            max_concurrent_io_requests, io_backend, total_cache_size,
                             nullptr, nullptr, nullptr, data_directory_lock,
                             result_out);
     } else {
@@ -1328,7 +1378,7 @@ void run_rethinkdb_porcelain(const base_path_t &base_path,
         server_config.version = 1;
 
         run_rethinkdb_serve(base_path, serve_info, initial_password, direct_io_mode,
-                            max_concurrent_io_requests,
+                            max_concurrent_io_requests, io_backend,
                             optional<optional<uint64_t> >(),
                             &our_server_id, &server_config, &cluster_metadata,
                             data_directory_lock, result_out);
@@ -1412,11 +1462,36 @@ options::help_section_t get_file_options(std::vector<options::option_t> *options
     options_out->push_back(options::option_t(options::names_t("--direct-io"),
                                              options::OPTIONAL_NO_PARAMETER));
     help.add("--direct-io", "use direct I/O for file access");
+#endif
+#ifdef __linux
+    options_out->push_back(options::option_t(options::names_t("--io-uring"),
+                                             options::OPTIONAL_NO_PARAMETER));
+    help.add("--io-uring", "submit file I/O through io_uring instead of a thread pool "
+        "(falls back to the thread pool if io_uring is unavailable)");
 #endif
     options_out->push_back(options::option_t(options::names_t("--cache-size"),
                                              options::OPTIONAL));
     help.add("--cache-size mb", "total cache size (in megabytes) for the process. Can "
         "be 'auto'.");
+    options_out->push_back(options::option_t(options::names_t("--block-compression"),
+                                             options::OPTIONAL,
+                                             "none"));
+    help.add("--block-compression {none|zlib}", "compress table data blocks before "
+        "writing them to disk; blocks already on disk stay readable whatever this is "
+        "set to, the default is 'none'");
+    options_out->push_back(options::option_t(options::names_t("--scrub-rate"),
+                                             options::OPTIONAL,
+                                             strprintf("%d", static_cast<int>(
+                                                 DEFAULT_SCRUB_BYTES_PER_SEC / MEGABYTE))));
+    help.add("--scrub-rate mb", strprintf("how many megabytes per second the background "
+        "scrubber reads to verify the checksums of table data blocks; 0 turns the "
+        "scrubber off, the default is %d",
+        static_cast<int>(DEFAULT_SCRUB_BYTES_PER_SEC / MEGABYTE)));
+    options_out->push_back(options::option_t(options::names_t("--compact-lba-on-shutdown"),
+                                             options::OPTIONAL_NO_PARAMETER));
+    help.add("--compact-lba-on-shutdown", "garbage collect the block indexes of the "
+        "tables when shutting down, which makes the next startup faster but the "
+        "shutdown slower");
     return help;
 }
 
@@ -1624,6 +1699,13 @@ options::help_section_t get_network_options(const bool join_required, std::vecto
                                                     "before giving up, the default is "
                                                     "24 hours");
 
+    options_out->push_back(options::option_t(options::names_t("--cluster-compression"),
+                                             options::OPTIONAL,
+                                             "none"));
+    help.add("--cluster-compression {none|fast|adaptive}", "compress the larger "
+             "messages sent to other servers; 'adaptive' compresses backfills harder "
+             "than 'fast', the default is 'none'");
+
     return help;
 }
 
@@ -1633,6 +1715,10 @@ options::help_section_t get_cpu_options(std::vector<options::option_t> *options_
                                              options::OPTIONAL,
                                              strprintf("%d", get_cpu_count())));
     help.add("-c [ --cores ] n", "the number of cores to use");
+    options_out->push_back(options::option_t(options::names_t("--rebalance-client-connections"),
+                                             options::OPTIONAL_NO_PARAMETER));
+    help.add("--rebalance-client-connections", "move idle client connections away from "
+             "cores that are much busier than the others");
     return help;
 }
 
@@ -1899,6 +1985,12 @@ file_direct_io_mode_t parse_direct_io_mode_option(const std::map<std::string, op
         file_direct_io_mode_t::buffered_desired;
 }
 
+file_io_backend_t parse_io_backend_option(const std::map<std::string, options::values_t> &opts) {
+    return exists_option(opts, "--io-uring") ?
+        file_io_backend_t::io_uring_desired :
+        file_io_backend_t::blocker_pool;
+}
+
 int main_rethinkdb_create(int argc, char *argv[]) {
     std::vector<options::option_t> options;
     std::vector<options::help_section_t> help;
@@ -1948,6 +2040,7 @@ int main_rethinkdb_create(int argc, char *argv[]) {
         recreate_temporary_directory(base_path);
 
         const file_direct_io_mode_t direct_io_mode = parse_direct_io_mode_option(opts);
+        const file_io_backend_t io_backend = parse_io_backend_option(opts);
 
         bool result;
         run_in_thread_pool(std::bind(&run_rethinkdb_create,
@@ -1958,6 +2051,7 @@ int main_rethinkdb_create(int argc, char *argv[]) {
                                      total_cache_size,
                                      direct_io_mode,
                                      max_concurrent_io_requests,
+                                     io_backend,
                                      &result),
                            num_workers);
 
@@ -2107,9 +2201,15 @@ int main_rethinkdb_serve(int argc, char *argv[]) {
                                 std::vector<std::string>(argv, argv + argc),
                                 join_delay_secs.value_or(0),
                                 node_reconnect_timeout_secs.value_or(cluster_defaults::reconnect_timeout),
-                                tls_configs);
+                                tls_configs,
+                                exists_option(opts, "--rebalance-client-connections"),
+                                parse_cluster_compression_option(opts),
+                                parse_block_compression_option(opts),
+                                exists_option(opts, "--compact-lba-on-shutdown"),
+                                parse_scrub_rate_option(opts));
 
         const file_direct_io_mode_t direct_io_mode = parse_direct_io_mode_option(opts);
+        const file_io_backend_t io_backend = parse_io_backend_option(opts);
 
         bool result;
         run_in_thread_pool(std::bind(&run_rethinkdb_serve,
@@ -2118,6 +2218,7 @@ int main_rethinkdb_serve(int argc, char *argv[]) {
                                      initial_password,
                                      direct_io_mode,
                                      max_concurrent_io_requests,
+                                     io_backend,
                                      total_cache_size,
                                      static_cast<server_id_t*>(nullptr),
                                      static_cast<server_config_versioned_t *>(nullptr),
@@ -2210,7 +2311,12 @@ int main_rethinkdb_proxy(int argc, char *argv[]) {
                                 std::vector<std::string>(argv, argv + argc),
                                 join_delay_secs.value_or(0),
                                 node_reconnect_timeout_secs.value_or(cluster_defaults::reconnect_timeout),
-                                tls_configs);
+                                tls_configs,
+                                false,
+                                parse_cluster_compression_option(opts),
+                                block_codec_t::none,
+                                false,
+                                0);
 
         bool result;
         run_in_thread_pool(
@@ -2400,9 +2506,15 @@ int main_rethinkdb_porcelain(int argc, char *argv[]) {
                                 std::vector<std::string>(argv, argv + argc),
                                 join_delay_secs.value_or(0),
                                 node_reconnect_timeout_secs.value_or(cluster_defaults::reconnect_timeout),
-                                tls_configs);
+                                tls_configs,
+                                exists_option(opts, "--rebalance-client-connections"),
+                                parse_cluster_compression_option(opts),
+                                parse_block_compression_option(opts),
+                                exists_option(opts, "--compact-lba-on-shutdown"),
+                                parse_scrub_rate_option(opts));
 
         const file_direct_io_mode_t direct_io_mode = parse_direct_io_mode_option(opts);
+        const file_io_backend_t io_backend = parse_io_backend_option(opts);
 
         bool result;
         run_in_thread_pool(std::bind(&run_rethinkdb_porcelain,
@@ -2412,6 +2524,7 @@ int main_rethinkdb_porcelain(int argc, char *argv[]) {
                                      initial_password,
                                      direct_io_mode,
                                      max_concurrent_io_requests,
+                                     io_backend,
                                      total_cache_size,
                                      is_new_directory,
                                      &serve_info,
@@ -236,7 +236,8 @@ bool do_serve(io_backender_t *io_backender,
                 serve_info.ports.client_port,
                 semilattice_manager_heartbeat.get_root_view(),
                 semilattice_manager_auth.get_root_view(),
-                serve_info.tls_configs.cluster.get()));
+                serve_info.tls_configs.cluster.get(),
+                serve_info.cluster_compression));
         } catch (const address_in_use_exc_t &ex) {
             throw address_in_use_exc_t(strprintf("Could not bind to cluster port: %s", ex.what()));
         }
@@ -299,6 +300,7 @@ bool do_serve(io_backender_t *io_backender,
             up tables and handling queries for them. The `table_persistence_interface_t`
             helps it by constructing the B-trees and serializers, and also persisting
             table-related metadata to disk. */
+            data_corruption_issue_tracker_t data_corruption_issue_tracker;
             scoped_ptr_t<cache_balancer_t> cache_balancer;
             scoped_ptr_t<real_table_persistence_interface_t>
                 table_persistence_interface;
@@ -306,13 +308,20 @@ bool do_serve(io_backender_t *io_backender,
             if (i_am_a_server) {
                 cache_balancer.init(new alt_cache_balancer_t(
                     server_config_server->get_actual_cache_size_bytes()));
+                log_serializer_dynamic_config_t serializer_config;
+                serializer_config.scrub_bytes_per_sec = serve_info.scrub_bytes_per_sec;
+                serializer_config.block_codec = serve_info.block_codec;
+                serializer_config.compact_lba_on_shutdown =
+                    serve_info.compact_lba_on_shutdown;
                 table_persistence_interface.init(
                     new real_table_persistence_interface_t(
                         io_backender,
                         cache_balancer.get(),
                         base_path,
                         &rdb_ctx,
-                        metadata_file));
+                        metadata_file,
+                        &data_corruption_issue_tracker,
+                        serializer_config));
                 multi_table_manager.init(new multi_table_manager_t(
                     server_id,
                     &mailbox_manager,
@@ -439,7 +448,8 @@ bool do_serve(io_backender_t *io_backender,
                 local_issue_server.init(new local_issue_server_t(
                     &mailbox_manager,
                     log_writer.get_log_write_issue_tracker(),
-                    memory_checker->get_memory_issue_tracker()));
+                    memory_checker->get_memory_issue_tracker(),
+                    &data_corruption_issue_tracker));
             }
 
             proc_directory_metadata_t initial_proc_directory {
@@ -543,7 +553,8 @@ bool do_serve(io_backender_t *io_backender,
                     &rdb_ctx,
                     &server_config_client,
                     server_id,
-                    serve_info.tls_configs.driver.get());
+                    serve_info.tls_configs.driver.get(),
+                    serve_info.rebalance_client_connections);
                 logNTC("Listening for client driver connections on port %d\n",
                        rdb_query_server.get_port());
                 /* If `serve_info.ports.reql_port` was zero then the OS assigned us a
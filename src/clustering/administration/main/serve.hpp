@@ -13,6 +13,8 @@
 #include "clustering/administration/main/version_check.hpp"
 #include "arch/address.hpp"
 #include "arch/io/openssl.hpp"
+#include "rpc/connectivity/cluster.hpp"
+#include "serializer/log/block_codec.hpp"
 
 class os_signal_cond_t;
 
@@ -120,7 +122,12 @@ public:
                  std::vector<std::string> &&_argv,
                  const int _join_delay_secs,
                  const int _node_reconnect_timeout_secs,
-                 tls_configs_t _tls_configs) :
+                 tls_configs_t _tls_configs,
+                 bool _rebalance_client_connections,
+                 cluster_compression_t _cluster_compression,
+                 block_codec_t _block_codec,
+                 bool _compact_lba_on_shutdown,
+                 int64_t _scrub_bytes_per_sec) :
         joins(std::move(_joins)),
         reql_http_proxy(std::move(_reql_http_proxy)),
         web_assets(std::move(_web_assets)),
@@ -129,7 +136,12 @@ public:
         config_file(_config_file),
         argv(std::move(_argv)),
         join_delay_secs(_join_delay_secs),
-        node_reconnect_timeout_secs(_node_reconnect_timeout_secs)
+        node_reconnect_timeout_secs(_node_reconnect_timeout_secs),
+        rebalance_client_connections(_rebalance_client_connections),
+        cluster_compression(_cluster_compression),
+        block_codec(_block_codec),
+        compact_lba_on_shutdown(_compact_lba_on_shutdown),
+        scrub_bytes_per_sec(_scrub_bytes_per_sec)
     {
         tls_configs = _tls_configs;
     }
@@ -151,6 +163,18 @@ public:
     int join_delay_secs;
     int node_reconnect_timeout_secs;
     tls_configs_t tls_configs;
+    /* Whether idle client connections move away from threads that are much busier
+    than the others. */
+    bool rebalance_client_connections;
+    /* How we compress the messages we send to other servers that support it. */
+    cluster_compression_t cluster_compression;
+    /* How the serializers of our tables compress the blocks they write. */
+    block_codec_t block_codec;
+    /* Whether the serializers of our tables compact their LBA when they shut down. */
+    bool compact_lba_on_shutdown;
+    /* How fast the serializers of our tables scrub their data blocks, or 0 if they
+    shouldn't. */
+    int64_t scrub_bytes_per_sec;
 };
 
 /* This has been factored out from `command_line.hpp` because it takes a very
@@ -4,6 +4,7 @@
 #include <algorithm>
 #include <array>
 
+#include "clustering/administration/issues/data_corruption.hpp"
 #include "clustering/administration/persist/branch_history_manager.hpp"
 #include "clustering/administration/persist/file_keys.hpp"
 #include "clustering/administration/persist/raft_storage_interface.hpp"
@@ -26,6 +27,8 @@ public:
             cache_balancer_t *cache_balancer,
             rdb_context_t *rdb_context,
             perfmon_collection_t *perfmon_collection_serializers,
+            data_corruption_issue_tracker_t *data_corruption_issue_tracker,
+            const log_serializer_t::dynamic_config_t &serializer_config,
             scoped_ptr_t<thread_allocation_t> &&serializer_thread,
             std::vector<scoped_ptr_t<thread_allocation_t> > &&store_threads,
             std::map<
@@ -47,6 +50,9 @@ public:
         // TODO: We should use N slices on M serializers, not N slices
         // on 1 serializer.
 
+        corruption_reporter.init(new data_corruption_issue_tracker_t::table_reporter_t(
+            data_corruption_issue_tracker, table_id));
+
         int res = access(path.permanent_path().c_str(), R_OK | W_OK);
         bool create = (res != 0);
 
@@ -63,9 +69,10 @@ public:
         // now, we don't.
 
         scoped_ptr_t<serializer_t> inner_serializer(new log_serializer_t(
-            log_serializer_t::dynamic_config_t(),
+            serializer_config,
             &file_opener,
-            perfmon_collection_serializers));
+            perfmon_collection_serializers,
+            corruption_reporter.get()));
         serializer.init(new merger_serializer_t(
             std::move(inner_serializer),
             MERGER_SERIALIZER_MAX_ACTIVE_WRITES));
@@ -136,6 +143,7 @@ public:
             }
             serializer.reset();
         }
+        corruption_reporter.reset();
     }
 
     branch_history_manager_t *get_branch_history_manager() {
@@ -165,6 +173,7 @@ public:
 
 private:
     scoped_ptr_t<real_branch_history_manager_t> branch_history_manager;
+    scoped_ptr_t<data_corruption_issue_tracker_t::table_reporter_t> corruption_reporter;
     scoped_ptr_t<serializer_t> serializer;
     scoped_ptr_t<serializer_multiplexer_t> multiplexer;
     scoped_ptr_t<store_t> stores[CPU_SHARDING_FACTOR];
@@ -298,6 +307,8 @@ void real_table_persistence_interface_t::load_multistore(
         cache_balancer,
         rdb_context,
         perfmon_collection_serializers,
+        data_corruption_issue_tracker,
+        serializer_config,
         std::move(serializer_thread),
         std::move(store_threads),
         &real_multistores));
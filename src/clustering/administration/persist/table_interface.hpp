@@ -5,8 +5,10 @@
 #include "clustering/administration/perfmon_collection_repo.hpp"
 #include "clustering/administration/persist/raft_storage_interface.hpp"
 #include "clustering/table_manager/table_metadata.hpp"
+#include "serializer/log/config.hpp"
 
 class cache_balancer_t;
+class data_corruption_issue_tracker_t;
 class metadata_file_t;
 class real_multistore_ptr_t;
 class table_raft_storage_interface_t;
@@ -19,12 +21,16 @@ public:
             cache_balancer_t *_cache_balancer,
             const base_path_t &_base_path,
             rdb_context_t *_rdb_context,
-            metadata_file_t *_metadata_file) :
+            metadata_file_t *_metadata_file,
+            data_corruption_issue_tracker_t *_data_corruption_issue_tracker,
+            const log_serializer_dynamic_config_t &_serializer_config) :
         io_backender(_io_backender),
         cache_balancer(_cache_balancer),
         base_path(_base_path),
         rdb_context(_rdb_context),
         metadata_file(_metadata_file),
+        data_corruption_issue_tracker(_data_corruption_issue_tracker),
+        serializer_config(_serializer_config),
         /* We assign threads from the lowest thread number upwards. This is to reduce
         the potential for conflicting with cluster connection threads, which are
         assigned from the highest thread number downwards. */
@@ -81,6 +87,9 @@ private:
     base_path_t const base_path;
     rdb_context_t * const rdb_context;
     metadata_file_t * const metadata_file;
+    data_corruption_issue_tracker_t * const data_corruption_issue_tracker;
+    /* The configuration of the serializers of the tables we load or create. */
+    log_serializer_dynamic_config_t const serializer_config;
 
     std::map<
         namespace_id_t, std::pair<real_multistore_ptr_t *, auto_drainer_t::lock_t>
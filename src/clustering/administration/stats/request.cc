@@ -34,7 +34,9 @@ const char *table_server_stats_request_t::table_server_request_type = "table_ser
 parsed_stats_t::server_stats_t::server_stats_t() :
     responsive(false),
     queries_per_sec(0), queries_total(0),
-    client_connections(0), clients_active(0) { }
+    client_connections(0), clients_active(0),
+    compressed_bytes_sent(0), uncompressed_bytes_sent(0),
+    compressed_bytes_received(0), uncompressed_bytes_received(0) { }
 
 parsed_stats_t::table_stats_t::table_stats_t() :
     read_docs_per_sec(0), read_docs_total(0),
@@ -65,6 +67,8 @@ parsed_stats_t::parsed_stats_t(const std::vector<ql::datum_t> &stats) {
             std::pair<datum_string_t, ql::datum_t> perf_pair = s.get_pair(i);
             if (perf_pair.first == "query_engine") {
                 store_query_engine_stats(perf_pair.second, &serv_stats);
+            } else if (perf_pair.first == "connectivity") {
+                store_connectivity_stats(perf_pair.second, &serv_stats);
             } else {
                 namespace_id_t table_id;
                 res = str_to_uuid(perf_pair.first.to_std(), &table_id);
@@ -167,6 +171,20 @@ void parsed_stats_t::store_query_engine_stats(const ql::datum_t &qe_perf,
     store_perfmon_value(qe_perf, "queries_total", &stats_out->queries_total);
     store_perfmon_value(qe_perf, "client_connections", &stats_out->client_connections);
     store_perfmon_value(qe_perf, "clients_active", &stats_out->clients_active);
+    stats_out->threads = qe_perf.get_field("threads", ql::throw_bool_t::NOTHROW);
+}
+
+void parsed_stats_t::store_connectivity_stats(const ql::datum_t &conn_perf,
+                                              server_stats_t *stats_out) {
+    r_sanity_check(conn_perf.get_type() == ql::datum_t::R_OBJECT);
+    store_perfmon_value(conn_perf, "compressed_bytes_sent",
+                        &stats_out->compressed_bytes_sent);
+    store_perfmon_value(conn_perf, "uncompressed_bytes_sent",
+                        &stats_out->uncompressed_bytes_sent);
+    store_perfmon_value(conn_perf, "compressed_bytes_received",
+                        &stats_out->compressed_bytes_received);
+    store_perfmon_value(conn_perf, "uncompressed_bytes_received",
+                        &stats_out->uncompressed_bytes_received);
 }
 
 void parsed_stats_t::store_table_stats(const namespace_id_t &table_id,
@@ -407,6 +425,7 @@ server_stats_request_t::server_stats_request_t(const server_id_t &_server_id) :
 std::set<std::vector<std::string> > server_stats_request_t::get_filter() const {
     return std::set<std::vector<std::string> >(
         { {"query_engine"},
+          {"connectivity", "(un)?compressed_bytes_.*"},
           {".*", "serializers", "shard_[0-9]+", "btree-.*" } });
 }
 
@@ -456,7 +475,17 @@ bool server_stats_request_t::to_datum(const parsed_stats_t &stats,
         ADD_SERVER_STAT(qe_builder, stats, server_id, read_docs_total);
         ADD_SERVER_STAT(qe_builder, stats, server_id, written_docs_per_sec);
         ADD_SERVER_STAT(qe_builder, stats, server_id, written_docs_total);
+        if (server_stats.threads.has()) {
+            qe_builder.overwrite("threads", server_stats.threads);
+        }
         row_builder.overwrite("query_engine", std::move(qe_builder).to_datum());
+
+        ql::datum_object_builder_t network_builder;
+        ADD_STAT(network_builder, server_stats, compressed_bytes_sent);
+        ADD_STAT(network_builder, server_stats, uncompressed_bytes_sent);
+        ADD_STAT(network_builder, server_stats, compressed_bytes_received);
+        ADD_STAT(network_builder, server_stats, uncompressed_bytes_received);
+        row_builder.overwrite("network", std::move(network_builder).to_datum());
     }
     *result_out = std::move(row_builder).to_datum();
     return true;
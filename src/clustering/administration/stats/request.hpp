@@ -46,6 +46,13 @@ public:
         double queries_total;
         double client_connections;
         double clients_active;
+        // The load of each of the server's threads, as reported by the query server.
+        ql::datum_t threads;
+        // Bytes of compressed intra-cluster messages, and their size before compression.
+        double compressed_bytes_sent;
+        double uncompressed_bytes_sent;
+        double compressed_bytes_received;
+        double uncompressed_bytes_received;
 
         std::map<namespace_id_t, table_stats_t> tables;
     };
@@ -90,6 +97,9 @@ private:
     void store_query_engine_stats(const ql::datum_t &qe_perf,
                                   server_stats_t *stats_out);
 
+    void store_connectivity_stats(const ql::datum_t &conn_perf,
+                                  server_stats_t *stats_out);
+
     void store_table_stats(const namespace_id_t &table_id,
                            const ql::datum_t &table_perf,
                            server_stats_t *stats_out);
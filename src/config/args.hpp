@@ -123,9 +123,25 @@
 #define LBA_MIN_SIZE_FOR_GC                       (MEGABYTE * 1)
 #define LBA_MIN_UNGARBAGE_FRACTION                0.5
 
+// When the serializer is configured to compact the LBA on a clean shutdown, it
+// rewrites every LBA shard in which less than this fraction of the entries is live,
+// so that the next startup has less to read.
+#define LBA_SHUTDOWN_MIN_UNGARBAGE_FRACTION       0.9
+
 // I/O priority for LBA garbage collection
 #define LBA_GC_IO_PRIORITY                        8
 
+// I/O priority and default rate (in bytes per second) of the background scrubber
+// that verifies the checksums of all live data blocks.  The rate can be set with
+// `--scrub-rate`, in megabytes per second, up to MAX_SCRUB_RATE_MEGS.
+#define SCRUB_IO_PRIORITY                         4
+#define DEFAULT_SCRUB_BYTES_PER_SEC               (4 * MEGABYTE)
+#define MAX_SCRUB_RATE_MEGS                       100000
+
+// How long the scrubber waits after finishing a pass over a file before it starts
+// the next one.
+#define SCRUB_PASS_INTERVAL_MS                    (60 * 60 * 1000)
+
 // How many block ids should the LBA garbage collector rewrite before yielding?
 #define LBA_GC_BATCH_SIZE                         (1024 * 8)
 
@@ -146,6 +162,15 @@
 
 #define COROUTINE_STACK_SIZE                      131072
 
+// Coroutine stacks that aren't used by any coroutine go to a process-wide pool, with
+// one part per NUMA node.  Each part keeps up to COROUTINE_STACK_POOL_HOT_STACKS
+// stacks as they are, so that they can be reused without any system calls, and up to
+// COROUTINE_STACK_POOL_MAX_STACKS stacks in all.  The rest of the stacks in it are
+// cold: the OS may take their memory back if it runs short.
+#define COROUTINE_STACK_POOL_HOT_STACKS           256
+#define COROUTINE_STACK_POOL_MAX_STACKS           4096
+#define COROUTINE_STACK_POOL_MAX_NUMA_NODES       8
+
 
 /**
  * Message scheduler configuration
@@ -183,6 +208,29 @@
 #define CORO_PRIORITY_RESET_DATA                (-2)
 #define CORO_PRIORITY_DIRECTORY_CHANGES         (-2)
 #define CORO_PRIORITY_LBA_GC                    (-2)
+#define CORO_PRIORITY_SCRUB                     (-2)
+
+
+/**
+ * Client connection placement
+ */
+
+// How often the query server samples how busy each thread is.
+#define CLIENT_LOAD_SAMPLE_INTERVAL_MS          250
+
+// A thread's load is the per mille of time that it spent processing messages during
+// the last sampling interval, plus these amounts for every message that was waiting
+// for it, every query that is running on it and every client connection on it.
+#define CLIENT_LOAD_PER_WAITING_MESSAGE         1
+#define CLIENT_LOAD_PER_RUNNING_QUERY           50
+#define CLIENT_LOAD_PER_CONNECTION              5
+
+// If client connections may be rebalanced, an idle connection moves away from its
+// thread when that thread's load is at least this much more than the least loaded
+// thread's.  At most CLIENT_MAX_REBALANCES_PER_SAMPLE connections move per sampling
+// interval, so that they don't all pile onto the same thread.
+#define CLIENT_REBALANCE_MIN_LOAD_DIFFERENCE    300
+#define CLIENT_MAX_REBALANCES_PER_SAMPLE        4
 
 #endif  // CONFIG_ARGS_HPP_
 
@@ -2,6 +2,8 @@
 #ifndef CONTAINERS_ARCHIVE_TCP_CONN_STREAM_HPP_
 #define CONTAINERS_ARCHIVE_TCP_CONN_STREAM_HPP_
 
+#include <vector>
+
 #include "arch/address.hpp"
 #include "arch/io/openssl.hpp"
 #include "arch/types.hpp"
@@ -23,6 +25,9 @@ public:
     virtual MUST_USE int64_t read(void *p, int64_t n);
     virtual MUST_USE int64_t write(const void *p, int64_t n);
     virtual MUST_USE int64_t write_buffered(const void *p, int64_t n);
+    // Like `write_buffered()`, but takes ownership of `data` to avoid copying it.
+    // Returns false if the connection is closed.
+    virtual MUST_USE bool write_buffered_vector(std::vector<char> &&data);
     virtual bool flush_buffer();
 
     void rethread(threadnum_t new_thread);
@@ -75,6 +80,7 @@ public:
     virtual MUST_USE int64_t read(void *p, int64_t n);
     virtual MUST_USE int64_t write(const void *p, int64_t n);
     virtual MUST_USE int64_t write_buffered(const void *p, int64_t n);
+    virtual MUST_USE bool write_buffered_vector(std::vector<char> &&data);
     virtual bool flush_buffer();
 
 private:
@@ -54,6 +54,11 @@ public:
     void remove(entry_t *);
     T pop();
     void update(int);
+    /* \brief calls f() on the data of every entry, and then restores the order of
+     * the queue.  Use this instead of update() when a change affects most entries
+     */
+    template<class Callable>
+    void update_all(const Callable &f);
 public:
     void validate();
 
@@ -0,0 +1,107 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#include "crc32c.hpp"
+
+#include <string.h>
+
+#if defined(__aarch64__) && defined(__ARM_FEATURE_CRC32)
+#include <arm_acle.h>
+#endif
+
+namespace {
+
+// The reflected CRC-32C polynomial.
+const uint32_t CRC32C_POLY = 0x82f63b78;
+
+struct crc32c_table_t {
+    crc32c_table_t() {
+        for (uint32_t i = 0; i < 256; ++i) {
+            uint32_t crc = i;
+            for (int j = 0; j < 8; ++j) {
+                crc = (crc >> 1) ^ ((crc & 1) ? CRC32C_POLY : 0);
+            }
+            entries[i] = crc;
+        }
+    }
+    uint32_t entries[256];
+};
+
+const crc32c_table_t crc32c_table;
+
+uint32_t crc32c_software(const uint8_t *p, size_t size, uint32_t crc) {
+    for (size_t i = 0; i < size; ++i) {
+        crc = crc32c_table.entries[(crc ^ p[i]) & 0xff] ^ (crc >> 8);
+    }
+    return crc;
+}
+
+#if defined(__x86_64__)
+
+__attribute__((target("sse4.2")))
+uint32_t crc32c_hardware(const uint8_t *p, size_t size, uint32_t crc) {
+    uint64_t crc64 = crc;
+    for (; size >= sizeof(uint64_t); size -= sizeof(uint64_t), p += sizeof(uint64_t)) {
+        uint64_t word;
+        memcpy(&word, p, sizeof(word));
+        crc64 = __builtin_ia32_crc32di(crc64, word);
+    }
+    uint32_t crc32 = static_cast<uint32_t>(crc64);
+    for (; size > 0; --size, ++p) {
+        crc32 = __builtin_ia32_crc32qi(crc32, *p);
+    }
+    return crc32;
+}
+
+bool detect_hardware_support() {
+    // We run during static initialization, so we need to call this first.
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("sse4.2");
+}
+
+#elif defined(__aarch64__) && defined(__ARM_FEATURE_CRC32)
+
+uint32_t crc32c_hardware(const uint8_t *p, size_t size, uint32_t crc) {
+    for (; size >= sizeof(uint64_t); size -= sizeof(uint64_t), p += sizeof(uint64_t)) {
+        uint64_t word;
+        memcpy(&word, p, sizeof(word));
+        crc = __crc32cd(crc, word);
+    }
+    for (; size > 0; --size, ++p) {
+        crc = __crc32cb(crc, *p);
+    }
+    return crc;
+}
+
+bool detect_hardware_support() {
+    // The compiler only defines __ARM_FEATURE_CRC32 if we're building for a CPU that
+    // has the instructions.
+    return true;
+}
+
+#else
+
+uint32_t crc32c_hardware(const uint8_t *p, size_t size, uint32_t crc) {
+    return crc32c_software(p, size, crc);
+}
+
+bool detect_hardware_support() {
+    return false;
+}
+
+#endif
+
+const bool use_hardware_crc32c = detect_hardware_support();
+
+}  // namespace
+
+uint32_t crc32c(const void *data, size_t size, uint32_t crc) {
+    const uint8_t *p = static_cast<const uint8_t *>(data);
+    crc = ~crc;
+    crc = use_hardware_crc32c
+        ? crc32c_hardware(p, size, crc)
+        : crc32c_software(p, size, crc);
+    return ~crc;
+}
+
+bool crc32c_is_hardware_accelerated() {
+    return use_hardware_crc32c;
+}
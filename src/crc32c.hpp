@@ -0,0 +1,19 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#ifndef CRC32C_HPP_
+#define CRC32C_HPP_
+
+#include <stddef.h>
+#include <stdint.h>
+
+/* Computes the CRC-32C (Castagnoli) checksum of `size` bytes at `data`.  `crc` is the
+checksum of any preceding data, which lets you checksum a buffer in pieces.
+
+Uses the SSE4.2 or ARMv8 CRC32 instructions where the CPU supports them, which
+makes it fast enough to run on every block read.  Otherwise falls back to a
+table-based implementation. */
+uint32_t crc32c(const void *data, size_t size, uint32_t crc = 0);
+
+/* Returns true if `crc32c()` is using hardware instructions. */
+bool crc32c_is_hardware_accelerated();
+
+#endif  // CRC32C_HPP_
@@ -348,3 +348,15 @@ std::string perfmon_duration_sampler_t::call(UNUSED int argc, UNUSED char **argv
     }
 }
 
+perfmon_function_t::perfmon_function_t(std::function<int64_t()> _fun)
+    : fun(std::move(_fun)) { }
+
+void *perfmon_function_t::begin_stats() {
+    return nullptr;
+}
+
+void perfmon_function_t::visit_stats(void *) { }
+
+ql::datum_t perfmon_function_t::end_stats(void *) {
+    return ql::datum_t(static_cast<double>(fun()));
+}
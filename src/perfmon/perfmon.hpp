@@ -9,6 +9,7 @@
 #define PERFMON_PERFMON_HPP_
 
 #include <algorithm>
+#include <functional>
 #include <limits>
 #include <string>
 #include <map>
@@ -253,6 +254,23 @@ public:
     std::string call(UNUSED int argc, UNUSED char **argv);
 };
 
+/* perfmon_function_t reports the value that a function returns when the stats are
+ * read, for values that are already kept track of somewhere else.
+ */
+struct perfmon_function_t : public perfmon_t {
+public:
+    explicit perfmon_function_t(std::function<int64_t()> _fun);
+
+    void *begin_stats();
+    void visit_stats(void *data);
+    ql::datum_t end_stats(void *data);
+
+private:
+    std::function<int64_t()> fun;
+
+    DISABLE_COPYING(perfmon_function_t);
+};
+
 struct block_pm_duration {
     ticks_t time;
     bool ended;
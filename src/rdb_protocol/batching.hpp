@@ -84,6 +84,7 @@ public:
     static batchspec_t empty() { return batchspec_t(); }
     static batchspec_t default_for(batch_type_t batch_type);
     batch_type_t get_batch_type() const { return batch_type; }
+    int64_t get_max_els() const { return max_els; }
     batchspec_t with_new_batch_type(batch_type_t new_batch_type) const;
     batchspec_t with_min_els(int64_t new_min_els) const;
     batchspec_t with_max_dur(kiloticks_t new_max_dur) const;
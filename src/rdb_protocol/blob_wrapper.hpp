@@ -29,6 +29,8 @@ public:
                     buffer_group_t *buffer_group_out,
                     blob_acq_t *acq_group_out);
 
+    void read_all(buf_parent_t parent, char *dest);
+
 private:
     blob_t internal;
 };
@@ -30,6 +30,7 @@
 #include "rdb_protocol/pseudo_geometry.hpp"
 #include "rdb_protocol/serialize_datum_onto_blob.hpp"
 #include "rdb_protocol/shards.hpp"
+#include "rdb_protocol/sindex_bloom_filter.hpp"
 #include "rdb_protocol/table_common.hpp"
 
 #include "debug.hpp"
@@ -717,22 +718,34 @@ public:
     rget_cb_wrapper_t(
             rget_cb_t *_cb,
             size_t _copies,
-            optional<std::string> _skey_left)
-        : cb(_cb), copies(_copies), skey_left(std::move(_skey_left)) { }
+            optional<std::string> _skey_left,
+            bool _is_scan = false)
+        : cb(_cb), copies(_copies), skey_left(std::move(_skey_left)),
+          scan(_is_scan), saw_any_pair(false) { }
     virtual continue_bool_t handle_pair(
         scoped_key_value_t &&keyvalue,
         concurrent_traversal_fifo_enforcer_signal_t waiter)
         THROWS_ONLY(interrupted_exc_t) {
+        saw_any_pair = true;
         return cb->handle_pair(
             std::move(keyvalue),
             copies,
             skey_left,
             std::move(waiter));
     }
+    virtual bool is_scan() THROWS_NOTHING {
+        return scan;
+    }
+    // Whether the traversal found any key at all.
+    bool saw_pair() const {
+        return saw_any_pair;
+    }
 private:
     rget_cb_t *cb;
     size_t copies;
     optional<std::string> skey_left;
+    bool scan;
+    bool saw_any_pair;
 };
 
 rget_cb_t::rget_cb_t(rget_io_data_t &&_io,
@@ -1018,6 +1031,7 @@ void rdb_rget_slice(
         const std::vector<transform_variant_t> &transforms,
         const optional<terminal_variant_t> &terminal,
         sorting_t sorting,
+        bool is_scan,
         rget_read_response_t *response,
         release_superblock_t release_superblock) {
     r_sanity_check(boost::get<ql::exc_t>(&response->result) == nullptr);
@@ -1072,7 +1086,7 @@ void rdb_rget_slice(
             }
         }
     } else {
-        rget_cb_wrapper_t wrapper(&callback, 1, r_nullopt);
+        rget_cb_wrapper_t wrapper(&callback, 1, r_nullopt, is_scan);
         cont = btree_concurrent_traversal(
             superblock, range, &wrapper, direction, release_superblock);
     }
@@ -1093,6 +1107,7 @@ void rdb_rget_secondary_slice(
         sorting_t sorting,
         require_sindexes_t require_sindex_val,
         const sindex_disk_info_t &sindex_info,
+        sindex_bloom_filter_t *bloom_filter,
         rget_read_response_t *response,
         release_superblock_t release_superblock) {
     r_sanity_check(boost::get<ql::exc_t>(&response->result) == nullptr);
@@ -1126,23 +1141,46 @@ void rdb_rget_secondary_slice(
             sindex_info.mapping,
             sindex_info.multi)));
 
+    // `getAll` looks up individual values, which the bloom filter can rule out.
+    const bool use_bloom_filter = bloom_filter != nullptr && bloom_filter->is_ready()
+        && datumspec.visit<bool>(
+            [](const ql::datum_range_t &) { return false; },
+            [](const std::map<ql::datum_t, uint64_t> &) { return true; });
+
     direction_t direction = reversed(sorting) ? BACKWARD : FORWARD;
     auto cb = [&](const std::pair<ql::datum_range_t, uint64_t> &pair, bool is_last) {
         key_range_t sindex_keyrange =
             pair.first.to_sindex_keyrange(sindex_func_reql_version);
+        // For a single value, this is its truncated secondary key.
+        std::string skey_left = key_to_unescaped_str(sindex_keyrange.left);
+        if (use_bloom_filter && bloom_filter->definitely_absent(skey_left)) {
+            return continue_bool_t::CONTINUE;
+        }
         rget_cb_wrapper_t wrapper(
             &callback,
             pair.second,
-            make_optional(key_to_unescaped_str(sindex_keyrange.left)));
+            make_optional(std::move(skey_left)));
         key_range_t active_range = active_region_range.intersection(sindex_keyrange);
         // This can happen sometimes with truncated keys.
         if (active_range.is_empty()) return continue_bool_t::CONTINUE;
-        return btree_concurrent_traversal(
+        // `drop_sindex()` destroys the bloom filter once it gets the index's
+        // superblock, so we hold on to the superblock until we're done with the filter.
+        const bool release_now = is_last && !use_bloom_filter;
+        continue_bool_t cont = btree_concurrent_traversal(
             superblock,
             active_range,
             &wrapper,
             direction,
-            is_last ? release_superblock : release_superblock_t::KEEP);
+            release_now ? release_superblock : release_superblock_t::KEEP);
+        if (use_bloom_filter) {
+            if (!wrapper.saw_pair()) {
+                bloom_filter->note_false_positive();
+            }
+            if (is_last && release_superblock == release_superblock_t::RELEASE) {
+                superblock->release();
+            }
+        }
+        return cont;
     };
     continue_bool_t cont = datumspec.iter(sorting, cb);
     callback.finish(cont);
@@ -1848,6 +1886,11 @@ void rdb_update_single_sindex(
             compute_keys(
                 modification->primary_key, added, sindex_info,
                 &keys, cfeed_new_keys_out);
+            // The keys must be in the bloom filter before they're in the index, or
+            // a read could miss them.
+            for (const auto &pair : keys) {
+                store->note_sindex_key(sindex->sindex.id, pair.first);
+            }
             if (keys_available_cond != nullptr) {
                 guarantee(*updates_left > 0);
                 decremented_updates_left = true;
@@ -22,6 +22,7 @@ class key_tester_t;
 template <class> class promise_t;
 struct rdb_value_t;
 class refcount_superblock_t;
+class sindex_bloom_filter_t;
 struct sindex_disk_info_t;
 
 
@@ -151,6 +152,7 @@ void rdb_rget_slice(
     const std::vector<ql::transform_variant_t> &transforms,
     const optional<ql::terminal_variant_t> &terminal,
     sorting_t sorting,
+    bool is_scan,
     rget_read_response_t *response,
     release_superblock_t release_superblock);
 
@@ -168,6 +170,8 @@ void rdb_rget_secondary_slice(
     sorting_t sorting,
     require_sindexes_t require_sindex_val,
     const sindex_disk_info_t &sindex_info,
+    // May be `nullptr`.  Only used for `getAll`, and only while we hold `superblock`.
+    sindex_bloom_filter_t *bloom_filter,
     rget_read_response_t *response,
     release_superblock_t release_superblock);
 
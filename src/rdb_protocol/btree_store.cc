@@ -41,6 +41,13 @@
 //  block out writes anyway.
 const int64_t WRITE_SUPERBLOCK_ACQ_WAITERS_LIMIT = 2;
 
+// The bloom filters of a store's secondary indexes may use this fraction of the memory
+// that the cache balancer gives to the store's cache, but at least
+// `SINDEX_BLOOM_FILTER_MIN_BUDGET` (the balancer may not have given the cache any
+// memory yet when a filter gets built right after startup).
+const uint64_t SINDEX_BLOOM_FILTER_CACHE_DIVISOR = 32;
+const size_t SINDEX_BLOOM_FILTER_MIN_BUDGET = 64 * KILOBYTE;
+
 // Some of this implementation is in store.cc and some in btree_store.cc for no
 // particularly good reason.  Historically it turned out that way, and for now
 // there's not enough refactoring urgency to combine them into one.
@@ -646,12 +653,173 @@ optional<uuid_u> store_t::add_sindex_internal(
                                                           index_type_t::SECONDARY)));
 
         sindex.needs_post_construction_range = key_range_t::universe();
+        add_sindex_bloom_filter(sindex.id, opaque_definition, true);
 
         ::set_secondary_index(sindex_block, name, sindex);
         return make_optional(sindex.id);
     }
 }
 
+void store_t::add_sindex_bloom_filter(const uuid_u &sindex_id,
+                                      const std::vector<char> &opaque_definition,
+                                      bool index_is_empty) {
+    sindex_disk_info_t sindex_info;
+    try {
+        deserialize_sindex_info(opaque_definition, &sindex_info,
+            [](obsolete_reql_version_t) {
+                throw archive_exc_t("Obsolete secondary index.");
+            });
+    } catch (const archive_exc_t &) {
+        // We'll complain about the index elsewhere.  It doesn't need a filter.
+        return;
+    } catch (const ql::base_exc_t &) {
+        return;
+    }
+    // `getAll` doesn't work on geospatial indexes.
+    if (sindex_info.geo == sindex_geo_bool_t::GEO) {
+        return;
+    }
+    auto slice_it = secondary_index_slices.find(sindex_id);
+    guarantee(slice_it != secondary_index_slices.end());
+    sindex_bloom_filters[sindex_id] = make_scoped<sindex_bloom_filter_t>(
+        &slice_it->second->stats.btree_collection, index_is_empty);
+}
+
+sindex_bloom_filter_t *store_t::get_sindex_bloom_filter(const uuid_u &id) {
+    assert_thread();
+    auto it = sindex_bloom_filters.find(id);
+    return it != sindex_bloom_filters.end() ? it->second.get() : nullptr;
+}
+
+sindex_bloom_filter_t *store_t::get_sindex_bloom_filter_for_get_all(
+        const uuid_u &id, const ql::datumspec_t &datumspec) {
+    const bool is_get_all = datumspec.visit<bool>(
+        [](const ql::datum_range_t &) { return false; },
+        [](const std::map<ql::datum_t, uint64_t> &) { return true; });
+    if (!is_get_all) {
+        return nullptr;
+    }
+    sindex_bloom_filter_t *filter = get_sindex_bloom_filter(id);
+    if (filter != nullptr && !filter->is_ready() && !filter->is_rebuilding()) {
+        spawn_sindex_bloom_filter_rebuild(id, filter);
+    }
+    return filter;
+}
+
+void store_t::note_sindex_key(const uuid_u &sindex_id, const store_key_t &key) {
+    assert_thread();
+    auto it = sindex_bloom_filters.find(sindex_id);
+    if (it == sindex_bloom_filters.end()) {
+        return;
+    }
+    it->second->note_key(key);
+    if (it->second->wants_rebuild()) {
+        spawn_sindex_bloom_filter_rebuild(sindex_id, it->second.get());
+    }
+}
+
+size_t store_t::sindex_bloom_filter_budget() {
+    const size_t total = std::max<size_t>(
+        cache->memory_limit() / SINDEX_BLOOM_FILTER_CACHE_DIVISOR,
+        SINDEX_BLOOM_FILTER_MIN_BUDGET);
+    // A filter that got built while there were fewer indexes may still be bigger than
+    // its share, until its next rebuild.  But a rebuild never has to make do with
+    // what another one left over.
+    return total / std::max<size_t>(sindex_bloom_filters.size(), 1);
+}
+
+void store_t::spawn_sindex_bloom_filter_rebuild(const uuid_u &sindex_id,
+                                                sindex_bloom_filter_t *filter) {
+    filter->begin_rebuild(sindex_bloom_filter_budget());
+    coro_t::spawn_sometime(std::bind(&store_t::rebuild_sindex_bloom_filter,
+                                     this, sindex_id, drainer.lock()));
+}
+
+class sindex_bloom_filter_rebuild_cb_t : public depth_first_traversal_callback_t {
+public:
+    sindex_bloom_filter_rebuild_cb_t(store_t *_store, uuid_u _sindex_id)
+        : store(_store), sindex_id(_sindex_id), num_traversed(0) { }
+    continue_bool_t handle_pair(scoped_key_value_t &&keyvalue, signal_t *) {
+        // The index can get dropped while we're blocked on a node, which destroys its
+        // filter, so we look it up again every time.
+        sindex_bloom_filter_t *filter = store->get_sindex_bloom_filter(sindex_id);
+        if (filter == nullptr) {
+            return continue_bool_t::ABORT;
+        }
+        filter->add_rebuilt_key(store_key_t(keyvalue.key()));
+        if (++num_traversed % YIELD_INTERVAL == 0) {
+            // If the nodes are all in the cache, the traversal doesn't block on
+            // anything, so we must give other coroutines a chance to run.
+            coro_t::yield();
+        }
+        return continue_bool_t::CONTINUE;
+    }
+    static const size_t YIELD_INTERVAL = 1024;
+private:
+    store_t *store;
+    uuid_u sindex_id;
+    size_t num_traversed;
+};
+
+void store_t::rebuild_sindex_bloom_filter(
+        uuid_u sindex_id,
+        auto_drainer_t::lock_t store_keepalive)
+        THROWS_NOTHING {
+    bool reached_end = false;
+    try {
+        // We read from a snapshot so that we don't hold up writes while we traverse
+        // the whole index, and through the scan account so that we don't push the
+        // pages of other queries out of the cache.  Keys that get inserted after we
+        // take the snapshot go into the new filter through `note_sindex_key()`.
+        read_token_t token;
+        new_read_token(&token);
+        scoped_ptr_t<txn_t> txn;
+        scoped_ptr_t<real_superblock_t> superblock;
+        acquire_superblock_for_read(&token,
+                                    &txn,
+                                    &superblock,
+                                    store_keepalive.get_drain_signal(),
+                                    true /* use snapshot */);
+        txn->set_account(cache->scan_reads_account());
+
+        buf_lock_t sindex_block(superblock->expose_buf(),
+                                superblock->get_sindex_block_id(),
+                                access_t::read);
+        superblock->release();
+
+        secondary_index_t sindex;
+        if (get_secondary_index(&sindex_block, sindex_id, &sindex)
+            && !sindex.being_deleted) {
+            buf_lock_t sindex_superblock_lock(buf_parent_t(&sindex_block),
+                                              sindex.superblock, access_t::read);
+            sindex_block.reset_buf_lock();
+            sindex_superblock_t sindex_superblock(std::move(sindex_superblock_lock));
+
+            sindex_bloom_filter_rebuild_cb_t traversal_cb(this, sindex_id);
+            reached_end =
+                (continue_bool_t::CONTINUE == btree_depth_first_traversal(
+                    &sindex_superblock,
+                    key_range_t::universe(),
+                    &traversal_cb,
+                    access_t::read,
+                    direction_t::FORWARD,
+                    release_superblock_t::RELEASE,
+                    store_keepalive.get_drain_signal()));
+        }
+    } catch (const interrupted_exc_t &) {
+        // We're shutting down.
+    }
+
+    sindex_bloom_filter_t *filter = get_sindex_bloom_filter(sindex_id);
+    if (filter != nullptr) {
+        if (reached_end) {
+            filter->finish_rebuild();
+        } else {
+            filter->abandon_rebuild();
+        }
+    }
+}
+
 sindex_name_t compute_sindex_deletion_name(uuid_u sindex_uuid) {
     sindex_name_t result("_DEL_" + uuid_to_str(sindex_uuid));
     result.being_deleted = true;
@@ -910,6 +1078,7 @@ void store_t::drop_sindex(uuid_u sindex_id) THROWS_NOTHING {
     sindex_superblock_lock.write_acq_signal()->wait_lazily_unordered();
     sindex_superblock_lock.mark_deleted();
     ::delete_secondary_index(&sindex_block, compute_sindex_deletion_name(sindex.id));
+    sindex_bloom_filters.erase(sindex.id);
     size_t num_erased = secondary_index_slices.erase(sindex.id);
     guarantee(num_erased == 1);
 
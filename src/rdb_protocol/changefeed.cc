@@ -995,6 +995,7 @@ public:
                     sorting,
                     ops}),
             sorting,
+            false /* is_scan */,
             &resp,
             release_superblock_t::KEEP);
         auto *gs = boost::get<ql::grouped_t<ql::stream_t> >(&resp.result);
@@ -1075,6 +1076,7 @@ public:
             sorting,
             require_sindexes_t::NO,
             *ref.sindex_info,
+            nullptr,
             &resp,
             release_superblock_t::KEEP);
         auto *gs = boost::get<ql::grouped_t<ql::stream_t> >(&resp.result);
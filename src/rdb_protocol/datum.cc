@@ -22,6 +22,7 @@
 #include "rapidjson/rapidjson.h"
 #include "rapidjson/stringbuffer.h"
 #include "rapidjson/writer.h"
+#include "rdb_protocol/datum_json_writer.hpp"
 #include "rdb_protocol/datum_stream/array.hpp"
 #include "rdb_protocol/env.hpp"
 #include "rdb_protocol/error.hpp"
@@ -1574,6 +1575,7 @@ template void datum_t::write_json(
     rapidjson::Writer<rapidjson::StringBuffer> *writer) const;
 template void datum_t::write_json(
     rapidjson::PrettyWriter<rapidjson::StringBuffer> *writer) const;
+template void datum_t::write_json(datum_json_writer_t *writer) const;
 
 rapidjson::Value datum_t::as_json(rapidjson::Value::AllocatorType *allocator) const {
     switch (get_type()) {
@@ -1840,6 +1842,97 @@ int datum_t::cmp(const datum_t &rhs) const {
         });
 }
 
+// The finalizer of MurmurHash3, which spreads every input bit over the output.
+uint64_t hash_finish(uint64_t h) {
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdULL;
+    h ^= h >> 33;
+    h *= 0xc4ceb9fe1a85ec53ULL;
+    h ^= h >> 33;
+    return h;
+}
+
+uint64_t hash_combine(uint64_t h, uint64_t value) {
+    return hash_finish(h ^ (value + 0x9e3779b97f4a7c15ULL + (h << 6) + (h >> 2)));
+}
+
+uint64_t hash_bytes(uint64_t h, const char *data, size_t size) {
+    h = hash_combine(h, size);
+    size_t i = 0;
+    for (; i + sizeof(uint64_t) <= size; i += sizeof(uint64_t)) {
+        uint64_t word;
+        memcpy(&word, data + i, sizeof(word));
+        h = hash_combine(h, word);
+    }
+    uint64_t tail = 0;
+    memcpy(&tail, data + i, size - i);
+    return hash_combine(h, tail);
+}
+
+uint64_t hash_number(double d) {
+    // -0.0 and 0.0 compare as equal.
+    if (d == 0.0) {
+        d = 0.0;
+    }
+    uint64_t bits;
+    memcpy(&bits, &d, sizeof(bits));
+    return hash_combine(datum_t::R_NUM, bits);
+}
+
+uint64_t datum_t::hash_unchecked_stack() const {
+    // This has to follow `cmp_unchecked_stack`.  Pseudotypes that don't compare as
+    // objects are compared by `pseudo_cmp`, which only looks at the epoch time of
+    // times and fails for the ones it doesn't know.  We give all of the latter the
+    // same hash, so they still get compared and fail like they used to.
+    if (is_ptype() && !pseudo_compares_as_obj()) {
+        if (get_type() == R_BINARY) {
+            const datum_string_t &binary = as_binary();
+            return hash_bytes(R_BINARY, binary.data(), binary.size());
+        } else if (get_reql_type() == pseudo::time_string) {
+            return hash_combine(R_OBJECT,
+                                hash_number(pseudo::time_to_epoch_time(*this)));
+        }
+        return R_OBJECT;
+    }
+
+    switch (get_type()) {
+    case R_NULL: // fallthru
+    case MINVAL: // fallthru
+    case MAXVAL: // fallthru
+    case R_BOOL: return hash_combine(get_type(), get_type() == R_BOOL && as_bool());
+    case R_NUM: return hash_number(as_num());
+    case R_STR: return hash_bytes(R_STR, as_str().data(), as_str().size());
+    case R_ARRAY: {
+        const size_t sz = arr_size();
+        uint64_t h = hash_combine(R_ARRAY, sz);
+        for (size_t i = 0; i < sz; ++i) {
+            h = hash_combine(h, unchecked_get(i).hash());
+        }
+        return h;
+    }
+    case R_OBJECT: {
+        // The fields are sorted by key, so equal objects hash them in the same order.
+        const size_t sz = obj_size();
+        uint64_t h = hash_combine(R_OBJECT, sz);
+        for (size_t i = 0; i < sz; ++i) {
+            auto pair = unchecked_get_pair(i);
+            h = hash_bytes(h, pair.first.data(), pair.first.size());
+            h = hash_combine(h, pair.second.hash());
+        }
+        return h;
+    }
+    case R_BINARY: // This should be handled by the ptype code above
+    case UNINITIALIZED: // fallthru
+    default: unreachable();
+    }
+}
+
+uint64_t datum_t::hash() const {
+    return call_with_enough_stack_datum<uint64_t>([&] {
+            return this->hash_unchecked_stack();
+        });
+}
+
 bool datum_t::operator==(const datum_t &rhs) const { return cmp(rhs) == 0; }
 bool datum_t::operator!=(const datum_t &rhs) const { return cmp(rhs) != 0; }
 bool datum_t::operator<(const datum_t &rhs) const { return cmp(rhs) < 0; }
@@ -301,8 +301,8 @@ public:
                   const configured_limits_t &limits,
                   std::set<std::string> *conditions) const;
 
-    // json_writer_t can be rapidjson::Writer<rapidjson::StringBuffer>
-    // or rapidjson::PrettyWriter<rapidjson::StringBuffer>
+    // json_writer_t can be rapidjson::Writer<rapidjson::StringBuffer>,
+    // rapidjson::PrettyWriter<rapidjson::StringBuffer> or datum_json_writer_t
     template <class json_writer_t> void write_json(json_writer_t *writer) const;
     rapidjson::Value as_json(rapidjson::Value::AllocatorType *allocator) const;
 
@@ -317,6 +317,10 @@ public:
     // alphabetically by type name.
     int cmp(const datum_t &rhs) const;
 
+    // Returns a hash that is the same for any two datums that `cmp` finds equal, and
+    // doesn't depend on the process, so it can be used across servers.
+    uint64_t hash() const;
+
     // operator== and operator!= don't take a reql_version_t, unlike other comparison
     // functions, because we know (by inspection) that the behavior of cmp() hasn't
     // changed with respect to the question of equality vs. inequality.
@@ -400,6 +404,7 @@ private:
         std::string *str_out) const;
 
     int cmp_unchecked_stack(const datum_t &rhs) const;
+    uint64_t hash_unchecked_stack() const;
 
     int pseudo_cmp(const datum_t &rhs) const;
     bool pseudo_compares_as_obj() const;
@@ -0,0 +1,153 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#ifndef RDB_PROTOCOL_DATUM_HASH_MAP_HPP_
+#define RDB_PROTOCOL_DATUM_HASH_MAP_HPP_
+
+#include <stdint.h>
+
+#include <algorithm>
+#include <limits>
+#include <utility>
+#include <vector>
+
+#include "rdb_protocol/datum.hpp"
+#include "rdb_protocol/datum_utils.hpp"
+
+namespace ql {
+
+/* A map from datums to `T`s that finds keys by their `datum_t::hash()`, with open
+addressing, instead of by comparing them like `std::map<datum_t, T>` does.  Keys can
+be empty `datum_t()`s, like the keys of `grouped_t`.
+
+The entries are kept in a vector in the order they were inserted.  The table holds
+their indexes, along with the top half of their hashes, so that most probes that run
+into another key don't have to compare it.  Inserting invalidates pointers to the
+values. */
+template <class T>
+class datum_hash_map_t {
+public:
+    typedef std::pair<datum_t, T> value_type;
+    typedef typename std::vector<value_type>::iterator iterator;
+
+    datum_hash_map_t() : num_slots(0) { }
+
+    size_t size() const { return entries.size(); }
+    iterator begin() { return entries.begin(); }
+    iterator end() { return entries.end(); }
+
+    // Returns the value for `key`, or `nullptr` if there is none.
+    T *find(const datum_t &key) {
+        if (entries.empty()) {
+            return nullptr;
+        }
+        const uint64_t hash = hash_key(key);
+        for (size_t pos = hash & (num_slots - 1); ; pos = (pos + 1) & (num_slots - 1)) {
+            const slot_t &slot = slots[pos];
+            if (slot.index == EMPTY_SLOT) {
+                return nullptr;
+            }
+            if (slot.tag == tag_of(hash) && keys_equal(entries[slot.index].first, key)) {
+                return &entries[slot.index].second;
+            }
+        }
+    }
+
+    // Like `std::map::insert`, returns the value for `key` and whether it was
+    // inserted, with a copy of `default_value`.
+    std::pair<T *, bool> insert(const datum_t &key, const T &default_value) {
+        if ((entries.size() + 1) * 2 > num_slots) {
+            grow();
+        }
+        const uint64_t hash = hash_key(key);
+        size_t pos = hash & (num_slots - 1);
+        for (; slots[pos].index != EMPTY_SLOT; pos = (pos + 1) & (num_slots - 1)) {
+            const slot_t &slot = slots[pos];
+            if (slot.tag == tag_of(hash) && keys_equal(entries[slot.index].first, key)) {
+                return std::make_pair(&entries[slot.index].second, false);
+            }
+        }
+        guarantee(entries.size() < EMPTY_SLOT);
+        slots[pos].index = entries.size();
+        slots[pos].tag = tag_of(hash);
+        entries.push_back(value_type(key, default_value));
+        hashes.push_back(hash);
+        return std::make_pair(&entries.back().second, true);
+    }
+
+    // Removes the entry that was inserted last.  No other key can have been put after
+    // it in the table, so emptying its slot doesn't cut any key off from where it was
+    // put.
+    void erase_last() {
+        guarantee(!entries.empty());
+        size_t pos = hashes.back() & (num_slots - 1);
+        while (slots[pos].index != entries.size() - 1) {
+            pos = (pos + 1) & (num_slots - 1);
+        }
+        slots[pos].index = EMPTY_SLOT;
+        entries.pop_back();
+        hashes.pop_back();
+    }
+
+    void clear() {
+        entries.clear();
+        hashes.clear();
+        slots.clear();
+        num_slots = 0;
+    }
+
+    // Moves the entries out, sorted by key like a `grouped_t`'s, and leaves the map
+    // empty.
+    std::vector<value_type> release_sorted() {
+        std::vector<value_type> res;
+        res.swap(entries);
+        clear();
+        optional_datum_less_t less;
+        std::sort(res.begin(), res.end(),
+                  [&](const value_type &a, const value_type &b) {
+                      return less(a.first, b.first);
+                  });
+        return res;
+    }
+
+private:
+    static const uint32_t EMPTY_SLOT = std::numeric_limits<uint32_t>::max();
+
+    struct slot_t {
+        uint32_t index;
+        uint32_t tag;
+    };
+
+    static uint64_t hash_key(const datum_t &key) {
+        return key.has() ? key.hash() : 0;
+    }
+    static uint32_t tag_of(uint64_t hash) {
+        return hash >> 32;
+    }
+    static bool keys_equal(const datum_t &a, const datum_t &b) {
+        return a.has() ? b.has() && a == b : !b.has();
+    }
+
+    void grow() {
+        num_slots = std::max<size_t>(8, num_slots * 2);
+        slots.assign(num_slots, slot_t{EMPTY_SLOT, 0});
+        for (size_t i = 0; i < entries.size(); ++i) {
+            size_t pos = hashes[i] & (num_slots - 1);
+            while (slots[pos].index != EMPTY_SLOT) {
+                pos = (pos + 1) & (num_slots - 1);
+            }
+            slots[pos].index = i;
+            slots[pos].tag = tag_of(hashes[i]);
+        }
+    }
+
+    std::vector<value_type> entries;
+    // The hash of each entry's key, so the table can be grown without hashing them
+    // again.
+    std::vector<uint64_t> hashes;
+    std::vector<slot_t> slots;
+    // The size of `slots`, a power of two.
+    size_t num_slots;
+};
+
+}  // namespace ql
+
+#endif  // RDB_PROTOCOL_DATUM_HASH_MAP_HPP_
@@ -0,0 +1,278 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#include "rdb_protocol/datum_json_writer.hpp"
+
+#include <math.h>
+#include <string.h>
+
+#if defined(__x86_64__)
+#include <immintrin.h>
+#endif
+
+#include "rapidjson/internal/itoa.h"
+
+namespace ql {
+
+namespace {
+
+// The characters that rapidjson escapes, and what it escapes them with.  Control
+// characters without a short escape are written as `\u00XX`.
+const char json_escapes[256] = {
+#define Z16 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0
+    'u', 'u', 'u', 'u', 'u', 'u', 'u', 'u', 'b', 't', 'n', 'u', 'f', 'r', 'u', 'u',
+    'u', 'u', 'u', 'u', 'u', 'u', 'u', 'u', 'u', 'u', 'u', 'u', 'u', 'u', 'u', 'u',
+    0, 0, '"', 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    Z16, Z16,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, '\\', 0, 0, 0,
+    Z16, Z16, Z16, Z16, Z16, Z16, Z16, Z16, Z16, Z16
+#undef Z16
+};
+
+typedef size_t (*find_escape_fn_t)(const char *, size_t);
+
+// Returns the index of the first character in `str` that has to be escaped, or
+// `size` if there is none.
+__attribute__((always_inline)) inline size_t find_escape_scalar(const char *str,
+                                                                size_t size) {
+    size_t i = 0;
+    while (i < size && json_escapes[static_cast<unsigned char>(str[i])] == 0) {
+        ++i;
+    }
+    return i;
+}
+
+#if defined(__x86_64__)
+
+// Returns a mask of the bytes among the 16 at `str` that have to be escaped.  SSE2
+// only has signed byte compares, so we find the control characters by checking
+// which bytes `max(x, 0x1F)` leaves at 0x1F.
+//
+// This gets inlined into the AVX2 version too, where it's compiled to VEX encoded
+// instructions.  Calling a legacy SSE function from AVX code instead is very slow on
+// some CPUs.
+__attribute__((always_inline)) inline uint32_t escape_mask_16(const char *str) {
+    const __m128i quote = _mm_set1_epi8('"');
+    const __m128i backslash = _mm_set1_epi8('\\');
+    const __m128i control = _mm_set1_epi8(0x1F);
+    __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i *>(str));
+    __m128i found = _mm_or_si128(
+        _mm_or_si128(_mm_cmpeq_epi8(x, quote), _mm_cmpeq_epi8(x, backslash)),
+        _mm_cmpeq_epi8(_mm_max_epu8(x, control), control));
+    return _mm_movemask_epi8(found);
+}
+
+// Checks the bytes from `i` on, when there are fewer than 16 of them left.  If the
+// string is at least 16 bytes long, we check its last 16 bytes and ignore the ones
+// before `i`, rather than going through the rest one at a time.
+__attribute__((always_inline)) inline size_t find_escape_tail(const char *str,
+                                                              size_t size,
+                                                              size_t i) {
+    if (i == size || size < 16) {
+        return i + find_escape_scalar(str + i, size - i);
+    }
+    const size_t start = size - 16;
+    const uint32_t mask = escape_mask_16(str + start) >> (i - start);
+    return mask == 0 ? size : i + __builtin_ctz(mask);
+}
+
+size_t find_escape_sse2(const char *str, size_t size) {
+    size_t i = 0;
+    for (; i + 16 <= size; i += 16) {
+        uint32_t mask = escape_mask_16(str + i);
+        if (mask != 0) {
+            return i + __builtin_ctz(mask);
+        }
+    }
+    return find_escape_tail(str, size, i);
+}
+
+__attribute__((target("avx2")))
+size_t find_escape_avx2(const char *str, size_t size) {
+    const __m256i quote = _mm256_set1_epi8('"');
+    const __m256i backslash = _mm256_set1_epi8('\\');
+    const __m256i control = _mm256_set1_epi8(0x1F);
+    size_t i = 0;
+    for (; i + 32 <= size; i += 32) {
+        __m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(str + i));
+        __m256i found = _mm256_or_si256(
+            _mm256_or_si256(_mm256_cmpeq_epi8(x, quote),
+                            _mm256_cmpeq_epi8(x, backslash)),
+            _mm256_cmpeq_epi8(_mm256_max_epu8(x, control), control));
+        uint32_t mask = _mm256_movemask_epi8(found);
+        if (mask != 0) {
+            return i + __builtin_ctz(mask);
+        }
+    }
+    if (i + 16 <= size) {
+        uint32_t mask = escape_mask_16(str + i);
+        if (mask != 0) {
+            return i + __builtin_ctz(mask);
+        }
+        i += 16;
+    }
+    return find_escape_tail(str, size, i);
+}
+
+find_escape_fn_t detect_find_escape() {
+    // We run during static initialization, so we need to call this first.
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) {
+        return &find_escape_avx2;
+    } else {
+        return &find_escape_sse2;
+    }
+}
+
+const find_escape_fn_t find_escape = detect_find_escape();
+
+#else
+
+const find_escape_fn_t find_escape = &find_escape_scalar;
+
+#endif
+
+// Powers of ten from 1e-5 to 1e16.  The ones from 1e0 on are exact.
+const double powers_of_ten[] = {
+    1e-5, 1e-4, 1e-3, 1e-2, 1e-1, 1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9,
+    1e10, 1e11, 1e12, 1e13, 1e14, 1e15, 1e16
+};
+
+double power_of_ten(int exponent) {
+    return powers_of_ten[exponent + 5];
+}
+
+// We only look for representations with at most this many significant digits.  A
+// double has more precision than that anywhere in its range, by a margin we use
+// below.
+const int MAX_SHORT_DIGITS = 12;
+
+// Writes `d` to `buffer` the way `rapidjson::internal::dtoa` would, if it has at most
+// MAX_SHORT_DIGITS significant digits and a fractional part, and it's big enough
+// that rapidjson wouldn't use an exponent for it.  Returns the end of what it wrote,
+// or `nullptr` if `d` isn't like that.
+//
+// We round `d` to `fraction_digits` decimal places, choosing that so the result has
+// MAX_SHORT_DIGITS digits, and check that the result converts back to `d`.  A
+// decimal place there is bigger than `d`'s precision, so if any shorter decimal
+// converts back to `d` it's the one we round to, with trailing zeros.  (Grisu2,
+// which dtoa uses, sometimes writes a longer decimal than needed, so our output is
+// occasionally shorter than rapidjson's.  It converts back to the same double.)
+char *write_short_double(double d, char *buffer) {
+    const double magnitude = fabs(d);
+    if (!(magnitude >= 1e-5 && magnitude < 1e12)
+        || static_cast<double>(static_cast<int64_t>(d)) == d) {
+        // Integers are written with a `.0`, which we leave to dtoa.
+        return nullptr;
+    }
+    int integer_digits = -4;
+    while (magnitude >= power_of_ten(integer_digits)) {
+        ++integer_digits;
+    }
+    int fraction_digits = MAX_SHORT_DIGITS - integer_digits;
+    const double scaled = magnitude * power_of_ten(fraction_digits);
+    const uint64_t rounded = static_cast<uint64_t>(scaled + 0.5);
+    // If `d` has a short representation, `scaled` is within about 1e-4 of it.  This
+    // cheaply rules out most doubles that don't, before we divide.
+    if (fabs(scaled - static_cast<double>(rounded)) > 1e-3
+        || static_cast<double>(rounded) / power_of_ten(fraction_digits) != magnitude) {
+        return nullptr;
+    }
+
+    uint64_t digits = rounded;
+    while (digits % 10 == 0) {
+        digits /= 10;
+        --fraction_digits;
+    }
+
+    char digit_buffer[20];
+    const int num_digits = rapidjson::internal::u64toa(digits, digit_buffer)
+        - digit_buffer;
+    char *out = buffer;
+    if (d < 0) {
+        *out++ = '-';
+    }
+    if (num_digits > fraction_digits) {
+        const int whole_digits = num_digits - fraction_digits;
+        memcpy(out, digit_buffer, whole_digits);
+        out += whole_digits;
+        *out++ = '.';
+        memcpy(out, digit_buffer + whole_digits, fraction_digits);
+        out += fraction_digits;
+    } else {
+        *out++ = '0';
+        *out++ = '.';
+        memset(out, '0', fraction_digits - num_digits);
+        out += fraction_digits - num_digits;
+        memcpy(out, digit_buffer, num_digits);
+        out += num_digits;
+    }
+    return out;
+}
+
+}  // namespace
+
+bool datum_json_writer_t::String(const char *str, rapidjson::SizeType length, bool) {
+    Prefix(rapidjson::kStringType);
+
+    size_t run = find_escape(str, length);
+    if (run == length) {
+        // Most strings don't need any escaping.
+        char *out = os_->Push(length + 2);
+        out[0] = '"';
+        memcpy(out + 1, str, length);
+        out[length + 1] = '"';
+        return true;
+    }
+
+    static const char hex_digits[16] = {
+        '0', '1', '2', '3', '4', '5', '6', '7',
+        '8', '9', 'A', 'B', 'C', 'D', 'E', 'F' };
+    os_->Put('"');
+    size_t i = 0;
+    for (;;) {
+        memcpy(os_->Push(run), str + i, run);
+        i += run;
+        if (i == length) {
+            break;
+        }
+        const unsigned char c = str[i];
+        const char escape = json_escapes[c];
+        if (escape == 'u') {
+            char *out = os_->Push(6);
+            out[0] = '\\';
+            out[1] = 'u';
+            out[2] = '0';
+            out[3] = '0';
+            out[4] = hex_digits[c >> 4];
+            out[5] = hex_digits[c & 0xF];
+        } else {
+            char *out = os_->Push(2);
+            out[0] = '\\';
+            out[1] = escape;
+        }
+        ++i;
+        run = find_escape(str + i, length - i);
+    }
+    os_->Put('"');
+    return true;
+}
+
+bool datum_json_writer_t::Double(double d) {
+    Prefix(rapidjson::kNumberType);
+    char *buffer = os_->Push(25);
+    char *end = write_short_double(d, buffer);
+    if (end == nullptr) {
+        end = rapidjson::internal::dtoa(d, buffer);
+    }
+    os_->Pop(25 - (end - buffer));
+    return true;
+}
+
+bool datum_json_writer_t::is_avx2_accelerated() {
+#if defined(__x86_64__)
+    return find_escape == &find_escape_avx2;
+#else
+    return false;
+#endif
+}
+
+}  // namespace ql
@@ -0,0 +1,46 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#ifndef RDB_PROTOCOL_DATUM_JSON_WRITER_HPP_
+#define RDB_PROTOCOL_DATUM_JSON_WRITER_HPP_
+
+#include "errors.hpp"
+#include "rapidjson/stringbuffer.h"
+#include "rapidjson/writer.h"
+
+namespace ql {
+
+/* A `rapidjson::Writer` for encoding datums into responses, which writes the same
+JSON faster.  `datum_t::write_json` is a template, so it calls these versions of
+`String`, `Key` and `Double` instead of the base class's.
+
+Strings are scanned for characters that need escaping 16 or 32 bytes at a time with
+SSE2 or AVX2, and the runs in between are copied into the buffer at once, where
+rapidjson escapes and copies them a byte at a time.  Doubles that have a short
+decimal representation, like `0.25` or `12.99`, are formatted directly from that
+instead of through Grisu.  Grisu sometimes writes a few more digits than it needs
+to, so a double can come out shorter than rapidjson would write it, but it always
+parses back to the same value. */
+class datum_json_writer_t : public rapidjson::Writer<rapidjson::StringBuffer> {
+public:
+    explicit datum_json_writer_t(rapidjson::StringBuffer &buffer)
+        : rapidjson::Writer<rapidjson::StringBuffer>(buffer) { }
+
+    using rapidjson::Writer<rapidjson::StringBuffer>::String;
+    using rapidjson::Writer<rapidjson::StringBuffer>::Key;
+
+    bool String(const char *str, rapidjson::SizeType length, bool copy = false);
+    bool Key(const char *str, rapidjson::SizeType length, bool copy = false) {
+        return String(str, length, copy);
+    }
+    bool Double(double d);
+
+    // Returns true if the CPU lets us scan strings with AVX2 (otherwise we use SSE2,
+    // or a lookup table).
+    static bool is_avx2_accelerated();
+
+private:
+    DISABLE_COPYING(datum_json_writer_t);
+};
+
+}  // namespace ql
+
+#endif  // RDB_PROTOCOL_DATUM_JSON_WRITER_HPP_
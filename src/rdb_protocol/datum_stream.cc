@@ -7,6 +7,7 @@
 #include "rdb_protocol/datum_stream/array.hpp"
 #include "rdb_protocol/datum_stream/eq_join.hpp"
 #include "rdb_protocol/datum_stream/fold.hpp"
+#include "rdb_protocol/datum_stream/in_memory_sort.hpp"
 #include "rdb_protocol/datum_stream/indexed_sort.hpp"
 #include "rdb_protocol/datum_stream/lazy.hpp"
 #include "rdb_protocol/datum_stream/map.hpp"
@@ -1069,6 +1070,10 @@ rget_read_t primary_readgen_t::next_read_impl(
         ? region_t(active_ranges_to_range(*active_ranges))
         : region_t(datumspec.covering_range().to_primary_keyrange());
     r_sanity_check(!region.inner.is_empty());
+    // Reading the whole table is a scan, and shouldn't push the pages of other
+    // queries out of the cache.
+    const bool is_scan = !store_keys.has_value()
+        && datumspec.covering_range().to_primary_keyrange() == key_range_t::universe();
     return rget_read_t(
         std::move(stamp),
         std::move(region),
@@ -1080,7 +1085,8 @@ rget_read_t primary_readgen_t::next_read_impl(
         std::move(transforms),
         optional<terminal_variant_t>(),
         optional<sindex_rangespec_t>(),
-        sorting(batchspec));
+        sorting(batchspec),
+        is_scan);
 }
 
 void primary_readgen_t::sindex_sort(
@@ -1153,8 +1159,7 @@ void sindex_readgen_t::sindex_sort(
         return;
     }
     if (sorting(batchspec) != sorting_t::UNORDERED) {
-        std::stable_sort(vec->begin(), vec->end(),
-                         sindex_compare_t(sorting(batchspec)));
+        sort_by_sindex(vec, sorting(batchspec));
     }
 }
 
@@ -1197,7 +1202,8 @@ rget_read_t sindex_readgen_t::next_read_impl(
                                          std::move(region),
                                          std::move(ds),
                                          require_sindex_val)),
-        sorting(batchspec));
+        sorting(batchspec),
+        false /* is_scan */);
 }
 
 key_range_t sindex_readgen_t::original_keyrange(reql_version_t rv) const {
@@ -1622,6 +1628,91 @@ indexed_sort_datum_stream_t::next_raw_batch(env_t *env, const batchspec_t &batch
     return ret;
 }
 
+// IN_MEMORY_SORT_DATUM_STREAM_T
+in_memory_sort_datum_stream_t::in_memory_sort_datum_stream_t(
+    std::vector<datum_t> &&_data,
+    std::function<bool(env_t *,  // NOLINT(readability/casting)
+                       profile::sampler_t *,
+                       const datum_t &,
+                       const datum_t &)> _lt_cmp,
+    backtrace_id_t _bt)
+    : eager_datum_stream_t(_bt),
+      lt_cmp(_lt_cmp),
+      data(std::move(_data)),
+      sorted(false),
+      index(0) { }
+
+bool in_memory_sort_datum_stream_t::is_exhausted() const {
+    return index >= data.size() && batch_cache_exhausted();
+}
+feed_type_t in_memory_sort_datum_stream_t::cfeed_type() const {
+    return feed_type_t::not_feed;
+}
+bool in_memory_sort_datum_stream_t::is_infinite() const {
+    return false;
+}
+bool in_memory_sort_datum_stream_t::is_array() const {
+    return !is_grouped();
+}
+
+void in_memory_sort_datum_stream_t::select_first(
+        env_t *env, profile::sampler_t *sampler, size_t n) {
+    // Whether `data[i]` comes before `data[j]` in the stable sort.
+    auto before = [&](size_t i, size_t j) {
+        return i < j
+            ? !lt_cmp(env, sampler, data[j], data[i])
+            : lt_cmp(env, sampler, data[i], data[j]);
+    };
+    // A heap of the first `n` elements so far, with the last of them on top.
+    first.clear();
+    first.reserve(n);
+    for (size_t i = 0; i < data.size(); ++i) {
+        if (first.size() < n) {
+            first.push_back(i);
+            std::push_heap(first.begin(), first.end(), before);
+        } else if (before(i, first.front())) {
+            std::pop_heap(first.begin(), first.end(), before);
+            first.back() = i;
+            std::push_heap(first.begin(), first.end(), before);
+        }
+    }
+    std::sort_heap(first.begin(), first.end(), before);
+}
+
+std::vector<datum_t>
+in_memory_sort_datum_stream_t::next_raw_batch(env_t *env, const batchspec_t &batchspec) {
+    std::vector<datum_t> ret;
+    if (index >= data.size()) {
+        return ret;
+    }
+
+    profile::sampler_t sampler("Sorting in-memory.", env->trace);
+    if (!sorted && index == first.size()) {
+        // Selecting `n` elements takes about one comparison per element when `n` is
+        // much smaller than `data`, but it's slower than sorting otherwise.
+        const int64_t wanted = batchspec.get_max_els();
+        if (index == 0 && wanted > 0
+            && static_cast<uint64_t>(wanted) <= data.size() / 16) {
+            select_first(env, &sampler, wanted);
+        } else {
+            // The elements we returned from `first` are the same as the ones at the
+            // start of `data` once it's sorted.
+            std::stable_sort(data.begin(), data.end(),
+                             std::bind(lt_cmp, env, &sampler, ph::_1, ph::_2));
+            sorted = true;
+        }
+    }
+
+    batcher_t batcher = batchspec.to_batcher();
+    const size_t available = sorted ? data.size() : first.size();
+    for (; index < available && !batcher.should_send_batch(); ++index) {
+        datum_t el = sorted ? std::move(data[index]) : data[first[index]];
+        batcher.note_el(el);
+        ret.push_back(std::move(el));
+    }
+    return ret;
+}
+
 // ORDERED_DISTINCT_DATUM_STREAM_T
 ordered_distinct_datum_stream_t::ordered_distinct_datum_stream_t(
     counted_t<datum_stream_t> _source) : wrapper_datum_stream_t(_source) { }
@@ -2313,6 +2404,18 @@ eq_join_datum_stream_t::eq_join_datum_stream_t(counted_t<datum_stream_t> _stream
     eq_join_type(stream->cfeed_type()) { }
 
 std::vector<datum_t> eq_join_datum_stream_t::next_raw_batch(
+    env_t *env,
+    const batchspec_t &batchspec) {
+    try {
+        return next_joined_batch(env, batchspec);
+    } catch (const interrupted_exc_t &) {
+        // The query is being stopped, so a running prefetch won't be used either.
+        prefetch_abort.pulse_if_not_already_pulsed();
+        throw;
+    }
+}
+
+std::vector<datum_t> eq_join_datum_stream_t::next_joined_batch(
     env_t *env,
     const batchspec_t &batchspec) {
     batcher_t batcher = batchspec.to_batcher();
@@ -2327,8 +2430,7 @@ std::vector<datum_t> eq_join_datum_stream_t::next_raw_batch(
             (get_all_reader->is_finished() &&
              get_all_items.empty())) {
             // Get a new batch of keys
-            std::vector<datum_t> stream_batch = stream->next_batch(env,
-                                                                   inner_batchspec);
+            std::vector<datum_t> stream_batch = next_left_batch(env, inner_batchspec);
             if (stream_batch.empty()) {
                 // We got an empty batch from the input stream. It's either exhausted
                 // or a changefeed. In either case we abort and emit our current results.
@@ -2351,11 +2453,14 @@ std::vector<datum_t> eq_join_datum_stream_t::next_raw_batch(
                         throw;
                     }
                 }
-                // Build a multimap from sindex value to datums from left side stream.
+                // Build a hash table from sindex value to datums from left side
+                // stream.
                 if (key_val.get_type() != datum_t::type_t::R_NULL) {
-                    sindex_to_datum.insert(std::pair<datum_t, datum_t>{
-                            key_val, stream_batch[i]});
-                    keys[key_val] = 1;
+                    auto rows = sindex_to_datum.insert(key_val, std::vector<datum_t>());
+                    rows.first->push_back(stream_batch[i]);
+                    if (rows.second) {
+                        keys[key_val] = 1;
+                    }
                 }
             }
             get_all_reader = table->get_all_with_sindexes(
@@ -2363,6 +2468,7 @@ std::vector<datum_t> eq_join_datum_stream_t::next_raw_batch(
                 datumspec_t(std::move(keys)),
                 join_index.to_std(),
                 backtrace());
+            maybe_prefetch_left_batch(env, inner_batchspec);
         }
         if (get_all_items.empty()) {
             get_all_items = get_all_reader->raw_next_batch(env, batchspec);
@@ -2375,21 +2481,21 @@ std::vector<datum_t> eq_join_datum_stream_t::next_raw_batch(
             continue;
         }
         // Get each item in get_all results, and match it with all datums that match
-        // in the multimap from the left side stream.
-        std::pair<std::multimap<datum_t, datum_t>::iterator,
-                  std::multimap<datum_t, datum_t>::iterator> range;
-        if (item.sindex_key.has()) {
-            range = sindex_to_datum.equal_range(item.sindex_key);
-        } else {
-            range = sindex_to_datum.equal_range(item.data.get_field(join_index));
+        // in the hash table from the left side stream.
+        const std::vector<datum_t> *matches = sindex_to_datum.find(
+            item.sindex_key.has()
+                ? item.sindex_key
+                : item.data.get_field(join_index));
+        if (matches == nullptr) {
+            continue;
         }
         datum_string_t right("right");
         datum_string_t left("left");
-        for (auto pair = range.first; pair != range.second; ++pair) {
+        for (const datum_t &match : *matches) {
             ql::datum_object_builder_t res_item;
             bool conflict = true;
             conflict &= res_item.add(right, item.data);
-            conflict &= res_item.add(left, pair->second);
+            conflict &= res_item.add(left, match);
             guarantee(!conflict);
             datum_t res_datum = std::move(res_item).to_datum();
             batcher.note_el(res_datum);
@@ -2399,8 +2505,58 @@ std::vector<datum_t> eq_join_datum_stream_t::next_raw_batch(
     return res;
 }
 
+std::vector<datum_t> eq_join_datum_stream_t::next_left_batch(
+        env_t *env, const batchspec_t &batchspec) {
+    if (!prefetch_done.has()) {
+        return stream->next_batch(env, batchspec);
+    }
+    wait_interruptible(prefetch_done.get(), env->interruptor);
+    prefetch_done.reset();
+    if (prefetch_exc) {
+        std::exception_ptr exc = prefetch_exc;
+        prefetch_exc = std::exception_ptr();
+        std::rethrow_exception(exc);
+    }
+    return std::move(prefetched_batch);
+}
+
+void eq_join_datum_stream_t::maybe_prefetch_left_batch(
+        env_t *env, const batchspec_t &batchspec) {
+    // A changefeed on the left side may not have a batch for a long time, and we
+    // don't want to hold on to a read of it after we've returned.
+    if (stream->cfeed_type() != feed_type_t::not_feed || stream->is_exhausted()) {
+        return;
+    }
+    r_sanity_check(!prefetch_done.has());
+    if (env->trace != nullptr && !prefetch_trace.has()) {
+        prefetch_trace = make_scoped<profile::trace_t>();
+        prefetch_disabler = make_scoped<profile::disabler_t>(prefetch_trace.get());
+    }
+    prefetch_done = make_scoped<cond_t>();
+    auto_drainer_t::lock_t lock(&drainer);
+    coro_t::spawn_sometime([this, batchspec, lock,
+                            rdb_ctx = env->get_rdb_ctx(),
+                            return_empty = env->return_empty_normal_batches,
+                            s_env = env->get_serializable_env()]() {
+        // `env`'s interruptor only lives as long as the request that started us, and
+        // the prefetch may still be running when that request returns.
+        wait_any_t interruptor(lock.get_drain_signal(), &prefetch_abort);
+        try {
+            env_t prefetch_env(rdb_ctx, return_empty, &interruptor, s_env,
+                               prefetch_trace.get_or_null());
+            prefetched_batch = stream->next_batch(&prefetch_env, batchspec);
+        } catch (...) {
+            // This includes being interrupted because we're being destroyed or the
+            // query is being stopped, in which case nobody will look at it.
+            prefetch_exc = std::current_exception();
+        }
+        prefetch_done->pulse();
+    });
+}
+
 bool eq_join_datum_stream_t::is_exhausted() const {
     if (stream->is_exhausted() &&
+        !prefetch_done.has() &&
         get_all_items.empty() &&
         (!get_all_reader.has() || get_all_reader->is_finished())) {
         return batch_cache_exhausted();
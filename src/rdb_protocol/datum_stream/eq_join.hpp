@@ -1,6 +1,12 @@
 #ifndef RDB_PROTOCOL_DATUM_STREAM_EQ_JOIN_HPP_
 #define RDB_PROTOCOL_DATUM_STREAM_EQ_JOIN_HPP_
 
+#include <exception>
+#include <vector>
+
+#include "concurrency/auto_drainer.hpp"
+#include "concurrency/cond_var.hpp"
+#include "rdb_protocol/datum_hash_map.hpp"
 #include "rdb_protocol/datum_stream.hpp"
 
 namespace ql {
@@ -30,6 +36,16 @@ public:
     }
 
 private:
+    // Does the work of `next_raw_batch`, which interrupts the prefetch if it throws
+    // `interrupted_exc_t`.
+    std::vector<datum_t> next_joined_batch(env_t *env, const batchspec_t &batchspec);
+    // Returns the next batch of the left side, which may have been prefetched.
+    std::vector<datum_t> next_left_batch(env_t *env, const batchspec_t &batchspec);
+    // Starts reading the next batch of the left side in a coroutine, so that it's
+    // read while we wait for the `getAll` of the current one.  If the query stops
+    // reading from us, e.g. because of a `limit`, that batch is read for nothing.
+    void maybe_prefetch_left_batch(env_t *env, const batchspec_t &batchspec);
+
     counted_t<datum_stream_t> stream;
     scoped_ptr_t<reader_t> get_all_reader;
     std::vector<rget_item_t> get_all_items;
@@ -37,8 +53,9 @@ private:
     counted_t<table_t> table;
     datum_string_t join_index;
 
-    std::multimap<ql::datum_t,
-                  ql::datum_t> sindex_to_datum;
+    // The rows of the left side's current batch, by the value they join on, in the
+    // order they came in.
+    datum_hash_map_t<std::vector<datum_t> > sindex_to_datum;
 
     counted_t<const func_t> predicate;
 
@@ -47,6 +64,23 @@ private:
     bool is_array_eq_join;
     bool is_infinite_eq_join;
     feed_type_t eq_join_type;
+
+    // The prefetch can't use the `env_t` of the query, which only one coroutine may
+    // use at a time, so it gets its own like `union_datum_stream_t` does.  Set the
+    // first time we prefetch, if the query is being profiled.
+    scoped_ptr_t<profile::trace_t> prefetch_trace;
+    scoped_ptr_t<profile::disabler_t> prefetch_disabler;
+    // Pulsed when the query is interrupted while reading from us, to interrupt a
+    // running prefetch along with it.
+    cond_t prefetch_abort;
+    // Set while a prefetch is running or its batch hasn't been used yet, and pulsed
+    // once the batch (or the exception) is there.
+    scoped_ptr_t<cond_t> prefetch_done;
+    std::vector<datum_t> prefetched_batch;
+    std::exception_ptr prefetch_exc;
+
+    // Interrupts a running prefetch when we're destroyed.
+    auto_drainer_t drainer;
 };
 
 
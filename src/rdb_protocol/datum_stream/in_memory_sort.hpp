@@ -0,0 +1,50 @@
+#ifndef RDB_PROTOCOL_DATUM_STREAM_IN_MEMORY_SORT_HPP_
+#define RDB_PROTOCOL_DATUM_STREAM_IN_MEMORY_SORT_HPP_
+
+#include <functional>
+#include <vector>
+
+#include "rdb_protocol/datum_stream.hpp"
+
+namespace ql {
+
+// Stably sorts `data` for `order_by` without an index, when it's first read.  If
+// the first read asks for only a few elements, like `order_by(...).limit(n)` does,
+// we just select the smallest ones with a heap, and only sort the rest if more are
+// read after them.
+class in_memory_sort_datum_stream_t : public eager_datum_stream_t {
+public:
+    in_memory_sort_datum_stream_t(
+        std::vector<datum_t> &&data,
+        std::function<bool(env_t *,  // NOLINT(readability/casting)
+                           profile::sampler_t *,
+                           const datum_t &,
+                           const datum_t &)> lt_cmp,
+        backtrace_id_t bt);
+    virtual bool is_exhausted() const;
+    virtual feed_type_t cfeed_type() const;
+    virtual bool is_infinite() const;
+
+private:
+    virtual bool is_array() const;
+    virtual std::vector<datum_t>
+    next_raw_batch(env_t *env, const batchspec_t &batchspec);
+
+    // Fills `first` with the indexes of the `n` elements that come first in the
+    // sorted order, in that order.
+    void select_first(env_t *env, profile::sampler_t *sampler, size_t n);
+
+    std::function<bool(env_t *,  // NOLINT(readability/casting)
+                       profile::sampler_t *,
+                       const datum_t &,
+                       const datum_t &)> lt_cmp;
+    std::vector<datum_t> data;
+    // Whether `data` has been sorted, otherwise we read `data[first[index]]`.
+    bool sorted;
+    std::vector<size_t> first;
+    size_t index;
+};
+
+}  // namespace ql
+
+#endif  // RDB_PROTOCOL_DATUM_STREAM_IN_MEMORY_SORT_HPP_
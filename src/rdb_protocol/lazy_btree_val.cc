@@ -4,6 +4,7 @@
 #include "containers/archive/buffer_group_stream.hpp"
 #include "containers/archive/versioned.hpp"
 #include "rdb_protocol/blob_wrapper.hpp"
+#include "rdb_protocol/serialize_datum.hpp"
 
 ql::datum_t get_data(const rdb_value_t *value, buf_parent_t parent) {
     // TODO: Just use deserialize_from_blob?
@@ -11,6 +12,16 @@ ql::datum_t get_data(const rdb_value_t *value, buf_parent_t parent) {
                             const_cast<rdb_value_t *>(value)->value_ref(),
                             blob::btree_maxreflen);
 
+    const int64_t size = blob.valuesize();
+    if (size >= blob::large_value_threshold) {
+        // Read large values straight into the buffer that backs the datum, instead
+        // of keeping all of their blocks acquired while we deserialize them.
+        counted_t<shared_buf_t> buf = shared_buf_t::create(size);
+        blob.read_all(parent, buf->data());
+        return ql::datum_deserialize_from_buf(shared_buf_ref_t<char>(std::move(buf), 0),
+                                              0);
+    }
+
     ql::datum_t data;
 
     blob_acq_t acq_group;
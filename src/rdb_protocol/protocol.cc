@@ -1501,7 +1501,7 @@ RDB_IMPL_SERIALIZABLE_4_FOR_CLUSTER(sindex_rangespec_t,
 ARCHIVE_PRIM_MAKE_RANGED_SERIALIZABLE(
         sorting_t, int8_t,
         sorting_t::UNORDERED, sorting_t::DESCENDING);
-RDB_IMPL_SERIALIZABLE_12_FOR_CLUSTER(
+RDB_IMPL_SERIALIZABLE_13_FOR_CLUSTER(
     rget_read_t,
     stamp,
     region,
@@ -1514,7 +1514,8 @@ RDB_IMPL_SERIALIZABLE_12_FOR_CLUSTER(
     transforms,
     terminal,
     sindex,
-    sorting);
+    sorting,
+    is_scan);
 RDB_IMPL_SERIALIZABLE_9_FOR_CLUSTER(
     intersecting_geo_read_t,
     stamp,
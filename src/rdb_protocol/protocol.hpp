@@ -294,7 +294,7 @@ RDB_DECLARE_SERIALIZABLE_FOR_CLUSTER(changefeed_stamp_t);
 
 class rget_read_t {
 public:
-    rget_read_t() : batchspec(ql::batchspec_t::empty()) { }
+    rget_read_t() : batchspec(ql::batchspec_t::empty()), is_scan(false) { }
 
     rget_read_t(optional<changefeed_stamp_t> &&_stamp,
                 region_t _region,
@@ -306,7 +306,8 @@ public:
                 std::vector<ql::transform_variant_t> _transforms,
                 optional<ql::terminal_variant_t> &&_terminal,
                 optional<sindex_rangespec_t> &&_sindex,
-                sorting_t _sorting)
+                sorting_t _sorting,
+                bool _is_scan)
     : stamp(std::move(_stamp)),
       region(std::move(_region)),
       hints(std::move(_hints)),
@@ -317,7 +318,8 @@ public:
       transforms(std::move(_transforms)),
       terminal(std::move(_terminal)),
       sindex(std::move(_sindex)),
-      sorting(std::move(_sorting)) { }
+      sorting(std::move(_sorting)),
+      is_scan(_is_scan) { }
 
     optional<changefeed_stamp_t> stamp;
 
@@ -343,6 +345,11 @@ public:
     optional<sindex_rangespec_t> sindex;
 
     sorting_t sorting; // Optional sorting info (UNORDERED means no sorting).
+
+    // True if the query reads the whole table, so that the read should go through
+    // the cache's scan account.  `region` can't tell us that, because it only covers
+    // one shard and gets narrowed as the query reads more batches.
+    bool is_scan;
 };
 RDB_DECLARE_SERIALIZABLE_FOR_CLUSTER(rget_read_t);
 
@@ -2,6 +2,7 @@
 #include "rdb_protocol/query_cache.hpp"
 
 #include "rdb_protocol/env.hpp"
+#include "rdb_protocol/func.hpp"
 #include "rdb_protocol/pseudo_time.hpp"
 #include "rdb_protocol/response.hpp"
 #include "rdb_protocol/term_walker.hpp"
@@ -17,6 +18,7 @@ query_cache_t::query_cache_t(
         client_addr_port(_client_addr_port),
         return_empty_normal_batches(_return_empty_normal_batches),
         user_context(std::move(_user_context)),
+        next_prepared_query_id(0),
         next_query_id(0),
         oldest_outstanding_query_id(0) {
     auto res = rdb_ctx->get_query_caches_for_this_thread()->insert(this);
@@ -36,25 +38,17 @@ query_cache_t::const_iterator query_cache_t::end() const {
     return queries.end();
 }
 
-scoped_ptr_t<query_cache_t::ref_t> query_cache_t::create(query_params_t *query_params,
-                                                         ql::datum_t &&deterministic_time,
-                                                         signal_t *interruptor) {
-    guarantee(this == query_params->query_cache);
-    query_params->maybe_release_query_id();
-    if (queries.find(query_params->token) != queries.end()) {
-        throw bt_exc_t(Response::CLIENT_ERROR, Response::QUERY_LOGIC,
-            strprintf("ERROR: duplicate token %" PRIi64, query_params->token),
-            backtrace_registry_t::EMPTY_BACKTRACE);
-    }
-
-    global_optargs_t global_optargs;
-    counted_t<const term_t> term_tree;
+// Preprocesses and compiles the query in `query_params`.
+static void compile_query(query_params_t *query_params,
+                          global_optargs_t *global_optargs_out,
+                          counted_t<const term_t> *term_tree_out) {
     try {
         query_params->term_storage->preprocess();
-        global_optargs = query_params->term_storage->global_optargs();
+        *global_optargs_out = query_params->term_storage->global_optargs();
 
         compile_env_t compile_env((var_visibility_t()));
-        term_tree = compile_term(&compile_env, query_params->term_storage->root_term());
+        *term_tree_out = compile_term(&compile_env,
+                                      query_params->term_storage->root_term());
 
     } catch (const exc_t &e) {
         throw bt_exc_t(Response::COMPILE_ERROR,
@@ -67,11 +61,91 @@ scoped_ptr_t<query_cache_t::ref_t> query_cache_t::create(query_params_t *query_p
                        e.what(),
                        backtrace_registry_t::EMPTY_BACKTRACE);
     }
+}
+
+scoped_ptr_t<query_cache_t::ref_t> query_cache_t::create(query_params_t *query_params,
+                                                         ql::datum_t &&deterministic_time,
+                                                         signal_t *interruptor) {
+    guarantee(this == query_params->query_cache);
+    query_params->maybe_release_query_id();
+    if (queries.find(query_params->token) != queries.end()) {
+        throw bt_exc_t(Response::CLIENT_ERROR, Response::QUERY_LOGIC,
+            strprintf("ERROR: duplicate token %" PRIi64, query_params->token),
+            backtrace_registry_t::EMPTY_BACKTRACE);
+    }
+
+    global_optargs_t global_optargs;
+    counted_t<const term_t> term_tree;
+    compile_query(query_params, &global_optargs, &term_tree);
     scoped_ptr_t<entry_t> entry(new entry_t(query_params,
                                             std::move(global_optargs),
                                             std::move(deterministic_time),
                                             std::move(term_tree)));
+    return add_entry(query_params, std::move(entry), interruptor);
+}
+
+int64_t query_cache_t::prepare(query_params_t *query_params) {
+    guarantee(this == query_params->query_cache);
+    query_params->maybe_release_query_id();
+
+    global_optargs_t global_optargs;
+    counted_t<const term_t> func_term;
+    compile_query(query_params, &global_optargs, &func_term);
+    if (query_params->term_storage->root_term().type() != Term::FUNC) {
+        throw bt_exc_t(Response::COMPILE_ERROR, Response::QUERY_LOGIC,
+            "Expected the term of a PREPARE query to be a function.",
+            backtrace_registry_t::EMPTY_BACKTRACE);
+    }
+
+    if (prepared_queries.size() >= MAX_PREPARED_QUERIES_PER_CONNECTION) {
+        // Running EXECUTE queries keep their prepared query alive.
+        prepared_queries.erase(prepared_queries.begin());
+    }
+    const int64_t id = next_prepared_query_id++;
+    counted_t<const prepared_query_t> prepared_query(
+        new prepared_query_t(std::move(query_params->term_storage),
+                             std::move(global_optargs),
+                             std::move(func_term)));
+    auto insert_res = prepared_queries.insert(
+        std::make_pair(id, std::move(prepared_query)));
+    guarantee(insert_res.second);
+    return id;
+}
+
+scoped_ptr_t<query_cache_t::ref_t> query_cache_t::execute(query_params_t *query_params,
+                                                          ql::datum_t &&deterministic_time,
+                                                          signal_t *interruptor) {
+    guarantee(this == query_params->query_cache);
+    query_params->maybe_release_query_id();
+    if (queries.find(query_params->token) != queries.end()) {
+        throw bt_exc_t(Response::CLIENT_ERROR, Response::QUERY_LOGIC,
+            strprintf("ERROR: duplicate token %" PRIi64, query_params->token),
+            backtrace_registry_t::EMPTY_BACKTRACE);
+    }
 
+    // Only the arguments get deserialized, the rest was compiled by `prepare()`.
+    int64_t prepared_query_id;
+    std::vector<datum_t> args;
+    query_params->term_storage->execute_args(&prepared_query_id, &args);
+    auto it = prepared_queries.find(prepared_query_id);
+    if (it == prepared_queries.end()) {
+        throw bt_exc_t(Response::CLIENT_ERROR, Response::QUERY_LOGIC,
+            strprintf("Prepared query %" PRIi64 " not found.  It may have been "
+                      "forgotten to make room for newer ones.", prepared_query_id),
+            backtrace_registry_t::EMPTY_BACKTRACE);
+    }
+
+    scoped_ptr_t<entry_t> entry(new entry_t(query_params,
+                                            counted_t<const prepared_query_t>(it->second),
+                                            std::move(args),
+                                            std::move(deterministic_time)));
+    return add_entry(query_params, std::move(entry), interruptor);
+}
+
+scoped_ptr_t<query_cache_t::ref_t> query_cache_t::add_entry(
+        query_params_t *query_params,
+        scoped_ptr_t<entry_t> &&entry,
+        signal_t *interruptor) {
     scoped_ptr_t<ref_t> ref(new ref_t(this,
                                       query_params->token,
                                       std::move(query_params->throttler),
@@ -256,13 +330,13 @@ void query_cache_t::ref_t::fill_response(response_t *res) {
         throw bt_exc_t(Response::RUNTIME_ERROR,
                        ex.get_error_type(),
                        ex.what(),
-                       entry->term_storage->backtrace_registry().datum_backtrace(ex));
+                       entry->get_term_storage()->backtrace_registry().datum_backtrace(ex));
     } catch (const datum_exc_t &ex) {
         query_cache->terminate_internal(entry);
         throw bt_exc_t(Response::RUNTIME_ERROR,
                        ex.get_error_type(),
                        ex.what(),
-                       entry->term_storage->backtrace_registry().datum_backtrace(
+                       entry->get_term_storage()->backtrace_registry().datum_backtrace(
                             backtrace_id_t::empty(), 0));
     } catch (const std::exception &ex) {
         query_cache->terminate_internal(entry);
@@ -276,6 +350,9 @@ void query_cache_t::ref_t::fill_response(response_t *res) {
 void query_cache_t::ref_t::run(env_t *env, response_t *res) {
     scope_env_t scope_env(env, var_scope_t());
     scoped_ptr_t<val_t> val = entry->term_tree->eval(&scope_env);
+    if (entry->prepared_query.has()) {
+        val = val->as_func()->call(env, entry->args);
+    }
 
     if (val->get_type().is_convertible(val_t::type_t::DATUM)) {
         res->set_type(Response::SUCCESS_ATOM);
@@ -377,6 +454,33 @@ query_cache_t::entry_t::entry_t(query_params_t *query_params,
         term_tree(std::move(_term_tree)),
         has_sent_batch(false) { }
 
+query_cache_t::entry_t::entry_t(query_params_t *query_params,
+                                counted_t<const prepared_query_t> &&_prepared_query,
+                                std::vector<datum_t> &&_args,
+                                ql::datum_t &&_deterministic_time) :
+        state(state_t::START),
+        interrupt_reason(interrupt_reason_t::UNKNOWN),
+        job_id(generate_uuid()),
+        noreply(query_params->noreply),
+        profile(query_params->profile ? profile_bool_t::PROFILE :
+                                        profile_bool_t::DONT_PROFILE),
+        term_storage(std::move(query_params->term_storage)),
+        global_optargs(_prepared_query->global_optargs),
+        prepared_query(std::move(_prepared_query)),
+        args(std::move(_args)),
+        deterministic_time(_deterministic_time),
+        start_time(get_kiloticks()),
+        term_tree(prepared_query->func_term),
+        has_sent_batch(false) { }
+
 query_cache_t::entry_t::~entry_t() { }
 
+query_cache_t::prepared_query_t::prepared_query_t(
+            scoped_ptr_t<const term_storage_t> &&_term_storage,
+            global_optargs_t &&_global_optargs,
+            counted_t<const term_t> &&_func_term) :
+        term_storage(std::move(_term_storage)),
+        global_optargs(std::move(_global_optargs)),
+        func_term(std::move(_func_term)) { }
+
 } // namespace ql
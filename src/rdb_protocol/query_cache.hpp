@@ -8,6 +8,7 @@
 #include <map>
 #include <set>
 #include <string>
+#include <vector>
 
 #include "arch/address.hpp"
 #include "clustering/administration/auth/user_context.hpp"
@@ -32,8 +33,13 @@
 
 namespace ql {
 
+// The most prepared queries a single connection may have.  Preparing another one
+// forgets the oldest.
+#define MAX_PREPARED_QUERIES_PER_CONNECTION 1024
+
 class query_cache_t : public home_thread_mixin_t {
     class entry_t;
+    class prepared_query_t;
 public:
     query_cache_t(rdb_context_t *_rdb_ctx,
                   ip_and_port_t _client_addr_port,
@@ -89,6 +95,19 @@ public:
     scoped_ptr_t<ref_t> get(query_params_t *query_params,
                             signal_t *interruptor);
 
+    // Compiles the function in a PREPARE query and keeps it around, so that EXECUTE
+    // queries can call it without parsing or compiling it again.  Returns the id
+    // that EXECUTE queries refer to it by.
+    int64_t prepare(query_params_t *query_params);
+
+    // Like `create()`, but for an EXECUTE query, which calls a prepared query with
+    // the arguments it carries.
+    scoped_ptr_t<ref_t> execute(query_params_t *query_params,
+                                ql::datum_t &&deterministic_time,
+                                signal_t *interruptor);
+
+    bool has_prepared_queries() const { return !prepared_queries.empty(); }
+
     void noreply_wait(const query_params_t &query_params,
                       signal_t *interruptor);
 
@@ -103,14 +122,42 @@ public:
     auth::user_context_t const &get_user_context() const;
 
 private:
+    class prepared_query_t : public single_threaded_countable_t<prepared_query_t> {
+    public:
+        prepared_query_t(scoped_ptr_t<const term_storage_t> &&_term_storage,
+                         global_optargs_t &&_global_optargs,
+                         counted_t<const term_t> &&_func_term);
+
+        const scoped_ptr_t<const term_storage_t> term_storage;
+        const global_optargs_t global_optargs;
+        // Evaluates to the function that EXECUTE queries call.
+        const counted_t<const term_t> func_term;
+
+    private:
+        DISABLE_COPYING(prepared_query_t);
+    };
+
     class entry_t {
     public:
         entry_t(query_params_t *query_params,
                 global_optargs_t &&_global_optargs,
                 ql::datum_t &&_deterministic_time,
                 counted_t<const term_t> &&_term_tree);
+        // For EXECUTE queries.
+        entry_t(query_params_t *query_params,
+                counted_t<const prepared_query_t> &&_prepared_query,
+                std::vector<datum_t> &&_args,
+                ql::datum_t &&_deterministic_time);
         ~entry_t();
 
+        // The term storage the query's terms come from, which for an EXECUTE query
+        // is the one of the prepared query.
+        const term_storage_t *get_term_storage() const {
+            return prepared_query.has()
+                ? prepared_query->term_storage.get()
+                : term_storage.get();
+        }
+
         enum class state_t { START, STREAM, DONE, DELETING } state;
         interrupt_reason_t interrupt_reason;
 
@@ -119,6 +166,10 @@ private:
         const profile_bool_t profile;
         const scoped_ptr_t<const term_storage_t> term_storage;
         const global_optargs_t global_optargs;
+        // Only set for EXECUTE queries, in which case `term_tree` evaluates to the
+        // function that we call with `args`.
+        const counted_t<const prepared_query_t> prepared_query;
+        const std::vector<datum_t> args;
         // TODO: deterministic_time and start_time represent approximately the same
         // time, but we can't compute one from the other because pseudo::time_now() uses
         // boost::posix_time.
@@ -146,12 +197,20 @@ private:
 
     static void async_destroy_entry(entry_t *entry);
 
+    scoped_ptr_t<ref_t> add_entry(query_params_t *query_params,
+                                  scoped_ptr_t<entry_t> &&entry,
+                                  signal_t *interruptor);
+
     rdb_context_t *const rdb_ctx;
     ip_and_port_t client_addr_port;
     return_empty_normal_batches_t return_empty_normal_batches;
     auth::user_context_t user_context;
     std::map<int64_t, scoped_ptr_t<entry_t> > queries;
 
+    // Ids only ever grow, so the first prepared query is the oldest one.
+    int64_t next_prepared_query_id;
+    std::map<int64_t, counted_t<const prepared_query_t> > prepared_queries;
+
     // Used for noreply waiting, this contains all allocated-but-incomplete query ids
     friend class query_params_t::query_id_t;
     uint64_t next_query_id;
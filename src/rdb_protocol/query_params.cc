@@ -71,7 +71,10 @@ query_params_t::query_params_t(int64_t _token,
         id(query_cache), token(_token), noreply(false), profile(false) {
     // Parse out information that is needed before query evaluation
     type = term_storage->query_type();
-    noreply = term_storage->static_optarg_as_bool("noreply", noreply);
+    // A PREPARE query's reply is the id of the prepared query, which the client
+    // needs to run it, so we always send it.
+    noreply = type != Query::PREPARE
+        && term_storage->static_optarg_as_bool("noreply", noreply);
     profile = term_storage->static_optarg_as_bool("profile", profile);
 }
 
@@ -12,10 +12,12 @@
 rdb_query_server_t::rdb_query_server_t(
     const std::set<ip_address_t> &local_addresses, int port,
     rdb_context_t *_rdb_ctx, server_config_client_t *_server_config_client,
-    const server_id_t &_server_id, tls_ctx_t *tls_ctx
+    const server_id_t &_server_id, tls_ctx_t *tls_ctx,
+    bool rebalance_connections
 ) :
     server(
-        _rdb_ctx, local_addresses, port, this, default_http_timeout_sec, tls_ctx
+        _rdb_ctx, local_addresses, port, this, default_http_timeout_sec, tls_ctx,
+        rebalance_connections
     ),
     rdb_ctx(_rdb_ctx),
     server_config_client(_server_config_client),
@@ -46,6 +48,17 @@ void rdb_query_server_t::run_query(ql::query_params_t *query_params,
                                                   interruptor);
             query_ref->fill_response(response_out);
         } break;
+        case Query::PREPARE: {
+            int64_t id = query_params->query_cache->prepare(query_params);
+            response_out->set_type(Response::SUCCESS_ATOM);
+            response_out->set_data(ql::datum_t(static_cast<double>(id)));
+        } break;
+        case Query::EXECUTE: {
+            scoped_ptr_t<ql::query_cache_t::ref_t> query_ref =
+                query_params->query_cache->execute(query_params, ql::pseudo::time_now(),
+                                                   interruptor);
+            query_ref->fill_response(response_out);
+        } break;
         case Query::CONTINUE: {
             scoped_ptr_t<ql::query_cache_t::ref_t> query_ref =
                 query_params->query_cache->get(query_params, interruptor);
@@ -7,6 +7,7 @@
 #include <boost/variant.hpp>
 
 #include "debug.hpp"
+#include "rdb_protocol/datum_hash_map.hpp"
 #include "rdb_protocol/func.hpp"
 #include "rdb_protocol/profile.hpp"
 #include "rdb_protocol/protocol.hpp"
@@ -26,6 +27,19 @@ void debug_print(printf_buffer_t *buf, const rget_item_t &item) {
     buf->appendf("}");
 }
 
+void sort_by_sindex(raw_stream_t *stream, sorting_t sorting) {
+    // Below this size moving to another thread and back would take longer than the
+    // sorting itself.
+    const size_t MIGRATABLE_SORT_SIZE = 1000;
+    if (stream->size() >= MIGRATABLE_SORT_SIZE) {
+        migratable_section_t migratable;
+        std::stable_sort(stream->begin(), stream->end(),
+                         sindex_compare_t(sorting, &migratable));
+    } else {
+        std::stable_sort(stream->begin(), stream->end(), sindex_compare_t(sorting));
+    }
+}
+
 void debug_print(printf_buffer_t *buf, const keyed_stream_t &stream) {
     buf->appendf("keyed_stream_t(");
     debug_print(buf, stream.stream);
@@ -67,6 +81,19 @@ void dprint(const char *s, const datum_t &t) {
 }
 #endif // NDEBUG
 
+// Moves the groups of `acc` into `out`, which must be empty.
+template<class T>
+void groups_to_grouped(datum_hash_map_t<T> *acc, grouped_t<T> *out) {
+    guarantee(out->size() == 0);
+    auto *map = out->get_underlying_map();
+    for (auto &&pair : acc->release_sorted()) {
+        map->emplace_hint(map->end(), std::move(pair));
+    }
+}
+
+// The groups are accumulated in a hash map, so that each row only has to hash its
+// group rather than compare it with O(log n) others.  They only get sorted when they
+// are returned as a `grouped_t`.
 template<class T>
 class grouped_acc_t : public accumulator_t {
 protected:
@@ -76,7 +103,7 @@ protected:
 
     virtual void finish_impl(continue_bool_t, result_t *out) {
         *out = grouped_t<T>();
-        boost::get<grouped_t<T> >(*out).swap(acc);
+        groups_to_grouped(&acc, boost::get<grouped_t<T> >(out));
         guarantee(acc.size() == 0);
     }
 private:
@@ -86,16 +113,16 @@ private:
             const store_key_t &key,
             const std::function<datum_t()> &lazy_sindex_val) {
         for (auto it = groups->begin(); it != groups->end(); ++it) {
-            auto pair = acc.insert(std::make_pair(it->first, default_val));
-            auto t_it = pair.first;
+            auto pair = acc.insert(it->first, default_val);
             bool keep = !pair.second;
             for (auto el = it->second.begin(); el != it->second.end(); ++el) {
-                keep |= accumulate(env, *el, &t_it->second, key, lazy_sindex_val);
+                keep |= accumulate(env, *el, pair.first, key, lazy_sindex_val);
             }
             if (!keep) {
-                acc.erase(t_it);
+                acc.erase_last();
             }
         }
+        check_num_groups(env);
         return should_send_batch() ? continue_bool_t::ABORT : continue_bool_t::CONTINUE;
     }
     virtual bool accumulate(env_t *env,
@@ -108,29 +135,40 @@ private:
 
     virtual void unshard(env_t *env, const std::vector<result_t *> &results) {
         guarantee(acc.size() == 0);
-        std::map<datum_t, std::vector<T *>, optional_datum_less_t> vecs;
+        datum_hash_map_t<std::vector<T *> > vecs;
         r_sanity_check(results.size() != 0);
         for (auto res = results.begin(); res != results.end(); ++res) {
             guarantee(*res);
             grouped_t<T> *gres = boost::get<grouped_t<T> >(*res);
             guarantee(gres);
             for (auto kv = gres->begin(); kv != gres->end(); ++kv) {
-                vecs[kv->first].push_back(&kv->second);
+                vecs.insert(kv->first, std::vector<T *>()).first->push_back(
+                    &kv->second);
             }
         }
         for (auto kv = vecs.begin(); kv != vecs.end(); ++kv) {
-            auto t_it = acc.insert(std::make_pair(kv->first, default_val)).first;
-            unshard_impl(env, &t_it->second, kv->second);
+            T *t = acc.insert(kv->first, default_val).first;
+            unshard_impl(env, t, kv->second);
         }
+        check_num_groups(env);
     }
     virtual void unshard_impl(env_t *env, T *acc, const std::vector<T *> &ts) = 0;
 
 protected:
     const T *get_default_val() { return &default_val; }
-    grouped_t<T> *get_acc() { return &acc; }
+    datum_hash_map_t<T> *get_acc() { return &acc; }
+
+    // Keeps the memory the groups take bounded, like `group_trans_t` does for the
+    // groups of a batch.
+    void check_num_groups(env_t *env) {
+        rcheck_toplevel(acc.size() <= env->limits().array_size_limit(),
+                        base_exc_t::RESOURCE,
+                        strprintf("Too many groups (> %zu).",
+                                  env->limits().array_size_limit()));
+    }
 private:
     const T default_val;
-    grouped_t<T> acc;
+    datum_hash_map_t<T> acc;
 };
 
 class append_t : public grouped_acc_t<stream_t> {
@@ -431,9 +469,7 @@ private:
                         bool is_sindex = pair.second.stream[0].sindex_key.get_type()
                             != datum_t::UNINITIALIZED;
                         if (is_sindex) {
-                            std::stable_sort(pair.second.stream.begin(),
-                                             pair.second.stream.end(),
-                                             sindex_compare_t(sorting));
+                            sort_by_sindex(&pair.second.stream, sorting);
                         }
                         if (is_sindex_sort) {
                             r_sanity_check(*is_sindex_sort == is_sindex);
@@ -511,27 +547,27 @@ protected:
     explicit terminal_t(T &&t) : grouped_acc_t<T>(std::move(t)) { }
 private:
     virtual void operator()(env_t *env, groups_t *groups) {
-        grouped_t<T> *_acc = grouped_acc_t<T>::get_acc();
+        datum_hash_map_t<T> *_acc = grouped_acc_t<T>::get_acc();
         const T *_default_val = grouped_acc_t<T>::get_default_val();
         for (auto it = groups->begin(); it != groups->end(); ++it) {
-            auto pair = _acc->insert(std::make_pair(it->first, *_default_val));
-            auto t_it = pair.first;
+            auto pair = _acc->insert(it->first, *_default_val);
             bool keep = !pair.second;
             for (auto el = it->second.begin(); el != it->second.end(); ++el) {
-                keep |= accumulate(env, *el, &t_it->second);
+                keep |= accumulate(env, *el, pair.first);
             }
             if (!keep) {
-                _acc->erase(t_it);
+                _acc->erase_last();
             }
         }
         groups->clear();
+        grouped_acc_t<T>::check_num_groups(env);
     }
 
     virtual scoped_ptr_t<val_t> finish_eager(backtrace_id_t bt,
                                              bool is_grouped,
                                              UNUSED const configured_limits_t &limits) {
         accumulator_t::mark_finished();
-        grouped_t<T> *_acc = grouped_acc_t<T>::get_acc();
+        datum_hash_map_t<T> *_acc = grouped_acc_t<T>::get_acc();
         const T *_default_val = grouped_acc_t<T>::get_default_val();
         scoped_ptr_t<val_t> retval;
         if (is_grouped) {
@@ -556,24 +592,21 @@ private:
     virtual datum_t unpack(T *t) = 0;
 
     virtual void add_res(env_t *env, result_t *res, sorting_t) {
-        grouped_t<T> *_acc = grouped_acc_t<T>::get_acc();
+        datum_hash_map_t<T> *_acc = grouped_acc_t<T>::get_acc();
         const T *_default_val = grouped_acc_t<T>::get_default_val();
         if (auto e = boost::get<exc_t>(res)) {
             throw *e;
         }
         grouped_t<T> *gres = boost::get<grouped_t<T> >(res);
         r_sanity_check(gres);
-        if (_acc->size() == 0) {
-            _acc->swap(*gres);
-        } else {
-            // Order in fact does NOT matter here.  The reason is, each `kv->first`
-            // value is different, which means each operation works on a different
-            // key/value pair of `acc`.
-            for (auto kv = gres->begin(); kv != gres->end(); ++kv) {
-                auto t_it = _acc->insert(std::make_pair(kv->first, *_default_val)).first;
-                unshard_impl(env, &t_it->second, &kv->second);
-            }
+        // Order in fact does NOT matter here.  The reason is, each `kv->first`
+        // value is different, which means each operation works on a different
+        // key/value pair of `acc`.
+        for (auto kv = gres->begin(); kv != gres->end(); ++kv) {
+            T *t = _acc->insert(kv->first, *_default_val).first;
+            unshard_impl(env, t, &kv->second);
         }
+        grouped_acc_t<T>::check_num_groups(env);
     }
 
     virtual bool accumulate(env_t *env,
@@ -1000,10 +1033,16 @@ private:
 // Note: this removes duplicates ONLY TO SAVE NETWORK TRAFFIC.  It's possible
 // for duplicates to survive, either because they're on different shards or
 // because they span batch boundaries.  `ordered_distinct_datum_stream_t` in
-// `datum_stream.cc` removes any duplicates that survive this `lst_transform`.
+// `datum_stream.cc`, or `distinct_term_t` for unordered streams, removes any
+// duplicates that survive this `lst_transform`.
+//
+// Sorted streams only have adjacent duplicates, which `last_val` catches.  Once we
+// see that the values aren't sorted, we also remember the ones we've kept in a hash
+// map, so that we can drop duplicates wherever they are in the batch.
 class distinct_trans_t : public ungrouped_op_t {
 public:
-    explicit distinct_trans_t(const distinct_wire_func_t &f) : use_index(f.use_index) { }
+    explicit distinct_trans_t(const distinct_wire_func_t &f)
+        : use_index(f.use_index), direction(0), sorted(true) { }
 private:
     // sindex_val may be NULL
     virtual void lst_transform(
@@ -1016,7 +1055,20 @@ private:
                 r_sanity_check(sindex_val.has());
                 *it = sindex_val;
             }
-            if (!last_val.has() || *it != last_val) {
+            if (sorted && last_val.has()) {
+                const int c = it->cmp(last_val);
+                if (c == 0) {
+                    continue;
+                } else if (direction == 0) {
+                    direction = c;
+                } else if ((c < 0) != (direction < 0)) {
+                    sorted = false;
+                    for (auto kept = lst->begin(); kept != loc; ++kept) {
+                        seen.insert(*kept, true);
+                    }
+                }
+            }
+            if (sorted || seen.insert(*it, true).second) {
                 std::swap(*loc, *it);
                 last_val = *loc;
                 ++loc;
@@ -1026,6 +1078,11 @@ private:
     }
     bool use_index;
     datum_t last_val;
+    // The sign of the first comparison between consecutive values, or 0.
+    int direction;
+    bool sorted;
+    // The values are unused.
+    datum_hash_map_t<bool> seen;
 };
 
 
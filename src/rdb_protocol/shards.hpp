@@ -9,6 +9,7 @@
 #include <vector>
 
 #include "arch/runtime/coroutines.hpp"
+#include "arch/runtime/migratable_section.hpp"
 #include "btree/concurrent_traversal.hpp"
 #include "btree/keys.hpp"
 #include "containers/archive/stl_types.hpp"
@@ -63,17 +64,23 @@ struct rget_item_t {
 RDB_DECLARE_SERIALIZABLE(rget_item_t);
 
 // `sindex_compare_t` may block if there are a large number of things being compared.
+// If `migratable` is given, it may also move the coroutine to another thread.
 class sindex_compare_t {
 public:
-    explicit sindex_compare_t(sorting_t _sorting)
-        : sorting(_sorting), iterations_since_last_yield(0) { }
+    explicit sindex_compare_t(sorting_t _sorting,
+                              migratable_section_t *_migratable = nullptr)
+        : sorting(_sorting), migratable(_migratable), iterations_since_last_yield(0) { }
     bool operator()(const rget_item_t &l, const rget_item_t &r) {
         r_sanity_check(l.sindex_key.has() && r.sindex_key.has());
 
         ++iterations_since_last_yield;
         const size_t YIELD_INTERVAL = 10000;
         if (iterations_since_last_yield % YIELD_INTERVAL == 0) {
-            coro_t::yield();
+            if (migratable != nullptr) {
+                migratable->yield_point();
+            } else {
+                coro_t::yield();
+            }
         }
 
         int cmp = l.sindex_key.cmp(r.sindex_key);
@@ -89,12 +96,19 @@ public:
     }
 private:
     sorting_t sorting;
+    migratable_section_t *migratable;
     size_t iterations_since_last_yield;
 };
 
 void debug_print(printf_buffer_t *, const rget_item_t &);
 
 typedef std::vector<rget_item_t> raw_stream_t;
+
+// Stably sorts `stream` by secondary index key with `sindex_compare_t`.  Large
+// streams are sorted in a `migratable_section_t`, so that a busy thread can hand the
+// sorting over to an idle one.
+void sort_by_sindex(raw_stream_t *stream, sorting_t sorting);
+
 struct keyed_stream_t {
     raw_stream_t stream;
     store_key_t last_key;
@@ -0,0 +1,184 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#include "rdb_protocol/sindex_bloom_filter.hpp"
+
+#include <string.h>
+
+#include <algorithm>
+#include <functional>
+
+#include "btree/keys.hpp"
+#include "rdb_protocol/datum.hpp"
+
+namespace {
+
+// The finalizer of MurmurHash3, to spread the bits of `std::hash`.
+uint64_t mix_hash(uint64_t h) {
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdULL;
+    h ^= h >> 33;
+    h *= 0xc4ceb9fe1a85ec53ULL;
+    h ^= h >> 33;
+    return h;
+}
+
+}  // namespace
+
+const size_t sindex_bloom_filter_t::MIN_EXPECTED_KEYS = 512;
+
+bloom_filter_t::bloom_filter_t(size_t max_bytes) : num_blocks_(1) {
+    const size_t block_size = WORDS_PER_BLOCK * sizeof(uint64_t);
+    while (num_blocks_ * 2 * block_size <= max_bytes) {
+        num_blocks_ *= 2;
+    }
+    words_.init(num_blocks_ * WORDS_PER_BLOCK);
+    memset(words_.data(), 0, memory_usage());
+}
+
+size_t bloom_filter_t::bytes_for(size_t expected_items) {
+    const size_t block_bits = WORDS_PER_BLOCK * 64;
+    const size_t blocks = (expected_items * BITS_PER_ITEM + block_bits - 1) / block_bits;
+    return std::max<size_t>(blocks, 1) * WORDS_PER_BLOCK * sizeof(uint64_t);
+}
+
+size_t bloom_filter_t::capacity() const {
+    return num_blocks_ * WORDS_PER_BLOCK * 64 / BITS_PER_ITEM;
+}
+
+size_t bloom_filter_t::block_offset(uint64_t hash) const {
+    return ((hash >> 32) & (num_blocks_ - 1)) * WORDS_PER_BLOCK;
+}
+
+void bloom_filter_t::add(uint64_t hash) {
+    uint64_t *block = words_.data() + block_offset(hash);
+    // Each probe takes nine bits of a second hash as the bit index within the block.
+    uint64_t bits = hash * 0x9e3779b97f4a7c15ULL;
+    for (int i = 0; i < NUM_PROBES; ++i, bits >>= 9) {
+        block[(bits >> 6) & (WORDS_PER_BLOCK - 1)] |= uint64_t(1) << (bits & 63);
+    }
+}
+
+bool bloom_filter_t::may_contain(uint64_t hash) const {
+    const uint64_t *block = words_.data() + block_offset(hash);
+    uint64_t bits = hash * 0x9e3779b97f4a7c15ULL;
+    for (int i = 0; i < NUM_PROBES; ++i, bits >>= 9) {
+        if ((block[(bits >> 6) & (WORDS_PER_BLOCK - 1)] & (uint64_t(1) << (bits & 63)))
+            == 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void bloom_filter_t::shrink_to_fit(size_t expected_items) {
+    const size_t needed_bytes = bytes_for(expected_items);
+    size_t new_num_blocks = num_blocks_;
+    while (new_num_blocks > 1 && memory_usage() * new_num_blocks / num_blocks_ / 2
+                                 >= needed_bytes) {
+        new_num_blocks /= 2;
+    }
+    if (new_num_blocks == num_blocks_) {
+        return;
+    }
+    // A hash's block is given by the low bits of its top half, so block `i` of the
+    // smaller filter takes the bits of every block `j` with `j % new_num_blocks == i`.
+    scoped_array_t<uint64_t> new_words(new_num_blocks * WORDS_PER_BLOCK);
+    memset(new_words.data(), 0, new_words.size() * sizeof(uint64_t));
+    for (size_t i = 0; i < words_.size(); ++i) {
+        new_words[i % new_words.size()] |= words_[i];
+    }
+    words_ = std::move(new_words);
+    num_blocks_ = new_num_blocks;
+}
+
+sindex_bloom_filter_t::sindex_bloom_filter_t(perfmon_collection_t *parent,
+                                             bool index_is_empty)
+    : expected_keys_(0),
+      num_keys_(0),
+      rebuilt_num_keys_(0),
+      pm_membership(parent,
+                    &pm_hits, "bloom_filter_hits",
+                    &pm_false_positives, "bloom_filter_false_positives") {
+    if (index_is_empty) {
+        // Nothing can be in the index yet, so an empty filter is complete.
+        filter_ = make_scoped<bloom_filter_t>(
+            bloom_filter_t::bytes_for(MIN_EXPECTED_KEYS));
+        expected_keys_ = filter_->capacity();
+    }
+}
+
+uint64_t sindex_bloom_filter_t::hash_truncated_secondary(
+        const std::string &truncated_secondary) {
+    return mix_hash(std::hash<std::string>()(truncated_secondary));
+}
+
+uint64_t sindex_bloom_filter_t::hash_sindex_key(const store_key_t &sindex_key) {
+    return hash_truncated_secondary(
+        ql::datum_t::extract_truncated_secondary(key_to_unescaped_str(sindex_key)));
+}
+
+void sindex_bloom_filter_t::note_key(const store_key_t &sindex_key) {
+    const uint64_t hash = hash_sindex_key(sindex_key);
+    if (filter_.has()) {
+        filter_->add(hash);
+    }
+    if (rebuilt_filter_.has()) {
+        rebuilt_filter_->add(hash);
+        ++rebuilt_num_keys_;
+    }
+    ++num_keys_;
+}
+
+bool sindex_bloom_filter_t::definitely_absent(const std::string &truncated_secondary) {
+    if (!filter_.has()
+        || filter_->may_contain(hash_truncated_secondary(truncated_secondary))) {
+        return false;
+    }
+    ++pm_hits;
+    return true;
+}
+
+size_t sindex_bloom_filter_t::memory_usage() const {
+    return (filter_.has() ? filter_->memory_usage() : 0)
+        + (rebuilt_filter_.has() ? rebuilt_filter_->memory_usage() : 0);
+}
+
+bool sindex_bloom_filter_t::wants_rebuild() const {
+    return filter_.has() && !is_rebuilding() && num_keys_ > expected_keys_;
+}
+
+void sindex_bloom_filter_t::begin_rebuild(size_t max_bytes) {
+    guarantee(!is_rebuilding());
+    // If we don't have a filter yet, we don't know how many keys there are, so we
+    // start out as big as we may and shrink the filter once we know.
+    const size_t bytes = filter_.has()
+        ? std::min(bloom_filter_t::bytes_for(2 * num_keys_), max_bytes)
+        : max_bytes;
+    rebuilt_filter_ = make_scoped<bloom_filter_t>(bytes);
+    rebuilt_num_keys_ = 0;
+}
+
+void sindex_bloom_filter_t::add_rebuilt_key(const store_key_t &sindex_key) {
+    guarantee(is_rebuilding());
+    rebuilt_filter_->add(hash_sindex_key(sindex_key));
+    ++rebuilt_num_keys_;
+}
+
+void sindex_bloom_filter_t::finish_rebuild() {
+    guarantee(is_rebuilding());
+    // Leave room to grow, so that we don't have to rebuild again right away.
+    rebuilt_filter_->shrink_to_fit(
+        std::max<size_t>(2 * rebuilt_num_keys_, MIN_EXPECTED_KEYS));
+    filter_ = std::move(rebuilt_filter_);
+    // If we ran into the memory limit, the filter will be fuller than we'd like.  We
+    // still rebuild it once the number of keys doubles, in case we may use more
+    // memory by then.
+    expected_keys_ = std::max(filter_->capacity(), 2 * rebuilt_num_keys_);
+    num_keys_ = rebuilt_num_keys_;
+}
+
+void sindex_bloom_filter_t::abandon_rebuild() {
+    guarantee(is_rebuilding());
+    rebuilt_filter_.reset();
+    // Don't try again right away.
+    expected_keys_ = std::max<size_t>(2 * num_keys_, MIN_EXPECTED_KEYS);
+}
@@ -0,0 +1,117 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#ifndef RDB_PROTOCOL_SINDEX_BLOOM_FILTER_HPP_
+#define RDB_PROTOCOL_SINDEX_BLOOM_FILTER_HPP_
+
+#include <stdint.h>
+
+#include <string>
+
+#include "containers/scoped.hpp"
+#include "perfmon/perfmon.hpp"
+
+class store_key_t;
+
+/* A blocked bloom filter over 64-bit hashes.  All the bits of one hash are in the
+same 64-byte block, so a lookup touches a single cache line.  The number of blocks is
+a power of two, which lets us fold the filter in half once we know that it's bigger
+than it has to be. */
+class bloom_filter_t {
+public:
+    // Uses the largest power of two number of blocks that fits in `max_bytes`, but at
+    // least one block.
+    explicit bloom_filter_t(size_t max_bytes);
+
+    void add(uint64_t hash);
+    bool may_contain(uint64_t hash) const;
+
+    // Folds the filter in half for as long as it stays large enough for about 1%
+    // false positives with `expected_items` hashes in it.
+    void shrink_to_fit(size_t expected_items);
+
+    // The number of hashes the filter can take with about 1% false positives.
+    size_t capacity() const;
+    size_t memory_usage() const { return words_.size() * sizeof(uint64_t); }
+
+    static size_t bytes_for(size_t expected_items);
+
+private:
+    static const size_t WORDS_PER_BLOCK = 8;
+    static const size_t BITS_PER_ITEM = 10;
+    static const int NUM_PROBES = 6;
+
+    size_t block_offset(uint64_t hash) const;
+
+    size_t num_blocks_;
+    scoped_array_t<uint64_t> words_;
+
+    DISABLE_COPYING(bloom_filter_t);
+};
+
+/* The in-memory bloom filter of one secondary index, which `store_t` keeps so that
+`getAll` can skip the B-tree traversal for values that aren't in the index.  It is
+keyed on the truncated secondary part of the index keys (the same prefix that
+`datum_range_t::to_sindex_keyrange()` scans for), so it works the same for multi
+indexes and for values that got truncated.
+
+Bloom filters can't forget, so `rdb_update_sindexes()` adds every key it inserts and
+ignores deletions.  Whenever more keys have been added since the filter was built than
+it was sized for, `store_t` rebuilds it from a snapshot of the index.  After the
+server starts, the filter of an index that isn't empty only gets built once a `getAll`
+uses the index.  Until that build has finished the filter isn't ready and can't rule
+anything out. */
+class sindex_bloom_filter_t {
+public:
+    sindex_bloom_filter_t(perfmon_collection_t *parent, bool index_is_empty);
+
+    static uint64_t hash_truncated_secondary(const std::string &truncated_secondary);
+    static uint64_t hash_sindex_key(const store_key_t &sindex_key);
+
+    // Called for every key that gets inserted into the index.
+    void note_key(const store_key_t &sindex_key);
+
+    bool is_ready() const { return filter_.has(); }
+
+    // Returns true if the index certainly has no key with this truncated secondary
+    // part.  Counts a filter hit if so.
+    bool definitely_absent(const std::string &truncated_secondary);
+
+    // Called after a lookup that the filter didn't rule out turned up nothing.
+    void note_false_positive() { ++pm_false_positives; }
+
+    // Includes the filter that's being rebuilt, if any.
+    size_t memory_usage() const;
+
+    // Rebuild protocol: `store_t` calls `wants_rebuild()` after `note_key()`, and if
+    // it returns true starts a rebuild with `begin_rebuild()`.  Filters that aren't
+    // ready never want a rebuild; `store_t` starts their first build on a read.  From then on the keys
+    // passed to `note_key()` also go into the new filter, as do the keys that the
+    // rebuild finds in the index through `add_rebuilt_key()`.  `finish_rebuild()`
+    // then replaces the old filter with the new one, while `abandon_rebuild()` keeps
+    // the old one (if any).
+    bool wants_rebuild() const;
+    void begin_rebuild(size_t max_bytes);
+    void add_rebuilt_key(const store_key_t &sindex_key);
+    void finish_rebuild();
+    void abandon_rebuild();
+    bool is_rebuilding() const { return rebuilt_filter_.has(); }
+
+    static const size_t MIN_EXPECTED_KEYS;
+
+private:
+    scoped_ptr_t<bloom_filter_t> filter_;
+
+    // The number of keys the filter was sized for, and the number of keys added to it
+    // since (including the ones it was built from, and duplicates).
+    size_t expected_keys_;
+    size_t num_keys_;
+
+    scoped_ptr_t<bloom_filter_t> rebuilt_filter_;
+    size_t rebuilt_num_keys_;
+
+    perfmon_counter_t pm_hits, pm_false_positives;
+    perfmon_multi_membership_t pm_membership;
+
+    DISABLE_COPYING(sindex_bloom_filter_t);
+};
+
+#endif  // RDB_PROTOCOL_SINDEX_BLOOM_FILTER_HPP_
@@ -129,7 +129,7 @@ void store_t::help_construct_bring_sindexes_up_to_date() {
     };
 
     // Get the map of indexes and check if any were postconstructing or being deleted.
-    // Kick off coroutines to finish the respective operations
+    // Kick off coroutines to finish the respective operations.
     {
         std::map<sindex_name_t, secondary_index_t> sindexes;
         get_secondary_indexes(&sindex_block, &sindexes);
@@ -144,6 +144,13 @@ void store_t::help_construct_bring_sindexes_up_to_date() {
                                                  this,
                                                  drainer.lock()));
             }
+            if (!it->second.being_deleted) {
+                // We don't know what's in the index, so its bloom filter isn't ready
+                // until the first `getAll` on the index has it built.
+                add_sindex_bloom_filter(it->second.id,
+                                        it->second.opaque_definition,
+                                        false);
+            }
         }
     }
 
@@ -218,6 +225,7 @@ void do_read(ql::env_t *env,
             rget.transforms,
             rget.terminal,
             rget.sorting,
+            rget.is_scan,
             res,
             release_superblock);
     } else {
@@ -273,6 +281,8 @@ void do_read(ql::env_t *env,
                 rget.sorting,
                 rget.sindex->require_sindex_val,
                 sindex_info,
+                store->get_sindex_bloom_filter_for_get_all(
+                    sindex_uuid, rget.sindex->datumspec),
                 res,
                 release_superblock_t::RELEASE);
         } catch (const ql::exc_t &e) {
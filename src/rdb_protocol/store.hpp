@@ -24,6 +24,7 @@
 #include "protocol_api.hpp"
 #include "rdb_protocol/changefeed.hpp"
 #include "rdb_protocol/protocol.hpp"
+#include "rdb_protocol/sindex_bloom_filter.hpp"
 #include "rdb_protocol/store_metainfo.hpp"
 #include "rpc/mailbox/typed.hpp"
 #include "store_view.hpp"
@@ -297,6 +298,19 @@ public:
         return secondary_index_slices.at(id).get();
     }
 
+    // Returns the bloom filter of the given secondary index, or `nullptr` if it
+    // doesn't have one (geospatial and deleted indexes don't).
+    sindex_bloom_filter_t *get_sindex_bloom_filter(const uuid_u &id);
+
+    // Returns the bloom filter to use for a read of the given index, which is
+    // `nullptr` unless the read is a `getAll`.  Starts building the filter if it
+    // isn't ready yet, so that we only ever scan the indexes that `getAll` uses.
+    sindex_bloom_filter_t *get_sindex_bloom_filter_for_get_all(
+            const uuid_u &id, const ql::datumspec_t &datumspec);
+
+    // Called by `rdb_update_sindexes()` for every key it inserts into an index.
+    void note_sindex_key(const uuid_u &sindex_id, const store_key_t &key);
+
     void protocol_read(const read_t &read,
                        read_response_t *response,
                        real_superblock_t *superblock,
@@ -346,6 +360,26 @@ private:
     // through `clear_sindex_data()`.
     void drop_sindex(uuid_u sindex_id) THROWS_NOTHING;
 
+    // Creates the bloom filter of a regular secondary index.  It's only ready right
+    // away if the index is empty, otherwise it needs a rebuild first.
+    void add_sindex_bloom_filter(const uuid_u &sindex_id,
+                                 const std::vector<char> &opaque_definition,
+                                 bool index_is_empty);
+    // The number of bytes that a rebuild of a bloom filter may use.  All the filters
+    // of a store get an equal share of a fraction of the memory that the cache
+    // balancer gives to the store's cache.
+    size_t sindex_bloom_filter_budget();
+    // Begins a rebuild of the given index's bloom filter and spawns
+    // `rebuild_sindex_bloom_filter()` to do it.
+    void spawn_sindex_bloom_filter_rebuild(const uuid_u &sindex_id,
+                                           sindex_bloom_filter_t *filter);
+    // Fills the new bloom filter of an index whose rebuild has begun from a snapshot
+    // of its B-tree, and then swaps it in.  To be run in a coroutine.
+    void rebuild_sindex_bloom_filter(
+            uuid_u sindex_id,
+            auto_drainer_t::lock_t store_keepalive)
+            THROWS_NOTHING;
+
     // Resumes post construction for partially constructed indexes.  Resumes deleting
     // deleted indexes.  Also migrates the secondary index block to the current version.
     void help_construct_bring_sindexes_up_to_date();
@@ -381,6 +415,10 @@ public:
 
     std::map<uuid_u, scoped_ptr_t<btree_slice_t> > secondary_index_slices;
 
+    // The filters keep perfmons in the collections of the slices above, so they must
+    // be destroyed first.
+    std::map<uuid_u, scoped_ptr_t<sindex_bloom_filter_t> > sindex_bloom_filters;
+
     // We construct secondary indexes by starting with a `universe()` construction_range,
     // and then making the range increasingly smaller until it is `empty()`.
     // While we are in that process, we must put any write for a primary key that is in
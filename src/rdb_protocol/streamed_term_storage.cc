@@ -0,0 +1,814 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#include "rdb_protocol/streamed_term_storage.hpp"
+
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "containers/archive/archive.hpp"
+#include "rapidjson/reader.h"
+#include "rdb_protocol/minidriver.hpp"
+#include "rdb_protocol/pseudo_literal.hpp"
+#include "rdb_protocol/term_walker.hpp"
+
+namespace ql {
+
+// Feeds `size` bytes from a `read_stream_t` to `rapidjson::Reader`, a chunk at a time.
+class json_read_stream_t {
+public:
+    typedef char Ch;
+
+    json_read_stream_t(read_stream_t *_stream, size_t _size) :
+        stream(_stream), remaining(_size), buffer(64 * KILOBYTE),
+        position(0), end(0), consumed(0) {
+        fill();
+    }
+
+    char Peek() const {
+        return position < end ? buffer[position] : '\0';
+    }
+
+    char Take() {
+        if (position == end) {
+            return '\0';
+        }
+        char c = buffer[position];
+        ++position;
+        ++consumed;
+        if (position == end) {
+            fill();
+        }
+        return c;
+    }
+
+    size_t Tell() const { return consumed; }
+
+    // The reader only writes to the stream when parsing in situ.
+    char *PutBegin() { unreachable(); }
+    void Put(char) { unreachable(); }
+    void Flush() { unreachable(); }
+    size_t PutEnd(char *) { unreachable(); }
+
+    // Reads whatever the parser didn't, so the connection stays in sync.
+    void skip_rest() {
+        while (position != end) {
+            position = end;
+            fill();
+        }
+    }
+
+private:
+    void fill() {
+        position = 0;
+        end = 0;
+        if (remaining == 0) {
+            return;
+        }
+        size_t chunk_size = remaining < buffer.size() ? remaining : buffer.size();
+        int64_t res = stream->read(buffer.data(), chunk_size);
+        if (res <= 0) {
+            // The stream ended early, which the parser will see as truncated JSON.
+            remaining = 0;
+            return;
+        }
+        end = static_cast<size_t>(res);
+        remaining -= end;
+    }
+
+    read_stream_t *stream;
+    size_t remaining;
+    scoped_array_t<char> buffer;
+    size_t position;
+    size_t end;
+    size_t consumed;
+
+    DISABLE_COPYING(json_read_stream_t);
+};
+
+// A scalar JSON value, which is only converted to a datum where one is needed.
+struct json_scalar_t {
+    rapidjson::Type type;
+    double number;
+    const char *str;
+    size_t length;
+
+    datum_t to_datum() const {
+        switch (type) {
+        case rapidjson::kNullType: return datum_t::null();
+        case rapidjson::kFalseType: return datum_t::boolean(false);
+        case rapidjson::kTrueType: return datum_t::boolean(true);
+        case rapidjson::kStringType: return datum_t::utf8(datum_string_t(length, str));
+        case rapidjson::kNumberType: return datum_t(number);
+        case rapidjson::kObjectType: // fallthru
+        case rapidjson::kArrayType: // fallthru
+        default: unreachable();
+        }
+    }
+};
+
+// The SAX handler that builds the query.  It keeps a stack of frames, one per open
+// JSON array or object, and does the same checks as `term_walker_t` as each term
+// is started.  Backtraces are only registered for values that become terms (or
+// that an error is reported for), so the fields of literal objects don't get any.
+class streamed_term_storage_t::handler_t {
+public:
+    explicit handler_t(streamed_term_storage_t *_parent) :
+        parent(_parent),
+        reql_type_key(datum_t::reql_type_string.to_std()),
+        depth(0),
+        skipping(false),
+        skip_depth(0),
+        query_failed(false) { }
+
+    // Throws the first error in the query envelope, after the whole query has been
+    // parsed, so that syntax errors take precedence like they do for
+    // `json_term_storage_t`.
+    void finish() {
+        if (query_failed) {
+            throw bt_exc_t(Response::CLIENT_ERROR, Response::QUERY_LOGIC,
+                           query_error, backtrace_registry_t::EMPTY_BACKTRACE);
+        }
+    }
+
+    bool Null() {
+        return scalar(json_scalar_t{rapidjson::kNullType, 0, nullptr, 0});
+    }
+    bool Bool(bool b) {
+        return scalar(json_scalar_t{b ? rapidjson::kTrueType : rapidjson::kFalseType,
+                                    0, nullptr, 0});
+    }
+    bool Int(int i) { return number(i); }
+    bool Uint(unsigned u) { return number(u); }
+    bool Int64(int64_t i) { return number(i); }
+    bool Uint64(uint64_t u) { return number(u); }
+    bool Double(double d) { return number(d); }
+    bool String(const char *str, rapidjson::SizeType length, bool) {
+        return scalar(json_scalar_t{rapidjson::kStringType, 0, str, length});
+    }
+
+    bool StartArray() { return start_container(rapidjson::kArrayType); }
+    bool StartObject() { return start_container(rapidjson::kObjectType); }
+
+    bool Key(const char *str, rapidjson::SizeType length, bool) {
+        if (!skipping) {
+            guarded([&]() { key(str, length); });
+        }
+        return true;
+    }
+
+    bool EndArray(rapidjson::SizeType) { return end_container(); }
+    bool EndObject(rapidjson::SizeType) { return end_container(); }
+
+private:
+    enum class frame_kind_t {
+        // The top-level `[type, term, global_optargs]` array.
+        QUERY,
+        // A term, in the `[type, args, optargs]` form.
+        TERM,
+        ARGS,
+        // The optargs of a term, or the global optargs.
+        OPTARGS,
+        // An object in place of a term.  It is kept as a map of datums until it turns
+        // out to contain a term, and becomes a `MAKE_OBJ` term then.
+        OBJECT,
+        // JSON that is converted to a datum as is, like the value of a `DATUM` term.
+        JSON_ARRAY,
+        JSON_OBJECT
+    };
+
+    struct frame_t;
+
+    // Where a value goes in the term tree, which is needed to check the value and to
+    // make its backtrace.
+    struct position_t {
+        // The `TERM` or `OBJECT` frame this is an argument of, if any.
+        frame_t *container;
+        datum_t bt_frame;
+        bool is_zeroth_argument;
+        bool no_backtraces;
+    };
+
+    struct frame_t {
+        frame_t(frame_kind_t _kind, const position_t &_position) :
+            kind(_kind), count(0), position(_position), has_bt(false),
+            writes_legal(true), type(Term::DATUM), has_optargs(false),
+            owner(nullptr) { }
+
+        frame_kind_t kind;
+        // The number of elements or members started so far.
+        size_t count;
+        std::string key;
+
+        // For `TERM` and `OBJECT` frames.
+        position_t position;
+        bool has_bt;
+        backtrace_id_t bt;
+        bool writes_legal;
+        Term::TermType type;
+        counted_t<generated_term_t> term;
+
+        // For `TERM` frames.
+        bool has_optargs;
+
+        // For `ARGS` and `OPTARGS` frames, the `TERM` frame they belong to.  This is
+        // null for the global optargs.
+        frame_t *owner;
+
+        // For `OBJECT` frames that are still literal, and `JSON_OBJECT` frames.
+        std::map<datum_string_t, datum_t> fields;
+
+        // For `JSON_ARRAY` frames.
+        std::vector<datum_t> items;
+    };
+
+    bool number(double d) {
+        return scalar(json_scalar_t{rapidjson::kNumberType, d, nullptr, 0});
+    }
+
+    bool scalar(const json_scalar_t &value) {
+        if (!skipping) {
+            guarded([&]() { start_value(value.type, &value); });
+        }
+        return true;
+    }
+
+    bool start_container(rapidjson::Type type) {
+        ++depth;
+        if (!skipping) {
+            guarded([&]() { start_value(type, nullptr); });
+        }
+        return true;
+    }
+
+    bool end_container() {
+        --depth;
+        if (skipping) {
+            if (depth == skip_depth) {
+                skipping = false;
+            }
+        } else {
+            guarded([&]() { finish_frame(); });
+        }
+        return true;
+    }
+
+    // Ignores everything up to the end of the container that was just started.
+    void skip_container() {
+        skipping = true;
+        skip_depth = depth - 1;
+    }
+
+    // Errors in the term are kept until `preprocess()`, like `preprocess_term_tree`
+    // would throw them.  The rest of that part of the query is skipped.
+    template <class callable_t>
+    void guarded(callable_t &&f) {
+        try {
+            f();
+        } catch (const base_exc_t &) {
+            if (!parent->term_error) {
+                parent->term_error = std::current_exception();
+            }
+            r_sanity_check(!frames.empty());
+            frames.resize(1);
+            if (depth > 1) {
+                skipping = true;
+                skip_depth = 1;
+            }
+        }
+    }
+
+    void fail_query(std::string message) {
+        if (!query_failed) {
+            query_failed = true;
+            query_error = std::move(message);
+        }
+    }
+
+    frame_t *push_frame(frame_kind_t kind, const position_t &position) {
+        frames.push_back(make_scoped<frame_t>(kind, position));
+        return frames.back().get();
+    }
+
+    frame_t *push_frame(frame_kind_t kind) {
+        return push_frame(kind, position_t{nullptr, datum_t(), false, true});
+    }
+
+    backtrace_id_t bt_at(const position_t &position) {
+        if (position.no_backtraces || position.container == nullptr) {
+            return backtrace_id_t::empty();
+        }
+        return parent->bt_reg.new_frame(bt_of(position.container),
+                                        position.bt_frame);
+    }
+
+    backtrace_id_t bt_of(frame_t *frame) {
+        if (!frame->has_bt) {
+            frame->bt = bt_at(frame->position);
+            frame->has_bt = true;
+        }
+        return frame->bt;
+    }
+
+    // The position of the value that was last started in `top`.
+    position_t current_position(frame_t *top) {
+        switch (top->kind) {
+        case frame_kind_t::QUERY:
+            return position_t{nullptr, datum_t(), true, false};
+        case frame_kind_t::ARGS:
+            return position_t{top->owner,
+                              datum_t(static_cast<double>(top->count - 1)),
+                              top->count == 1,
+                              top->owner->position.no_backtraces};
+        case frame_kind_t::OPTARGS:
+            if (top->owner == nullptr) {
+                return position_t{nullptr, datum_t(), false, true};
+            }
+            return position_t{top->owner,
+                              datum_t(datum_string_t(top->key)),
+                              false,
+                              top->owner->position.no_backtraces};
+        case frame_kind_t::OBJECT:
+            return position_t{top,
+                              datum_t(datum_string_t(top->key)),
+                              false,
+                              top->position.no_backtraces};
+        case frame_kind_t::TERM: // fallthru
+        case frame_kind_t::JSON_ARRAY: // fallthru
+        case frame_kind_t::JSON_OBJECT: // fallthru
+        default: unreachable();
+        }
+    }
+
+    counted_t<generated_term_t> datum_term(datum_t &&datum, backtrace_id_t bt) {
+        counted_t<generated_term_t> res = make_counted<generated_term_t>(Term::DATUM, bt);
+        res->datum = std::move(datum);
+        return res;
+    }
+
+    void start_value(rapidjson::Type type, const json_scalar_t *value) {
+        if (frames.empty()) {
+            if (type == rapidjson::kArrayType) {
+                push_frame(frame_kind_t::QUERY);
+            } else {
+                fail_query(strprintf("Expected a query to be an array, but found %s.",
+                                     rapidjson_typestr(type)));
+                if (value == nullptr) {
+                    skip_container();
+                }
+            }
+            return;
+        }
+
+        frame_t *top = frames.back().get();
+        const size_t index = top->count;
+        ++top->count;
+        switch (top->kind) {
+        case frame_kind_t::QUERY:
+            start_query_element(index, type, value);
+            break;
+        case frame_kind_t::TERM:
+            start_term_element(top, index, type, value);
+            break;
+        case frame_kind_t::ARGS: // fallthru
+        case frame_kind_t::OPTARGS: // fallthru
+        case frame_kind_t::OBJECT:
+            start_term(current_position(top), type, value);
+            break;
+        case frame_kind_t::JSON_ARRAY: // fallthru
+        case frame_kind_t::JSON_OBJECT:
+            start_json(type, value);
+            break;
+        default: unreachable();
+        }
+    }
+
+    void start_query_element(size_t index, rapidjson::Type type,
+                             const json_scalar_t *value) {
+        if (index == 0) {
+            if (type != rapidjson::kNumberType) {
+                fail_query(strprintf("Expected a query type as a number, "
+                                     "but found %s.", rapidjson_typestr(type)));
+            } else {
+                const int raw_type = static_cast<int>(value->number);
+                parent->type = static_cast<Query::QueryType>(raw_type);
+                if (!query_type_is_valid(parent->type)) {
+                    fail_query(strprintf("Unrecognized QueryType: %d.", raw_type));
+                }
+            }
+        } else if (!query_failed && index == 1) {
+            if (parent->type == Query::START || parent->type == Query::PREPARE) {
+                start_term(current_position(frames.back().get()), type, value);
+            } else {
+                start_json(type, value);
+            }
+            return;
+        } else if (!query_failed && index == 2) {
+            if (type == rapidjson::kObjectType) {
+                push_frame(frame_kind_t::OPTARGS);
+                return;
+            }
+            fail_query(strprintf("Expected global optargs as an object, "
+                                 "but found %s.", rapidjson_typestr(type)));
+        }
+        if (value == nullptr) {
+            skip_container();
+        }
+    }
+
+    void start_term_element(frame_t *top, size_t index, rapidjson::Type type,
+                            const json_scalar_t *value) {
+        switch (index) {
+        case 0: {
+            rcheck_src(bt_of(top), type == rapidjson::kNumberType, base_exc_t::LOGIC,
+                strprintf("Expected a TermType as a NUMBER but found %s.",
+                          rapidjson_typestr(type)));
+            start_term_type(top, static_cast<int>(value->number));
+        } break;
+        case 1: {
+            if (top->type == Term::DATUM) {
+                start_json(type, value);
+            } else if (type == rapidjson::kArrayType) {
+                push_frame(frame_kind_t::ARGS)->owner = top;
+            } else if (type == rapidjson::kObjectType) {
+                top->has_optargs = true;
+                push_frame(frame_kind_t::OPTARGS)->owner = top;
+            } else {
+                rfail_src(bt_of(top), base_exc_t::LOGIC,
+                          "Second element in a Term is neither "
+                          "arguments nor optional arguments.");
+            }
+        } break;
+        case 2: {
+            rcheck_src(bt_of(top), !top->has_optargs, base_exc_t::LOGIC,
+                       "Second and third element in a term are "
+                       "both optional arguments.");
+            rcheck_src(bt_of(top), type == rapidjson::kObjectType, base_exc_t::LOGIC,
+                       "Third element in a Term is not optional arguments.");
+            top->has_optargs = true;
+            push_frame(frame_kind_t::OPTARGS)->owner = top;
+        } break;
+        default: {
+            // This is reported with the number of elements when the term ends.
+            if (value == nullptr) {
+                skip_container();
+            }
+        } break;
+        }
+    }
+
+    void start_term_type(frame_t *top, int raw_type) {
+        const Term::TermType type = static_cast<Term::TermType>(raw_type);
+        const backtrace_id_t bt = bt_of(top);
+        rcheck_src(bt, term_type_is_valid(type), base_exc_t::LOGIC,
+                   strprintf("Unrecognized TermType: %d.", raw_type));
+
+        if (type == Term::ASC || type == Term::DESC) {
+            const frame_t *container = top->position.container;
+            rcheck_src(bt,
+                container != nullptr
+                && (container->type == Term::ORDER_BY
+                    || container->type == Term::UNION
+                    || (container->position.container != nullptr
+                        && container->position.container->type == Term::UNION
+                        && container->type == Term::MAKE_ARRAY)),
+                base_exc_t::LOGIC,
+                strprintf("%s may only be used as an argument to ORDER_BY or UNION.",
+                          (type == Term::ASC ? "ASC" : "DESC")));
+        }
+
+        rcheck_src(bt, !term_is_write_or_meta(type) || top->writes_legal,
+            base_exc_t::LOGIC,
+            strprintf("Cannot nest writes or meta ops in stream operations.  Use "
+                      "FOR_EACH instead."));
+
+        top->type = type;
+        top->term = make_counted<generated_term_t>(type, bt);
+    }
+
+    // Starts a value that is a term, either an array in the `[type, args, optargs]`
+    // form, an object, or a scalar, which becomes a `DATUM` term.
+    void start_term(const position_t &position, rapidjson::Type type,
+                    const json_scalar_t *value) {
+        if (value != nullptr) {
+            add_value(value->to_datum(), counted_t<generated_term_t>());
+            return;
+        }
+
+        frame_t *frame = push_frame(type == rapidjson::kArrayType
+                                        ? frame_kind_t::TERM
+                                        : frame_kind_t::OBJECT,
+                                    position);
+        const frame_t *container = position.container;
+        if (container != nullptr) {
+            frame->writes_legal = container->writes_legal &&
+                (position.is_zeroth_argument || !term_forbids_writes(container->type));
+        }
+        if (frame->kind == frame_kind_t::OBJECT) {
+            frame->type = Term::MAKE_OBJ;
+        }
+    }
+
+    void start_json(rapidjson::Type type, const json_scalar_t *value) {
+        if (value != nullptr) {
+            add_value(value->to_datum(), counted_t<generated_term_t>());
+        } else if (type == rapidjson::kArrayType) {
+            push_frame(frame_kind_t::JSON_ARRAY);
+        } else {
+            push_frame(frame_kind_t::JSON_OBJECT);
+        }
+    }
+
+    void key(const char *str, size_t length) {
+        r_sanity_check(!frames.empty());
+        frame_t *top = frames.back().get();
+        switch (top->kind) {
+        case frame_kind_t::OPTARGS: {
+            top->key.assign(str, length);
+            if (top->owner != nullptr) {
+                rcheck_src(bt_at(current_position(top)),
+                           top->owner->term->optargs.count(top->key) == 0,
+                           base_exc_t::LOGIC,
+                           strprintf("Duplicate optional argument: %s",
+                                     top->key.c_str()));
+            }
+        } break;
+        case frame_kind_t::OBJECT: {
+            top->key.assign(str, length);
+            datum_string_t field(length, str);
+            rcheck_src(bt_of(top),
+                       top->fields.count(field) == 0
+                       && (!top->term.has()
+                           || top->term->optargs.count(top->key) == 0),
+                       base_exc_t::LOGIC,
+                       strprintf("Duplicate object key: %s.", top->key.c_str()));
+            // Pseudotypes are left for `MAKE_OBJ` to check when it's evaluated.
+            if (top->key == reql_type_key) {
+                make_object_term(top);
+            }
+        } break;
+        case frame_kind_t::JSON_OBJECT: {
+            datum_string_t field = datum_t::utf8(datum_string_t(length, str)).as_str();
+            rcheck_datum(top->fields.count(field) == 0, base_exc_t::LOGIC,
+                         strprintf("Duplicate key %s in JSON.",
+                                   datum_t(field).print().c_str()));
+            top->key.assign(str, length);
+        } break;
+        case frame_kind_t::QUERY: // fallthru
+        case frame_kind_t::TERM: // fallthru
+        case frame_kind_t::ARGS: // fallthru
+        case frame_kind_t::JSON_ARRAY: // fallthru
+        default: unreachable();
+        }
+    }
+
+    // Turns a literal object into a `MAKE_OBJ` term, because one of its fields is
+    // a term.
+    void make_object_term(frame_t *object) {
+        if (object->term.has()) {
+            return;
+        }
+        const backtrace_id_t bt = bt_of(object);
+        object->term = make_counted<generated_term_t>(Term::MAKE_OBJ, bt);
+        for (auto &&pair : object->fields) {
+            const backtrace_id_t field_bt = object->position.no_backtraces
+                ? backtrace_id_t::empty()
+                : parent->bt_reg.new_frame(bt, datum_t(pair.first));
+            object->term->optargs.insert(std::make_pair(
+                pair.first.to_std(), datum_term(std::move(pair.second), field_bt)));
+        }
+        object->fields.clear();
+    }
+
+    void finish_frame() {
+        r_sanity_check(!frames.empty());
+        scoped_ptr_t<frame_t> frame = std::move(frames.back());
+        frames.pop_back();
+
+        switch (frame->kind) {
+        case frame_kind_t::QUERY: {
+            if (frame->count == 0 || frame->count > 3) {
+                // This takes precedence over any other error in the query.
+                query_failed = false;
+                fail_query(strprintf("Expected 1 to 3 elements in the top-level query, "
+                                     "but found %zu.", frame->count));
+            }
+        } break;
+        case frame_kind_t::TERM: {
+            const backtrace_id_t bt = bt_of(frame.get());
+            rcheck_src(bt, frame->count >= 1 && frame->count <= 3, base_exc_t::LOGIC,
+                strprintf("Expected between 1 and 3 elements in a raw term, "
+                          "but found %zu.", frame->count));
+            if (frame->type == Term::DATUM) {
+                // `raw_term_t` counts the backtrace `preprocess_term_tree` appends.
+                rcheck_src(bt, frame->count == 2, base_exc_t::LOGIC,
+                           strprintf("Expected 3 items in array, but found %zu.",
+                                     frame->count + 1));
+            }
+            add_value(datum_t(), std::move(frame->term));
+        } break;
+        case frame_kind_t::ARGS: // fallthru
+        case frame_kind_t::OPTARGS:
+            break;
+        case frame_kind_t::OBJECT: {
+            if (frame->term.has()) {
+                add_value(datum_t(), std::move(frame->term));
+            } else {
+                // This is what `MAKE_OBJ` would evaluate to.
+                add_value(datum_t(std::move(frame->fields)),
+                          counted_t<generated_term_t>());
+            }
+        } break;
+        case frame_kind_t::JSON_ARRAY: {
+            add_value(datum_t(std::move(frame->items), configured_limits_t::unlimited),
+                      counted_t<generated_term_t>());
+        } break;
+        case frame_kind_t::JSON_OBJECT: {
+            const std::set<std::string> pts = { pseudo::literal_string };
+            add_value(datum_t(std::move(frame->fields), pts),
+                      counted_t<generated_term_t>());
+        } break;
+        default: unreachable();
+        }
+    }
+
+    // Adds a finished value, either a datum or a term, to the frame it's in.
+    void add_value(datum_t &&datum, counted_t<generated_term_t> &&term) {
+        r_sanity_check(datum.has() != term.has());
+        r_sanity_check(!frames.empty());
+        frame_t *top = frames.back().get();
+        switch (top->kind) {
+        case frame_kind_t::QUERY: {
+            if (parent->type == Query::START || parent->type == Query::PREPARE) {
+                parent->root = term.has()
+                    ? std::move(term)
+                    : datum_term(std::move(datum), backtrace_id_t::empty());
+            } else {
+                parent->payload = std::move(datum);
+            }
+        } break;
+        case frame_kind_t::TERM: {
+            r_sanity_check(top->type == Term::DATUM);
+            top->term->datum = std::move(datum);
+        } break;
+        case frame_kind_t::ARGS: {
+            top->owner->term->args.push_back(term.has()
+                ? std::move(term)
+                : datum_term(std::move(datum), bt_at(current_position(top))));
+        } break;
+        case frame_kind_t::OPTARGS: {
+            counted_t<generated_term_t> optarg = term.has()
+                ? std::move(term)
+                : datum_term(std::move(datum), bt_at(current_position(top)));
+            if (top->owner != nullptr) {
+                top->owner->term->optargs.insert(
+                    std::make_pair(top->key, std::move(optarg)));
+            } else {
+                parent->optargs.push_back(std::make_pair(top->key, std::move(optarg)));
+            }
+        } break;
+        case frame_kind_t::OBJECT: {
+            if (term.has()) {
+                make_object_term(top);
+                top->term->optargs.insert(std::make_pair(top->key, std::move(term)));
+            } else if (top->term.has()) {
+                top->term->optargs.insert(std::make_pair(
+                    top->key,
+                    datum_term(std::move(datum), bt_at(current_position(top)))));
+            } else {
+                top->fields.insert(
+                    std::make_pair(datum_string_t(top->key), std::move(datum)));
+            }
+        } break;
+        case frame_kind_t::JSON_ARRAY: {
+            top->items.push_back(std::move(datum));
+        } break;
+        case frame_kind_t::JSON_OBJECT: {
+            top->fields.insert(
+                std::make_pair(datum_string_t(top->key), std::move(datum)));
+        } break;
+        default: unreachable();
+        }
+    }
+
+    streamed_term_storage_t *parent;
+    const std::string reql_type_key;
+
+    std::vector<scoped_ptr_t<frame_t> > frames;
+
+    // The number of arrays and objects we are in.
+    size_t depth;
+    bool skipping;
+    size_t skip_depth;
+
+    bool query_failed;
+    std::string query_error;
+
+    DISABLE_COPYING(handler_t);
+};
+
+streamed_term_storage_t::streamed_term_storage_t() : type(Query::START) { }
+
+bool streamed_term_storage_t::parse(read_stream_t *stream, size_t size) {
+    json_read_stream_t json_stream(stream, size);
+    handler_t handler(this);
+
+    // The iterative parser doesn't recurse, so deeply nested queries don't need a
+    // deep coroutine stack.  Neither does the handler.
+    rapidjson::Reader reader;
+    reader.Parse<rapidjson::kParseIterativeFlag>(json_stream, handler);
+    json_stream.skip_rest();
+
+    if (reader.HasParseError()) {
+        return false;
+    }
+    handler.finish();
+    return true;
+}
+
+Query::QueryType streamed_term_storage_t::query_type() const {
+    return type;
+}
+
+bool streamed_term_storage_t::static_optarg_as_bool(const std::string &key,
+                                                    bool default_value) const {
+    for (const auto &pair : optargs) {
+        if (pair.first == key) {
+            const counted_t<generated_term_t> &term = pair.second;
+            if (term->type != Term::DATUM ||
+                term->datum.get_type() != datum_t::R_BOOL) {
+                return default_value;
+            }
+            return term->datum.as_bool();
+        }
+    }
+    return default_value;
+}
+
+void streamed_term_storage_t::preprocess() {
+    if (term_error) {
+        std::rethrow_exception(term_error);
+    }
+    if (!root.has()) {
+        throw bt_exc_t(Response::CLIENT_ERROR, Response::QUERY_LOGIC,
+                       "Expected a term as the second element of the query.",
+                       backtrace_registry_t::EMPTY_BACKTRACE);
+    }
+}
+
+raw_term_t streamed_term_storage_t::root_term() const {
+    r_sanity_check(root.has());
+    return raw_term_t(root);
+}
+
+global_optargs_t streamed_term_storage_t::global_optargs() {
+    global_optargs_t res;
+    bool has_db_optarg = false;
+    for (const auto &pair : optargs) {
+        has_db_optarg = has_db_optarg || pair.first == "db";
+        res.add_optarg(raw_term_t(pair.second), pair.first);
+    }
+
+    // Create a default db global optarg
+    if (!has_db_optarg) {
+        minidriver_t r(backtrace_id_t::empty());
+        res.add_optarg(r.db("test").root_term(), "db");
+    }
+    return res;
+}
+
+void streamed_term_storage_t::execute_args(int64_t *prepared_query_id_out,
+                                           std::vector<datum_t> *args_out) const {
+    r_sanity_check(type == Query::EXECUTE);
+    try {
+        if (term_error) {
+            std::rethrow_exception(term_error);
+        }
+    } catch (const base_exc_t &ex) {
+        throw bt_exc_t(Response::CLIENT_ERROR, ex.get_error_type(),
+                       strprintf("Invalid argument for a prepared query: %s",
+                                 ex.what()),
+                       backtrace_registry_t::EMPTY_BACKTRACE);
+    }
+
+    if (!payload.has() ||
+        payload.get_type() != datum_t::R_ARRAY ||
+        payload.arr_size() != 2 ||
+        payload.get(0).get_type() != datum_t::R_NUM ||
+        !number_as_integer(payload.get(0).as_num(), prepared_query_id_out) ||
+        payload.get(1).get_type() != datum_t::R_ARRAY) {
+        throw bt_exc_t(Response::CLIENT_ERROR, Response::QUERY_LOGIC,
+                       "Expected an EXECUTE query to have a term of the form "
+                       "[PREPARED_QUERY_ID, [ARGS...]].",
+                       backtrace_registry_t::EMPTY_BACKTRACE);
+    }
+
+    const datum_t args = payload.get(1);
+    args_out->clear();
+    args_out->reserve(args.arr_size());
+    for (size_t i = 0; i < args.arr_size(); ++i) {
+        args_out->push_back(args.get(i));
+    }
+}
+
+} // namespace ql
@@ -0,0 +1,69 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#ifndef RDB_PROTOCOL_STREAMED_TERM_STORAGE_HPP_
+#define RDB_PROTOCOL_STREAMED_TERM_STORAGE_HPP_
+
+#include <exception>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "containers/counted.hpp"
+#include "rdb_protocol/datum.hpp"
+#include "rdb_protocol/term_storage.hpp"
+
+class read_stream_t;
+
+namespace ql {
+
+// A `term_storage_t` for JSON queries that get parsed while they are read, rather
+// than read into a buffer and parsed into a `rapidjson::Document` first.  This is
+// meant for large queries, which are mostly big literal objects being inserted.
+//
+// The term is built as `generated_term_t`s, doing the checks that
+// `preprocess_term_tree` would do on the JSON as it goes.  Objects that are all
+// literals are converted to a single datum as soon as they end, so they don't turn
+// into a `MAKE_OBJ` term with a term and a backtrace frame per field.  Literal arrays
+// are left as `MAKE_ARRAY` terms, because those enforce the array size limit when
+// they are evaluated.
+class streamed_term_storage_t : public term_storage_t {
+public:
+    streamed_term_storage_t();
+
+    // Parses a query of exactly `size` bytes from `stream`.  Returns false if the
+    // query isn't valid JSON, and throws `bt_exc_t` if it isn't a valid query, like
+    // `json_term_storage_t`'s constructor does.  Always reads all `size` bytes, unless
+    // reading from `stream` throws.
+    MUST_USE bool parse(read_stream_t *stream, size_t size);
+
+    Query::QueryType query_type() const;
+    bool static_optarg_as_bool(const std::string &key, bool default_value) const;
+    // Throws the first error found in the term while parsing it.
+    void preprocess();
+    raw_term_t root_term() const;
+    global_optargs_t global_optargs();
+    void execute_args(int64_t *prepared_query_id_out,
+                      std::vector<datum_t> *args_out) const;
+
+private:
+    class handler_t;
+
+    Query::QueryType type;
+
+    // The term of START and PREPARE queries.
+    counted_t<generated_term_t> root;
+    // The second element of other queries, such as the id and arguments of an
+    // EXECUTE query.
+    datum_t payload;
+    // The global optargs in the order they were sent.  This isn't a map so that
+    // `global_optargs_t::add_optarg` still catches duplicates.
+    std::vector<std::pair<std::string, counted_t<generated_term_t> > > optargs;
+
+    // The first error found in the term or the global optargs.
+    std::exception_ptr term_error;
+
+    DISABLE_COPYING(streamed_term_storage_t);
+};
+
+} // namespace ql
+
+#endif // RDB_PROTOCOL_STREAMED_TERM_STORAGE_HPP_
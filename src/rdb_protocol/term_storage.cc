@@ -30,6 +30,8 @@ bool query_type_is_valid(Query::QueryType query_type) {
     case Query::STOP:
     case Query::NOREPLY_WAIT:
     case Query::SERVER_INFO:
+    case Query::PREPARE:
+    case Query::EXECUTE:
         return true;
     default:
         return false;
@@ -235,6 +237,13 @@ global_optargs_t term_storage_t::global_optargs() {
     unreachable();
 }
 
+void term_storage_t::execute_args(UNUSED int64_t *prepared_query_id_out,
+                                  UNUSED std::vector<datum_t> *args_out) const {
+    r_sanity_check(false, "execute_args() is unimplemented "
+                   "for this term_storage_t type");
+    unreachable();
+}
+
 const backtrace_registry_t &term_storage_t::backtrace_registry() const {
     return bt_reg;
 }
@@ -361,6 +370,37 @@ global_optargs_t json_term_storage_t::global_optargs() {
     return res;
 }
 
+void json_term_storage_t::execute_args(int64_t *prepared_query_id_out,
+                                       std::vector<datum_t> *args_out) const {
+    r_sanity_check(query_type() == Query::EXECUTE);
+    if (query_json.Size() < 2 ||
+        !query_json[1].IsArray() ||
+        query_json[1].Size() != 2 ||
+        !query_json[1][0].IsInt64() ||
+        !query_json[1][1].IsArray()) {
+        throw bt_exc_t(Response::CLIENT_ERROR, Response::QUERY_LOGIC,
+                       "Expected an EXECUTE query to have a term of the form "
+                       "[PREPARED_QUERY_ID, [ARGS...]].",
+                       backtrace_registry_t::EMPTY_BACKTRACE);
+    }
+    *prepared_query_id_out = query_json[1][0].GetInt64();
+
+    const rapidjson::Value &args = query_json[1][1];
+    args_out->clear();
+    args_out->reserve(args.Size());
+    try {
+        for (rapidjson::SizeType i = 0; i < args.Size(); ++i) {
+            args_out->push_back(to_datum(args[i], configured_limits_t::unlimited,
+                                         reql_version_t::LATEST));
+        }
+    } catch (const base_exc_t &ex) {
+        throw bt_exc_t(Response::CLIENT_ERROR, ex.get_error_type(),
+                       strprintf("Invalid argument for a prepared query: %s",
+                                 ex.what()),
+                       backtrace_registry_t::EMPTY_BACKTRACE);
+    }
+}
+
 wire_term_storage_t::wire_term_storage_t(scoped_array_t<char> &&_original_data,
                                          rapidjson::Document &&_func_json) :
         original_data(std::move(_original_data)),
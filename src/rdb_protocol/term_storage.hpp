@@ -20,6 +20,7 @@
 namespace ql {
 
 const char *rapidjson_typestr(rapidjson::Type t);
+bool query_type_is_valid(Query::QueryType query_type);
 
 struct generated_term_t;
 
@@ -133,6 +134,8 @@ public:
                                        bool default_value) const;
     virtual void preprocess();
     virtual global_optargs_t global_optargs();
+    virtual void execute_args(int64_t *prepared_query_id_out,
+                              std::vector<datum_t> *args_out) const;
 
 protected:
     backtrace_registry_t bt_reg;
@@ -148,6 +151,9 @@ public:
     void preprocess();
     raw_term_t root_term() const;
     global_optargs_t global_optargs();
+    // Only valid for EXECUTE queries, whose term is `[id, [arg, ...]]`.
+    void execute_args(int64_t *prepared_query_id_out,
+                      std::vector<datum_t> *args_out) const;
 private:
     scoped_array_t<char> original_data;
     rapidjson::Document query_json;
@@ -10,10 +10,6 @@
 
 namespace ql {
 
-bool term_type_is_valid(Term::TermType type);
-bool term_is_write_or_meta(Term::TermType type);
-bool term_forbids_writes(Term::TermType type);
-
 // The minimum amount of stack space we require to be available on a coroutine
 // before attempting to walk into another term.
 const size_t MIN_WALK_STACK_SPACE = 16 * KILOBYTE;
@@ -3,6 +3,7 @@
 #define RDB_PROTOCOL_TERM_WALKER_HPP_
 
 #include "rapidjson/document.h"
+#include "rdb_protocol/ql2.pb.h"
 
 namespace ql {
 
@@ -24,6 +25,12 @@ void preprocess_term_tree(rapidjson::Value *query_json,
 void preprocess_global_optarg(rapidjson::Value *optarg,
                               rapidjson::Value::AllocatorType *allocator);
 
+// The checks the walker does on each term, also used when terms are built straight
+// from a stream (see `streamed_term_storage_t`).
+bool term_type_is_valid(Term::TermType type);
+bool term_is_write_or_meta(Term::TermType type);
+bool term_forbids_writes(Term::TermType type);
+
 } // namespace ql
 
 #endif // RDB_PROTOCOL_TERM_WALKER_HPP_
@@ -4,8 +4,9 @@
 #include <string>
 #include <utility>
 
+#include "rdb_protocol/datum_hash_map.hpp"
 #include "rdb_protocol/datum_stream.hpp"
-#include "rdb_protocol/datum_stream/array.hpp"
+#include "rdb_protocol/datum_stream/in_memory_sort.hpp"
 #include "rdb_protocol/datum_stream/indexed_sort.hpp"
 #include "rdb_protocol/error.hpp"
 #include "rdb_protocol/func.hpp"
@@ -116,12 +117,10 @@ private:
                 std::move(data.begin(), data.end(), std::back_inserter(to_sort));
                 rcheck_array_size(to_sort, env->env->limits());
             }
-            profile::sampler_t sampler("Sorting in-memory.", env->env->trace);
-            auto fn = std::bind(lt_cmp, env->env, &sampler, ph::_1, ph::_2);
-            std::stable_sort(to_sort.begin(), to_sort.end(), fn);
-            seq = make_counted<array_datum_stream_t>(
-                datum_t(std::move(to_sort), env->env->limits()),
-                backtrace());
+            // The elements get sorted when they're read, so that
+            // `order_by(...).limit(n)` only has to find the first `n`.
+            seq = make_counted<in_memory_sort_datum_stream_t>(
+                std::move(to_sort), lt_cmp, backtrace());
         }
         return tbl_slice.has()
             ? new_val(make_counted<selection_t>(tbl_slice->get_tbl(), seq))
@@ -166,22 +165,35 @@ private:
         rcheck(!idx, base_exc_t::LOGIC,
                "Can only perform an indexed distinct on a TABLE.");
         counted_t<datum_stream_t> s = v->as_seq(env->env);
-        // The reql_version matters here, because we copy `results` into `toret`
-        // in ascending order.
-        std::set<datum_t, optional_datum_less_t> results;
+        if (!s->is_array() && !s->is_grouped() && !s->is_infinite()
+            && s->cfeed_type() == feed_type_t::not_feed) {
+            // The shards drop the duplicates they find in each batch, so that we
+            // don't have to send and hash them here.
+            s->add_transformation(distinct_wire_func_t(false), backtrace());
+        }
+        // The values are unused, the hash map only serves as a set.  Hashing each
+        // element is much cheaper than comparing it with O(log n) others, and we
+        // only sort the distinct ones at the end.
+        datum_hash_map_t<bool> results;
         batchspec_t batchspec = batchspec_t::user(batch_type_t::TERMINAL, env->env);
         {
             profile::sampler_t sampler("Evaluating elements in distinct.",
                                        env->env->trace);
             datum_t d;
             while (d = s->next(env->env, batchspec), d.has()) {
-                results.insert(std::move(d));
-                rcheck_array_size(results, env->env->limits());
+                if (results.insert(d, true).second) {
+                    rcheck_array_size(results, env->env->limits());
+                }
                 sampler.new_sample();
             }
         }
+        // The reql_version matters here, because we return the elements in
+        // ascending order.
         std::vector<datum_t> toret;
-        std::move(results.begin(), results.end(), std::back_inserter(toret));
+        toret.reserve(results.size());
+        for (auto &&pair : results.release_sorted()) {
+            toret.push_back(std::move(pair.first));
+        }
         return new_val(datum_t(std::move(toret), env->env->limits()));
     }
 
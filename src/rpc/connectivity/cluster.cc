@@ -5,6 +5,8 @@
 #include <netinet/in.h>
 #endif
 
+#include <zlib.h>
+
 #include <algorithm>
 #include <functional>
 
@@ -28,12 +30,43 @@
 // Number of messages after which the message handling loop yields
 #define MESSAGE_HANDLER_MAX_BATCH_SIZE           16
 
+// Messages smaller than this are never compressed. Most replica writes and directory
+// updates are this small, and compressing them would add latency for little gain.
+#define CLUSTER_COMPRESSION_MIN_MESSAGE_SIZE     KILOBYTE
+
+// With `cluster_compression_t::ADAPTIVE`, messages of at least this size are compressed
+// at CLUSTER_COMPRESSION_STRONG_LEVEL rather than CLUSTER_COMPRESSION_FAST_LEVEL. Most
+// of them are backfill chunks, for which bandwidth matters more than latency.
+#define CLUSTER_COMPRESSION_STRONG_MESSAGE_SIZE  (64 * KILOBYTE)
+
+// zlib compression levels
+#define CLUSTER_COMPRESSION_FAST_LEVEL           1
+#define CLUSTER_COMPRESSION_STRONG_LEVEL         6
+
+// Deflate can't compress anything by more than about 1032:1, so a compressed message
+// that claims to expand by more than this is a bad frame. Checking this keeps a peer
+// from making us allocate an arbitrary amount of memory.
+#define CLUSTER_COMPRESSION_MAX_RATIO            1032
+
+// Larger messages are always sent uncompressed. The receiver rejects compressed frames
+// that claim to be larger than this before allocating any buffers for them.
+#define CLUSTER_COMPRESSION_MAX_MESSAGE_SIZE     (256 * MEGABYTE)
+
+// Servers list this in the `additional_info` of their successful handshake result to
+// tell the other server that it may send them compressed messages.
+#define CLUSTER_COMPRESSION_CAPABILITY           "compression:zlib"
+
 // The cluster communication protocol version.
 static_assert(cluster_version_t::CLUSTER == cluster_version_t::v2_5_is_latest,
               "We need to update CLUSTER_VERSION_STRING when we add a new cluster "
               "version.");
 
-#define CLUSTER_VERSION_STRING "2.5.0"
+// The last component changes when the messages change in a way that older servers
+// can't read, without a new `cluster_version_t`.  Servers refuse to connect to
+// servers with a lesser version string.
+//  - 2.5.1: `local_issues_t` carries data corruption issues.
+//  - 2.5.2: `rget_read_t` carries `is_scan`.
+#define CLUSTER_VERSION_STRING "2.5.2"
 
 const std::string connectivity_cluster_t::cluster_proto_header("RethinkDB cluster\n");
 const std::string connectivity_cluster_t::cluster_version_string(CLUSTER_VERSION_STRING);
@@ -100,6 +133,50 @@ static bool resolve_protocol_version(const std::string &remote_version_string,
     return false;
 }
 
+/* The codec of a compressed message, which is sent after its tag. The numeric values
+must never change. */
+enum class message_codec_t : uint8_t {
+    ZLIB = 1
+};
+
+/* Returns the zlib level at which to compress a message of size `size` on a connection
+that uses `compression`, or 0 if the message shouldn't be compressed. All messages that
+higher-level code sends share a few tags, so we go by size to tell backfill chunks
+apart from replica writes and directory updates. */
+static int compression_level(cluster_compression_t compression, size_t size) {
+    if (compression == cluster_compression_t::NONE
+            || size < CLUSTER_COMPRESSION_MIN_MESSAGE_SIZE
+            || size > static_cast<size_t>(CLUSTER_COMPRESSION_MAX_MESSAGE_SIZE)) {
+        return 0;
+    }
+    if (compression == cluster_compression_t::ADAPTIVE
+            && size >= CLUSTER_COMPRESSION_STRONG_MESSAGE_SIZE) {
+        return CLUSTER_COMPRESSION_STRONG_LEVEL;
+    }
+    return CLUSTER_COMPRESSION_FAST_LEVEL;
+}
+
+/* Compresses `data` into `*compressed_out`. Returns false if that wouldn't make the
+message any smaller, in which case it should be sent as it is. */
+static bool compress_message(const std::vector<char> &data,
+                             int level,
+                             std::vector<char> *compressed_out) {
+    // We don't allow the compressed message to be larger than the original one.
+    uLongf compressed_size = data.size();
+    compressed_out->resize(compressed_size);
+    int res = compress2(reinterpret_cast<Bytef *>(compressed_out->data()),
+                        &compressed_size,
+                        reinterpret_cast<const Bytef *>(data.data()),
+                        data.size(),
+                        level);
+    if (res == Z_BUF_ERROR) {
+        return false;
+    }
+    guarantee(res == Z_OK, "compress2 failed with error %d", res);
+    compressed_out->resize(compressed_size);
+    return true;
+}
+
 #if defined (__x86_64__) || defined (_WIN64) || defined (__s390x__)
 const std::string connectivity_cluster_t::cluster_arch_bitsize("64bit");
 #elif defined (__i386__) || defined(__arm__) || defined(_WIN32)
@@ -133,7 +210,8 @@ connectivity_cluster_t::connection_t::connection_t(
         const peer_id_t &_peer_id,
         const server_id_t &_server_id,
         keepalive_tcp_conn_stream_t *_conn,
-        const peer_address_t &_peer_address) THROWS_NOTHING :
+        const peer_address_t &_peer_address,
+        cluster_compression_t _compression) THROWS_NOTHING :
     conn(_conn),
     peer_address(_peer_address),
     flusher([&](signal_t *) {
@@ -145,6 +223,7 @@ connectivity_cluster_t::connection_t::connection_t(
         // must be handled elsewhere.
         this->conn->flush_buffer();
     }, 1),
+    compression(_conn == nullptr ? cluster_compression_t::NONE : _compression),
     pm_collection(),
     pm_bytes_sent(secs_to_ticks(1), true),
     pm_collection_membership(
@@ -221,11 +300,13 @@ connectivity_cluster_t::run_t::run_t(
             _heartbeat_sl_view,
         std::shared_ptr<semilattice_read_view_t<auth_semilattice_metadata_t> >
             _auth_sl_view,
-        tls_ctx_t *_tls_ctx)
+        tls_ctx_t *_tls_ctx,
+        cluster_compression_t _compression)
         THROWS_ONLY(address_in_use_exc_t, tcp_socket_exc_t) :
     parent(_parent),
     server_id(_server_id),
     tls_ctx(_tls_ctx),
+    compression(_compression),
 
     /* Create the socket to use when listening for connections from peers */
     cluster_listener_socket(new tcp_bound_socket_t(local_addresses, port)),
@@ -257,7 +338,8 @@ connectivity_cluster_t::run_t::run_t(
     `connection_map` on each thread and notifying any listeners that we're now
     connected to ourself. The destructor will remove us from the
     `connection_map` and again notify any listeners. */
-    connection_to_ourself(this, parent->me, _server_id, nullptr, routing_table[parent->me]),
+    connection_to_ourself(this, parent->me, _server_id, nullptr, routing_table[parent->me],
+                          cluster_compression_t::NONE),
 
     heartbeat_sl_view(_heartbeat_sl_view),
     auth_sl_view(_auth_sl_view),
@@ -739,6 +821,13 @@ public:
     static handshake_result_t success() {
         return handshake_result_t(handshake_result_code_t::SUCCESS);
     }
+    /* Old servers ignore the `additional_info` of a successful handshake result, so we
+    use it to announce optional features, separated by spaces. */
+    static handshake_result_t success(const std::string &features) {
+        handshake_result_t result(handshake_result_code_t::SUCCESS);
+        result.additional_info = features;
+        return result;
+    }
     static handshake_result_t error(handshake_result_code_t error_code,
                                     const std::string &additional_info) {
         return handshake_result_t(error_code, additional_info);
@@ -748,6 +837,12 @@ public:
         return code;
     }
 
+    bool has_feature(const std::string &feature) const {
+        rassert(code == handshake_result_code_t::SUCCESS);
+        const std::vector<std::string> features = split_string(additional_info, ' ');
+        return std::find(features.begin(), features.end(), feature) != features.end();
+    }
+
     std::string get_error_reason() const {
         if (code == handshake_result_code_t::UNKNOWN_ERROR) {
             return error_code_string + " (" + additional_info + ")";
@@ -1072,10 +1167,13 @@ join_result_t connectivity_cluster_t::run_t::handle(
         return join_result_t::TEMPORARY_ERROR;
     }
 
+    // Whether the other node can decompress the messages we send it
+    bool peer_decompresses = false;
     {
         // Tell the other node that we are happy to connect with it
         write_message_t wm;
-        serialize_universal(&wm, handshake_result_t::success());
+        serialize_universal(&wm, handshake_result_t::success(
+            CLUSTER_COMPRESSION_CAPABILITY));
         if (send_write_message(conn, &wm)) {
             return join_result_t::TEMPORARY_ERROR; // network error.
         }
@@ -1094,6 +1192,7 @@ join_result_t connectivity_cluster_t::run_t::handle(
                 return join_result_t::TEMPORARY_ERROR;
             return join_result_t::PERMANENT_ERROR;
         }
+        peer_decompresses = handshake_result.has_feature(CLUSTER_COMPRESSION_CAPABILITY);
     }
 
     // Look up the ip addresses for the other host
@@ -1317,7 +1416,8 @@ join_result_t connectivity_cluster_t::run_t::handle(
         constructor registers it in the `connectivity_cluster_t`'s connection
         map. */
         connection_t conn_structure(
-            this, other_id, remote_server_id, conn, *other_peer_addr.get());
+            this, other_id, remote_server_id, conn, *other_peer_addr.get(),
+            peer_decompresses ? compression : cluster_compression_t::NONE);
 
         /* `heartbeat_manager` will periodically send a heartbeat message to
         other servers, and it will also close the connection if we don't
@@ -1341,19 +1441,13 @@ join_result_t connectivity_cluster_t::run_t::handle(
                 /* Ignore messages tagged with the heartbeat tag. The
                 `keepalive_tcp_conn_stream_t` will have already notified the
                 `heartbeat_manager_t` as soon as the heartbeat arrived. */
-                if (tag != heartbeat_tag) {
-                    cluster_message_handler_t *handler = parent->message_handlers[tag];
-                    guarantee(handler != nullptr, "Got a message for an unfamiliar tag. "
-                        "Apparently we aren't compatible with the cluster on the other "
-                        "end.");
-
-                    /* If you really want to support old cluster versions, the
-                    resolved_version should be passed into the on_message() handler. */
-                    guarantee(resolved_version == cluster_version_t::CLUSTER);
-                    handler->on_message(
-                        &conn_structure,
-                        auto_drainer_t::lock_t(conn_structure.drainers.get()),
-                        conn); // might raise fake_archive_exc_t
+                if (tag == compressed_tag) {
+                    std::vector<char> data;
+                    receive_compressed_message(conn, &tag, &data);
+                    vector_read_stream_t data_stream(std::move(data));
+                    handle_message(&conn_structure, tag, resolved_version, &data_stream);
+                } else if (tag != heartbeat_tag) {
+                    handle_message(&conn_structure, tag, resolved_version, conn);
                 }
 
                 ++messages_handled_since_yield;
@@ -1393,6 +1487,65 @@ join_result_t connectivity_cluster_t::run_t::handle(
     return join_result_t::SUCCESS;
 }
 
+void connectivity_cluster_t::run_t::receive_compressed_message(
+        keepalive_tcp_conn_stream_t *conn,
+        message_tag_t *tag_out,
+        std::vector<char> *data_out) {
+    uint8_t codec;
+    uint64_t uncompressed_size, compressed_size;
+    if (bad(deserialize_universal(conn, tag_out)) ||
+        bad(deserialize_universal(conn, &codec)) ||
+        bad(deserialize_universal(conn, &uncompressed_size)) ||
+        bad(deserialize_universal(conn, &compressed_size))) {
+        throw fake_archive_exc_t();
+    }
+    if (codec != static_cast<uint8_t>(message_codec_t::ZLIB) ||
+        *tag_out == heartbeat_tag || *tag_out == compressed_tag ||
+        uncompressed_size > static_cast<uint64_t>(CLUSTER_COMPRESSION_MAX_MESSAGE_SIZE) ||
+        compressed_size > uncompressed_size ||
+        uncompressed_size / CLUSTER_COMPRESSION_MAX_RATIO > compressed_size) {
+        throw fake_archive_exc_t();
+    }
+
+    std::vector<char> compressed(compressed_size);
+    int64_t res = force_read(conn, compressed.data(), compressed_size);
+    if (res != static_cast<int64_t>(compressed_size)) {
+        throw fake_archive_exc_t();
+    }
+
+    data_out->resize(uncompressed_size);
+    uLongf size = uncompressed_size;
+    int zres = uncompress(reinterpret_cast<Bytef *>(data_out->data()),
+                          &size,
+                          reinterpret_cast<const Bytef *>(compressed.data()),
+                          compressed_size);
+    if (zres != Z_OK || size != uncompressed_size) {
+        throw fake_archive_exc_t();
+    }
+
+    parent->compressed_bytes_received += compressed_size;
+    parent->uncompressed_bytes_received += uncompressed_size;
+}
+
+void connectivity_cluster_t::run_t::handle_message(
+        connection_t *connection,
+        message_tag_t tag,
+        cluster_version_t resolved_version,
+        read_stream_t *stream) {
+    cluster_message_handler_t *handler = parent->message_handlers[tag];
+    guarantee(handler != nullptr, "Got a message for an unfamiliar tag. "
+        "Apparently we aren't compatible with the cluster on the other "
+        "end.");
+
+    /* If you really want to support old cluster versions, the
+    resolved_version should be passed into the on_message() handler. */
+    guarantee(resolved_version == cluster_version_t::CLUSTER);
+    handler->on_message(
+        connection,
+        auto_drainer_t::lock_t(connection->drainers.get()),
+        stream); // might raise fake_archive_exc_t
+}
+
 connectivity_cluster_t::connectivity_cluster_t() THROWS_NOTHING :
     me(peer_id_t(generate_uuid())),
     /* We assign threads from the highest thread number downwards. This is to reduce the
@@ -1403,7 +1556,12 @@ connectivity_cluster_t::connectivity_cluster_t() THROWS_NOTHING :
     }),
     current_run(nullptr),
     connectivity_collection(),
-    stats_membership(&get_global_perfmon_collection(), &connectivity_collection, "connectivity")
+    stats_membership(&get_global_perfmon_collection(), &connectivity_collection, "connectivity"),
+    compression_stats_membership(&connectivity_collection,
+        &compressed_bytes_sent, "compressed_bytes_sent",
+        &uncompressed_bytes_sent, "uncompressed_bytes_sent",
+        &compressed_bytes_received, "compressed_bytes_received",
+        &uncompressed_bytes_received, "uncompressed_bytes_received")
 {
     for (int i = 0; i < max_message_tag; i++) {
         message_handlers[i] = nullptr;
@@ -1526,6 +1684,23 @@ void connectivity_cluster_t::send_message(connection_t *connection,
         message_handlers[tag]->on_local_message(connection, connection_keepalive,
             std::move(buffer_data));
     } else {
+        std::vector<char> buffer_data;
+        buffer.swap(&buffer_data);
+
+        /* We compress the message before switching to the connection's thread, so
+        that compressing large messages doesn't hold up the other messages on that
+        thread. */
+        std::vector<char> compressed_data;
+        const int level = compression_level(connection->compression, bytes_sent);
+        const bool compressed =
+            level != 0 && compress_message(buffer_data, level, &compressed_data);
+        if (compressed) {
+            buffer_data.swap(compressed_data);
+            compressed_data.clear();
+            compressed_data.shrink_to_fit();
+        }
+        const size_t wire_size = buffer_data.size();
+
         on_thread_t threader(connection->conn->home_thread());
 
         /* Acquire the send-mutex so we don't collide with other things trying
@@ -1544,7 +1719,16 @@ void connectivity_cluster_t::send_message(connection_t *connection,
                               "changed, the cluster communication format has changed and "
                               "you need to ask yourself whether live cluster upgrades work."
                               );
-                serialize_universal(&wm, tag);
+                if (compressed) {
+                    serialize_universal(&wm, compressed_tag);
+                    serialize_universal(&wm, tag);
+                    serialize_universal(&wm,
+                        static_cast<uint8_t>(message_codec_t::ZLIB));
+                    serialize_universal(&wm, static_cast<uint64_t>(bytes_sent));
+                    serialize_universal(&wm, static_cast<uint64_t>(wire_size));
+                } else {
+                    serialize_universal(&wm, tag);
+                }
                 make_buffered_tcp_conn_stream_wrapper_t buffered_conn(connection->conn);
                 int res = send_write_message(&buffered_conn, &wm);
                 if (res == -1) {
@@ -1558,17 +1742,15 @@ void connectivity_cluster_t::send_message(connection_t *connection,
                 }
             }
 
-            /* Write the message itself to the network */
+            /* Write the message itself to the network. Large messages, such as
+            backfill chunks, are handed to the connection as they are instead of
+            being copied into its write buffer. */
             {
-                int64_t res = connection->conn->write_buffered(buffer.vector().data(),
-                                                               buffer.vector().size());
-                if (res == -1) {
+                if (!connection->conn->write_buffered_vector(std::move(buffer_data))) {
                     if (connection->conn->is_read_open()) {
                         connection->conn->shutdown_read();
                     }
                     return;
-                } else {
-                    guarantee(res == static_cast<int64_t>(buffer.vector().size()));
                 }
             }
         } /* Releases the send_mutex */
@@ -1582,6 +1764,11 @@ void connectivity_cluster_t::send_message(connection_t *connection,
             }
             return;
         }
+
+        if (compressed) {
+            compressed_bytes_sent += wire_size;
+            uncompressed_bytes_sent += bytes_sent;
+        }
     }
 
     connection->pm_bytes_sent.record(bytes_sent);
@@ -1596,6 +1783,9 @@ cluster_message_handler_t::cluster_message_handler_t(
     rassert(tag != connectivity_cluster_t::heartbeat_tag,
         "Tag %" PRIu8 " is reserved for heartbeat messages.",
         connectivity_cluster_t::heartbeat_tag);
+    rassert(tag != connectivity_cluster_t::compressed_tag,
+        "Tag %" PRIu8 " is reserved for compressed messages.",
+        connectivity_cluster_t::compressed_tag);
     rassert(connectivity_cluster->message_handlers[tag] == nullptr);
     connectivity_cluster->message_handlers[tag] = this;
 }
@@ -42,6 +42,21 @@ enum class join_result_t {
 
 typedef std::map<ip_and_port_t, join_result_t> join_results_t;
 
+/* How a server compresses the messages that it sends to other servers. Whether a
+connection compresses messages is negotiated during the handshake: a server only sends
+compressed messages to peers that announced that they can decompress them, and it can
+always decompress the messages it receives, whatever its own setting. Small messages,
+such as most replica writes and directory updates, are never compressed. */
+enum class cluster_compression_t {
+    NONE = 0,
+    /* Compresses larger messages at a low level, which saves bandwidth without adding
+    much latency. */
+    FAST = 1,
+    /* Like `FAST`, but compresses the largest messages, which are mostly backfill
+    chunks, at a higher level. This is meant for links where bandwidth is scarce. */
+    ADAPTIVE = 2
+};
+
 /* Uncomment this to enable message profiling. Message profiling will keep track of how
 many messages of each type are sent over the network; it will dump the results to a file
 named `msg_profiler_out_PID.txt` on shutdown. Each line of that file will be of the
@@ -105,6 +120,10 @@ public:
     /* This tag is reserved exclusively for heartbeat messages. */
     static const message_tag_t heartbeat_tag = 'H';
 
+    /* This tag is reserved for compressed messages. A compressed message carries the
+    tag of the message that it contains. */
+    static const message_tag_t compressed_tag = 'Z';
+
     class run_t;
 
     /* `connection_t` represents an open connection to another server. If we lose
@@ -154,7 +173,8 @@ public:
             const peer_id_t &peer_id,
             const server_id_t &server_id,
             keepalive_tcp_conn_stream_t *,
-            const peer_address_t &peer_address) THROWS_NOTHING;
+            const peer_address_t &peer_address,
+            cluster_compression_t compression) THROWS_NOTHING;
         ~connection_t() THROWS_NOTHING;
 
         /* NULL for the loopback connection (i.e. our "connection" to ourself) */
@@ -172,6 +192,11 @@ public:
         buffered write makes it to the TCP stack. */
         pump_coro_t flusher;
 
+        /* How we compress the messages we send on this connection. This is always
+        `NONE` for the loopback connection and for peers that can't decompress
+        messages. */
+        const cluster_compression_t compression;
+
         perfmon_collection_t pm_collection;
         perfmon_sampler_t pm_bytes_sent;
         perfmon_membership_t pm_collection_membership, pm_bytes_sent_membership;
@@ -203,7 +228,8 @@ public:
                   heartbeat_semilattice_metadata_t> > heartbeat_sl_view,
               std::shared_ptr<semilattice_read_view_t<
                   auth_semilattice_metadata_t> > auth_sl_view,
-              tls_ctx_t *tls_ctx)
+              tls_ctx_t *tls_ctx,
+              cluster_compression_t compression = cluster_compression_t::NONE)
             THROWS_ONLY(address_in_use_exc_t, tcp_socket_exc_t);
 
         ~run_t();
@@ -289,6 +315,18 @@ public:
             bool *successful_join_inout,
             const int join_delay_secs) THROWS_NOTHING;
 
+        /* Reads the rest of a message that was sent with `compressed_tag` from `conn`
+        and decompresses it. Throws `fake_archive_exc_t` if the message is invalid. */
+        void receive_compressed_message(keepalive_tcp_conn_stream_t *conn,
+                                        message_tag_t *tag_out,
+                                        std::vector<char> *data_out);
+
+        /* Passes a message that `handle()` received to the handler for its tag. */
+        void handle_message(connection_t *connection,
+                            message_tag_t tag,
+                            cluster_version_t resolved_version,
+                            read_stream_t *stream);
+
         connectivity_cluster_t *parent;
 
         /* The server's own id and the set of servers we are connected to, we only allow
@@ -298,6 +336,9 @@ public:
 
         tls_ctx_t *tls_ctx;
 
+        /* How we want to compress messages to peers that can decompress them */
+        const cluster_compression_t compression;
+
         /* `attempt_table` is a table of all the host:port pairs we're currently
         trying to connect to or have connected to. If we are told to connect to
         an address already in this table, we'll just ignore it. That's important
@@ -365,6 +406,12 @@ public:
                       message_tag_t tag,
                       cluster_send_message_write_callback_t *callback);
 
+    /* The stats of this `connectivity_cluster_t`, which appear as "connectivity" in the
+    server's stats. */
+    perfmon_collection_t *get_connectivity_collection() {
+        return &connectivity_collection;
+    }
+
 private:
     friend class cluster_message_handler_t;
     friend class run_t;
@@ -401,6 +448,13 @@ private:
     perfmon_collection_t connectivity_collection;
     perfmon_membership_t stats_membership;
 
+    /* `compressed_bytes_*` count the bytes of compressed messages as they go over the
+    network, and `uncompressed_bytes_*` count the size of the same messages before
+    compression. Messages that aren't compressed don't count towards either. */
+    perfmon_counter_t compressed_bytes_sent, uncompressed_bytes_sent;
+    perfmon_counter_t compressed_bytes_received, uncompressed_bytes_received;
+    perfmon_multi_membership_t compression_stats_membership;
+
     DISABLE_COPYING(connectivity_cluster_t);
 };
 
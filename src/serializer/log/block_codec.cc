@@ -0,0 +1,117 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#include "serializer/log/block_codec.hpp"
+
+#include <inttypes.h>
+#include <string.h>
+#include <zlib.h>
+
+#include "errors.hpp"
+#include "math.hpp"
+
+namespace {
+
+const size_t compressed_payload_offset
+    = sizeof(ls_buf_data_t) + sizeof(compressed_block_header_t);
+
+char *payload(ser_buffer_t *buf) {
+    return reinterpret_cast<char *>(buf) + compressed_payload_offset;
+}
+
+const char *payload(const ser_buffer_t *buf) {
+    return reinterpret_cast<const char *>(buf) + compressed_payload_offset;
+}
+
+}  // namespace
+
+bool compress_block(block_codec_t codec,
+                    const ser_buffer_t *buf,
+                    block_size_t block_size,
+                    scoped_device_block_aligned_ptr_t<ser_buffer_t> *compressed_out,
+                    block_size_t *disk_block_size_out) {
+    if (codec == block_codec_t::none) {
+        return false;
+    }
+    guarantee(codec == block_codec_t::zlib);
+
+    // Compression only pays off if it saves at least one device block, since that's
+    // the granularity at which blocks get laid out in an extent.
+    const size_t aligned_size = ceil_aligned(block_size.ser_value(), DEVICE_BLOCK_SIZE);
+    if (aligned_size < DEVICE_BLOCK_SIZE + compressed_payload_offset + 1) {
+        return false;
+    }
+    const size_t max_disk_size = aligned_size - DEVICE_BLOCK_SIZE;
+
+    scoped_device_block_aligned_ptr_t<ser_buffer_t> compressed(max_disk_size);
+    uLongf payload_size = max_disk_size - compressed_payload_offset;
+    int res = compress2(reinterpret_cast<Bytef *>(payload(compressed.get())),
+                        &payload_size,
+                        reinterpret_cast<const Bytef *>(buf->cache_data),
+                        block_size.value(),
+                        Z_BEST_SPEED);
+    if (res == Z_BUF_ERROR) {
+        // The block doesn't compress well enough.
+        return false;
+    }
+    guarantee(res == Z_OK, "compress2 failed with error %d", res);
+
+    compressed->ser_header = buf->ser_header;
+    compressed_block_header_t *header = reinterpret_cast<compressed_block_header_t *>(
+        compressed->cache_data);
+    header->codec = static_cast<uint8_t>(codec);
+    header->padding = 0;
+    header->ser_block_size = block_size.ser_value();
+
+    const size_t disk_size = compressed_payload_offset + payload_size;
+    memset(reinterpret_cast<char *>(compressed.get()) + disk_size, 0,
+           max_disk_size - disk_size);
+
+    *compressed_out = std::move(compressed);
+    *disk_block_size_out = block_size_t::unsafe_make(disk_size);
+    return true;
+}
+
+bool try_decompress_block(const ser_buffer_t *compressed,
+                          block_size_t disk_block_size,
+                          ser_buffer_t *buf_out,
+                          block_size_t block_size) {
+    if (disk_block_size.ser_value() <= compressed_payload_offset) {
+        return false;
+    }
+    const compressed_block_header_t *header
+        = reinterpret_cast<const compressed_block_header_t *>(compressed->cache_data);
+    if (header->ser_block_size != block_size.ser_value()
+        || header->codec != static_cast<uint8_t>(block_codec_t::zlib)) {
+        return false;
+    }
+
+    buf_out->ser_header = compressed->ser_header;
+    uLongf size = block_size.value();
+    int res = uncompress(reinterpret_cast<Bytef *>(buf_out->cache_data),
+                         &size,
+                         reinterpret_cast<const Bytef *>(payload(compressed)),
+                         disk_block_size.ser_value() - compressed_payload_offset);
+    return res == Z_OK && size == block_size.value();
+}
+
+void decompress_block(const ser_buffer_t *compressed,
+                      block_size_t disk_block_size,
+                      ser_buffer_t *buf_out,
+                      block_size_t block_size) {
+    guarantee(disk_block_size.ser_value() > compressed_payload_offset);
+    const compressed_block_header_t *header
+        = reinterpret_cast<const compressed_block_header_t *>(compressed->cache_data);
+    guarantee(header->ser_block_size == block_size.ser_value(),
+              "Compressed block has size %" PRIu16 ", expected %" PRIu16 ".",
+              header->ser_block_size, block_size.ser_value());
+    guarantee(header->codec == static_cast<uint8_t>(block_codec_t::zlib),
+              "Unknown block codec %" PRIu8 ".", header->codec);
+
+    buf_out->ser_header = compressed->ser_header;
+    uLongf size = block_size.value();
+    int res = uncompress(reinterpret_cast<Bytef *>(buf_out->cache_data),
+                         &size,
+                         reinterpret_cast<const Bytef *>(payload(compressed)),
+                         disk_block_size.ser_value() - compressed_payload_offset);
+    guarantee(res == Z_OK, "Corrupted compressed block (zlib error %d).", res);
+    guarantee(size == block_size.value());
+}
@@ -0,0 +1,54 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#ifndef SERIALIZER_LOG_BLOCK_CODEC_HPP_
+#define SERIALIZER_LOG_BLOCK_CODEC_HPP_
+
+#include <stdint.h>
+
+#include "arch/compiler.hpp"
+#include "containers/scoped.hpp"
+#include "serializer/types.hpp"
+
+/* The codec that the data block manager applies to blocks before writing them to
+disk.  The numeric values are stored in the header of every compressed block, so
+they must never change. */
+enum class block_codec_t : uint8_t {
+    none = 0,
+    zlib = 1
+};
+
+/* A compressed block on disk starts with the usual `ls_buf_data_t`, so that the GC
+and read-ahead can still find its block id, followed by this header and the
+compressed `cache_data`.  The LBA and the data block manager know a block is
+compressed because its on-disk size differs from its (uncompressed) block size. */
+ATTR_PACKED(struct compressed_block_header_t {
+    uint8_t codec;
+    uint8_t padding;
+    // The uncompressed `block_size_t::ser_value()` of the block.
+    uint16_t ser_block_size;
+});
+
+/* Compresses the block in `buf`, which has size `block_size`.  Returns false if
+the codec is `none` or if compression wouldn't save at least one device block on
+disk.  Otherwise fills `*compressed_out` with a device block aligned, zero padded
+buffer and sets `*disk_block_size_out` to its size. */
+bool compress_block(block_codec_t codec,
+                    const ser_buffer_t *buf,
+                    block_size_t block_size,
+                    scoped_device_block_aligned_ptr_t<ser_buffer_t> *compressed_out,
+                    block_size_t *disk_block_size_out);
+
+/* Decompresses a block of on-disk size `disk_block_size` into `buf_out`, which
+must have room for `block_size` bytes.  Crashes if the block is corrupted. */
+void decompress_block(const ser_buffer_t *compressed,
+                      block_size_t disk_block_size,
+                      ser_buffer_t *buf_out,
+                      block_size_t block_size);
+
+/* Like `decompress_block`, but returns false instead of crashing if the block is
+corrupted. */
+bool try_decompress_block(const ser_buffer_t *compressed,
+                          block_size_t disk_block_size,
+                          ser_buffer_t *buf_out,
+                          block_size_t block_size);
+
+#endif  // SERIALIZER_LOG_BLOCK_CODEC_HPP_
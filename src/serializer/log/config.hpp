@@ -6,6 +6,7 @@
 
 #include "config/args.hpp"
 #include "containers/archive/archive.hpp"
+#include "serializer/log/block_codec.hpp"
 #include "serializer/types.hpp"
 #include "rpc/serialize_macros.hpp"
 
@@ -14,11 +15,34 @@
 struct log_serializer_dynamic_config_t {
     log_serializer_dynamic_config_t() {
         read_ahead = true;
+        block_codec = block_codec_t::none;
+        scrub_bytes_per_sec = 0;
+        age_aware_gc = true;
+        compact_lba_on_shutdown = false;
     }
 
     /* Enable reading more data than requested to let the cache warmup more quickly
        esp. on rotational drives */
     bool read_ahead;
+
+    /* Compress data blocks with this codec before writing them.  Blocks that were
+       written with a different codec (or none) can still be read. */
+    block_codec_t block_codec;
+
+    /* If positive, a background coroutine reads all live blocks at this rate and
+       verifies their checksums. */
+    int64_t scrub_bytes_per_sec;
+
+    /* If true, the GC picks the extent to collect by weighing the space it would
+       free against how long the extent has gone without being modified, and writes
+       the blocks it moves into a separate extent from new user writes.  Otherwise it
+       always picks the extent with the most garbage. */
+    bool age_aware_gc;
+
+    /* If true, a clean shutdown garbage collects the LBA shards that have much
+       garbage in them, which makes the next startup faster at the cost of a slower
+       shutdown. */
+    bool compact_lba_on_shutdown;
 };
 
 /* This is equivalent to log_serializer_static_config_t below, but is an on-disk
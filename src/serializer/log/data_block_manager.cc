@@ -13,6 +13,7 @@
 #include "errors.hpp"
 #include "perfmon/perfmon.hpp"
 #include "serializer/buf_ptr.hpp"
+#include "serializer/log/block_codec.hpp"
 #include "serializer/log/log_serializer.hpp"
 #include "stl_utils.hpp"
 
@@ -72,10 +73,12 @@ public:
         : parent(_parent),
           extent_ref(parent->extent_manager->gen_extent()),
           timestamp(get_kiloticks()),
+          write_clock_at_start(parent->user_write_clock),
           was_written(false),
           state(state_active),
           garbage_bytes_stat(_parent->static_config->extent_size()),
           num_live_blocks_stat(0),
+          gc_score_(0),
           extent_offset(extent_ref.offset()) {
         static_assert(sizeof(block_info_t) == 4, "block_info_t not 4 bytes");
         add_self_to_parent_entries();
@@ -87,10 +90,12 @@ public:
         : parent(_parent),
           extent_ref(parent->extent_manager->reserve_extent(_offset)),
           timestamp(get_kiloticks()),
+          write_clock_at_start(parent->user_write_clock),
           was_written(false),
           state(state_reconstructing),
           garbage_bytes_stat(_parent->static_config->extent_size()),
           num_live_blocks_stat(0),
+          gc_score_(0),
           extent_offset(extent_ref.offset()) {
         add_self_to_parent_entries();
     }
@@ -198,6 +203,30 @@ public:
         return garbage_bytes_stat;
     }
 
+    // The key `gc_entry_less_t` orders the GC priority queue by.  It only changes
+    // when `update_gc_score()` is called, which must happen before the entry is
+    // pushed onto the queue and before its queue entry is updated.
+    double gc_score() const {
+        return gc_score_;
+    }
+
+    void update_gc_score() {
+        if (!parent->age_aware_gc()) {
+            gc_score_ = garbage_bytes();
+            return;
+        }
+        // The cost-benefit policy from the log-structured file system literature:
+        // collecting an extent with utilization `u` frees `1 - u` of an extent and
+        // costs reading it and writing `u` of it back.  Weighting that by the
+        // extent's age prefers cold extents, whose remaining live blocks are
+        // unlikely to become garbage on their own soon, over hot extents that
+        // only need a little more time to empty out by themselves.
+        const double extent_size = parent->static_config->extent_size();
+        const double u = 1.0 - garbage_bytes() / extent_size;
+        const double age = parent->user_write_clock - write_clock_at_start + 1;
+        gc_score_ = (1.0 - u) * age / (1.0 + u);
+    }
+
     bool block_is_garbage(unsigned int _block_index) const {
         guarantee(state != state_reconstructing);
         guarantee(_block_index < block_infos.size());
@@ -359,6 +388,8 @@ public:
 
     // When we started writing to the extent (this time).
     const kiloticks_t timestamp;
+    // The parent's `user_write_clock` at that point.
+    const uint64_t write_clock_at_start;
 
     // The PQ entry pointing to us.
     priority_queue_t<gc_entry_t *, gc_entry_less_t>::entry_t *our_pq_entry;
@@ -370,7 +401,7 @@ public:
         // It has been, or is being, reconstructed from data on disk.
         state_reconstructing,
         // We are currently putting things on this extent. It is equal to
-        // last_data_extent.
+        // active_extent or gc_active_extent.
         state_active,
         // Not active, but not a GC candidate yet. It is in young_extent_queue.
         state_young,
@@ -388,6 +419,8 @@ private:
     uint32_t garbage_bytes_stat;
     unsigned int num_live_blocks_stat;
 
+    double gc_score_;
+
     // Only to be used by the destructor, used to look up the gc entry in the
     // parent's entries array.
     const int64_t extent_offset;
@@ -402,6 +435,7 @@ data_block_manager_t::data_block_manager_t(
     : stats(_stats), shutdown_callback(nullptr), state(state_unstarted),
       gc_enabled(true), static_config(_static_config), extent_manager(em),
       serializer(_serializer),
+      user_write_clock(0),
       gc_index_write_pumper(std::bind(
           &data_block_manager_t::flush_gc_index_writes, this, std::placeholders::_1)),
       /* The capacity of the gc_index_write_semaphore will be scaled
@@ -480,6 +514,10 @@ void data_block_manager_t::start_existing(
         active_extent = nullptr;
     }
 
+    /* The metablock doesn't record the extent that the GC was writing to, so it
+    gets treated like any other old extent below. */
+    gc_active_extent = nullptr;
+
     /* Convert any extents that we found live blocks in, but that are not active
     extents, into old extents */
     while (gc_entry_t *entry = reconstructed_extents.head()) {
@@ -489,6 +527,7 @@ void data_block_manager_t::start_existing(
         entry->state = gc_entry_t::state_old;
         entry->shrink_to_fit();
 
+        entry->update_gc_score();
         entry->our_pq_entry = gc_pq.push(entry);
 
         gc_stats.old_total_block_bytes += static_config->extent_size();
@@ -665,14 +704,23 @@ public:
 
                 const block_size_t block_size
                     = block_size_t::unsafe_make(info.ser_block_size);
+                const block_size_t disk_block_size
+                    = block_size_t::unsafe_make(info.get_disk_block_size());
+                guarantee(disk_block_size.ser_value() <= *(lower_it + 1) - *lower_it);
                 buf_ptr_t buf = buf_ptr_t::alloc_uninitialized(block_size);
-                memcpy(buf.ser_buffer(), current_buf, info.ser_block_size);
+                if (disk_block_size == block_size) {
+                    memcpy(buf.ser_buffer(), current_buf, info.ser_block_size);
+                } else {
+                    decompress_block(reinterpret_cast<const ser_buffer_t *>(current_buf),
+                                     disk_block_size, buf.ser_buffer(), block_size);
+                    ++stats->pm_serializer_blocks_decompressed;
+                }
                 buf.fill_padding_zero();
-                guarantee(info.ser_block_size <= *(lower_it + 1) - *lower_it);
 
                 counted_t<block_token_t> token
                     = parent->serializer->generate_block_token(current_offset,
-                                                               block_size);
+                                                               block_size,
+                                                               info.checksum);
 
                 parent->serializer->offer_buf_to_read_ahead_callbacks(
                         block_id,
@@ -699,6 +747,49 @@ bool data_block_manager_t::should_perform_read_ahead(int64_t offset) {
 buf_ptr_t data_block_manager_t::read(int64_t off_in, block_size_t block_size,
                                    file_account_t *io_account) {
     guarantee(state == state_ready);
+    const block_size_t on_disk_size = disk_block_size(off_in);
+    if (on_disk_size == block_size) {
+        return read_disk_block(off_in, block_size, io_account);
+    }
+
+    buf_ptr_t compressed = read_disk_block(off_in, on_disk_size, io_account);
+    buf_ptr_t ret = buf_ptr_t::alloc_uninitialized(block_size);
+    decompress_block(compressed.ser_buffer(), on_disk_size, ret.ser_buffer(), block_size);
+    ret.fill_padding_zero();
+    ++stats->pm_serializer_blocks_decompressed;
+    return ret;
+}
+
+bool data_block_manager_t::read_and_verify(int64_t off_in, block_size_t block_size,
+                                           uint32_t checksum,
+                                           file_account_t *io_account) {
+    guarantee(state == state_ready);
+    const block_size_t on_disk_size = disk_block_size(off_in);
+    buf_ptr_t disk_buf = read_disk_block(off_in, on_disk_size, io_account);
+    if (on_disk_size == block_size) {
+        return block_checksum_matches(checksum, disk_buf.ser_buffer(), block_size);
+    }
+
+    buf_ptr_t buf = buf_ptr_t::alloc_uninitialized(block_size);
+    if (!try_decompress_block(disk_buf.ser_buffer(), on_disk_size,
+                              buf.ser_buffer(), block_size)) {
+        return false;
+    }
+    return block_checksum_matches(checksum, buf.ser_buffer(), block_size);
+}
+
+block_size_t data_block_manager_t::disk_block_size(int64_t offset) const {
+    const gc_entry_t *entry = entries.get(static_config->extent_index(offset));
+    guarantee(entry != nullptr);
+    const unsigned int block_index = entry->block_index(offset);
+    guarantee(entry->relative_offset(block_index)
+              == offset - entry->extent_ref.offset());
+    return entry->block_size(block_index);
+}
+
+buf_ptr_t data_block_manager_t::read_disk_block(int64_t off_in,
+                                                block_size_t block_size,
+                                                file_account_t *io_account) {
     if (should_perform_read_ahead(off_in)) {
         buf_ptr_t ret = buf_ptr_t::alloc_uninitialized(block_size);
         dbm_read_ahead_t::perform_read_ahead(this, off_in, block_size.ser_value(),
@@ -740,15 +831,51 @@ std::vector<counted_t<block_token_t>>
 data_block_manager_t::many_writes(const std::vector<buf_write_info_t> &writes,
                                   file_account_t *io_account,
                                   iocallback_t *cb) {
-    // These tokens are grouped by extent.  You can do a contiguous write in each
-    // extent.
-    std::vector<std::vector<counted_t<block_token_t>>> token_groups
-        = gimme_some_new_offsets(writes);
+    const block_codec_t codec = serializer->dynamic_config.block_codec;
 
+    std::vector<disk_write_t> disk_writes;
+    disk_writes.reserve(writes.size());
+    std::vector<scoped_device_block_aligned_ptr_t<ser_buffer_t>> compressed_bufs;
     for (auto it = writes.begin(); it != writes.end(); ++it) {
+        // This must happen before checksumming and compression, which both cover
+        // the header.
         it->buf->ser_header.block_id = it->block_id;
+        const uint32_t checksum = compute_block_checksum(it->buf, it->block_size);
+
+        scoped_device_block_aligned_ptr_t<ser_buffer_t> compressed;
+        block_size_t compressed_size = block_size_t::undefined();
+        if (compress_block(codec, it->buf, it->block_size,
+                           &compressed, &compressed_size)) {
+            ++stats->pm_serializer_blocks_compressed;
+            stats->pm_serializer_compression_saved_bytes
+                += gc_entry_t::aligned_value(it->block_size)
+                - gc_entry_t::aligned_value(compressed_size);
+            disk_writes.push_back(
+                disk_write_t{compressed.get(), it->block_size, compressed_size,
+                             checksum});
+            compressed_bufs.push_back(std::move(compressed));
+        } else {
+            disk_writes.push_back(
+                disk_write_t{it->buf, it->block_size, it->block_size, checksum});
+        }
     }
 
+    return write_disk_blocks(disk_writes, std::move(compressed_bufs),
+                             write_origin_t::user, io_account, cb);
+}
+
+std::vector<counted_t<block_token_t>>
+data_block_manager_t::write_disk_blocks(
+        const std::vector<disk_write_t> &writes,
+        std::vector<scoped_device_block_aligned_ptr_t<ser_buffer_t>> &&owned_bufs,
+        write_origin_t origin,
+        file_account_t *io_account,
+        iocallback_t *cb) {
+    // These tokens are grouped by extent.  You can do a contiguous write in each
+    // extent.
+    std::vector<std::vector<counted_t<block_token_t>>> token_groups
+        = gimme_some_new_offsets(writes, origin);
+
     struct intermediate_cb_t : public iocallback_t {
         virtual void on_io_complete() {
             --ops_remaining;
@@ -761,6 +888,8 @@ data_block_manager_t::many_writes(const std::vector<buf_write_info_t> &writes,
 
         size_t ops_remaining;
         iocallback_t *cb;
+        // Buffers that need to stay alive until the writes are complete.
+        std::vector<scoped_device_block_aligned_ptr_t<ser_buffer_t>> owned_bufs;
     };
 
     intermediate_cb_t *const intermediate_cb = new intermediate_cb_t;
@@ -768,13 +897,15 @@ data_block_manager_t::many_writes(const std::vector<buf_write_info_t> &writes,
     // intermediate_cb->on_io_complete later.
     intermediate_cb->ops_remaining = token_groups.size() + 1;
     intermediate_cb->cb = cb;
+    intermediate_cb->owned_bufs = std::move(owned_bufs);
 
     size_t write_number = 0;
     for (size_t i = 0; i < token_groups.size(); ++i) {
 
         const int64_t front_offset = token_groups[i].front()->offset();
+        const size_t back_write_number = write_number + token_groups[i].size() - 1;
         const int64_t back_offset = token_groups[i].back()->offset()
-            + gc_entry_t::aligned_value(token_groups[i].back()->block_size());
+            + gc_entry_t::aligned_value(writes[back_write_number].disk_block_size);
 
         guarantee(divides(DEVICE_BLOCK_SIZE, front_offset));
 
@@ -789,7 +920,8 @@ data_block_manager_t::many_writes(const std::vector<buf_write_info_t> &writes,
             const int64_t j_offset = token_groups[i][j]->offset();
             const block_size_t j_block_size = token_groups[i][j]->block_size();
             guarantee(j_offset == last_written_offset);
-            const size_t j_aligned_size = gc_entry_t::aligned_value(j_block_size);
+            const size_t j_aligned_size
+                = gc_entry_t::aligned_value(writes[write_number].disk_block_size);
             total_aligned_size += j_aligned_size;
 
             // The behavior of gimme_some_new_offsets is supposed to retain order, so
@@ -809,6 +941,11 @@ data_block_manager_t::many_writes(const std::vector<buf_write_info_t> &writes,
                              std::move(iovecs), io_account, intermediate_cb);
 
         stats->bytes_written(total_aligned_size);
+        if (origin == write_origin_t::gc) {
+            stats->pm_serializer_gc_written_bytes += total_aligned_size;
+        } else {
+            stats->pm_serializer_user_written_bytes += total_aligned_size;
+        }
     }
 
     // Call on_io_complete for degenerate case (we added 1 to ops_remaining
@@ -885,6 +1022,7 @@ void data_block_manager_t::check_and_handle_empty_extent(uint64_t extent_id) {
         destroy_entry(entry);
 
     } else if (entry->state == gc_entry_t::state_old) {
+        entry->update_gc_score();
         entry->our_pq_entry->update();
     }
 }
@@ -1001,6 +1139,14 @@ void data_block_manager_t::start_gc() {
         return;
     }
 
+    if (active_gcs.empty() && age_aware_gc()) {
+        // An entry's score only gets updated when its garbage changes, but the
+        // scores of all the extents that haven't been touched have kept growing
+        // with their age since then.  Catch up on that before picking extents
+        // again, so that cold extents get their turn.
+        gc_pq.update_all([](gc_entry_t *entry) { entry->update_gc_score(); });
+    }
+
     const size_t goal_num_active_gcs = compute_gc_concurrency();
     while (active_gcs.size() < goal_num_active_gcs) {
         gc_state_t *new_gc_state = new gc_state_t();
@@ -1189,8 +1335,15 @@ void data_block_manager_t::gc_one_extent(gc_state_t *gc_state) {
                     gc_state->current_entry->extent_ref.offset()
                     + gc_state->current_entry->relative_offset(i);
 
-                gc_writes.push_back(gc_write_t(block, block_offset,
-                    gc_state->current_entry->block_size(i)));
+                // We move compressed blocks without decompressing them, but we
+                // still need to know their real size and their checksum for the
+                // new block tokens.
+                block_size_t block_size = block_size_t::undefined();
+                uint32_t checksum;
+                serializer->live_block_info(block->ser_header.block_id, block_offset,
+                                            &block_size, &checksum);
+                gc_writes.push_back(gc_write_t(block, block_offset, block_size,
+                    gc_state->current_entry->block_size(i), checksum));
             }
             guarantee(gc_writes.size() == num_writes);
         }
@@ -1247,20 +1400,27 @@ void data_block_manager_t::write_gcs(
         // Step 1: Write buffers to disk and assemble index operations
         ASSERT_NO_CORO_WAITING;
 
-        std::vector<buf_write_info_t> the_writes;
+        std::vector<disk_write_t> the_writes;
         the_writes.reserve(writes.size());
         for (size_t i = 0; i < writes.size(); ++i) {
             old_block_tokens.push_back(
                     serializer->generate_block_token(writes[i].old_offset,
-                                                     writes[i].block_size));
+                                                     writes[i].block_size,
+                                                     writes[i].checksum));
 
-            the_writes.push_back(buf_write_info_t(writes[i].buf,
-                                                  writes[i].block_size,
-                                                  writes[i].buf->ser_header.block_id));
+            the_writes.push_back(disk_write_t{writes[i].buf,
+                                              writes[i].block_size,
+                                              writes[i].disk_block_size,
+                                              writes[i].checksum});
         }
 
-        new_block_tokens = many_writes(the_writes, choose_gc_io_account(),
-                                       &block_write_cond);
+        // `gc_blocks` outlives the writes, so there are no buffers to hand over.
+        new_block_tokens = write_disk_blocks(
+            the_writes,
+            std::vector<scoped_device_block_aligned_ptr_t<ser_buffer_t>>(),
+            write_origin_t::gc,
+            choose_gc_io_account(),
+            &block_write_cond);
 
         guarantee(new_block_tokens.size() == writes.size());
     }
@@ -1412,6 +1572,12 @@ void data_block_manager_t::actually_shutdown() {
         active_extent = nullptr;
     }
 
+    if (gc_active_extent != nullptr) {
+        UNUSED int64_t extent = gc_active_extent->extent_ref.release();
+        delete gc_active_extent;
+        gc_active_extent = nullptr;
+    }
+
     while (gc_entry_t *entry = young_extent_queue.head()) {
         young_extent_queue.remove(entry);
         UNUSED int64_t extent = entry->extent_ref.release();
@@ -1430,17 +1596,30 @@ void data_block_manager_t::actually_shutdown() {
 }
 
 std::vector<std::vector<counted_t<block_token_t>>>
-data_block_manager_t::gimme_some_new_offsets(const std::vector<buf_write_info_t> &writes) {
+data_block_manager_t::gimme_some_new_offsets(const std::vector<disk_write_t> &writes,
+                                             write_origin_t origin) {
     ASSERT_NO_CORO_WAITING;
 
+    // Blocks that the GC moves have survived at least one extent's lifetime, so
+    // they tend to be colder than freshly written ones.  Keeping them in their own
+    // extent stops them from getting mixed up with hot blocks, which would make
+    // both kinds of extent more expensive to collect later on.
+    gc_entry_t *&extent = (origin == write_origin_t::gc && age_aware_gc())
+        ? gc_active_extent
+        : active_extent;
+
+    if (origin == write_origin_t::user) {
+        user_write_clock += writes.size();
+    }
+
     // Start a new extent if necessary.
-    if (active_extent == nullptr) {
-        active_extent = new gc_entry_t(this);
+    if (extent == nullptr) {
+        extent = new gc_entry_t(this);
         ++stats->pm_serializer_data_extents_allocated;
     }
 
 
-    guarantee(active_extent->state == gc_entry_t::state_active);
+    guarantee(extent->state == gc_entry_t::state_active);
 
     std::vector<std::vector<counted_t<block_token_t>>> ret;
 
@@ -1448,26 +1627,26 @@ data_block_manager_t::gimme_some_new_offsets(const std::vector<buf_write_info_t>
     for (auto it = writes.begin(); it != writes.end(); ++it) {
         uint32_t relative_offset = valgrind_undefined<uint32_t>(UINT32_MAX);
         unsigned int block_index = valgrind_undefined<unsigned int>(UINT_MAX);
-        if (!active_extent->new_offset(it->block_size,
-                                       &relative_offset, &block_index)) {
-            // Move the active_extent gc_entry_t to the young extent queue (if it's
-            // not already empty), and make a new gc_entry_t.
-            if (active_extent->num_live_blocks() == 0) {
-                gc_entry_t *old_active_extent = active_extent;
-                active_extent = new gc_entry_t(this);
-                destroy_entry(old_active_extent);
+        if (!extent->new_offset(it->disk_block_size,
+                                &relative_offset, &block_index)) {
+            // Move the active extent's gc_entry_t to the young extent queue (if
+            // it's not already empty), and make a new gc_entry_t.
+            if (extent->num_live_blocks() == 0) {
+                gc_entry_t *old_extent = extent;
+                extent = new gc_entry_t(this);
+                destroy_entry(old_extent);
             } else {
-                active_extent->state = gc_entry_t::state_young;
-                active_extent->shrink_to_fit();
-                young_extent_queue.push_back(active_extent);
+                extent->state = gc_entry_t::state_young;
+                extent->shrink_to_fit();
+                young_extent_queue.push_back(extent);
                 mark_unyoung_entries();
-                active_extent = new gc_entry_t(this);
+                extent = new gc_entry_t(this);
             }
 
             ++stats->pm_serializer_data_extents_allocated;
-            const bool succeeded = active_extent->new_offset(it->block_size,
-                                                             &relative_offset,
-                                                             &block_index);
+            const bool succeeded = extent->new_offset(it->disk_block_size,
+                                                      &relative_offset,
+                                                      &block_index);
             guarantee(succeeded);
 
             // Push the current group of tokens, if it's nonempty, onto the return
@@ -1478,11 +1657,12 @@ data_block_manager_t::gimme_some_new_offsets(const std::vector<buf_write_info_t>
             }
         }
 
-        const int64_t offset = active_extent->extent_ref.offset() + relative_offset;
-        active_extent->was_written = true;
-        active_extent->mark_live_tokenwise(block_index);
+        const int64_t offset = extent->extent_ref.offset() + relative_offset;
+        extent->was_written = true;
+        extent->mark_live_tokenwise(block_index);
 
-        tokens.push_back(serializer->generate_block_token(offset, it->block_size));
+        tokens.push_back(serializer->generate_block_token(offset, it->block_size,
+                                                          it->checksum));
     }
 
     if (!tokens.empty()) {
@@ -1522,6 +1702,7 @@ void data_block_manager_t::remove_last_unyoung_entry() {
     guarantee(entry->state == gc_entry_t::state_young);
     entry->state = gc_entry_t::state_old;
 
+    entry->update_gc_score();
     entry->our_pq_entry = gc_pq.push(entry);
 
     gc_stats.old_total_block_bytes += static_config->extent_size();
@@ -1549,8 +1730,12 @@ bool data_block_manager_t::do_we_want_to_start_gcing() const {
     return gc_enabled && garbage_ratio() > GC_START_RATIO;
 }
 
+bool data_block_manager_t::age_aware_gc() const {
+    return serializer->dynamic_config.age_aware_gc;
+}
+
 bool gc_entry_less_t::operator()(const gc_entry_t *x, const gc_entry_t *y) {
-    return x->garbage_bytes() < y->garbage_bytes();
+    return x->gc_score() < y->gc_score();
 }
 
 /****************
@@ -48,9 +48,15 @@ public:
     static void prepare_initial_metablock(dbm_metablock_mixin_t *mb);
     void start_existing(file_t *dbfile, const dbm_metablock_mixin_t *last_metablock);
 
+    /* Reads the block at `off_in`, decompressing it if necessary.  `block_size` is
+    the block's uncompressed size. */
     buf_ptr_t read(int64_t off_in, block_size_t block_size,
                    file_account_t *io_account);
 
+    /* Returns the space that the live block at `offset` takes up in its extent.  This
+    is smaller than the block's `block_size_t` if the block is compressed. */
+    block_size_t disk_block_size(int64_t offset) const;
+
     /* exposed gc api */
     /* mark a buffer as garbage */
     void mark_garbage(int64_t offset, extent_transaction_t *txn);  // Takes a real int64_t.
@@ -82,17 +88,54 @@ public:
     // ratio of garbage to blocks in the system
     double garbage_ratio() const;
 
+    /* Compresses the blocks according to the serializer's `block_codec` and
+    writes them to disk. */
     std::vector<counted_t<block_token_t>>
     many_writes(const std::vector<buf_write_info_t> &writes,
                 file_account_t *io_account,
                 iocallback_t *cb);
 
-    std::vector<std::vector<counted_t<block_token_t>>>
-    gimme_some_new_offsets(const std::vector<buf_write_info_t> &writes);
-
     bool is_gc_active() const;
 
+    /* Reads the block at `off_in` and returns whether it matches `checksum`.  Unlike
+    `read()`, this doesn't crash if the block turns out to be corrupted.  Used by the
+    scrubber. */
+    bool read_and_verify(int64_t off_in, block_size_t block_size, uint32_t checksum,
+                         file_account_t *io_account);
+
 private:
+    /* A block, in the form it will be written to disk.  If `disk_block_size` differs
+    from `block_size`, `buf` holds the compressed block.  `checksum` is always the
+    checksum of the uncompressed block. */
+    struct disk_write_t {
+        ser_buffer_t *buf;
+        block_size_t block_size;
+        block_size_t disk_block_size;
+        uint32_t checksum;
+    };
+
+    /* Whether a write comes from the user (through `many_writes()`) or from the GC
+    moving live blocks out of an extent it's collecting. */
+    enum class write_origin_t { user, gc };
+
+    /* Writes blocks that have already been encoded.  `owned_bufs` are kept alive until
+    the writes are complete. */
+    std::vector<counted_t<block_token_t>>
+    write_disk_blocks(const std::vector<disk_write_t> &writes,
+                      std::vector<scoped_device_block_aligned_ptr_t<ser_buffer_t>>
+                          &&owned_bufs,
+                      write_origin_t origin,
+                      file_account_t *io_account,
+                      iocallback_t *cb);
+
+    std::vector<std::vector<counted_t<block_token_t>>>
+    gimme_some_new_offsets(const std::vector<disk_write_t> &writes,
+                           write_origin_t origin);
+
+    // Reads the `disk_block_size` bytes at `off_in`, without decoding them.
+    buf_ptr_t read_disk_block(int64_t off_in, block_size_t disk_block_size,
+                              file_account_t *io_account);
+
     void actually_shutdown();
 
     struct gc_state_t : public intrusive_list_node_t<gc_state_t>{
@@ -108,13 +151,18 @@ private:
     };
 
     struct gc_write_t {
+        // The block as it is on disk, i.e. possibly compressed.
         ser_buffer_t *buf;
         int64_t old_offset;
         block_size_t block_size;
+        block_size_t disk_block_size;
+        uint32_t checksum;
         gc_write_t(ser_buffer_t *b, int64_t _old_offset,
-                   block_size_t _block_size)
+                   block_size_t _block_size, block_size_t _disk_block_size,
+                   uint32_t _checksum)
             : buf(b), old_offset(_old_offset),
-              block_size(_block_size) { }
+              block_size(_block_size), disk_block_size(_disk_block_size),
+              checksum(_checksum) { }
     };
 
     /* Runs in a coroutine and keeps calling `gc_one_extent()` for as long as
@@ -158,6 +206,10 @@ private:
 
     void destroy_entry(gc_entry_t *entry);
 
+    // Whether the GC uses cost-benefit extent selection and writes the blocks it
+    // moves to `gc_active_extent`.  See `log_serializer_dynamic_config_t`.
+    bool age_aware_gc() const;
+
     bool should_perform_read_ahead(int64_t offset);
 
     log_serializer_stats_t *const stats;
@@ -192,8 +244,17 @@ private:
     /* Contains every extent in the gc_entry_t::state_reconstructing state */
     intrusive_list_t<gc_entry_t> reconstructed_extents;
 
-    /* Contains the extent in the gc_entry_t::state_active state. */
+    /* The extents in the gc_entry_t::state_active state.  New user writes go to
+    `active_extent`.  If `age_aware_gc()` is true, blocks that the GC moves go to
+    `gc_active_extent` instead. */
     gc_entry_t *active_extent;
+    gc_entry_t *gc_active_extent;
+
+    /* The number of blocks that users have written since we started.  The
+    cost-benefit GC measures the age of extents with this clock rather than with
+    wall-clock time, so that its choices only depend on the sequence of writes.  It
+    starts from zero, so extents from before a restart all count as equally old. */
+    uint64_t user_write_clock;
 
     /* Contains every extent in the gc_entry_t::state_young state */
     intrusive_list_t<gc_entry_t> young_extent_queue;
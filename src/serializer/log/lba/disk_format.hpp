@@ -3,6 +3,7 @@
 #define SERIALIZER_LOG_LBA_DISK_FORMAT_HPP_
 
 #include <limits.h>
+#include <stddef.h>
 
 #include "serializer/serializer.hpp"
 
@@ -60,13 +61,17 @@ ATTR_PACKED(struct lba_entry_t {
     // (It probably assumes that sizeof(lba_entry_t) evenly divides
     // DEVICE_BLOCK_SIZE).
 
-    // Put the zero-padding at the beginning of the LBA entry.  We could use this, or
-    // the first 16 bits, perhaps, as a version flag.
-    uint32_t zero_reserved;
+    // The checksum of the block, see compute_block_checksum.  Older versions wrote
+    // zero here, which is NO_BLOCK_CHECKSUM.
+    uint32_t block_checksum;
 
-    // This could be a uint16_t if you wanted it to be, as long as block sizes are
-    // all less than or equal to 4K (which is less than 64K).
-    uint32_t ser_block_size;
+    // Older versions stored ser_block_size as a uint32_t, whose upper half was
+    // always zero.  (This is little-endian, so the lower half comes first.)
+    uint16_t ser_block_size;
+
+    // The size the block takes up on disk, if it's stored compressed.  Zero means
+    // the block is stored uncompressed, i.e. with size ser_block_size.
+    uint16_t disk_block_size;
 
     block_id_t block_id;
 
@@ -76,11 +81,13 @@ ATTR_PACKED(struct lba_entry_t {
     flagged_off64_t offset;
 
     static lba_entry_t make(block_id_t block_id, repli_timestamp_t recency,
-                            flagged_off64_t offset, uint16_t ser_block_size) {
+                            flagged_off64_t offset, uint16_t ser_block_size,
+                            uint16_t disk_block_size, uint32_t block_checksum) {
         guarantee(ser_block_size != 0 || !offset.has_value());
         lba_entry_t entry;
-        entry.zero_reserved = 0;
+        entry.block_checksum = block_checksum;
         entry.ser_block_size = ser_block_size;
+        entry.disk_block_size = disk_block_size;
         entry.block_id = block_id;
         entry.recency = recency;
         entry.offset = offset;
@@ -93,10 +100,22 @@ ATTR_PACKED(struct lba_entry_t {
 
     static lba_entry_t make_padding_entry() {
         return make(PADDING_BLOCK_ID, repli_timestamp_t::invalid,
-                    flagged_off64_t::padding(), 0);
+                    flagged_off64_t::padding(), 0, 0,
+                    NO_BLOCK_CHECKSUM);
     }
 });
 
+// The on-disk layout of an LBA entry.  The sizes share the eight bytes in front of
+// `block_id` that older versions used for a zero `uint32_t` and `ser_block_size`.
+static_assert(offsetof(lba_entry_t, block_checksum) == 0,
+              "lba_entry_t layout changed");
+static_assert(offsetof(lba_entry_t, ser_block_size) == 4,
+              "lba_entry_t layout changed");
+static_assert(offsetof(lba_entry_t, disk_block_size) == 6,
+              "lba_entry_t layout changed");
+static_assert(offsetof(lba_entry_t, block_id) == 8, "lba_entry_t layout changed");
+static_assert(sizeof(lba_entry_t) == 32, "lba_entry_t is not 32 bytes");
+
 
 ATTR_PACKED(struct lba_shard_metablock_t {
     /* Reference to the last lba extent (that's currently being
@@ -2,7 +2,9 @@
 #include "serializer/log/lba/disk_structure.hpp"
 
 #include <algorithm>
+#include <functional>
 
+#include "arch/runtime/coroutines.hpp"
 #include "containers/scoped.hpp"
 #include "math.hpp"
 
@@ -70,6 +72,7 @@ void lba_disk_structure_t::on_extent_read() {
 
 void lba_disk_structure_t::add_entry(block_id_t block_id, repli_timestamp_t recency,
                                      flagged_off64_t offset, uint16_t ser_block_size,
+                                     uint16_t disk_block_size, uint32_t checksum,
                                      file_account_t *io_account,
                                      extent_transaction_t *txn) {
     if (last_extent && last_extent->full()) {
@@ -90,7 +93,9 @@ void lba_disk_structure_t::add_entry(block_id_t block_id, repli_timestamp_t rece
 
     rassert(!last_extent->full());
 
-    last_extent->add_entry(lba_entry_t::make(block_id, recency, offset, ser_block_size), io_account);
+    last_extent->add_entry(lba_entry_t::make(block_id, recency, offset, ser_block_size,
+                                             disk_block_size, checksum),
+                          io_account);
 }
 
 std::set<lba_disk_extent_t *> lba_disk_structure_t::get_inactive_extents() const {
@@ -213,6 +218,7 @@ struct reader_t
 {
     lba_disk_structure_t *ds;   // The disk structure we are reading from
     in_memory_index_t *index;   // The in-memory-index we are reading into
+    threadnum_t apply_thread;   // The thread on which we fill in `index`
     lba_disk_structure_t::read_callback_t *rcb;   // Who to call back when we finish
 
     /* extent_reader_t takes care of reading a single extent. */
@@ -259,7 +265,15 @@ struct reader_t
             if (have_read) done();
         }
         void done() {
-            extent->read_step_2(&read_info, parent->index);
+            // Putting the entries into the index is what keeps a CPU busy while
+            // loading a large LBA, so we do it on the shard's own thread.
+            coro_t::spawn_sometime(std::bind(&extent_reader_t::apply, this));
+        }
+        void apply() {
+            {
+                on_thread_t thread_switcher(parent->apply_thread);
+                extent->read_step_2(&read_info, parent->index);
+            }
             parent->active_readers--;
             parent->start_more_readers();
             if (index == static_cast<int>(parent->readers.size()) - 1) {
@@ -279,8 +293,9 @@ struct reader_t
     // throttle the reading process so that we stay under LBA_READ_BUFFER_SIZE.
     int active_readers;
 
-    reader_t(lba_disk_structure_t *_ds, in_memory_index_t *_index, lba_disk_structure_t::read_callback_t *cb)
-        : ds(_ds), index(_index), rcb(cb)
+    reader_t(lba_disk_structure_t *_ds, in_memory_index_t *_index,
+             threadnum_t _apply_thread, lba_disk_structure_t::read_callback_t *cb)
+        : ds(_ds), index(_index), apply_thread(_apply_thread), rcb(cb)
     {
         for (lba_disk_extent_t *e = ds->extents_in_superblock.head();
              e != nullptr; e = ds->extents_in_superblock.next(e)) {
@@ -315,8 +330,9 @@ struct reader_t
     }
 };
 
-void lba_disk_structure_t::read(in_memory_index_t *index, read_callback_t *cb) {
-    new reader_t(this, index, cb);
+void lba_disk_structure_t::read(in_memory_index_t *index, threadnum_t apply_thread,
+                                read_callback_t *cb) {
+    new reader_t(this, index, apply_thread, cb);
 }
 
 void lba_disk_structure_t::prepare_metablock(lba_shard_metablock_t *mb_out) {
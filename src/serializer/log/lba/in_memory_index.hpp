@@ -12,25 +12,42 @@ ATTR_PACKED(struct index_block_info_t {
     index_block_info_t()
         : offset(flagged_off64_t::unused()),
           recency(repli_timestamp_t::invalid),
-          ser_block_size(0) { }
+          ser_block_size(0),
+          disk_block_size(0),
+          checksum(NO_BLOCK_CHECKSUM) { }
 
     index_block_info_t(flagged_off64_t _offset,
                        repli_timestamp_t _recency,
-                       uint16_t _ser_block_size)
+                       uint16_t _ser_block_size,
+                       uint16_t _disk_block_size,
+                       uint32_t _checksum)
         : offset(_offset),
           recency(_recency),
-          ser_block_size(_ser_block_size) { }
+          ser_block_size(_ser_block_size),
+          disk_block_size(_disk_block_size),
+          checksum(_checksum) { }
 
     // For two_level_array_t.
     bool operator==(const index_block_info_t &other) const {
         return offset == other.offset &&
             recency == other.recency &&
-            ser_block_size == other.ser_block_size;
+            ser_block_size == other.ser_block_size &&
+            disk_block_size == other.disk_block_size &&
+            checksum == other.checksum;
+    }
+
+    // The size that the block occupies on disk, which is smaller than
+    // ser_block_size if the block is compressed.
+    uint16_t get_disk_block_size() const {
+        return disk_block_size == 0 ? ser_block_size : disk_block_size;
     }
 
     flagged_off64_t offset;
     repli_timestamp_t recency;
     uint16_t ser_block_size;
+    // Zero if the block is stored uncompressed, see lba_entry_t.
+    uint16_t disk_block_size;
+    uint32_t checksum;
 });
 
 /* This is a reduced-size block info for auxiliary blocks (currently
@@ -39,30 +56,52 @@ timestamp, because we don't need it for those blocks. */
 ATTR_PACKED(struct index_aux_block_info_t {
     index_aux_block_info_t()
         : offset(flagged_off64_t::unused()),
-          ser_block_size(0) { }
+          ser_block_size(0),
+          disk_block_size(0),
+          checksum(NO_BLOCK_CHECKSUM) { }
 
     index_aux_block_info_t(flagged_off64_t _offset,
-                           uint16_t _ser_block_size)
+                           uint16_t _ser_block_size,
+                           uint16_t _disk_block_size,
+                           uint32_t _checksum)
         : offset(_offset),
-          ser_block_size(_ser_block_size) { }
+          ser_block_size(_ser_block_size),
+          disk_block_size(_disk_block_size),
+          checksum(_checksum) { }
 
     // For two_level_array_t.
     bool operator==(const index_aux_block_info_t &other) const {
         return offset == other.offset &&
-            ser_block_size == other.ser_block_size;
+            ser_block_size == other.ser_block_size &&
+            disk_block_size == other.disk_block_size &&
+            checksum == other.checksum;
     }
 
     flagged_off64_t offset;
     uint16_t ser_block_size;
+    uint16_t disk_block_size;
+    uint32_t checksum;
 });
 
 
 
+/* The in-memory copy of the LBA.  It is split into one part per LBA shard (block
+ids are assigned to shards by `block_id % LBA_SHARD_FACTOR`), so that the shards can
+be loaded from disk on different threads at the same time: calls to
+`set_block_info()` for block ids in different shards don't touch any common state.
+Anything else must happen on one thread at a time. */
 class in_memory_index_t {
-    two_level_array_t<index_block_info_t> infos_;
-    block_id_t end_block_id_;
-    two_level_array_t<index_aux_block_info_t> aux_infos_;
-    block_id_t end_aux_block_id_;
+    struct shard_t {
+        shard_t() : end_block_id(0), end_aux_block_id(FIRST_AUX_BLOCK_ID) { }
+
+        // Both arrays are indexed by the (aux-relative) block id divided by
+        // LBA_SHARD_FACTOR.
+        two_level_array_t<index_block_info_t> infos;
+        block_id_t end_block_id;
+        two_level_array_t<index_aux_block_info_t> aux_infos;
+        block_id_t end_aux_block_id;
+    };
+    shard_t shards_[LBA_SHARD_FACTOR];
 
 public:
     in_memory_index_t();
@@ -73,7 +112,8 @@ public:
 
     index_block_info_t get_block_info(block_id_t id);
     void set_block_info(block_id_t id, repli_timestamp_t recency,
-                        flagged_off64_t offset, uint16_t ser_block_size);
+                        flagged_off64_t offset, uint16_t ser_block_size,
+                        uint16_t disk_block_size, uint32_t checksum);
 
 };
 
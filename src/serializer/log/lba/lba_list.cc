@@ -86,8 +86,13 @@ public:
         cbs_out--;
         if (cbs_out == 0) {
             cbs_out = LBA_SHARD_FACTOR;
+            // Each shard fills in its part of the index on a different thread (if
+            // there are enough), starting with the one after ours.
             for (int i = 0; i < LBA_SHARD_FACTOR; i++) {
-                owner->disk_structures[i]->read(&owner->in_memory_index, this);
+                threadnum_t apply_thread(
+                    (get_thread_id().threadnum + 1 + i) % get_num_threads());
+                owner->disk_structures[i]->read(&owner->in_memory_index, apply_thread,
+                                                this);
             }
         }
     }
@@ -101,15 +106,14 @@ public:
             // the metablock into the index:
             for (int32_t i = 0; i < owner->inline_lba_entries_count; ++i) {
                 lba_entry_t *e = &owner->inline_lba_entries[i];
-                // The on-disk format still stores 32 bit block sizes.
-                // We've never actually used them, and we now use 16 bit block sizes
-                // for the in-memory index to save a few bytes.
-                guarantee(e->ser_block_size <= std::numeric_limits<uint16_t>::max());
+                guarantee(e->disk_block_size <= e->ser_block_size);
                 owner->in_memory_index.set_block_info(
                         e->block_id,
                         e->recency,
                         e->offset,
-                        static_cast<uint16_t>(e->ser_block_size));
+                        e->ser_block_size,
+                        e->disk_block_size,
+                        e->block_checksum);
             }
 
             owner->state = lba_list_t::state_ready;
@@ -164,6 +168,10 @@ block_size_t lba_list_t::get_block_size(block_id_t block) {
     return block_size_t::unsafe_make(get_block_info(block).ser_block_size);
 }
 
+block_size_t lba_list_t::get_disk_block_size(block_id_t block) {
+    return block_size_t::unsafe_make(get_block_info(block).get_disk_block_size());
+}
+
 repli_timestamp_t lba_list_t::get_block_recency(block_id_t block) {
     return get_block_info(block).recency;
 }
@@ -192,10 +200,12 @@ segmented_vector_t<repli_timestamp_t> lba_list_t::get_block_recencies(block_id_t
 
 void lba_list_t::set_block_info(block_id_t block, repli_timestamp_t recency,
                                 flagged_off64_t offset, uint16_t ser_block_size,
+                                uint16_t disk_block_size, uint32_t checksum,
                                 file_account_t *io_account, extent_transaction_t *txn) {
     rassert(state == state_ready || state == state_gc_shutting_down);
 
-    in_memory_index.set_block_info(block, recency, offset, ser_block_size);
+    in_memory_index.set_block_info(block, recency, offset, ser_block_size,
+                                   disk_block_size, checksum);
 
     // If the inline LBA is full, free it up first by moving its entries to
     // the LBA extents
@@ -204,7 +214,8 @@ void lba_list_t::set_block_info(block_id_t block, repli_timestamp_t recency,
         rassert(!check_inline_lba_full());
     }
     // Then store the entry inline
-    add_inline_entry(block, recency, offset, ser_block_size);
+    add_inline_entry(block, recency, offset, ser_block_size, disk_block_size,
+                     checksum);
 }
 
 bool lba_list_t::check_inline_lba_full() const {
@@ -242,6 +253,8 @@ void lba_list_t::move_inline_entries_to_extents(file_account_t *io_account, exte
                 e.recency,
                 e.offset,
                 e.ser_block_size,
+                e.disk_block_size,
+                e.block_checksum,
                 io_account,
                 txn);
     }
@@ -250,11 +263,13 @@ void lba_list_t::move_inline_entries_to_extents(file_account_t *io_account, exte
 }
 
 void lba_list_t::add_inline_entry(block_id_t block, repli_timestamp_t recency,
-                                flagged_off64_t offset, uint16_t ser_block_size) {
+                                flagged_off64_t offset, uint16_t ser_block_size,
+                                uint16_t disk_block_size, uint32_t checksum) {
 
     rassert(!check_inline_lba_full());
     inline_lba_entries[inline_lba_entries_count++] =
-            lba_entry_t::make(block, recency, offset, ser_block_size);
+            lba_entry_t::make(block, recency, offset, ser_block_size, disk_block_size,
+                              checksum);
 }
 
 class lba_writer_t :
@@ -348,13 +363,14 @@ void lba_list_t::gc(int lba_shard, auto_drainer_t::lock_t) {
             break;
         }
 
-        flagged_off64_t off = get_block_offset(id);
-        if (off.has_value()) {
-            uint16_t ser_block_size = get_ser_block_size(id);
+        const index_block_info_t info = get_block_info(id);
+        if (info.offset.has_value()) {
             disk_structures[lba_shard]->add_entry(id,
-                                                  get_block_recency(id),
-                                                  off,
-                                                  ser_block_size,
+                                                  info.recency,
+                                                  info.offset,
+                                                  info.ser_block_size,
+                                                  info.disk_block_size,
+                                                  info.checksum,
                                                   gc_io_account.get(),
                                                   txns.back().get());
         }
@@ -460,11 +476,7 @@ bool lba_list_t::we_want_to_gc(int i) {
     // How much space are we using on disk? How much of that space is absolutely
     // necessary?  If we are not using more than N times the amount of space that we
     // need, don't GC
-    int entries_per_extent = disk_structures[i]->num_entries_that_can_fit_in_an_extent();
-    int64_t entries_total = disk_structures[i]->extents_in_superblock.size() * entries_per_extent;
-    int64_t entries_live = end_block_id() / LBA_SHARD_FACTOR
-                            + make_aux_block_id_relative(end_aux_block_id()) / LBA_SHARD_FACTOR;
-    if ((entries_live / static_cast<double>(entries_total)) > LBA_MIN_UNGARBAGE_FRACTION) {  // TODO: multiply both sides by common denominator
+    if (ungarbage_fraction(i) > LBA_MIN_UNGARBAGE_FRACTION) {
         return false;
     }
 
@@ -472,10 +484,31 @@ bool lba_list_t::we_want_to_gc(int i) {
     return true;
 }
 
-void lba_list_t::shutdown_gc() {
+double lba_list_t::ungarbage_fraction(int i) {
+    int entries_per_extent = disk_structures[i]->num_entries_that_can_fit_in_an_extent();
+    int64_t entries_total = disk_structures[i]->extents_in_superblock.size() * entries_per_extent;
+    int64_t entries_live = end_block_id() / LBA_SHARD_FACTOR
+                            + make_aux_block_id_relative(end_aux_block_id()) / LBA_SHARD_FACTOR;
+    return entries_live / static_cast<double>(entries_total);
+}
+
+void lba_list_t::shutdown_gc(bool compact) {
     guarantee(state == state_ready);
     guarantee(coro_t::self() != nullptr);
 
+    if (compact) {
+        // A shard that is being garbage collected right now gets compacted anyway
+        // (unless the GC is still running once we're done with the others).
+        for (int i = 0; i < LBA_SHARD_FACTOR; i++) {
+            if (!gc_active[i]
+                && !disk_structures[i]->extents_in_superblock.empty()
+                && ungarbage_fraction(i) < LBA_SHUTDOWN_MIN_UNGARBAGE_FRACTION) {
+                gc_active[i] = true;
+                gc(i, auto_drainer_t::lock_t(gc_drainer.get()));
+            }
+        }
+    }
+
     state = state_gc_shutting_down;
 
     // Wait for active GC coroutines to finish
@@ -45,6 +45,9 @@ public:
     flagged_off64_t get_block_offset(block_id_t block);
     uint16_t get_ser_block_size(block_id_t block);
     block_size_t get_block_size(block_id_t block);
+    // The size of the block on disk, which differs from get_block_size if the
+    // block is compressed.
+    block_size_t get_disk_block_size(block_id_t block);
     repli_timestamp_t get_block_recency(block_id_t block);
     segmented_vector_t<repli_timestamp_t> get_block_recencies(block_id_t first,
                                                               block_id_t step);
@@ -62,6 +65,7 @@ public:
 
     void set_block_info(block_id_t block, repli_timestamp_t recency,
                         flagged_off64_t offset, uint16_t ser_block_size,
+                        uint16_t disk_block_size, uint32_t checksum,
                         file_account_t *io_account,
                         extent_transaction_t *txn);
 
@@ -76,11 +80,14 @@ public:
     // The garbage collector must be shut down first through `shutdown_gc()`
     // (must be run in a coroutine). Once that is done, call `shutdown()` to
     // shut down the whole lba_list.
+    // If `compact` is true, `shutdown_gc()` first garbage collects every shard that
+    // has more than a little garbage, so that the next startup can load the LBA
+    // with one sequential pass over (almost) only live entries.
     // The reason for shutting down in two parts like this is because
     // the garbage collector depends on `write_metablock_fun` to be valid,
     // which would create circular dependencies in the shutdown process
     // of log_serializer_t.
-    void shutdown_gc();
+    void shutdown_gc(bool compact);
     void shutdown();
 
     bool is_any_gc_active() const;
@@ -117,7 +124,8 @@ private:
     void move_inline_entries_to_extents(file_account_t *io_account,
                                         extent_transaction_t *txn);
     void add_inline_entry(block_id_t block, repli_timestamp_t recency,
-                          flagged_off64_t offset, uint16_t ser_block_size);
+                          flagged_off64_t offset, uint16_t ser_block_size,
+                          uint16_t disk_block_size, uint32_t checksum);
 
     lba_disk_structure_t *disk_structures[LBA_SHARD_FACTOR];
 
@@ -128,6 +136,9 @@ private:
     // gc. The integer is which shard to GC.
     bool we_want_to_gc(int i);
 
+    // The fraction of the entries in the given shard's LBA extents that are live.
+    double ungarbage_fraction(int i);
+
     DISABLE_COPYING(lba_list_t);
 };
 
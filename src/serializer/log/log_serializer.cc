@@ -11,12 +11,14 @@
 #include "arch/io/disk.hpp"
 #include "arch/runtime/runtime.hpp"
 #include "arch/runtime/coroutines.hpp"
+#include "arch/timing.hpp"
 #include "buffer_cache/types.hpp"
 #include "concurrency/new_mutex.hpp"
 #include "logger.hpp"
 #include "perfmon/perfmon.hpp"
 #include "serializer/buf_ptr.hpp"
 #include "serializer/log/data_block_manager.hpp"
+#include "time.hpp"
 
 filepath_file_opener_t::filepath_file_opener_t(const serializer_filepath_t &filepath,
                                                io_backender_t *backender)
@@ -135,6 +137,15 @@ log_serializer_stats_t::log_serializer_stats_t(perfmon_collection_t *parent)
       pm_serializer_data_extents_gced(),
       pm_serializer_old_garbage_block_bytes(),
       pm_serializer_old_total_block_bytes(),
+      pm_serializer_blocks_compressed(),
+      pm_serializer_blocks_decompressed(),
+      pm_serializer_compression_saved_bytes(),
+      pm_serializer_user_written_bytes(),
+      pm_serializer_gc_written_bytes(),
+      pm_serializer_write_amplification(&pm_serializer_user_written_bytes,
+                                        &pm_serializer_gc_written_bytes),
+      pm_serializer_scrubbed_blocks(),
+      pm_serializer_scrub_corrupt_blocks(),
       pm_serializer_lba_gcs(),
       parent_collection_membership(parent, &serializer_collection, "serializer"),
       stats_membership(&serializer_collection,
@@ -155,9 +166,46 @@ log_serializer_stats_t::log_serializer_stats_t(perfmon_collection_t *parent)
           &pm_serializer_data_extents_gced, "serializer_data_extents_gced",
           &pm_serializer_old_garbage_block_bytes, "serializer_old_garbage_block_bytes",
           &pm_serializer_old_total_block_bytes, "serializer_old_total_block_bytes",
+          &pm_serializer_blocks_compressed, "serializer_blocks_compressed",
+          &pm_serializer_blocks_decompressed, "serializer_blocks_decompressed",
+          &pm_serializer_compression_saved_bytes, "serializer_compression_saved_bytes",
+          &pm_serializer_user_written_bytes, "serializer_user_written_bytes",
+          &pm_serializer_gc_written_bytes, "serializer_gc_written_bytes",
+          &pm_serializer_write_amplification, "serializer_write_amplification",
+          &pm_serializer_scrubbed_blocks, "serializer_scrubbed_blocks",
+          &pm_serializer_scrub_corrupt_blocks, "serializer_scrub_corrupt_blocks",
           &pm_serializer_lba_gcs, "serializer_lba_gcs")
 { }
 
+perfmon_write_amplification_t::perfmon_write_amplification_t(
+        perfmon_counter_t *_user_bytes, perfmon_counter_t *_gc_bytes)
+    : user_bytes(_user_bytes), gc_bytes(_gc_bytes) { }
+
+struct write_amplification_ctx_t {
+    void *user_ctx;
+    void *gc_ctx;
+};
+
+void *perfmon_write_amplification_t::begin_stats() {
+    return new write_amplification_ctx_t{user_bytes->begin_stats(),
+                                         gc_bytes->begin_stats()};
+}
+
+void perfmon_write_amplification_t::visit_stats(void *ctx) {
+    write_amplification_ctx_t *c = static_cast<write_amplification_ctx_t *>(ctx);
+    user_bytes->visit_stats(c->user_ctx);
+    gc_bytes->visit_stats(c->gc_ctx);
+}
+
+ql::datum_t perfmon_write_amplification_t::end_stats(void *ctx) {
+    scoped_ptr_t<write_amplification_ctx_t> c(
+        static_cast<write_amplification_ctx_t *>(ctx));
+    const double user = user_bytes->end_stats(c->user_ctx).as_num();
+    const double gc = gc_bytes->end_stats(c->gc_ctx).as_num();
+    // Nothing has been written yet, so nothing has been amplified either.
+    return ql::datum_t(user == 0 ? 1.0 : (user + gc) / user);
+}
+
 void log_serializer_stats_t::bytes_read(size_t count) {
     pm_serializer_read_bytes_per_sec.record(count);
     pm_serializer_read_bytes_total += count;
@@ -318,7 +366,7 @@ struct ls_start_existing_fsm_t :
                     ser->lba_index->get_block_offset(next_block_to_reconstruct);
                 if (offset.has_value()) {
                     ser->data_block_manager->mark_live(offset.get_value(),
-                        ser->lba_index->get_block_size(next_block_to_reconstruct));
+                        ser->lba_index->get_disk_block_size(next_block_to_reconstruct));
                 }
 
                 ++next_block_to_reconstruct;
@@ -409,7 +457,8 @@ private:
 
 log_serializer_t::log_serializer_t(dynamic_config_t _dynamic_config,
                                    serializer_file_opener_t *file_opener,
-                                   perfmon_collection_t *_perfmon_collection)
+                                   perfmon_collection_t *_perfmon_collection,
+                                   log_serializer_scrub_callback_t *_scrub_callback)
     : stats(new log_serializer_stats_t(_perfmon_collection)),  // can block in a perfmon_collection_t::add call.
       disk_stats_collection(),
       disk_stats_membership(_perfmon_collection, &disk_stats_collection, "disk"),  // can block in a perfmon_collection_t::add call.
@@ -426,12 +475,20 @@ log_serializer_t::log_serializer_t(dynamic_config_t _dynamic_config,
       metablock_manager(nullptr),
       lba_index(nullptr),
       data_block_manager(nullptr),
-      active_write_count(0) {
+      active_write_count(0),
+      scrub_callback(_scrub_callback) {
     // STATE A
     /* This is because the serializer is not completely converted to coroutines yet. */
     ls_start_existing_fsm_t *s = new ls_start_existing_fsm_t(this);
     cond_t cond;
     if (!s->run(&cond, file_opener)) cond.wait();
+
+    if (dynamic_config.scrub_bytes_per_sec > 0) {
+        scrub_drainer.init(new auto_drainer_t());
+        coro_t *scrub_coro = coro_t::spawn_sometime(std::bind(&log_serializer_t::scrub,
+                this, auto_drainer_t::lock_t(scrub_drainer.get())));
+        scrub_coro->set_priority(CORO_PRIORITY_SCRUB);
+    }
 }
 
 log_serializer_t::~log_serializer_t() {
@@ -491,8 +548,11 @@ void log_serializer_t::index_write(new_mutex_in_line_t *mutex_acq,
              write_op_it != write_ops.end();
              ++write_op_it) {
             const index_write_op_t &op = *write_op_it;
-            flagged_off64_t offset = lba_index->get_block_offset(op.block_id);
-            uint16_t ser_block_size = lba_index->get_ser_block_size(op.block_id);
+            const index_block_info_t info = lba_index->get_block_info(op.block_id);
+            flagged_off64_t offset = info.offset;
+            uint16_t ser_block_size = info.ser_block_size;
+            uint16_t disk_block_size = info.disk_block_size;
+            uint32_t checksum = info.checksum;
 
             if (op.token) {
                 // Update the offset pointed to, and mark garbage/liveness as necessary.
@@ -507,13 +567,22 @@ void log_serializer_t::index_write(new_mutex_in_line_t *mutex_acq,
                 if (token.has()) {
                     offset = flagged_off64_t::make(token->offset_);
                     ser_block_size = token->block_size().ser_value();
+                    checksum = token->checksum();
+
+                    // The block is compressed iff its size on disk differs.
+                    const block_size_t disk_size
+                        = data_block_manager->disk_block_size(offset.get_value());
+                    disk_block_size = disk_size == token->block_size()
+                        ? 0
+                        : disk_size.ser_value();
 
                     /* mark the life */
-                    data_block_manager->mark_live(offset.get_value(),
-                                                  token->block_size());
+                    data_block_manager->mark_live(offset.get_value(), disk_size);
                 } else {
                     offset = flagged_off64_t::unused();
                     ser_block_size = 0;
+                    disk_block_size = 0;
+                    checksum = NO_BLOCK_CHECKSUM;
                 }
             }
 
@@ -521,8 +590,8 @@ void log_serializer_t::index_write(new_mutex_in_line_t *mutex_acq,
                 : lba_index->get_block_recency(op.block_id);
 
             lba_index->set_block_info(op.block_id, recency,
-                                      offset, ser_block_size,
-                                      index_writes_io_account.get(), &txn);
+                                      offset, ser_block_size, disk_block_size,
+                                      checksum, index_writes_io_account.get(), &txn);
         }
     }
 
@@ -531,8 +600,9 @@ void log_serializer_t::index_write(new_mutex_in_line_t *mutex_acq,
 
     // Before we fully commit the write to disk, we must migrate the static header
     // if necessary.
-    // Note that this is early enough for upgrading from the 1.13 serializer
-    // version to 2.2, since only the format of the LBA changed.
+    // Note that this is early enough for upgrading from the 1.13 and 2.2 serializer
+    // versions to 2.5, since only the format of the LBA changed and entries for
+    // blocks written before this point still have the old format.
     // Future serializer format changes might require this step to happen earlier.
     {
         new_mutex_acq_t acq(&static_header_migration_mutex);
@@ -649,9 +719,11 @@ void log_serializer_t::write_metablock_sans_pipelining(
 }
 
 counted_t<block_token_t>
-log_serializer_t::generate_block_token(int64_t offset, block_size_t block_size) {
+log_serializer_t::generate_block_token(int64_t offset, block_size_t block_size,
+                                       uint32_t checksum) {
     assert_thread();
-    counted_t<block_token_t> token(new block_token_t(this, offset, block_size));
+    counted_t<block_token_t> token(
+        new block_token_t(this, offset, block_size, checksum));
 
     auto location = offset_tokens.find(offset);
     if (location == offset_tokens.end()) {
@@ -749,6 +821,23 @@ void log_serializer_t::remap_block_to_new_offset(int64_t current_offset,
     }
 }
 
+void log_serializer_t::live_block_info(block_id_t block_id, int64_t offset,
+                                       block_size_t *block_size_out,
+                                       uint32_t *checksum_out) {
+    assert_thread();
+    auto token_it = offset_tokens.find(offset);
+    if (token_it != offset_tokens.end()) {
+        *block_size_out = token_it->second->block_size();
+        *checksum_out = token_it->second->checksum();
+        return;
+    }
+    const index_block_info_t info = lba_index->get_block_info(block_id);
+    guarantee(info.offset.has_value() && info.offset.get_value() == offset,
+              "Block %" PRIu64 " at offset %" PRIi64 " is not live.", block_id, offset);
+    *block_size_out = block_size_t::unsafe_make(info.ser_block_size);
+    *checksum_out = info.checksum;
+}
+
 max_block_size_t log_serializer_t::max_block_size() const {
     return static_config.max_block_size();
 }
@@ -791,12 +880,93 @@ counted_t<block_token_t> log_serializer_t::index_read(block_id_t block_id) {
     index_block_info_t info = lba_index->get_block_info(block_id);
     if (info.offset.has_value()) {
         return generate_block_token(info.offset.get_value(),
-                                    block_size_t::unsafe_make(info.ser_block_size));
+                                    block_size_t::unsafe_make(info.ser_block_size),
+                                    info.checksum);
     } else {
         return counted_t<block_token_t>();
     }
 }
 
+void log_serializer_t::scrub(auto_drainer_t::lock_t lock) {
+    assert_thread();
+    scoped_ptr_t<file_account_t> io_account(
+        make_io_account(SCRUB_IO_PRIORITY, 1));
+
+    try {
+        while (true) {
+            // We pace ourselves so that on average we don't read more than
+            // `scrub_bytes_per_sec` bytes per second.
+            const ticks_t start_ticks = get_ticks();
+            int64_t bytes_read = 0;
+            for (block_id_t block_id = 0; ; ++block_id) {
+                if (!is_aux_block_id(block_id) && block_id >= end_block_id()) {
+                    block_id = FIRST_AUX_BLOCK_ID;
+                }
+                if (block_id >= end_aux_block_id()) {
+                    break;
+                }
+                if (!scrub_block(block_id, io_account.get(), &bytes_read)) {
+                    ++stats->pm_serializer_scrub_corrupt_blocks;
+                }
+
+                const int64_t target_ms
+                    = bytes_read * 1000 / dynamic_config.scrub_bytes_per_sec;
+                const int64_t elapsed_ms
+                    = (get_ticks().nanos - start_ticks.nanos) / 1000000;
+                if (target_ms > elapsed_ms) {
+                    nap(target_ms - elapsed_ms, lock.get_drain_signal());
+                } else {
+                    coro_t::yield();
+                    if (lock.get_drain_signal()->is_pulsed()) {
+                        throw interrupted_exc_t();
+                    }
+                }
+            }
+            nap(SCRUB_PASS_INTERVAL_MS, lock.get_drain_signal());
+        }
+    } catch (const interrupted_exc_t &) {
+        // We're shutting down.
+    }
+}
+
+bool log_serializer_t::scrub_block(block_id_t block_id, file_account_t *io_account,
+                                   int64_t *bytes_read_out) {
+    const index_block_info_t info = lba_index->get_block_info(block_id);
+    if (!info.offset.has_value() || info.checksum == NO_BLOCK_CHECKSUM) {
+        return true;
+    }
+
+    // The token keeps the block alive, and in the right place, if the GC moves it
+    // while we're reading.
+    counted_t<block_token_t> token = generate_block_token(
+        info.offset.get_value(), block_size_t::unsafe_make(info.ser_block_size),
+        info.checksum);
+    const bool ok = data_block_manager->read_and_verify(
+        token->offset(), token->block_size(), token->checksum(), io_account);
+    ++stats->pm_serializer_scrubbed_blocks;
+    *bytes_read_out += token->block_size().ser_value();
+
+    if (!ok) {
+        report_corrupt_block(block_id, token);
+    }
+    return ok;
+}
+
+void log_serializer_t::report_corrupt_block(block_id_t block_id,
+                                            const counted_t<block_token_t> &token) {
+    assert_thread();
+    // The cache may read the same damaged block over and over again.
+    if (!corrupt_block_offsets.insert(token->offset()).second) {
+        return;
+    }
+    logERR("Data corruption: block %" PRIu64 " at offset %" PRIi64
+           " does not match its checksum.  The data file is damaged, probably by"
+           " a disk or file system failure.", block_id, token->offset());
+    if (scrub_callback != nullptr) {
+        scrub_callback->on_corrupt_block(block_id, token->offset());
+    }
+}
+
 bool log_serializer_t::get_delete_bit(block_id_t id) {
     assert_thread();
     rassert(state == state_ready);
@@ -822,12 +992,16 @@ void log_serializer_t::shutdown(cond_t *cb) {
     rassert(shutdown_state == shutdown_not_started);
     shutdown_state = shutdown_begin;
 
+    // The scrubber reads blocks through the data block manager, so stop it first.
+    // This might block until its current read completes.
+    scrub_drainer.reset();
+
     // We must shutdown the LBA GC before we shut down
     // the data_block_manager or metablock_manager, because the LBA GC
     // uses our `write_metablock()` method which depends on those.
     // `shutdown_gc()` might block, but uses coroutine waiting in contrast
     // to most of the remaining shutdown process which is still FSM-based.
-    lba_index->shutdown_gc();
+    lba_index->shutdown_gc(dynamic_config.compact_lba_on_shutdown);
 
     // Additionally we tell the data block manager to stop GCing.
     // Not doing this doesn't hurt correctness, but it will delay the shutdown
@@ -986,9 +1160,11 @@ bool log_serializer_t::should_perform_read_ahead() {
 
 block_token_t::block_token_t(log_serializer_t *serializer,
                              int64_t initial_offset,
-                             block_size_t initial_block_size)
+                             block_size_t initial_block_size,
+                             uint32_t checksum)
     : serializer_(serializer), ref_count_(0),
-      block_size_(initial_block_size), offset_(initial_offset) {
+      block_size_(initial_block_size), offset_(initial_offset),
+      checksum_(checksum) {
     serializer_->assert_thread();
 }
 
@@ -3,6 +3,7 @@
 #define SERIALIZER_LOG_LOG_SERIALIZER_HPP_
 
 #include <map>
+#include <set>
 #include <string>
 #include <vector>
 #include <list>
@@ -12,6 +13,7 @@
 #include "serializer/serializer.hpp"
 #include "serializer/log/config.hpp"
 #include "utils.hpp"
+#include "concurrency/auto_drainer.hpp"
 #include "concurrency/mutex_assertion.hpp"
 #include "concurrency/new_mutex.hpp"
 #include "concurrency/signal.hpp"
@@ -89,6 +91,15 @@ private:
 };
 
 
+// Told about corrupted blocks that the scrubber or the cache finds, once per block
+// location.  Called on the serializer's thread; must not block.
+class log_serializer_scrub_callback_t {
+public:
+    virtual void on_corrupt_block(block_id_t block_id, int64_t offset) = 0;
+protected:
+    virtual ~log_serializer_scrub_callback_t() { }
+};
+
 // Used internally
 struct ls_start_existing_fsm_t;
 
@@ -116,7 +127,8 @@ public:
     /* Blocks. */
     log_serializer_t(dynamic_config_t dynamic_config,
                      serializer_file_opener_t *file_opener,
-                     perfmon_collection_t *perfmon_collection);
+                     perfmon_collection_t *perfmon_collection,
+                     log_serializer_scrub_callback_t *scrub_callback = nullptr);
 
     /* Blocks. */
     virtual ~log_serializer_t();
@@ -152,11 +164,22 @@ public:
 
     virtual bool is_gc_active() const;
 
+    void report_corrupt_block(block_id_t block_id,
+                              const counted_t<block_token_t> &token);
+
 private:
     void unregister_block_token(block_token_t *token);
     void remap_block_to_new_offset(int64_t current_offset, int64_t new_offset);
     counted_t<block_token_t> generate_block_token(int64_t offset,
-                                                             block_size_t block_size);
+                                                  block_size_t block_size,
+                                                  uint32_t checksum);
+
+    // Returns the (uncompressed) size and the checksum of a live block, as recorded
+    // by the tokens pointing to `offset` or by the index.  Used by the data block
+    // manager's GC, which can't tell the size of a compressed block from its size on
+    // disk, and has to carry the checksum over to the block's new location.
+    void live_block_info(block_id_t block_id, int64_t offset,
+                         block_size_t *block_size_out, uint32_t *checksum_out);
 
     void offer_buf_to_read_ahead_callbacks(
             block_id_t block_id,
@@ -201,6 +224,13 @@ private:
 
     void consider_start_gc();
 
+    /* Runs in a coroutine while `dynamic_config.scrub_bytes_per_sec` is positive.
+    Repeatedly reads all live blocks and verifies their checksums. */
+    void scrub(auto_drainer_t::lock_t lock);
+    // Returns false if `block_id` turned out to be corrupted.
+    bool scrub_block(block_id_t block_id, file_account_t *io_account,
+                     int64_t *bytes_read_out);
+
     // We maintain offset_tokens so that we can remap block tokens' offsets while doing
     // a GC.  It's a multimap (we create duplicate tokens for an offset) because on-disk
     // GC (which remaps offsets) will move block tokens from an "old" offset to a "new"
@@ -261,6 +291,11 @@ private:
 
     int active_write_count;
 
+    log_serializer_scrub_callback_t *const scrub_callback;
+    // The offsets of the corrupted blocks that we've reported so far.
+    std::set<int64_t> corrupt_block_offsets;
+    scoped_ptr_t<auto_drainer_t> scrub_drainer;
+
     DISABLE_COPYING(log_serializer_t);
 };
 
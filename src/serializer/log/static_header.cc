@@ -14,7 +14,12 @@
 // The CURRENT_SERIALIZER_VERSION_STRING might remain unchanged for a while --
 // individual metablocks have a disk_format_version field that can be incremented
 // for on-the-fly version updating.
-#define CURRENT_SERIALIZER_VERSION_STRING "2.2"
+#define CURRENT_SERIALIZER_VERSION_STRING "2.5"
+
+// Since 2.2, LBA entries carry a block checksum and the size of compressed blocks.
+// We can still read 2.2 serializer files, but previous versions of RethinkDB cannot
+// read 2.5+ files.
+#define V2_2_SERIALIZER_VERSION_STRING "2.2"
 
 // Since 1.13, we added the aux block ID space. We can still read 1.13 serializer
 // files, but previous versions of RethinkDB cannot read 2.2+ files.
@@ -84,7 +89,9 @@ void co_static_header_read(
     }
 
     if (memcmp(buffer->version, V1_13_SERIALIZER_VERSION_STRING,
-               sizeof(V1_13_SERIALIZER_VERSION_STRING)) == 0) {
+               sizeof(V1_13_SERIALIZER_VERSION_STRING)) == 0
+        || memcmp(buffer->version, V2_2_SERIALIZER_VERSION_STRING,
+                  sizeof(V2_2_SERIALIZER_VERSION_STRING)) == 0) {
         *needs_migration_out = true;
     } else if (memcmp(buffer->version, CURRENT_SERIALIZER_VERSION_STRING,
                sizeof(CURRENT_SERIALIZER_VERSION_STRING)) == 0) {
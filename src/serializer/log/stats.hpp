@@ -4,6 +4,24 @@
 
 #include "perfmon/perfmon.hpp"
 
+/* Reports how many bytes the serializer has written to data extents for every
+byte of user data, i.e. `(user + gc) / user`, based on two existing counters. */
+class perfmon_write_amplification_t : public perfmon_t {
+public:
+    perfmon_write_amplification_t(perfmon_counter_t *_user_bytes,
+                                  perfmon_counter_t *_gc_bytes);
+
+    void *begin_stats();
+    void visit_stats(void *ctx);
+    ql::datum_t end_stats(void *ctx);
+
+private:
+    perfmon_counter_t *const user_bytes;
+    perfmon_counter_t *const gc_bytes;
+
+    DISABLE_COPYING(perfmon_write_amplification_t);
+};
+
 struct log_serializer_stats_t {
     perfmon_collection_t serializer_collection;
     explicit log_serializer_stats_t(perfmon_collection_t *perfmon_collection);
@@ -35,6 +53,16 @@ struct log_serializer_stats_t {
     perfmon_counter_t pm_serializer_data_extents_gced;
     perfmon_counter_t pm_serializer_old_garbage_block_bytes;
     perfmon_counter_t pm_serializer_old_total_block_bytes;
+    perfmon_counter_t pm_serializer_blocks_compressed;
+    perfmon_counter_t pm_serializer_blocks_decompressed;
+    perfmon_counter_t pm_serializer_compression_saved_bytes;
+    perfmon_counter_t pm_serializer_user_written_bytes;
+    perfmon_counter_t pm_serializer_gc_written_bytes;
+    perfmon_write_amplification_t pm_serializer_write_amplification;
+
+    /* used by the scrubber in serializer/log/log_serializer.cc */
+    perfmon_counter_t pm_serializer_scrubbed_blocks;
+    perfmon_counter_t pm_serializer_scrub_corrupt_blocks;
 
     /* used in serializer/log/lba/lba_list.cc */
     perfmon_counter_t pm_serializer_lba_gcs;
@@ -114,6 +114,11 @@ public:
         return inner->is_gc_active();
     }
 
+    void report_corrupt_block(block_id_t block_id,
+                              const counted_t<block_token_t> &token) {
+        inner->report_corrupt_block(block_id, token);
+    }
+
 private:
     // Adds `op` to `outstanding_index_write_ops`, using `merge_index_write_op()` if
     // necessary
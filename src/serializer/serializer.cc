@@ -2,6 +2,7 @@
 #include "serializer/serializer.hpp"
 
 #include "arch/arch.hpp"
+#include "crc32c.hpp"
 #include "math.hpp"
 
 void debug_print(printf_buffer_t *buf, const index_write_op_t &write_op) {
@@ -21,6 +22,18 @@ ser_buffer_t *convert_buffer_cache_buf_to_ser_buffer(const void *buf) {
     return static_cast<ser_buffer_t *>(const_cast<void *>(buf)) - 1;
 }
 
+uint32_t compute_block_checksum(const ser_buffer_t *buf, block_size_t block_size) {
+    const uint32_t crc = crc32c(buf, block_size.ser_value());
+    // Don't collide with the value that means there's no checksum.
+    return crc == NO_BLOCK_CHECKSUM ? 1 : crc;
+}
+
+bool block_checksum_matches(uint32_t checksum, const ser_buffer_t *buf,
+                            block_size_t block_size) {
+    return checksum == NO_BLOCK_CHECKSUM
+        || checksum == compute_block_checksum(buf, block_size);
+}
+
 void debug_print(printf_buffer_t *buf, const buf_write_info_t &info) {
     buf->appendf("bwi{buf=%p, size=%" PRIu16 ", id=%" PRIu64 "}",
                  info.buf, info.block_size.ser_value(), info.block_id);
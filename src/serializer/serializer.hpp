@@ -125,6 +125,11 @@ public:
     /* Return true if the garbage collector is active */
     virtual bool is_gc_active() const = 0;
 
+    /* Called on the serializer's thread when a block that was read with `block_read`
+    turns out not to match its checksum. */
+    virtual void report_corrupt_block(block_id_t block_id,
+                                      const counted_t<block_token_t> &token) = 0;
+
 private:
     DISABLE_COPYING(serializer_t);
 };
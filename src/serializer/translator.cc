@@ -285,6 +285,11 @@ bool translator_serializer_t::is_gc_active() const {
     return inner->is_gc_active();
 }
 
+void translator_serializer_t::report_corrupt_block(
+        block_id_t block_id, const counted_t<block_token_t> &token) {
+    inner->report_corrupt_block(block_id, token);
+}
+
 // A helper function for `end_block_id` and `end_aux_block_id`
 // `first_block_id` is the lowest block ID in the range, either 0 for regular block
 // IDs or FIRST_AUX_BLOCK_ID for aux blocks.
@@ -135,6 +135,9 @@ public:
 
     bool is_gc_active() const;
 
+    void report_corrupt_block(block_id_t block_id,
+                              const counted_t<block_token_t> &token);
+
     block_id_t end_block_id();
     block_id_t end_aux_block_id();
 
@@ -128,12 +128,22 @@ private:
 
 class repli_timestamp_t;
 
+// Blocks are checksummed with CRC-32C over their whole `ser_buffer_t`, i.e. before
+// any compression.  A checksum of NO_BLOCK_CHECKSUM means that the checksum is
+// unknown, because the block was written by an older version.
+static const uint32_t NO_BLOCK_CHECKSUM = 0;
+uint32_t compute_block_checksum(const ser_buffer_t *buf, block_size_t block_size);
+// Returns false if `checksum` is known and doesn't match the block.
+bool block_checksum_matches(uint32_t checksum, const ser_buffer_t *buf,
+                            block_size_t block_size);
+
 class log_serializer_t;
 
 class block_token_t {
 public:
     int64_t offset() const { return offset_; }
     block_size_t block_size() const { return block_size_; }
+    uint32_t checksum() const { return checksum_; }
 
 private:
     friend class log_serializer_t;
@@ -144,7 +154,8 @@ private:
 
     block_token_t(log_serializer_t *serializer,
                   int64_t initial_offset,
-                  block_size_t initial_ser_block_size);
+                  block_size_t initial_ser_block_size,
+                  uint32_t checksum);
 
     log_serializer_t *const serializer_;
     std::atomic<intptr_t> ref_count_;
@@ -155,6 +166,9 @@ private:
     // The block's offset on disk.
     int64_t offset_;
 
+    // The checksum of the block's contents, or NO_BLOCK_CHECKSUM.
+    uint32_t checksum_;
+
     void do_destroy();
 
     DISABLE_COPYING(block_token_t);
@@ -56,6 +56,10 @@ public:
         }
 
         ASSERT_EQ(e - p_orig, p - p_orig);
+
+        std::string copied(size, '\0');
+        blob_.read_region(buf_parent_t(txn), offset, size, &copied[0]);
+        ASSERT_EQ(std::string(p_orig, e), copied);
     }
 
     void check_normalization(txn_t *txn) {
@@ -300,4 +304,65 @@ TPTEST(BlobTest, AllTests) {
     run_tests(&cache);
 }
 
+/* Reads a large value with `expose_all` and with `read_all`.  Every read goes through a
+fresh cache, so that all blocks come from the serializer. */
+
+std::string read_large_value(log_serializer_t *serializer,
+                             const scoped_array_t<char> &ref, bool use_read_all) {
+    dummy_cache_balancer_t balancer(32 * MEGABYTE);
+    cache_t cache(serializer, &balancer, &get_global_perfmon_collection());
+    cache_conn_t cache_conn(&cache);
+    txn_t txn(&cache_conn, read_access_t::read);
+
+    scoped_array_t<char> ref_copy(ref.size());
+    memcpy(ref_copy.data(), ref.data(), ref.size());
+    blob_t blob(cache.max_block_size(), ref_copy.data(), ref_copy.size());
+    const int64_t size = blob.valuesize();
+    std::string out(size, '\0');
+
+    if (use_read_all) {
+        blob.read_all(buf_parent_t(&txn), &out[0]);
+    } else {
+        buffer_group_t bg;
+        blob_acq_t bacq;
+        blob.expose_all(buf_parent_t(&txn), access_t::read, &bg, &bacq);
+        buffer_group_t dest;
+        dest.add_buffer(size, &out[0]);
+        buffer_group_copy_data(&dest, const_view(&bg));
+    }
+    return out;
+}
+
+TPTEST(BlobTest, LargeValueReadAll) {
+    mock_file_opener_t file_opener;
+    log_serializer_t::create(
+            &file_opener,
+            log_serializer_t::static_config_t());
+    log_serializer_t log_serializer(
+            log_serializer_t::dynamic_config_t(),
+            &file_opener,
+            &get_global_perfmon_collection());
+
+    const int64_t size = 4 * MEGABYTE;
+    scoped_array_t<char> ref(blob::btree_maxreflen);
+    memset(ref.data(), 0, ref.size());
+    std::string value(size, 'v');
+    for (int64_t i = 0; i < size; i += 4099) {
+        value[i] = 'a' + i % 26;
+    }
+    {
+        dummy_cache_balancer_t balancer(GIGABYTE);
+        cache_t cache(&log_serializer, &balancer, &get_global_perfmon_collection());
+        cache_conn_t cache_conn(&cache);
+        txn_t txn(&cache_conn, write_durability_t::HARD, 0);
+        blob_t blob(cache.max_block_size(), ref.data(), ref.size());
+        blob.append_region(buf_parent_t(&txn), size);
+        blob.write_from_string(value, buf_parent_t(&txn), 0);
+        txn.commit();
+    }
+
+    ASSERT_EQ(value, read_large_value(&log_serializer, ref, false));
+    ASSERT_EQ(value, read_large_value(&log_serializer, ref, true));
+}
+
 }  // namespace unittest
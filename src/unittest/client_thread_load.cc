@@ -0,0 +1,100 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#include <functional>
+#include <vector>
+
+#include "arch/runtime/coroutines.hpp"
+#include "arch/runtime/runtime.hpp"
+#include "arch/timing.hpp"
+#include "client_protocol/thread_load.hpp"
+#include "concurrency/cond_var.hpp"
+#include "containers/scoped.hpp"
+#include "perfmon/perfmon.hpp"
+#include "unittest/gtest.hpp"
+#include "unittest/unittest_utils.hpp"
+
+namespace unittest {
+
+// Keeps the given thread busy by yielding over and over, until `stop` is pulsed.
+void keep_thread_busy(threadnum_t thread, cond_t *stop, cond_t *stopped) {
+    {
+        on_thread_t thread_switcher(thread);
+        while (!stop->is_pulsed()) {
+            coro_t::yield();
+        }
+    }
+    stopped->pulse();
+}
+
+TPTEST(ClientThreadLoad, SpreadsConnectionsEvenly, 4) {
+    perfmon_collection_t stats;
+    client_thread_load_t thread_load(&stats);
+    const int num_db_threads = get_num_db_threads();
+
+    std::vector<scoped_ptr_t<client_thread_load_t::connection_t> > connections;
+    std::vector<int> per_thread(num_db_threads, 0);
+    for (int i = 0; i < 3 * num_db_threads; ++i) {
+        connections.push_back(make_scoped<client_thread_load_t::connection_t>(
+            &thread_load));
+        ++per_thread[connections.back()->get_thread().threadnum];
+    }
+    for (int i = 0; i < num_db_threads; ++i) {
+        ASSERT_EQ(3, per_thread[i]);
+    }
+
+    // Closing the connections of one thread makes it the least loaded one.
+    for (auto &connection : connections) {
+        if (connection->get_thread().threadnum == 1) {
+            connection.reset();
+        }
+    }
+    client_thread_load_t::connection_t connection(&thread_load);
+    ASSERT_EQ(1, connection.get_thread().threadnum);
+}
+
+TPTEST(ClientThreadLoad, AvoidsAndLeavesBusyThread, 4) {
+    perfmon_collection_t stats;
+    client_thread_load_t thread_load(&stats);
+    const int num_db_threads = get_num_db_threads();
+
+    // Two connections per thread, placed while all threads are idle.
+    std::vector<scoped_ptr_t<client_thread_load_t::connection_t> > connections;
+    for (int i = 0; i < 2 * num_db_threads; ++i) {
+        connections.push_back(make_scoped<client_thread_load_t::connection_t>(
+            &thread_load));
+    }
+
+    cond_t stop, stopped;
+    coro_t::spawn_sometime(std::bind(&keep_thread_busy, threadnum_t(1), &stop, &stopped));
+    nap(100);
+    thread_load.on_ring();
+    ASSERT_GE(thread_load.get_load(threadnum_t(1)),
+              thread_load.get_load(threadnum_t(0)) + CLIENT_REBALANCE_MIN_LOAD_DIFFERENCE);
+
+    // New connections go elsewhere.
+    for (int i = 0; i < 4; ++i) {
+        client_thread_load_t::connection_t connection(&thread_load);
+        ASSERT_NE(1, connection.get_thread().threadnum);
+    }
+
+    // Connections on the busy thread want to move, and one of them does.
+    bool rebalanced = false;
+    for (auto &connection : connections) {
+        if (connection->get_thread().threadnum == 1) {
+            ASSERT_TRUE(connection->wants_rebalance());
+            if (!rebalanced) {
+                ASSERT_TRUE(connection->rebalance());
+                ASSERT_NE(1, connection->get_thread().threadnum);
+                rebalanced = true;
+            }
+        } else {
+            ASSERT_FALSE(connection->wants_rebalance());
+        }
+    }
+    ASSERT_TRUE(rebalanced);
+    ASSERT_EQ(1, thread_load.num_rebalanced_connections());
+
+    stop.pulse();
+    stopped.wait();
+}
+
+}  // namespace unittest
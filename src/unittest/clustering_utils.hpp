@@ -287,10 +287,13 @@ private:
 class test_cluster_run_t {
 public:
     explicit test_cluster_run_t(connectivity_cluster_t *c,
-                                const peer_address_t &canonical_addr = peer_address_t())
+                                const peer_address_t &canonical_addr = peer_address_t(),
+                                cluster_compression_t compression
+                                    = cluster_compression_t::NONE)
         : run(c, server_id_t::generate_server_id(),
             get_unittest_addresses(), canonical_addr, 0, ANY_PORT, 0,
-            heartbeat_manager.get_view(), auth_manager.get_view(), nullptr) { }
+            heartbeat_manager.get_view(), auth_manager.get_view(), nullptr,
+            compression) { }
 
     operator connectivity_cluster_t::run_t&() {
         return run;
@@ -0,0 +1,121 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#ifndef _WIN32
+
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <functional>
+#include <vector>
+
+#include "arch/runtime/coro_stack_pool.hpp"
+#include "arch/runtime/coroutines.hpp"
+#include "arch/timing.hpp"
+#include "concurrency/cond_var.hpp"
+#include "unittest/gtest.hpp"
+#include "unittest/unittest_utils.hpp"
+
+namespace unittest {
+
+TEST(CoroStackPool, ReusesReleasedStacks) {
+    coro_stack_pool_t *pool = coro_stack_pool_t::get();
+    // An unusual size, so that no coroutine stacks get mixed up with ours.
+    const size_t size = 5 * getpagesize();
+
+    const int64_t stacks_before = pool->num_stacks();
+    coro_stack_pool_t::stack_memory_t stack = pool->acquire(size);
+    ASSERT_TRUE(stack.memory != nullptr);
+    ASSERT_EQ(size, stack.size);
+    ASSERT_FALSE(stack.guard_page_protected);
+    ASSERT_EQ(stacks_before + 1, pool->num_stacks());
+    // The whole stack must be usable.
+    stack.memory[0] = 1;
+    stack.memory[size - 1] = 1;
+
+    // A hot stack can keep its guard page protected while it's in the pool.  If the
+    // hot part of the pool is full, the stack goes cold and gets unprotected instead.
+    checked_mprotect_page(stack.memory, PROT_NONE);
+    stack.guard_page_protected = true;
+    const int64_t pooled_before = pool->num_pooled_stacks();
+    const int64_t cold_before = pool->num_cold_pooled_stacks();
+    const size_t protected_before = pool->num_protected_pooled_stacks();
+    pool->release(stack);
+    ASSERT_EQ(stacks_before, pool->num_stacks());
+    ASSERT_EQ(pooled_before + 1, pool->num_pooled_stacks());
+    const bool went_cold = pool->num_cold_pooled_stacks() == cold_before + 1;
+    const bool kept_protection =
+        pool->num_protected_pooled_stacks() == protected_before + 1;
+    ASSERT_FALSE(went_cold && kept_protection);
+
+    coro_stack_pool_t::stack_memory_t reused = pool->acquire(size);
+    ASSERT_EQ(stack.memory, reused.memory);
+    ASSERT_EQ(kept_protection, reused.guard_page_protected);
+    ASSERT_EQ(protected_before, pool->num_protected_pooled_stacks());
+    ASSERT_EQ(pooled_before, pool->num_pooled_stacks());
+    pool->release(reused);
+}
+
+TEST(CoroStackPool, ColdStacksAreUnprotected) {
+    coro_stack_pool_t *pool = coro_stack_pool_t::get();
+    const size_t size = 3 * getpagesize();
+
+    // Fill up the hot part of the pool, so that the rest goes cold.
+    std::vector<coro_stack_pool_t::stack_memory_t> stacks;
+    for (int i = 0; i < COROUTINE_STACK_POOL_HOT_STACKS + 16; ++i) {
+        stacks.push_back(pool->acquire(size));
+        checked_mprotect_page(stacks.back().memory, PROT_NONE);
+        stacks.back().guard_page_protected = true;
+    }
+    const int64_t cold_before = pool->num_cold_pooled_stacks();
+    for (const auto &stack : stacks) {
+        pool->release(stack);
+    }
+    ASSERT_LE(cold_before + 16, pool->num_cold_pooled_stacks());
+    // The protected stacks in the pool count against MAX_PROTECTED_COROS, so it only
+    // keeps the protection of a few of them.
+    ASSERT_LE(pool->num_protected_pooled_stacks(), MAX_PROTECTED_COROS / 4);
+
+    // Whatever we get back, hot or cold, must say whether its guard page is
+    // protected, and its other pages must be usable.
+    for (auto &stack : stacks) {
+        stack = pool->acquire(size);
+        stack.memory[size - 1] = 1;
+        if (!stack.guard_page_protected) {
+            stack.memory[0] = 1;
+        }
+    }
+    for (const auto &stack : stacks) {
+        pool->release(stack);
+    }
+}
+
+void spawn_and_finish_coroutines(int count) {
+    std::vector<cond_t> started(count);
+    cond_t finish;
+    for (int i = 0; i < count; ++i) {
+        coro_t::spawn_sometime([&started, &finish, i]() {
+            started[i].pulse();
+            finish.wait();
+        });
+    }
+    for (auto &cond : started) {
+        cond.wait();
+    }
+    finish.pulse();
+    // Let the coroutines finish.
+    nap(10);
+}
+
+TPTEST(CoroStackPool, BurstsReuseStacks, 2) {
+    coro_stack_pool_t *pool = coro_stack_pool_t::get();
+    const int burst = 500;
+
+    // Most of the coroutines from a burst get destroyed afterwards, so their stacks
+    // end up in the pool.
+    const int64_t pooled_before = pool->num_pooled_stacks();
+    spawn_and_finish_coroutines(burst);
+    ASSERT_GT(pool->num_pooled_stacks(), pooled_before);
+}
+
+}  // namespace unittest
+
+#endif  // _WIN32
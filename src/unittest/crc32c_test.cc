@@ -0,0 +1,31 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#include <string>
+
+#include "crc32c.hpp"
+#include "unittest/gtest.hpp"
+#include "unittest/unittest_utils.hpp"
+
+namespace unittest {
+
+TEST(Crc32cTest, KnownValues) {
+    EXPECT_EQ(0u, crc32c("", 0));
+    EXPECT_EQ(0xe3069283u, crc32c("123456789", 9));
+    // From RFC 3720, appendix B.4.
+    std::string zeros(32, '\0');
+    EXPECT_EQ(0x8a9136aau, crc32c(zeros.data(), zeros.size()));
+    std::string ones(32, '\xff');
+    EXPECT_EQ(0x62a8ab43u, crc32c(ones.data(), ones.size()));
+}
+
+TEST(Crc32cTest, Incremental) {
+    // Covers both the 8 byte and the single byte steps, at every alignment.
+    std::string data = rand_string(1000);
+    const uint32_t expected = crc32c(data.data(), data.size());
+    for (size_t split = 0; split <= 17; ++split) {
+        uint32_t crc = crc32c(data.data(), split);
+        crc = crc32c(data.data() + split, data.size() - split, crc);
+        EXPECT_EQ(expected, crc);
+    }
+}
+
+}  // namespace unittest
@@ -0,0 +1,113 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#include <map>
+#include <vector>
+
+#include "rdb_protocol/datum_hash_map.hpp"
+#include "rdb_protocol/pseudo_time.hpp"
+#include "rdb_protocol/shards.hpp"
+#include "unittest/gtest.hpp"
+
+namespace unittest {
+
+ql::datum_t make_group_key(int i) {
+    switch (i % 4) {
+    case 0: return ql::datum_t(static_cast<double>(i));
+    case 1: return ql::datum_t(datum_string_t(strprintf("group %d", i)));
+    case 2: {
+        std::vector<ql::datum_t> array;
+        array.push_back(ql::datum_t(static_cast<double>(i)));
+        array.push_back(ql::datum_t::boolean(i % 3 == 0));
+        return ql::datum_t(std::move(array), ql::configured_limits_t());
+    }
+    default: {
+        ql::datum_object_builder_t object;
+        object.overwrite("id", ql::datum_t(static_cast<double>(i)));
+        object.overwrite("name", ql::datum_t("group"));
+        return std::move(object).to_datum();
+    }
+    }
+}
+
+TEST(DatumHashMap, EqualDatumsHashEqually) {
+    ASSERT_EQ(ql::datum_t(0.0).hash(), ql::datum_t(-0.0).hash());
+    ASSERT_EQ(ql::pseudo::make_time(1000.0, "+00:00").hash(),
+              ql::pseudo::make_time(1000.0, "-07:00").hash());
+    ASSERT_NE(ql::pseudo::make_time(1000.0, "+00:00").hash(),
+              ql::pseudo::make_time(1001.0, "+00:00").hash());
+
+    ql::datum_object_builder_t a, b;
+    a.overwrite("x", ql::datum_t(1.0));
+    a.overwrite("y", ql::datum_t("y"));
+    b.overwrite("y", ql::datum_t("y"));
+    b.overwrite("x", ql::datum_t(1.0));
+    ASSERT_EQ(std::move(a).to_datum().hash(), std::move(b).to_datum().hash());
+
+    // Datums that are equal across types still get different hashes.
+    ASSERT_NE(ql::datum_t(1.0).hash(), ql::datum_t("1").hash());
+    ASSERT_NE(ql::datum_t::null().hash(), ql::datum_t::boolean(false).hash());
+    for (int i = 0; i < 1000; ++i) {
+        ASSERT_EQ(make_group_key(i).hash(), make_group_key(i).hash());
+        ASSERT_NE(make_group_key(i).hash(), make_group_key(i + 4).hash());
+    }
+}
+
+TEST(DatumHashMap, SameAsMap) {
+    ql::datum_hash_map_t<int> hash_map;
+    std::map<ql::datum_t, int, optional_datum_less_t> map;
+    for (int i = 0; i < 5000; ++i) {
+        // Every key gets inserted a few times, and some of them get erased right
+        // after they are inserted, like groups that didn't keep any rows.
+        ql::datum_t key = i % 7 == 0 ? ql::datum_t() : make_group_key(i % 1500);
+        auto res = hash_map.insert(key, 0);
+        auto map_res = map.insert(std::make_pair(key, 0));
+        ASSERT_EQ(map_res.second, res.second);
+        if (res.second && i % 5 == 0) {
+            hash_map.erase_last();
+            map.erase(map_res.first);
+        } else {
+            *res.first += i;
+            map_res.first->second += i;
+        }
+        ASSERT_EQ(map.size(), hash_map.size());
+    }
+    for (const auto &pair : map) {
+        const int *value = hash_map.find(pair.first);
+        ASSERT_TRUE(value != nullptr);
+        ASSERT_EQ(pair.second, *value);
+    }
+    ASSERT_TRUE(hash_map.find(make_group_key(1500)) == nullptr);
+
+    std::vector<std::pair<ql::datum_t, int> > sorted = hash_map.release_sorted();
+    ASSERT_EQ(0u, hash_map.size());
+    std::vector<std::pair<ql::datum_t, int> > expected(map.begin(), map.end());
+    ASSERT_EQ(expected, sorted);
+}
+
+std::vector<ql::datum_t> shard_distinct(const std::vector<double> &values) {
+    scoped_ptr_t<ql::op_t> op = ql::make_op(ql::distinct_wire_func_t(false));
+    ql::groups_t groups;
+    for (double d : values) {
+        groups[ql::datum_t()].push_back(ql::datum_t(d));
+    }
+    (*op)(nullptr, &groups, []() { return ql::datum_t(); });
+    return groups[ql::datum_t()];
+}
+
+std::vector<ql::datum_t> datums(const std::vector<double> &values) {
+    std::vector<ql::datum_t> res;
+    for (double d : values) {
+        res.push_back(ql::datum_t(d));
+    }
+    return res;
+}
+
+TEST(DatumHashMap, ShardDistinct) {
+    ASSERT_EQ(datums({1, 2, 3}), shard_distinct({1, 1, 2, 2, 2, 3}));
+    ASSERT_EQ(datums({3, 2, 1}), shard_distinct({3, 3, 2, 1, 1}));
+    // Once the values turn out not to be sorted, the ones that aren't adjacent are
+    // dropped too.
+    ASSERT_EQ(datums({1, 2, 3}), shard_distinct({1, 2, 1, 3, 2, 1, 3}));
+    ASSERT_EQ(datums({2, 1, 3}), shard_distinct({2, 1, 1, 3, 2, 3}));
+}
+
+}  // namespace unittest
@@ -1,7 +1,10 @@
 // Copyright 2010-2013 RethinkDB, all rights reserved.
 
+#include <stdlib.h>
+
 #include "containers/archive/string_stream.hpp"
 #include "rdb_protocol/datum.hpp"
+#include "rdb_protocol/datum_json_writer.hpp"
 #include "rdb_protocol/datum_string.hpp"
 #include "rdb_protocol/env.hpp"
 #include "unittest/gtest.hpp"
@@ -205,4 +208,62 @@ TEST(DatumTest, OffsetScaling) {
     }
 }
 
+typedef rapidjson::Writer<rapidjson::StringBuffer> rapidjson_writer_t;
+
+template <class json_writer_t>
+std::string datum_to_json(const ql::datum_t &datum) {
+    rapidjson::StringBuffer buffer;
+    json_writer_t writer(buffer);
+    datum.write_json(&writer);
+    return std::string(buffer.GetString(), buffer.GetSize());
+}
+
+TEST(DatumTest, JSONWriter) {
+    // Strings with characters that need escaping in different places, so that both
+    // the SIMD scans and their tails find them.
+    std::string all_chars;
+    for (int c = 0; c < 256; ++c) {
+        all_chars.push_back(static_cast<char>(c));
+    }
+    std::vector<std::string> strings = {"", "plain", all_chars};
+    for (size_t size : {1, 15, 16, 17, 31, 32, 33, 64, 100}) {
+        for (size_t i = 0; i < size; i += 3) {
+            for (char c : {'"', '\\', '\n', '\x01', '\x1f', '\x7f', '\xc3'}) {
+                std::string str(size, 'x');
+                str[i] = c;
+                strings.push_back(str);
+            }
+        }
+    }
+    for (const std::string &str : strings) {
+        ql::datum_object_builder_t object;
+        object.overwrite(datum_string_t(str), ql::datum_t(datum_string_t(str)));
+        ql::datum_t datum = std::move(object).to_datum();
+        ASSERT_EQ(datum_to_json<rapidjson_writer_t>(datum),
+                  datum_to_json<ql::datum_json_writer_t>(datum));
+    }
+
+    // Short doubles get written like rapidjson would write them.
+    for (double d : {0.5, -0.25, 12.99, 0.1, 0.3, 1.0 / 1024, 1e-5, 1.5e-5,
+                     123456.789, -99999999999.5, 52.520008}) {
+        ql::datum_t datum(d);
+        ASSERT_EQ(datum_to_json<rapidjson_writer_t>(datum),
+                  datum_to_json<ql::datum_json_writer_t>(datum));
+    }
+
+    // Other doubles might come out shorter, but they have to parse back to the same
+    // value.
+    for (double d : {1.0 / 3, -2.0 / 3, 1e-6, 1e-300, 1e300, 1e12 + 0.5, 1e15,
+                     9007199254740993.0, -0.0, 4.35, 0.8345359999999999}) {
+        for (double scale : {1.0, 7.0, 1.0 / 7, 1e-3, 1e3}) {
+            const double value = d * scale;
+            const std::string json =
+                datum_to_json<ql::datum_json_writer_t>(ql::datum_t(value));
+            ASSERT_EQ(value, strtod(json.c_str(), nullptr)) << json;
+            ASSERT_LE(json.size(),
+                      datum_to_json<rapidjson_writer_t>(ql::datum_t(value)).size());
+        }
+    }
+}
+
 }  // namespace unittest
@@ -1,5 +1,15 @@
+#include <set>
+
+#include "concurrency/new_mutex.hpp"
+#include "perfmon/perfmon.hpp"
+#include "random.hpp"
+#include "rdb_protocol/datum.hpp"
+#include "serializer/buf_ptr.hpp"
 #include "serializer/log/data_block_manager.hpp"
+#include "serializer/log/log_serializer.hpp"
 #include "unittest/gtest.hpp"
+#include "unittest/mock_file.hpp"
+#include "unittest/unittest_utils.hpp"
 
 namespace unittest {
 
@@ -48,6 +58,98 @@ TEST(DBMTest, ReadAheadInterval) {
     ASSERT_EQ(100, end_offset);
 }
 
+struct dbm_write_cond_t : public iocallback_t, public cond_t {
+    void on_io_complete() {
+        pulse();
+    }
+};
+
+/* Writes the blocks in `block_ids`, using one buffer of `bufs` for each, and puts
+them in the index. */
+void write_block_ids(log_serializer_t *ser, file_account_t *account,
+                     const std::vector<block_id_t> &block_ids,
+                     const std::vector<buf_ptr_t> &bufs) {
+    std::vector<buf_write_info_t> infos;
+    for (size_t i = 0; i < block_ids.size(); ++i) {
+        infos.push_back(buf_write_info_t(bufs[i].ser_buffer(), bufs[i].block_size(),
+                                         block_ids[i]));
+    }
+    dbm_write_cond_t cb;
+    std::vector<counted_t<block_token_t>> tokens
+        = ser->block_writes(infos, account, &cb);
+    cb.wait();
+
+    std::vector<index_write_op_t> write_ops;
+    for (size_t i = 0; i < tokens.size(); ++i) {
+        write_ops.push_back(index_write_op_t(block_ids[i], make_optional(tokens[i]),
+            make_optional(repli_timestamp_t::distant_past)));
+    }
+    new_mutex_in_line_t dummy_acq;
+    ser->index_write(&dummy_acq, []{ }, write_ops);
+}
+
+/* Runs a workload in which 90% of the updates go to 10% of the blocks, and returns
+the resulting write amplification. */
+double run_skewed_workload(bool age_aware_gc) {
+    const block_id_t num_blocks = 4000;
+    const block_id_t num_hot_blocks = num_blocks / 10;
+    const int num_updates = 40000;
+    const size_t batch_size = 16;
+
+    mock_file_opener_t file_opener;
+    log_serializer_t::static_config_t static_config;
+    // Small extents, so that the workload goes through plenty of them.
+    static_config.extent_size_ = 16 * static_config.block_size_;
+    log_serializer_t::create(&file_opener, static_config);
+
+    log_serializer_t::dynamic_config_t dynamic_config;
+    dynamic_config.read_ahead = false;
+    dynamic_config.age_aware_gc = age_aware_gc;
+    perfmon_collection_t stats;
+    log_serializer_t ser(dynamic_config, &file_opener, &stats);
+    scoped_ptr_t<file_account_t> account(ser.make_io_account(1));
 
+    std::vector<buf_ptr_t> bufs;
+    for (size_t i = 0; i < batch_size; ++i) {
+        bufs.push_back(buf_ptr_t::alloc_zeroed(ser.max_block_size()));
+    }
+
+    std::vector<block_id_t> block_ids;
+    for (block_id_t i = 0; i < num_blocks; ++i) {
+        block_ids.push_back(i);
+        if (block_ids.size() == batch_size) {
+            write_block_ids(&ser, account.get(), block_ids, bufs);
+            block_ids.clear();
+        }
+    }
+
+    // Use the same sequence of updates for both GC policies.
+    rng_t rng(1234);
+    for (int i = 0; i < num_updates; i += batch_size) {
+        std::set<block_id_t> batch;
+        while (batch.size() < batch_size) {
+            batch.insert(rng.randint(10) != 0
+                         ? rng.randint(num_hot_blocks)
+                         : num_hot_blocks + rng.randint(num_blocks - num_hot_blocks));
+        }
+        write_block_ids(&ser, account.get(),
+                        std::vector<block_id_t>(batch.begin(), batch.end()), bufs);
+    }
+
+    void *ctx = stats.begin_stats();
+    stats.visit_stats(ctx);
+    ql::datum_t result = stats.end_stats(ctx);
+    return result.get_field("serializer")
+        .get_field("serializer_write_amplification").as_num();
+}
+
+/* Compares the write amplification of cost-benefit GC with hot/cold separation
+against that of always collecting the extent with the most garbage. */
+TPTEST(DBMTest, SkewedWorkloadWriteAmplification) {
+    const double greedy = run_skewed_workload(false);
+    const double age_aware = run_skewed_workload(true);
+    ASSERT_GE(greedy, 1.0);
+    ASSERT_LT(age_aware, greedy);
+}
 
 }  // namespace unittest
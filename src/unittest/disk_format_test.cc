@@ -56,8 +56,9 @@ TEST(DiskFormatTest, LbaMetablockMixinT) {
 }
 
 TEST(DiskFormatTest, LbaEntryT) {
-    EXPECT_EQ(0u, offsetof(lba_entry_t, zero_reserved));
+    EXPECT_EQ(0u, offsetof(lba_entry_t, block_checksum));
     EXPECT_EQ(4u, offsetof(lba_entry_t, ser_block_size));
+    EXPECT_EQ(6u, offsetof(lba_entry_t, disk_block_size));
     EXPECT_EQ(8u, offsetof(lba_entry_t, block_id));
     EXPECT_EQ(16u, offsetof(lba_entry_t, recency));
     EXPECT_EQ(24u, offsetof(lba_entry_t, offset));
@@ -69,14 +70,30 @@ TEST(DiskFormatTest, LbaEntryT) {
     ASSERT_TRUE(lba_entry_t::is_padding(&ent));
     flagged_off64_t real = flagged_off64_t::unused();
     real = flagged_off64_t::make(1);
-    ent = lba_entry_t::make(1, repli_timestamp_t::invalid, real, 1234);
+    ent = lba_entry_t::make(1, repli_timestamp_t::invalid, real, 1234, 0, 0xabcd);
     ASSERT_FALSE(lba_entry_t::is_padding(&ent));
     flagged_off64_t deleteblock = flagged_off64_t::unused();
     deleteblock = flagged_off64_t::make(1);
-    ent = lba_entry_t::make(1, repli_timestamp_t::invalid, deleteblock, 1234);
+    ent = lba_entry_t::make(1, repli_timestamp_t::invalid, deleteblock, 1234, 0,
+                            NO_BLOCK_CHECKSUM);
     ASSERT_FALSE(lba_entry_t::is_padding(&ent));
 }
 
+TEST(DiskFormatTest, LbaEntryTOldFormat) {
+    // Older versions wrote a zero uint32_t and then a uint32_t ser_block_size at
+    // the start of the entry.
+    lba_entry_t ent = lba_entry_t::make(1, repli_timestamp_t::invalid,
+                                        flagged_off64_t::make(1), 1, 1, 1);
+    const uint32_t zero = 0;
+    const uint32_t old_ser_block_size = 4096;
+    memcpy(reinterpret_cast<char *>(&ent), &zero, sizeof(zero));
+    memcpy(reinterpret_cast<char *>(&ent) + 4, &old_ser_block_size,
+           sizeof(old_ser_block_size));
+    EXPECT_EQ(NO_BLOCK_CHECKSUM, ent.block_checksum);
+    EXPECT_EQ(4096u, ent.ser_block_size);
+    EXPECT_EQ(0u, ent.disk_block_size);
+}
+
 TEST(DiskFormatTest, LbaExtentT) {
     EXPECT_EQ(32u, sizeof(lba_extent_t::header_t));
 
@@ -0,0 +1,217 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#include "arch/io/disk/uring.hpp"
+
+#if USE_IO_URING
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include "arch/runtime/thread_pool.hpp"
+#include "concurrency/cond_var.hpp"
+#include "config/args.hpp"
+#include "containers/scoped.hpp"
+#include "unittest/gtest.hpp"
+#include "unittest/unittest_utils.hpp"
+
+namespace unittest {
+
+/* The `uring_test_driver_t` plays the role of the rest of the disk manager stack: it
+pushes actions into the source queue of a `uring_diskmgr_t` and waits for them to come
+back through `done_fun`. */
+struct uring_test_driver_t {
+    typedef uring_diskmgr_t::action_t action_t;
+
+    explicit uring_test_driver_t(int max_concurrent_io_requests)
+        : fd(open(file.name().permanent_path().c_str(), O_RDWR | O_CREAT, 0644)),
+          diskmgr(&linux_thread_pool_t::get_thread()->queue, &source,
+                  max_concurrent_io_requests) {
+        guarantee_err(fd.get() != INVALID_FD, "Could not open test file");
+        diskmgr.done_fun = std::bind(&uring_test_driver_t::on_done, this, ph::_1);
+    }
+
+    action_t *make_action() {
+        allocated_actions.push_back(make_scoped<action_t>());
+        return allocated_actions.back().get();
+    }
+
+    void submit(action_t *a) {
+        done_conds[a].init(new cond_t);
+        source.push(a);
+    }
+
+    void wait_for(action_t *a) {
+        done_conds[a]->wait();
+    }
+
+    // Submits the action and blocks until it is done.
+    void run(action_t *a) {
+        submit(a);
+        wait_for(a);
+    }
+
+    int64_t file_size() {
+        struct stat st;
+        int res = fstat(fd.get(), &st);
+        guarantee_err(res == 0, "fstat failed");
+        return st.st_size;
+    }
+
+    void on_done(action_t *a) {
+        done_conds[a]->pulse();
+    }
+
+    temp_file_t file;
+    scoped_fd_t fd;
+    std::vector<scoped_ptr_t<action_t> > allocated_actions;
+    std::map<action_t *, scoped_ptr_t<cond_t> > done_conds;
+    unlimited_fifo_queue_t<action_t *> source;
+    uring_diskmgr_t diskmgr;
+};
+
+/* `io_uring` might be disabled or unavailable on the machine running the tests, in
+which case there's nothing to test. */
+#define SKIP_IF_IO_URING_UNSUPPORTED() do {                             \
+        if (!uring_diskmgr_t::is_supported()) {                         \
+            fprintf(stderr, "io_uring is not supported, skipping.\n");  \
+            return;                                                     \
+        }                                                               \
+    } while (0)
+
+/* WriteRead verifies that data written through the ring can be read back. */
+
+TPTEST(DiskUringTest, WriteRead) {
+    SKIP_IF_IO_URING_UNSUPPORTED();
+    uring_test_driver_t d(4);
+
+    std::string data = rand_string(3 * DEVICE_BLOCK_SIZE);
+    uring_test_driver_t::action_t *w = d.make_action();
+    w->make_write(d.fd.get(), data.data(), data.size(), 0, false);
+    d.run(w);
+    ASSERT_TRUE(w->get_succeeded());
+
+    std::vector<char> buf(data.size());
+    uring_test_driver_t::action_t *r = d.make_action();
+    r->make_read(d.fd.get(), buf.data(), buf.size(), 0);
+    d.run(r);
+    ASSERT_TRUE(r->get_succeeded());
+    ASSERT_EQ(data, std::string(buf.data(), buf.size()));
+}
+
+/* WritevDatasyncs verifies vectored writes, wrapped in datasyncs. */
+
+TPTEST(DiskUringTest, WritevDatasyncs) {
+    SKIP_IF_IO_URING_UNSUPPORTED();
+    uring_test_driver_t d(4);
+
+    std::string part1 = rand_string(DEVICE_BLOCK_SIZE);
+    std::string part2 = rand_string(2 * DEVICE_BLOCK_SIZE);
+    scoped_array_t<iovec> vecs(2);
+    vecs[0].iov_base = const_cast<char *>(part1.data());
+    vecs[0].iov_len = part1.size();
+    vecs[1].iov_base = const_cast<char *>(part2.data());
+    vecs[1].iov_len = part2.size();
+
+    uring_test_driver_t::action_t *w = d.make_action();
+    w->make_writev(d.fd.get(), std::move(vecs), part1.size() + part2.size(),
+                   DEVICE_BLOCK_SIZE);
+    d.run(w);
+    ASSERT_TRUE(w->get_succeeded());
+
+    uring_test_driver_t::action_t *w2 = d.make_action();
+    w2->make_write(d.fd.get(), part1.data(), part1.size(), 0, true);
+    d.run(w2);
+    ASSERT_TRUE(w2->get_succeeded());
+
+    std::vector<char> buf(4 * DEVICE_BLOCK_SIZE);
+    uring_test_driver_t::action_t *r = d.make_action();
+    r->make_read(d.fd.get(), buf.data(), buf.size(), 0);
+    d.run(r);
+    ASSERT_TRUE(r->get_succeeded());
+    ASSERT_EQ(part1 + part1 + part2, std::string(buf.data(), buf.size()));
+}
+
+/* Resize verifies that growing (through `fallocate`) and shrinking (through the
+fallback pool) both change the file size. */
+
+TPTEST(DiskUringTest, Resize) {
+    SKIP_IF_IO_URING_UNSUPPORTED();
+    uring_test_driver_t d(4);
+
+    uring_test_driver_t::action_t *grow = d.make_action();
+    grow->make_resize(d.fd.get(), 0, 4 * DEVICE_BLOCK_SIZE, true);
+    d.run(grow);
+    ASSERT_TRUE(grow->get_succeeded());
+    ASSERT_EQ(4 * DEVICE_BLOCK_SIZE, d.file_size());
+
+    uring_test_driver_t::action_t *unchanged = d.make_action();
+    unchanged->make_resize(d.fd.get(), 4 * DEVICE_BLOCK_SIZE, 4 * DEVICE_BLOCK_SIZE,
+                           false);
+    d.run(unchanged);
+    ASSERT_TRUE(unchanged->get_succeeded());
+    ASSERT_EQ(4 * DEVICE_BLOCK_SIZE, d.file_size());
+
+    uring_test_driver_t::action_t *shrink = d.make_action();
+    shrink->make_resize(d.fd.get(), 4 * DEVICE_BLOCK_SIZE, DEVICE_BLOCK_SIZE, false);
+    d.run(shrink);
+    ASSERT_TRUE(shrink->get_succeeded());
+    ASSERT_EQ(DEVICE_BLOCK_SIZE, d.file_size());
+}
+
+/* ReadPastEnd verifies that errors are reported the same way as by the pool. */
+
+TPTEST(DiskUringTest, ReadPastEnd) {
+    SKIP_IF_IO_URING_UNSUPPORTED();
+    uring_test_driver_t d(4);
+
+    std::vector<char> buf(DEVICE_BLOCK_SIZE);
+    uring_test_driver_t::action_t *r = d.make_action();
+    r->make_read(d.fd.get(), buf.data(), buf.size(), 0);
+    d.run(r);
+    ASSERT_FALSE(r->get_succeeded());
+    ASSERT_EQ(EINVAL, r->get_io_errno());
+}
+
+/* ManyConcurrent submits many more actions than the ring allows in flight, and
+verifies that they all complete. */
+
+TPTEST(DiskUringTest, ManyConcurrent) {
+    SKIP_IF_IO_URING_UNSUPPORTED();
+    uring_test_driver_t d(8);
+
+    const int num_blocks = 256;
+    std::vector<std::string> blocks;
+    blocks.reserve(num_blocks);
+    std::vector<uring_test_driver_t::action_t *> writes;
+    for (int i = 0; i < num_blocks; ++i) {
+        blocks.push_back(rand_string(DEVICE_BLOCK_SIZE));
+        uring_test_driver_t::action_t *w = d.make_action();
+        w->make_write(d.fd.get(), blocks.back().data(), DEVICE_BLOCK_SIZE,
+                      i * DEVICE_BLOCK_SIZE, false);
+        writes.push_back(w);
+        d.submit(w);
+    }
+    for (uring_test_driver_t::action_t *w : writes) {
+        d.wait_for(w);
+        ASSERT_TRUE(w->get_succeeded());
+    }
+
+    std::vector<char> buf(num_blocks * DEVICE_BLOCK_SIZE);
+    uring_test_driver_t::action_t *r = d.make_action();
+    r->make_read(d.fd.get(), buf.data(), buf.size(), 0);
+    d.run(r);
+    ASSERT_TRUE(r->get_succeeded());
+    for (int i = 0; i < num_blocks; ++i) {
+        ASSERT_EQ(blocks[i], std::string(buf.data() + i * DEVICE_BLOCK_SIZE,
+                                         DEVICE_BLOCK_SIZE));
+    }
+}
+
+}  // namespace unittest
+
+#endif  // USE_IO_URING
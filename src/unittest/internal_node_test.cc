@@ -5,7 +5,10 @@
 #include "unittest/gtest.hpp"
 
 #include "btree/internal_node.hpp"
+#include "btree/internal_node_search.hpp"
 #include "btree/node.hpp"
+#include "containers/scoped.hpp"
+#include "random.hpp"
 
 namespace unittest {
 
@@ -61,6 +64,70 @@ TEST(InternalNodeTest, Offsets) {
     EXPECT_EQ(9u, sizeof(btree_internal_pair));
 }
 
+// Makes a key out of the letters 'a' and 'b', so that many keys share their first
+// eight bytes.
+store_key_t random_ab_key(rng_t *rng, int max_size) {
+    std::string s(rng->randint(max_size + 1), 'a');
+    for (char &c : s) {
+        c = 'a' + rng->randint(2);
+    }
+    return store_key_t(s);
+}
+
+// Fills `node` with random keys until it's full.
+void fill_internal_node(block_size_t block_size, internal_node_t *node, rng_t *rng,
+                        int max_key_size) {
+    internal_node::init(block_size, node);
+    block_id_t next_id = 1;
+    for (;;) {
+        store_key_t key = random_ab_key(rng, max_key_size);
+        if (key.size() == 0) {
+            continue;
+        }
+        if (node->npairs > 0) {
+            int index = internal_node::get_offset_index(node, key.btree_key());
+            if (btree_key_cmp(&internal_node::get_pair_by_index(node, index)->key,
+                              key.btree_key()) == 0) {
+                continue;
+            }
+        }
+        if (!internal_node::insert(node, key.btree_key(), next_id, next_id + 1)) {
+            break;
+        }
+        next_id += 2;
+    }
+    verify(block_size, node);
+}
+
+TEST(InternalNodeTest, SearchIndex) {
+    const block_size_t block_size = block_size_t::unsafe_make(4096);
+    rng_t rng;
+    for (int max_key_size : {1, 8, 9, 16, 40, MAX_KEY_SIZE}) {
+        SCOPED_TRACE(max_key_size);
+        scoped_malloc_t<internal_node_t> node(block_size.value());
+        fill_internal_node(block_size, node.get(), &rng, max_key_size);
+        internal_node_search_index_t index(node.get());
+        // The page cache counts the index towards the node's memory usage.
+        ASSERT_LE(sizeof(index) + (node->npairs - 1) * sizeof(int64_t),
+                  index.memory_usage());
+
+        for (int i = 0; i < 10000; ++i) {
+            store_key_t key = random_ab_key(&rng, std::min(max_key_size + 1, MAX_KEY_SIZE));
+            ASSERT_EQ(internal_node::get_offset_index(node.get(), key.btree_key()),
+                      index.get_offset_index(node.get(), key.btree_key()));
+        }
+        // The node's own keys, and keys at the extremes of the key heads.
+        for (int i = 0; i < node->npairs - 1; ++i) {
+            const btree_key_t *key = &internal_node::get_pair_by_index(node.get(), i)->key;
+            ASSERT_EQ(i, index.get_offset_index(node.get(), key));
+        }
+        store_key_t min_key = store_key_t::min();
+        store_key_t max_key = store_key_t::max();
+        ASSERT_EQ(0, index.get_offset_index(node.get(), min_key.btree_key()));
+        ASSERT_EQ(internal_node::get_offset_index(node.get(), max_key.btree_key()),
+                  index.get_offset_index(node.get(), max_key.btree_key()));
+    }
+}
 
 }  // namespace unittest
 
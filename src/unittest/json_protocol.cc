@@ -0,0 +1,69 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#include <string>
+
+#include "client_protocol/json.hpp"
+#include "containers/archive/string_stream.hpp"
+#include "rapidjson/stringbuffer.h"
+#include "rdb_protocol/response.hpp"
+#include "unittest/gtest.hpp"
+#include "unittest/unittest_utils.hpp"
+
+namespace unittest {
+
+ql::datum_t make_response_row(int i) {
+    ql::datum_object_builder_t row;
+    row.overwrite("id", ql::datum_t(static_cast<double>(i)));
+    row.overwrite("name", ql::datum_t(strprintf("row %d", i).c_str()));
+    row.overwrite("ratio", ql::datum_t(i / 7.0));
+    return std::move(row).to_datum();
+}
+
+void fill_response(int num_rows, ql::response_t *response) {
+    std::vector<ql::datum_t> rows;
+    for (int i = 0; i < num_rows; ++i) {
+        rows.push_back(make_response_row(i));
+    }
+    response->set_type(Response::SUCCESS_PARTIAL);
+    response->set_data(std::move(rows));
+    response->add_note(Response::SEQUENCE_FEED);
+}
+
+// What `json_protocol_t::send_response` writes when it encodes the whole response
+// into a buffer.
+std::string buffered_response(int64_t token, ql::response_t *response) {
+    const size_t prefix_size = sizeof(int64_t) + sizeof(uint32_t);
+    rapidjson::StringBuffer buffer;
+    buffer.Push(prefix_size);
+    json_protocol_t::write_response_to_buffer(response, &buffer);
+    const uint32_t data_size = buffer.GetSize() - prefix_size;
+
+    std::string res(buffer.GetString(), buffer.GetSize());
+    memcpy(&res[0], &token, sizeof(token));
+    memcpy(&res[sizeof(token)], &data_size, sizeof(data_size));
+    return res;
+}
+
+TPTEST_MULTITHREAD(JSONProtocol, ChunkedResponse, 4) {
+    // With fewer rows than threads, some of the threads' slices are empty.
+    for (int num_rows : {0, 2, 10, 501, 5000}) {
+        ql::response_t response;
+        fill_response(num_rows, &response);
+
+        string_stream_t stream;
+        ASSERT_TRUE(json_protocol_t::write_response_in_chunks(&response, 12, &stream));
+        ASSERT_EQ(buffered_response(12, &response), stream.str());
+    }
+
+    // Responses that can't be encoded are left to `send_response`, which sends an
+    // error instead.
+    ql::response_t response;
+    fill_response(1000, &response);
+    std::vector<ql::datum_t> rows = response.data();
+    rows.push_back(ql::datum_t::minval());
+    response.set_data(std::move(rows));
+    string_stream_t stream;
+    ASSERT_FALSE(json_protocol_t::write_response_in_chunks(&response, 12, &stream));
+    ASSERT_TRUE(stream.str().empty());
+}
+
+}  // namespace unittest
@@ -210,6 +210,37 @@ public:
         // leaf::print(stdout, &sizer_, node());
     }
 
+    // Checks the key search functions against kv_ for a key that might or might not
+    // be in the node.
+    void VerifyLookup(const store_key_t &key) {
+        SCOPED_TRACE("VerifyLookup " + key_to_debug_str(key));
+        short_value_buffer_t value_buf(std::string(""));
+        auto it = kv_.find(key);
+        ASSERT_EQ(it != kv_.end(),
+                  leaf::lookup(&sizer_, node(), key.btree_key(), value_buf.data()));
+        if (it != kv_.end()) {
+            ASSERT_EQ(it->second, value_buf.as_str());
+        }
+
+        auto lower = kv_.lower_bound(key);
+        leaf_node_t::iterator leaf_lower = leaf::inclusive_lower_bound(key.btree_key(), *node());
+        if (lower == kv_.end()) {
+            ASSERT_TRUE(leaf_lower == leaf::end(*node()));
+        } else {
+            ASSERT_TRUE(leaf_lower != leaf::end(*node()));
+            ASSERT_EQ(0, btree_key_cmp(lower->first.btree_key(), (*leaf_lower).first));
+        }
+
+        leaf_node_t::reverse_iterator leaf_upper = leaf::exclusive_upper_bound(key.btree_key(), *node());
+        if (lower == kv_.begin()) {
+            ASSERT_TRUE(leaf_upper == leaf::rend(*node()));
+        } else {
+            --lower;
+            ASSERT_TRUE(leaf_upper != leaf::rend(*node()));
+            ASSERT_EQ(0, btree_key_cmp(lower->first.btree_key(), (*leaf_upper).first));
+        }
+    }
+
     void printmap(const std::map<store_key_t, std::string>& m) {
         for (std::map<store_key_t, std::string>::const_iterator p = m.begin(), q = m.end(); p != q; ++p) {
             printf("%s: %s;", key_to_debug_str(p->first).c_str(), p->second.c_str());
@@ -389,6 +420,40 @@ TEST(LeafNodeTest, RandomOutOfOrder) {
     }
 }
 
+/* Keys that share long prefixes, like secondary index keys do, exercise the prefix
+skipping in the key search. */
+std::vector<store_key_t> make_long_prefix_keys(rng_t *rng, int num_keys) {
+    std::string prefix = random_letter_string(rng, 0, 220);
+    std::vector<store_key_t> keys;
+    for (int i = 0; i < num_keys; ++i) {
+        std::string key = prefix.substr(0, prefix.size() - rng->randint(std::min<size_t>(prefix.size(), 3) + 1))
+            + random_letter_string(rng, 0, 30);
+        keys.push_back(store_key_t(key.substr(0, MAX_KEY_SIZE)));
+    }
+    return keys;
+}
+
+TEST(LeafNodeTest, LongPrefixLookupFuzz) {
+    rng_t rng;
+    for (int try_num = 0; try_num < 20; ++try_num) {
+        LeafNodeTracker tracker;
+        std::vector<store_key_t> keys = make_long_prefix_keys(&rng, 60);
+        for (int i = 0; i < 2000; ++i) {
+            const store_key_t &key = keys[rng.randint(keys.size())];
+            if (rng.randint(3) == 0) {
+                if (tracker.ShouldHave(key)) {
+                    tracker.Remove(key);
+                }
+            } else {
+                tracker.Insert(key, random_letter_string(&rng, 0, 20));
+            }
+            for (int j = 0; j < 4; ++j) {
+                tracker.VerifyLookup(keys[rng.randint(keys.size())]);
+            }
+        }
+    }
+}
+
 TEST(LeafNodeTest, RandomOutOfOrderLowTstamp) {
     for (int try_num = 0; try_num < 10; ++try_num) {
         // In contrast to RandomOutOfOrder, we use a fixed tstamp of 0
@@ -0,0 +1,78 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#include <functional>
+#include <vector>
+
+#include "arch/runtime/coroutines.hpp"
+#include "arch/runtime/runtime.hpp"
+#include "concurrency/cond_var.hpp"
+#include "concurrency/pmap.hpp"
+#include "unittest/gtest.hpp"
+#include "unittest/unittest_utils.hpp"
+
+namespace unittest {
+
+// Collects ordered messages from all other threads on thread 0.
+class ordered_receiver_t : public home_thread_mixin_t {
+public:
+    ordered_receiver_t(int num_senders, int messages_per_sender)
+        : next_seq_(num_senders, 0),
+          remaining_(num_senders * messages_per_sender) { }
+
+    void receive(int sender, int seq) {
+        assert_thread();
+        // Messages from each sender must arrive in the order they were sent.
+        ASSERT_EQ(next_seq_[sender], seq);
+        ++next_seq_[sender];
+        --remaining_;
+        if (remaining_ == 0) {
+            done.pulse();
+        }
+    }
+
+    cond_t done;
+
+private:
+    std::vector<int> next_seq_;
+    int remaining_;
+};
+
+class ordered_msg_t : public linux_thread_message_t {
+public:
+    ordered_msg_t(ordered_receiver_t *receiver, int sender, int seq)
+        : receiver_(receiver), sender_(sender), seq_(seq) { }
+
+    void on_thread_switch() {
+        receiver_->receive(sender_, seq_);
+        delete this;
+    }
+
+private:
+    ordered_receiver_t *receiver_;
+    int sender_;
+    int seq_;
+};
+
+TPTEST(MessageHub, OrderedFromManyThreads, 8) {
+    const int num_senders = get_num_threads() - 1;
+    const int messages_per_sender = 20000;
+    on_thread_t thread_switcher((threadnum_t(0)));
+    ordered_receiver_t receiver(num_senders, messages_per_sender);
+
+    pmap(num_senders, [&](int sender) {
+        on_thread_t sender_thread((threadnum_t(sender + 1)));
+        for (int seq = 0; seq < messages_per_sender; ++seq) {
+            // Yielding now and then lets the event loop push the messages, so that
+            // they arrive in many batches of different sizes.
+            if (seq % (sender + 10) == 0) {
+                coro_t::yield();
+            }
+            bool same_thread = continue_on_thread(
+                threadnum_t(0), new ordered_msg_t(&receiver, sender, seq));
+            guarantee(!same_thread);
+        }
+    });
+
+    receiver.done.wait();
+}
+
+}  // namespace unittest
@@ -0,0 +1,52 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#include <functional>
+#include <vector>
+
+#include "arch/runtime/coroutines.hpp"
+#include "arch/runtime/migratable_section.hpp"
+#include "arch/runtime/runtime.hpp"
+#include "concurrency/cond_var.hpp"
+#include "unittest/gtest.hpp"
+#include "unittest/unittest_utils.hpp"
+
+namespace unittest {
+
+// Keeps a thread busy by yielding over and over, until `stop` is pulsed.
+void keep_busy(cond_t *stop, cond_t *stopped) {
+    while (!stop->is_pulsed()) {
+        coro_t::yield();
+    }
+    stopped->pulse();
+}
+
+TPTEST(MigratableSection, StaysWhileIdle, 4) {
+    on_thread_t thread_switcher((threadnum_t(0)));
+    migratable_section_t migratable;
+    for (int i = 0; i < 100; ++i) {
+        migratable.yield_point();
+        ASSERT_EQ(0, get_thread_id().threadnum);
+    }
+}
+
+TPTEST(MigratableSection, MovesAwayFromBusyThread, 4) {
+    on_thread_t thread_switcher((threadnum_t(0)));
+    cond_t stop, stopped;
+    coro_t::spawn_now_dangerously(std::bind(&keep_busy, &stop, &stopped));
+
+    bool moved = false;
+    {
+        migratable_section_t migratable;
+        for (int i = 0; i < 100 && !moved; ++i) {
+            migratable.yield_point();
+            moved = get_thread_id().threadnum != 0;
+        }
+    }
+    // The section always ends on the thread it began on.
+    ASSERT_EQ(0, get_thread_id().threadnum);
+    ASSERT_TRUE(moved);
+
+    stop.pulse();
+    stopped.wait();
+}
+
+}  // namespace unittest
@@ -7,6 +7,7 @@
 #include "concurrency/auto_drainer.hpp"
 #include "concurrency/pmap.hpp"
 #include "containers/scoped.hpp"
+#include "random.hpp"
 #include "serializer/log/log_serializer.hpp"
 #include "unittest/gtest.hpp"
 #include "unittest/mock_file.hpp"
@@ -52,8 +53,10 @@ class test_cache_t : public page_cache_t {
 public:
     test_cache_t(serializer_t *_serializer,
                  cache_balancer_t *balancer,
-                 alt_txn_throttler_t *throttler)
-        : page_cache_t(_serializer, balancer, throttler),
+                 alt_txn_throttler_t *throttler,
+                 alt::eviction_policy_t eviction_policy
+                     = alt::eviction_policy_t::scan_resistant)
+        : page_cache_t(_serializer, balancer, throttler, eviction_policy),
           throttler_(throttler) { }
 
     void flush(scoped_ptr_t<test_txn_t> txn) {
@@ -1181,4 +1184,85 @@ TPTEST(PageTest, BiggerTestNoMemory, 4) {
     test.run();
 }
 
+// Acquires the page for reading through `account` and returns true if it was already
+// in memory.
+bool read_page(test_cache_t *cache, page_txn_t *txn, block_id_t block_id,
+               cache_account_t *account) {
+    current_test_acq_t acq(txn, block_id, access_t::read);
+    page_acq_t page_acq;
+    page_acq.init(acq.current_page_acq_t::current_page_for_read(account), cache,
+                  account);
+    const bool hit = page_acq.buf_ready_signal()->is_pulsed();
+    page_acq.buf_ready_signal()->wait();
+    return hit;
+}
+
+/* Runs a trace that alternates between point reads of a small working set and scans
+through the rest of the blocks, with a cache that holds twice the working set.
+Returns the hit ratio of the point reads. */
+double run_scan_trace(alt::eviction_policy_t eviction_policy) {
+    const size_t num_blocks = 4000;
+    const size_t num_hot_blocks = 200;
+    const size_t point_reads_per_round = 2 * num_hot_blocks;
+    const size_t scan_length = 500;
+    const int warmup_rounds = 10;
+    const int measured_rounds = 10;
+
+    mock_ser_t mock;
+    std::vector<block_id_t> block_ids;
+    {
+        dummy_cache_balancer_t balancer(GIGABYTE);
+        test_cache_t cache(mock.ser.get(), &balancer, mock.throttler.get());
+        auto txn = make_scoped<test_txn_t>(&cache);
+        for (size_t i = 0; i < num_blocks; ++i) {
+            current_test_acq_t acq(txn.get(), alt_create_t::create);
+            test_acq_t page_acq;
+            page_acq.init(acq.current_page_for_write(), &cache);
+            memset(page_acq.get_buf_write(), 0, cache.max_block_size().value());
+            block_ids.push_back(acq.block_id());
+        }
+        cache.flush(std::move(txn));
+    }
+
+    dummy_cache_balancer_t balancer(
+        2 * num_hot_blocks * (mock.ser->max_block_size().ser_value() + 512));
+    test_cache_t cache(mock.ser.get(), &balancer, mock.throttler.get(),
+                       eviction_policy);
+    rng_t rng(1234);
+    size_t scan_position = num_hot_blocks;
+    size_t hits = 0;
+    size_t point_reads = 0;
+    for (int round = 0; round < warmup_rounds + measured_rounds; ++round) {
+        auto txn = make_scoped<test_txn_t>(&cache);
+        for (size_t i = 0; i < point_reads_per_round; ++i) {
+            const bool hit = read_page(&cache, txn.get(),
+                                       block_ids[rng.randsize(num_hot_blocks)],
+                                       cache.default_reads_account());
+            if (round >= warmup_rounds) {
+                hits += hit ? 1 : 0;
+                ++point_reads;
+            }
+        }
+        for (size_t i = 0; i < scan_length; ++i) {
+            read_page(&cache, txn.get(), block_ids[scan_position],
+                      cache.scan_reads_account());
+            ++scan_position;
+            if (scan_position == num_blocks) {
+                scan_position = num_hot_blocks;
+            }
+        }
+        cache.flush(std::move(txn));
+    }
+    return static_cast<double>(hits) / point_reads;
+}
+
+/* Compares the two eviction policies on a mix of point reads and scans. */
+TPTEST(PageTest, ScanResistantEviction) {
+    const double random_sampling
+        = run_scan_trace(alt::eviction_policy_t::random_sampling);
+    const double scan_resistant
+        = run_scan_trace(alt::eviction_policy_t::scan_resistant);
+    ASSERT_GT(scan_resistant, random_sampling);
+}
+
 }  // namespace unittest
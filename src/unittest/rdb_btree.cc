@@ -110,10 +110,13 @@ void spawn_writes(store_t *store, cond_t *background_inserts_done) {
                 store, background_inserts_done));
 }
 
+// With `as_get_all` the value is looked up like `getAll` does, which consults the
+// index's bloom filter.
 ql::grouped_t<ql::stream_t> read_row_via_sindex(
         store_t *store,
         const sindex_name_t &sindex_name,
-        int sindex_value) {
+        int sindex_value,
+        bool as_get_all = false) {
     cond_t dummy_interruptor;
     read_token_t token;
     store->new_read_token(&token);
@@ -147,6 +150,10 @@ ql::grouped_t<ql::stream_t> read_row_via_sindex(
 
     rget_read_response_t res;
     ql::datum_range_t datum_range(ql::datum_t(static_cast<double>(sindex_value)));
+    ql::datumspec_t datumspec = as_get_all
+        ? ql::datumspec_t(std::map<ql::datum_t, uint64_t>{
+              {ql::datum_t(static_cast<double>(sindex_value)), 1}})
+        : ql::datumspec_t(datum_range);
     /* The only thing this does is have a NULL `profile::trace_t *` in it which
      * prevents to profiling code from crashing. */
     ql::env_t dummy_env(&dummy_interruptor,
@@ -156,7 +163,7 @@ ql::grouped_t<ql::stream_t> read_row_via_sindex(
     rdb_rget_secondary_slice(
         store->get_sindex_slice(sindex_uuid),
         region_t(),
-        ql::datumspec_t(datum_range),
+        datumspec,
         datum_range.to_sindex_keyrange(reql_version_t::LATEST),
         sindex_sb.get(),
         &dummy_env, // env_t
@@ -167,6 +174,7 @@ ql::grouped_t<ql::stream_t> read_row_via_sindex(
         sorting_t::ASCENDING,
         require_sindexes_t::NO,
         sindex_info,
+        store->get_sindex_bloom_filter_for_get_all(sindex_uuid, datumspec),
         &res,
         release_superblock_t::RELEASE);
 
@@ -371,6 +379,104 @@ TPTEST(RDBBtree, SindexEraseRange) {
     check_keys_are_NOT_present(&store, sindex_name);
 }
 
+void check_get_all_with_bloom_filter(store_t *store,
+                                     const sindex_name_t &sindex_name) {
+    sindex_bloom_filter_t *filter = store->get_sindex_bloom_filter(
+        store->get_sindexes().at(sindex_name).id);
+    ASSERT_TRUE(filter != nullptr);
+    ASSERT_TRUE(filter->is_ready());
+
+    int ruled_out = 0;
+    for (int i = 0; i < TOTAL_KEYS_TO_INSERT; ++i) {
+        // The filter must never rule out a value that's in the index...
+        ASSERT_EQ(1, read_row_via_sindex(store, sindex_name, i * i, true).size());
+        // ... while values that aren't should mostly get ruled out.
+        if (i > 1) {
+            ASSERT_EQ(0, read_row_via_sindex(store, sindex_name, i * i - 1, true).size());
+            ql::datum_range_t missing(ql::datum_t(static_cast<double>(i * i - 1)));
+            if (filter->definitely_absent(
+                    missing.get_left_bound_trunc_key(reql_version_t::LATEST))) {
+                ++ruled_out;
+            }
+        }
+    }
+    ASSERT_GT(ruled_out, (TOTAL_KEYS_TO_INSERT * 9) / 10);
+}
+
+TPTEST(RDBBtree, SindexBloomFilter) {
+    recreate_temporary_directory(base_path_t("."));
+    temp_file_t temp_file;
+
+    io_backender_t io_backender(file_direct_io_mode_t::buffered_desired);
+    dummy_cache_balancer_t balancer(GIGABYTE);
+
+    filepath_file_opener_t file_opener(temp_file.name(), &io_backender);
+    log_serializer_t::create(
+        &file_opener,
+        log_serializer_t::static_config_t());
+
+    log_serializer_t serializer(
+        log_serializer_t::dynamic_config_t(),
+        &file_opener,
+        &get_global_perfmon_collection());
+
+    scoped_ptr_t<store_t> store(new store_t(
+            region_t::universe(),
+            &serializer,
+            &balancer,
+            "unit_test_store",
+            true,
+            &get_global_perfmon_collection(),
+            nullptr,
+            &io_backender,
+            base_path_t("."),
+            generate_uuid(),
+            update_sindexes_t::UPDATE));
+
+    insert_rows(0, (TOTAL_KEYS_TO_INSERT * 9) / 10, store.get());
+
+    // The new index starts with an empty filter, which gets rebuilt a few times as
+    // post construction and the writes below fill it.
+    sindex_name_t sindex_name = create_sindex(store.get());
+
+    cond_t background_inserts_done;
+    spawn_writes(store.get(), &background_inserts_done);
+    background_inserts_done.wait();
+
+    check_keys_are_present(store.get(), sindex_name);
+    check_get_all_with_bloom_filter(store.get(), sindex_name);
+
+    // After a restart the filter must be rebuilt from the index, but only once a
+    // `getAll` uses it.
+    const namespace_id_t table_id = store->get_table_id();
+    store.reset();
+    store.init(new store_t(
+            region_t::universe(),
+            &serializer,
+            &balancer,
+            "unit_test_store",
+            false,
+            &get_global_perfmon_collection(),
+            nullptr,
+            &io_backender,
+            base_path_t("."),
+            table_id,
+            update_sindexes_t::UPDATE));
+
+    sindex_bloom_filter_t *filter = store->get_sindex_bloom_filter(
+        store->get_sindexes().at(sindex_name).id);
+    ASSERT_TRUE(filter != nullptr);
+    nap(100);
+    ASSERT_FALSE(filter->is_ready());
+    ASSERT_FALSE(filter->is_rebuilding());
+    ASSERT_EQ(1, read_row_via_sindex(store.get(), sindex_name, 0, true).size());
+    for (int i = 0; i < MAX_RETRIES_FOR_SINDEX_POSTCONSTRUCT && !filter->is_ready();
+         ++i) {
+        nap(100);
+    }
+    check_get_all_with_bloom_filter(store.get(), sindex_name);
+}
+
 TPTEST(RDBBtree, SindexInterruptionViaDrop) {
     recreate_temporary_directory(base_path_t("."));
     temp_file_t temp_file;
@@ -0,0 +1,91 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#include <algorithm>
+#include <functional>
+#include <vector>
+
+#include "concurrency/cond_var.hpp"
+#include "rdb_protocol/datum_stream/in_memory_sort.hpp"
+#include "rdb_protocol/env.hpp"
+#include "unittest/gtest.hpp"
+#include "unittest/unittest_utils.hpp"
+
+namespace unittest {
+
+std::vector<ql::datum_t> make_sort_rows(int num_rows, int num_keys) {
+    std::vector<ql::datum_t> rows;
+    for (int i = 0; i < num_rows; ++i) {
+        ql::datum_object_builder_t row;
+        row.overwrite("k", ql::datum_t(static_cast<double>((i * 7919) % num_keys)));
+        row.overwrite("i", ql::datum_t(static_cast<double>(i)));
+        rows.push_back(std::move(row).to_datum());
+    }
+    return rows;
+}
+
+// Compares rows by their `k` field only, so that the sort has to be stable to keep
+// the rows with equal keys in order.
+class key_lt_t {
+public:
+    explicit key_lt_t(size_t *_num_comparisons) : num_comparisons(_num_comparisons) { }
+    bool operator()(ql::env_t *, profile::sampler_t *,
+                    const ql::datum_t &l, const ql::datum_t &r) const {
+        ++*num_comparisons;
+        return l.get_field("k").as_num() < r.get_field("k").as_num();
+    }
+private:
+    size_t *num_comparisons;
+};
+
+std::vector<ql::datum_t> read_sorted(ql::env_t *env,
+                                     const std::vector<ql::datum_t> &rows,
+                                     const std::vector<uint64_t> &batch_sizes,
+                                     size_t *num_comparisons) {
+    counted_t<ql::datum_stream_t> stream =
+        make_counted<ql::in_memory_sort_datum_stream_t>(
+            std::vector<ql::datum_t>(rows), key_lt_t(num_comparisons),
+            ql::backtrace_id_t::empty());
+    std::vector<ql::datum_t> res;
+    for (uint64_t batch_size : batch_sizes) {
+        std::vector<ql::datum_t> batch = stream->next_batch(
+            env, ql::batchspec_t::all().with_at_most(batch_size));
+        res.insert(res.end(), batch.begin(), batch.end());
+    }
+    return res;
+}
+
+TPTEST(RDBInMemorySort, SameAsStableSort) {
+    cond_t interruptor;
+    ql::env_t env(&interruptor,
+                  ql::return_empty_normal_batches_t::NO,
+                  reql_version_t::LATEST);
+    const size_t num_rows = 2000;
+    std::vector<ql::datum_t> rows = make_sort_rows(num_rows, 50);
+    std::vector<ql::datum_t> expected = rows;
+    size_t num_comparisons = 0;
+    std::stable_sort(expected.begin(), expected.end(),
+                     std::bind(key_lt_t(&num_comparisons), nullptr, nullptr,
+                               std::placeholders::_1, std::placeholders::_2));
+
+    // Reading everything at once sorts the rows.
+    ASSERT_EQ(expected, read_sorted(&env, rows, {num_rows}, &num_comparisons));
+
+    // Reading the first few rows only selects them, with about one comparison per
+    // row, and reading more after them sorts the rest.
+    for (uint64_t first : {1, 5, 100}) {
+        num_comparisons = 0;
+        std::vector<ql::datum_t> res =
+            read_sorted(&env, rows, {first}, &num_comparisons);
+        ASSERT_EQ(std::vector<ql::datum_t>(expected.begin(), expected.begin() + first),
+                  res);
+        if (first <= 5) {
+            ASSERT_LT(num_comparisons, 2 * num_rows);
+        }
+        ASSERT_EQ(expected, read_sorted(&env, rows, {first, 7, num_rows},
+                                        &num_comparisons));
+    }
+
+    ASSERT_EQ(std::vector<ql::datum_t>(),
+              read_sorted(&env, std::vector<ql::datum_t>(), {5}, &num_comparisons));
+}
+
+}  // namespace unittest
@@ -0,0 +1,182 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#include <inttypes.h>
+
+#include <functional>
+#include <set>
+#include <string>
+
+#include "client_protocol/json.hpp"
+#include "rdb_protocol/pseudo_time.hpp"
+#include "rdb_protocol/query_cache.hpp"
+#include "rdb_protocol/query_params.hpp"
+#include "rdb_protocol/response.hpp"
+#include "unittest/gtest.hpp"
+#include "unittest/rdb_env.hpp"
+#include "unittest/unittest_utils.hpp"
+
+namespace unittest {
+
+// Runs a query the way `rdb_query_server_t::run_query()` would.
+void run_json_query(ql::query_cache_t *query_cache,
+                    int64_t token,
+                    const std::string &query,
+                    ql::response_t *response_out) {
+    scoped_array_t<char> buffer(query.size() + 1);
+    memcpy(buffer.data(), query.c_str(), query.size() + 1);
+    scoped_ptr_t<ql::query_params_t> query_params =
+        json_protocol_t::parse_query_from_buffer(
+            std::move(buffer), 0, query_cache, token, response_out);
+    ASSERT_TRUE(query_params.has());
+
+    cond_t interruptor;
+    try {
+        switch (query_params->type) {
+        case Query::START: {
+            query_cache->create(query_params.get(), ql::pseudo::time_now(),
+                                &interruptor)->fill_response(response_out);
+        } break;
+        case Query::PREPARE: {
+            int64_t id = query_cache->prepare(query_params.get());
+            response_out->set_type(Response::SUCCESS_ATOM);
+            response_out->set_data(ql::datum_t(static_cast<double>(id)));
+        } break;
+        case Query::EXECUTE: {
+            query_cache->execute(query_params.get(), ql::pseudo::time_now(),
+                                 &interruptor)->fill_response(response_out);
+        } break;
+        case Query::CONTINUE: // fallthru
+        case Query::STOP: // fallthru
+        case Query::NOREPLY_WAIT: // fallthru
+        case Query::SERVER_INFO: // fallthru
+        default: unreachable();
+        }
+    } catch (const ql::bt_exc_t &ex) {
+        response_out->fill_error(ex.response_type, ex.error_type,
+                                 ex.message, ex.bt_datum);
+    }
+}
+
+// A function of one key that gets the row with that key.
+const char *const get_func_json =
+    "[69, [[2, [1]], [16, [[15, [[14, [\"db\"]], \"table\"]], [10, [1]]]]]]";
+
+// A function of one row that inserts it.
+const char *const insert_func_json =
+    "[69, [[2, [1]], [56, [[15, [[14, [\"db\"]], \"table\"]], [10, [1]]]]]]";
+
+int64_t prepare_json_query(ql::query_cache_t *query_cache,
+                           int64_t token,
+                           const std::string &func_json) {
+    ql::response_t response;
+    run_json_query(query_cache, token, "[6, " + func_json + "]", &response);
+    guarantee(response.type() == Response::SUCCESS_ATOM);
+    return response.data()[0].as_int();
+}
+
+scoped_ptr_t<ql::query_cache_t> make_query_cache(
+        test_rdb_env_t::instance_t *env_instance) {
+    return make_scoped<ql::query_cache_t>(
+        env_instance->get_rdb_context(),
+        ip_and_port_t(),
+        ql::return_empty_normal_batches_t::NO,
+        auth::user_context_t(auth::permissions_t(
+            tribool::True, tribool::True, tribool::True, tribool::True)));
+}
+
+void run_prepared_get_test(test_rdb_env_t *test_env) {
+    scoped_ptr_t<test_rdb_env_t::instance_t> env_instance = test_env->make_env();
+    scoped_ptr_t<ql::query_cache_t> query_cache = make_query_cache(env_instance.get());
+
+    const int64_t id = prepare_json_query(query_cache.get(), 1, get_func_json);
+
+    // The same prepared query can be executed with different arguments.
+    for (const char *key : {"a", "b"}) {
+        ql::response_t response;
+        run_json_query(query_cache.get(), 2,
+                       strprintf("[7, [%" PRIi64 ", [\"%s\"]]]", id, key),
+                       &response);
+        ASSERT_EQ(Response::SUCCESS_ATOM, response.type());
+        ASSERT_EQ(1u, response.data().size());
+        ASSERT_EQ(ql::datum_t(key),
+                  response.data()[0].get_field("id", ql::NOTHROW));
+    }
+
+    // A missing row comes back as `null`, like it would for `r.get()`.
+    ql::response_t response;
+    run_json_query(query_cache.get(), 3,
+                   strprintf("[7, [%" PRIi64 ", [\"c\"]]]", id), &response);
+    ASSERT_EQ(Response::SUCCESS_ATOM, response.type());
+    ASSERT_EQ(ql::datum_t::null(), response.data()[0]);
+}
+
+TEST(RDBPreparedQuery, Get) {
+    test_rdb_env_t test_env;
+    test_env.add_database("db");
+    std::set<ql::datum_t, optional_datum_less_t> rows;
+    for (const char *key : {"a", "b"}) {
+        ql::datum_object_builder_t row;
+        row.overwrite("id", ql::datum_t(key));
+        rows.insert(std::move(row).to_datum());
+    }
+    test_env.add_table("db", "table", "id", rows);
+    run_in_thread_pool(std::bind(run_prepared_get_test, &test_env));
+}
+
+void run_prepared_errors_test(test_rdb_env_t *test_env) {
+    scoped_ptr_t<test_rdb_env_t::instance_t> env_instance = test_env->make_env();
+    scoped_ptr_t<ql::query_cache_t> query_cache = make_query_cache(env_instance.get());
+
+    // Only functions can be prepared.
+    ql::response_t response;
+    run_json_query(query_cache.get(), 1, "[6, [24, [1, 2]]]", &response);
+    ASSERT_EQ(Response::COMPILE_ERROR, response.type());
+    ASSERT_FALSE(query_cache->has_prepared_queries());
+
+    response.clear();
+    run_json_query(query_cache.get(), 2, "[7, [12, [\"a\"]]]", &response);
+    ASSERT_EQ(Response::CLIENT_ERROR, response.type());
+
+    const int64_t id = prepare_json_query(query_cache.get(), 3, get_func_json);
+    ASSERT_TRUE(query_cache->has_prepared_queries());
+
+    // The client needs the id of the prepared query, so `noreply` is ignored.
+    const std::string noreply_query =
+        strprintf("[6, %s, {\"noreply\": true}]", get_func_json);
+    scoped_array_t<char> buffer(noreply_query.size() + 1);
+    memcpy(buffer.data(), noreply_query.c_str(), noreply_query.size() + 1);
+    response.clear();
+    scoped_ptr_t<ql::query_params_t> noreply_params =
+        json_protocol_t::parse_query_from_buffer(
+            std::move(buffer), 0, query_cache.get(), 8, &response);
+    ASSERT_TRUE(noreply_params.has());
+    ASSERT_FALSE(noreply_params->noreply);
+
+    response.clear();
+    run_json_query(query_cache.get(), 4,
+                   strprintf("[7, %" PRIi64 "]", id), &response);
+    ASSERT_EQ(Response::CLIENT_ERROR, response.type());
+
+    // A wrong number of arguments is an error when calling the function.
+    response.clear();
+    run_json_query(query_cache.get(), 5,
+                   strprintf("[7, [%" PRIi64 ", [\"a\", \"b\"]]]", id), &response);
+    ASSERT_EQ(Response::RUNTIME_ERROR, response.type());
+
+    // The oldest prepared queries get forgotten.
+    for (int i = 0; i < MAX_PREPARED_QUERIES_PER_CONNECTION; ++i) {
+        prepare_json_query(query_cache.get(), 6, get_func_json);
+    }
+    response.clear();
+    run_json_query(query_cache.get(), 7,
+                   strprintf("[7, [%" PRIi64 ", [\"a\"]]]", id), &response);
+    ASSERT_EQ(Response::CLIENT_ERROR, response.type());
+}
+
+TEST(RDBPreparedQuery, Errors) {
+    test_rdb_env_t test_env;
+    test_env.add_database("db");
+    test_env.add_table("db", "table", "id");
+    run_in_thread_pool(std::bind(run_prepared_errors_test, &test_env));
+}
+
+}  // namespace unittest
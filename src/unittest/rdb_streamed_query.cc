@@ -0,0 +1,170 @@
+// Copyright 2010-2016 RethinkDB, all rights reserved.
+#include <functional>
+#include <string>
+
+#include "client_protocol/json.hpp"
+#include "containers/archive/string_stream.hpp"
+#include "rdb_protocol/env.hpp"
+#include "rdb_protocol/pseudo_time.hpp"
+#include "rdb_protocol/query_cache.hpp"
+#include "rdb_protocol/query_params.hpp"
+#include "rdb_protocol/response.hpp"
+#include "rdb_protocol/term.hpp"
+#include "unittest/gtest.hpp"
+#include "unittest/rdb_env.hpp"
+#include "unittest/unittest_utils.hpp"
+
+namespace unittest {
+
+scoped_ptr_t<ql::query_params_t> parse_buffered_query(ql::query_cache_t *query_cache,
+                                                      int64_t token,
+                                                      const std::string &query,
+                                                      ql::response_t *error_out) {
+    scoped_array_t<char> buffer(query.size() + 1);
+    memcpy(buffer.data(), query.c_str(), query.size() + 1);
+    return json_protocol_t::parse_query_from_buffer(
+        std::move(buffer), 0, query_cache, token, error_out);
+}
+
+scoped_ptr_t<ql::query_params_t> parse_streamed_query(ql::query_cache_t *query_cache,
+                                                      int64_t token,
+                                                      const std::string &query,
+                                                      ql::response_t *error_out) {
+    string_read_stream_t stream(std::string(query), 0);
+    scoped_ptr_t<ql::query_params_t> res = json_protocol_t::parse_query_from_stream(
+        &stream, query.size(), query_cache, token, error_out);
+
+    // The whole query must have been read, even if it couldn't be parsed.
+    char c;
+    guarantee(stream.read(&c, 1) == 0);
+    return res;
+}
+
+typedef std::function<scoped_ptr_t<ql::query_params_t>(
+    ql::query_cache_t *, int64_t, const std::string &, ql::response_t *)> parser_t;
+
+void run_start_query(ql::query_cache_t *query_cache,
+                     int64_t token,
+                     const std::string &query,
+                     const parser_t &parser,
+                     ql::response_t *response_out) {
+    scoped_ptr_t<ql::query_params_t> query_params =
+        parser(query_cache, token, query, response_out);
+    if (!query_params.has()) {
+        return;
+    }
+    ASSERT_EQ(Query::START, query_params->type);
+
+    cond_t interruptor;
+    try {
+        query_cache->create(query_params.get(), ql::pseudo::time_now(),
+                            &interruptor)->fill_response(response_out);
+    } catch (const ql::bt_exc_t &ex) {
+        response_out->fill_error(ex.response_type, ex.error_type,
+                                 ex.message, ex.bt_datum);
+    }
+}
+
+scoped_ptr_t<ql::query_cache_t> make_streamed_query_cache(
+        test_rdb_env_t::instance_t *env_instance) {
+    return make_scoped<ql::query_cache_t>(
+        env_instance->get_rdb_context(),
+        ip_and_port_t(),
+        ql::return_empty_normal_batches_t::NO,
+        auth::user_context_t(auth::permissions_t(
+            tribool::True, tribool::True, tribool::True, tribool::True)));
+}
+
+// A query that inserts `num_rows` documents with ids starting at `first_id`, like a
+// driver would send for `r.db("db").table("table").insert([...])`.
+std::string make_bulk_insert_query(int first_id, int num_rows) {
+    std::string rows;
+    for (int i = first_id; i < first_id + num_rows; ++i) {
+        rows += strprintf("%s{\"id\": %d, \"name\": \"row %d\", \"valid\": true, "
+                          "\"nested\": {\"x\": %d.5, \"y\": null}}",
+                          i == first_id ? "" : ", ", i, i, i);
+    }
+    return "[1, [56, [[15, [[14, [\"db\"]], \"table\"]], [2, [" + rows + "]]]]]";
+}
+
+void run_streamed_equivalence_test(test_rdb_env_t *test_env) {
+    scoped_ptr_t<test_rdb_env_t::instance_t> env_instance = test_env->make_env();
+    scoped_ptr_t<ql::query_cache_t> query_cache =
+        make_streamed_query_cache(env_instance.get());
+
+    const char *const queries[] = {
+        // Literal objects, which get folded into datums.
+        "[1, [2, [{\"a\": 1, \"b\": {\"c\": \"d\", \"e\": [2, [1, 2]]}}, {}]]]",
+        // Objects with terms and pseudotypes in them.
+        "[1, {\"a\": [24, [1, 2]], \"b\": {\"c\": [24, [\"x\", \"y\"]]}, \"d\": 3}]",
+        "[1, {\"t\": {\"$reql_type$\": \"TIME\", \"epoch_time\": 0, "
+            "\"timezone\": \"+00:00\"}}]",
+        "[1, {\"t\": {\"$reql_type$\": \"NOT_A_TYPE\"}}]",
+        // Scalars and `DATUM` terms.
+        "[1, \"a string\"]",
+        "[1, [1, {\"a\": [1, 2]}]]",
+        "[1, [24, [1, [1, 2]]], {\"db\": [14, [\"db\"]]}]",
+        // Errors in the term, which need the same backtraces.
+        "[1, [2, [1, {\"a\": 1, \"a\": 2}]]]",
+        "[1, [24, [1, [999, []]]]]",
+        "[1, [24, [1, [24, [1, 2], {}, {}]]]]",
+        "[1, [24, [1, [24, {}, {}]]]]",
+        "[1, [24, [1, [24, 5]]]]",
+        "[1, [24, [1, [\"ADD\", [1, 2]]]]]",
+        "[1, [2, [[73, [\"a\"]]]]]",
+        "[1, [2, [[]]]]",
+        "[1, [2, [\"\xff\"]]]",
+        // Errors in the global optargs.
+        "[1, 1, {\"db\": [999, []]}]",
+        "[1, 1, {\"not_an_optarg\": 1}]",
+        // Errors in the query itself.
+        "{\"a\": 1}",
+        "[]",
+        "[1, 1, 2, 3]",
+        "[\"START\", 1]",
+        "[99, 1]",
+        "[1, 1, 2]",
+        "[1, [24, [1, 2]]",
+        "[1, 1] garbage",
+    };
+
+    int64_t token = 0;
+    for (const char *query : queries) {
+        ql::response_t buffered, streamed;
+        run_start_query(query_cache.get(), ++token, query,
+                        parse_buffered_query, &buffered);
+        run_start_query(query_cache.get(), ++token, query,
+                        parse_streamed_query, &streamed);
+        SCOPED_TRACE(query);
+        ASSERT_EQ(buffered.type(), streamed.type());
+        ASSERT_EQ(buffered.error_type(), streamed.error_type());
+        ASSERT_EQ(buffered.data(), streamed.data());
+        ASSERT_EQ(buffered.backtrace(), streamed.backtrace());
+    }
+
+    // Static optargs are read from the streamed query too.
+    ql::response_t error;
+    scoped_ptr_t<ql::query_params_t> query_params = parse_streamed_query(
+        query_cache.get(), ++token, "[1, 1, {\"noreply\": true, \"profile\": [1, true]}]",
+        &error);
+    ASSERT_TRUE(query_params.has());
+    ASSERT_TRUE(query_params->noreply);
+    ASSERT_TRUE(query_params->profile);
+
+    // And writes work.
+    ql::response_t response;
+    run_start_query(query_cache.get(), ++token, make_bulk_insert_query(0, 100),
+                    parse_streamed_query, &response);
+    ASSERT_EQ(Response::SUCCESS_ATOM, response.type());
+    ASSERT_EQ(ql::datum_t(100.0),
+              response.data()[0].get_field("inserted", ql::NOTHROW));
+}
+
+TEST(RDBStreamedQuery, SameAsBuffered) {
+    test_rdb_env_t test_env;
+    test_env.add_database("db");
+    test_env.add_table("db", "table", "id");
+    run_in_thread_pool(std::bind(run_streamed_equivalence_test, &test_env));
+}
+
+}  // namespace unittest
@@ -1,5 +1,6 @@
 // Copyright 2010-2014 RethinkDB, all rights reserved.
 #include <functional>
+#include <vector>
 
 #ifdef _WIN32
 #include "windows.hpp"
@@ -9,6 +10,7 @@
 
 #include "arch/runtime/thread_pool.hpp"
 #include "arch/timing.hpp"
+#include "concurrency/pmap.hpp"
 #include "containers/scoped.hpp"
 #include "containers/archive/socket_stream.hpp"
 #include "unittest/clustering_utils.hpp"
@@ -452,6 +454,179 @@ TPTEST_MULTITHREAD(RPCConnectivityTest, BinaryData, 3) {
     EXPECT_TRUE(a2.got_spectrum);
 }
 
+/* `LargeMessages` sends messages that are small enough to be copied into the
+connection's write buffer and messages that are handed to it as they are, and makes
+sure that they all arrive intact. */
+
+class bulk_test_application_t :
+    public home_thread_mixin_t,
+    public cluster_message_handler_t {
+public:
+    explicit bulk_test_application_t(connectivity_cluster_t *cm) :
+        cluster_message_handler_t(cm, 'L'),
+        messages_received(0),
+        bytes_received(0),
+        corrupt_messages(0)
+        { }
+    void send(const std::vector<char> &payload, peer_id_t peer) {
+        class writer_t : public cluster_send_message_write_callback_t {
+        public:
+            explicit writer_t(const std::vector<char> *_payload) : payload(_payload) { }
+            virtual ~writer_t() { }
+            void write(write_stream_t *stream) {
+                write_message_t wm;
+                serialize<cluster_version_t::CLUSTER>(
+                    &wm, static_cast<uint64_t>(payload->size()));
+                int res = send_write_message(stream, &wm);
+                if (res) { throw fake_archive_exc_t(); }
+                int64_t written = stream->write(payload->data(), payload->size());
+                if (written != static_cast<int64_t>(payload->size())) {
+                    throw fake_archive_exc_t();
+                }
+            }
+#ifdef ENABLE_MESSAGE_PROFILER
+            const char *message_profiler_tag() const {
+                return "unittest";
+            }
+#endif
+            const std::vector<char> *payload;
+        } writer(&payload);
+        auto_drainer_t::lock_t connection_keepalive;
+        connectivity_cluster_t::connection_t *connection =
+            get_connectivity_cluster()->get_connection(peer, &connection_keepalive);
+        ASSERT_TRUE(connection != nullptr);
+        get_connectivity_cluster()->send_message(connection, connection_keepalive,
+                                                 get_message_tag(), &writer);
+    }
+    void wait_for_messages(int64_t count) {
+        assert_thread();
+        while (messages_received < count) {
+            nap(1);
+        }
+    }
+    int64_t messages_received;
+    int64_t bytes_received;
+    int64_t corrupt_messages;
+
+private:
+    void on_message(connectivity_cluster_t::connection_t *,
+                    auto_drainer_t::lock_t,
+                    read_stream_t *stream) {
+        uint64_t size;
+        archive_result_t res = deserialize<cluster_version_t::CLUSTER>(stream, &size);
+        if (bad(res)) { throw fake_archive_exc_t(); }
+        std::vector<char> payload(size);
+        int64_t read = force_read(stream, payload.data(), size);
+        if (read != static_cast<int64_t>(size)) { throw fake_archive_exc_t(); }
+        bool corrupt = false;
+        for (size_t i = 0; i < payload.size(); ++i) {
+            if (payload[i] != static_cast<char>(i * 7)) {
+                corrupt = true;
+                break;
+            }
+        }
+        on_thread_t th(home_thread());
+        ++messages_received;
+        bytes_received += size;
+        if (corrupt) {
+            ++corrupt_messages;
+        }
+    }
+};
+
+std::vector<char> make_bulk_payload(size_t size) {
+    std::vector<char> payload(size);
+    for (size_t i = 0; i < size; ++i) {
+        payload[i] = static_cast<char>(i * 7);
+    }
+    return payload;
+}
+
+TPTEST_MULTITHREAD(RPCConnectivityTest, LargeMessages, 3) {
+    connectivity_cluster_t c1, c2;
+    bulk_test_application_t a1(&c1), a2(&c2);
+    test_cluster_run_t cr1(&c1);
+    test_cluster_run_t cr2(&c2);
+    cr1.join(get_cluster_local_address(&c2), 0);
+
+    let_stuff_happen();
+
+    const std::vector<size_t> sizes = {0, 1, 1000, 8191, 8192, 100000, 3000000};
+    int64_t expected_bytes = 0;
+    for (int round = 0; round < 3; ++round) {
+        for (size_t size : sizes) {
+            a1.send(make_bulk_payload(size), c2.get_me());
+            expected_bytes += size;
+        }
+    }
+    a2.wait_for_messages(3 * sizes.size());
+
+    EXPECT_EQ(static_cast<int64_t>(3 * sizes.size()), a2.messages_received);
+    EXPECT_EQ(expected_bytes, a2.bytes_received);
+    EXPECT_EQ(0, a2.corrupt_messages);
+}
+
+int64_t get_connectivity_stat(connectivity_cluster_t *c, const char *name) {
+    perfmon_collection_t *collection = c->get_connectivity_collection();
+    void *ctx = collection->begin_stats();
+    pmap(get_num_threads(), [&](int i) {
+        on_thread_t thread_switcher((threadnum_t(i)));
+        collection->visit_stats(ctx);
+    });
+    ql::datum_t stats = collection->end_stats(ctx);
+    return stats.get_field(name).as_int();
+}
+
+/* `CompressedMessages` makes sure that messages between servers that both compress
+arrive intact, that small messages and messages to servers that don't compress are
+sent as they are, and that the compression counters add up. */
+TPTEST_MULTITHREAD(RPCConnectivityTest, CompressedMessages, 3) {
+    connectivity_cluster_t c1, c2, c3;
+    bulk_test_application_t a1(&c1), a2(&c2), a3(&c3);
+    test_cluster_run_t cr1(&c1, peer_address_t(), cluster_compression_t::ADAPTIVE);
+    test_cluster_run_t cr2(&c2, peer_address_t(), cluster_compression_t::FAST);
+    test_cluster_run_t cr3(&c3);
+    cr1.join(get_cluster_local_address(&c2), 0);
+    cr1.join(get_cluster_local_address(&c3), 0);
+
+    let_stuff_happen();
+
+    // The payloads repeat every 256 bytes, so they compress well.
+    const std::vector<size_t> sizes = {0, 100, 1000, 10000, 100000, 3000000};
+    int64_t total_bytes = 0;
+    for (size_t size : sizes) {
+        a1.send(make_bulk_payload(size), c2.get_me());
+        a2.send(make_bulk_payload(size), c1.get_me());
+        a1.send(make_bulk_payload(size), c3.get_me());
+        a3.send(make_bulk_payload(size), c1.get_me());
+        total_bytes += size;
+    }
+    a1.wait_for_messages(2 * sizes.size());
+    a2.wait_for_messages(sizes.size());
+    a3.wait_for_messages(sizes.size());
+
+    EXPECT_EQ(2 * total_bytes, a1.bytes_received);
+    EXPECT_EQ(total_bytes, a2.bytes_received);
+    EXPECT_EQ(total_bytes, a3.bytes_received);
+    EXPECT_EQ(0, a1.corrupt_messages);
+    EXPECT_EQ(0, a2.corrupt_messages);
+    EXPECT_EQ(0, a3.corrupt_messages);
+
+    // Only the messages of at least a kilobyte between `c1` and `c2` get compressed.
+    // Each message starts with the eight byte size of its payload.
+    const int64_t compressed_message_bytes = 10008 + 100008 + 3000008;
+    const int64_t c1_sent = get_connectivity_stat(&c1, "uncompressed_bytes_sent");
+    EXPECT_EQ(compressed_message_bytes, c1_sent);
+    EXPECT_EQ(c1_sent, get_connectivity_stat(&c2, "uncompressed_bytes_received"));
+    EXPECT_EQ(get_connectivity_stat(&c1, "compressed_bytes_sent"),
+              get_connectivity_stat(&c2, "compressed_bytes_received"));
+    EXPECT_GT(c1_sent / 10, get_connectivity_stat(&c1, "compressed_bytes_sent"));
+    EXPECT_EQ(get_connectivity_stat(&c2, "uncompressed_bytes_sent"),
+              get_connectivity_stat(&c1, "uncompressed_bytes_received"));
+    EXPECT_EQ(0, get_connectivity_stat(&c3, "uncompressed_bytes_sent"));
+    EXPECT_EQ(0, get_connectivity_stat(&c3, "uncompressed_bytes_received"));
+}
+
 /* `PeerIDSemantics` makes sure that `peer_id_t::is_nil()` works as expected. */
 TPTEST_MULTITHREAD(RPCConnectivityTest, PeerIDSemantics, 3) {
     peer_id_t nil_peer;
@@ -1,7 +1,11 @@
 #include <functional>
 
 #include "arch/runtime/starter.hpp"
+#include "arch/timing.hpp"
 #include "concurrency/new_mutex.hpp"
+#include "concurrency/wait_any.hpp"
+#include "perfmon/perfmon.hpp"
+#include "rdb_protocol/datum.hpp"
 #include "serializer/buf_ptr.hpp"
 #include "serializer/log/log_serializer.hpp"
 #include "unittest/mock_file.hpp"
@@ -21,10 +25,12 @@ TPTEST(SerializerTest, CreateConstructDestroy, 4) {
                               &get_global_perfmon_collection());
 }
 
-void run_AddDeleteRepeatedly(bool perform_index_write) {
+void run_AddDeleteRepeatedly(bool perform_index_write, block_codec_t codec) {
     mock_file_opener_t file_opener;
     log_serializer_t::create(&file_opener, log_serializer_t::static_config_t());
-    log_serializer_t ser(log_serializer_t::dynamic_config_t(),
+    log_serializer_t::dynamic_config_t dynamic_config;
+    dynamic_config.block_codec = codec;
+    log_serializer_t ser(dynamic_config,
                               &file_opener,
                               &get_global_perfmon_collection());
 
@@ -82,12 +88,257 @@ void run_AddDeleteRepeatedly(bool perform_index_write) {
 }
 
 TEST(SerializerTest, AddDeleteRepeatedly) {
-    run_in_thread_pool(std::bind(run_AddDeleteRepeatedly, false), 4);
+    ::unittest::run_in_thread_pool(std::bind(run_AddDeleteRepeatedly, false,
+                                             block_codec_t::none), 4);
 }
 
 // This is a regression test for #1691.
 TEST(SerializerTest, AddDeleteRepeatedlyWithIndex) {
-    run_in_thread_pool(std::bind(run_AddDeleteRepeatedly, true), 4);
+    ::unittest::run_in_thread_pool(std::bind(run_AddDeleteRepeatedly, true,
+                                             block_codec_t::none), 4);
+}
+
+// The same, but the GC has to move compressed blocks around.
+TEST(SerializerTest, AddDeleteRepeatedlyCompressed) {
+    ::unittest::run_in_thread_pool(std::bind(run_AddDeleteRepeatedly, true,
+                                             block_codec_t::zlib), 4);
+}
+
+struct write_cond_t : public iocallback_t, public cond_t {
+    void on_io_complete() {
+        pulse();
+    }
+};
+
+// Fills a block with data that compresses about as well as a leaf node full of JSON
+// documents would, or with random data if `compressible` is false.
+void fill_block(const buf_ptr_t &buf, block_id_t block_id, bool compressible) {
+    char *data = static_cast<char *>(buf.cache_data());
+    const size_t size = buf.block_size().value();
+    std::string chunk;
+    while (chunk.size() < size) {
+        chunk += compressible
+            ? strprintf("{\"id\":%" PRIu64 ",\"name\":\"%s\",\"count\":%zu}",
+                        block_id, rand_string(8).c_str(), chunk.size())
+            : rand_string(64);
+    }
+    memcpy(data, chunk.data(), size);
+}
+
+// Writes the blocks with ids [0, bufs.size()) and puts them in the index.
+void write_blocks(log_serializer_t *ser, file_account_t *account,
+                  const std::vector<buf_ptr_t> &bufs) {
+    std::vector<buf_write_info_t> infos;
+    for (size_t i = 0; i < bufs.size(); ++i) {
+        infos.push_back(buf_write_info_t(bufs[i].ser_buffer(), bufs[i].block_size(), i));
+    }
+    write_cond_t cb;
+    std::vector<counted_t<block_token_t>> tokens
+        = ser->block_writes(infos, account, &cb);
+    cb.wait();
+
+    std::vector<index_write_op_t> write_ops;
+    for (size_t i = 0; i < tokens.size(); ++i) {
+        write_ops.push_back(index_write_op_t(i, make_optional(tokens[i]),
+            make_optional(repli_timestamp_t::distant_past)));
+    }
+    new_mutex_in_line_t dummy_acq;
+    ser->index_write(&dummy_acq, []{ }, write_ops);
+}
+
+void check_blocks(log_serializer_t *ser, file_account_t *account,
+                  const std::vector<buf_ptr_t> &bufs) {
+    for (size_t i = 0; i < bufs.size(); ++i) {
+        counted_t<block_token_t> token = ser->index_read(i);
+        ASSERT_TRUE(token.has());
+        ASSERT_EQ(bufs[i].block_size(), token->block_size());
+        buf_ptr_t buf = ser->block_read(token, account);
+        ASSERT_EQ(bufs[i].block_size(), buf.block_size());
+        ASSERT_EQ(0, memcmp(bufs[i].ser_buffer(), buf.ser_buffer(),
+                            buf.block_size().ser_value()));
+    }
+}
+
+/* Writes a mix of compressible and incompressible blocks with compression enabled,
+and reads them back, both before and after restarting the serializer without
+compression. */
+TPTEST(SerializerTest, CompressedRoundTrip) {
+    mock_file_opener_t file_opener;
+    log_serializer_t::create(&file_opener, log_serializer_t::static_config_t());
+
+    std::vector<buf_ptr_t> bufs;
+    for (block_id_t i = 0; i < 200; ++i) {
+        bufs.push_back(buf_ptr_t::alloc_zeroed(
+            log_serializer_t::static_config_t().max_block_size()));
+        fill_block(bufs.back(), i, i % 10 != 0);
+    }
+
+    {
+        log_serializer_t::dynamic_config_t dynamic_config;
+        dynamic_config.block_codec = block_codec_t::zlib;
+        log_serializer_t ser(dynamic_config, &file_opener,
+                             &get_global_perfmon_collection());
+        scoped_ptr_t<file_account_t> account(ser.make_io_account(1));
+        write_blocks(&ser, account.get(), bufs);
+        check_blocks(&ser, account.get(), bufs);
+    }
+
+    {
+        log_serializer_t ser(log_serializer_t::dynamic_config_t(), &file_opener,
+                             &get_global_perfmon_collection());
+        scoped_ptr_t<file_account_t> account(ser.make_io_account(1));
+        check_blocks(&ser, account.get(), bufs);
+    }
+}
+
+struct scrub_corruption_cond_t : public log_serializer_scrub_callback_t, public cond_t {
+    void on_corrupt_block(block_id_t block_id, UNUSED int64_t offset) {
+        corrupt_block_ids.push_back(block_id);
+        if (!is_pulsed()) {
+            pulse();
+        }
+    }
+    std::vector<block_id_t> corrupt_block_ids;
+};
+
+/* Damages one block on disk, and verifies that its checksum no longer matches and
+that the scrubber finds it. */
+TPTEST(SerializerTest, ScrubFindsCorruption) {
+    mock_file_opener_t file_opener;
+    log_serializer_t::create(&file_opener, log_serializer_t::static_config_t());
+
+    std::vector<buf_ptr_t> bufs;
+    for (block_id_t i = 0; i < 50; ++i) {
+        bufs.push_back(buf_ptr_t::alloc_zeroed(
+            log_serializer_t::static_config_t().max_block_size()));
+        fill_block(bufs.back(), i, false);
+    }
+
+    const block_id_t damaged_block_id = 7;
+    int64_t damaged_offset;
+    {
+        log_serializer_t ser(log_serializer_t::dynamic_config_t(), &file_opener,
+                             &get_global_perfmon_collection());
+        scoped_ptr_t<file_account_t> account(ser.make_io_account(1));
+        write_blocks(&ser, account.get(), bufs);
+        damaged_offset = ser.index_read(damaged_block_id)->offset();
+    }
+
+    (*file_opener.file_data())[damaged_offset + 100] ^= 0x40;
+
+    log_serializer_t::dynamic_config_t dynamic_config;
+    dynamic_config.scrub_bytes_per_sec = 100 * MEGABYTE;
+    scrub_corruption_cond_t found_corruption;
+    log_serializer_t ser(dynamic_config, &file_opener,
+                         &get_global_perfmon_collection(), &found_corruption);
+    scoped_ptr_t<file_account_t> account(ser.make_io_account(1));
+    for (block_id_t i = 0; i < bufs.size(); ++i) {
+        counted_t<block_token_t> token = ser.index_read(i);
+        buf_ptr_t buf = ser.block_read(token, account.get());
+        ASSERT_EQ(i != damaged_block_id,
+                  block_checksum_matches(token->checksum(), buf.ser_buffer(),
+                                         buf.block_size()));
+    }
+
+    signal_timer_t timeout;
+    timeout.start(10000);
+    wait_any_t waiter(&found_corruption, &timeout);
+    waiter.wait();
+    ASSERT_TRUE(found_corruption.is_pulsed());
+    ASSERT_EQ(std::vector<block_id_t>{damaged_block_id},
+              found_corruption.corrupt_block_ids);
+}
+
+/* Reports the same damaged block twice, like the cache does when it reads the block
+again, and verifies that the callback only hears about it once. */
+TPTEST(SerializerTest, ReportCorruptBlockOnce) {
+    mock_file_opener_t file_opener;
+    log_serializer_t::create(&file_opener, log_serializer_t::static_config_t());
+
+    std::vector<buf_ptr_t> bufs;
+    for (block_id_t i = 0; i < 5; ++i) {
+        bufs.push_back(buf_ptr_t::alloc_zeroed(
+            log_serializer_t::static_config_t().max_block_size()));
+        fill_block(bufs.back(), i, false);
+    }
+
+    scrub_corruption_cond_t found_corruption;
+    log_serializer_t ser(log_serializer_t::dynamic_config_t(), &file_opener,
+                         &get_global_perfmon_collection(), &found_corruption);
+    scoped_ptr_t<file_account_t> account(ser.make_io_account(1));
+    write_blocks(&ser, account.get(), bufs);
+
+    counted_t<block_token_t> token = ser.index_read(3);
+    ser.report_corrupt_block(3, token);
+    ser.report_corrupt_block(3, token);
+    ASSERT_EQ(std::vector<block_id_t>{3}, found_corruption.corrupt_block_ids);
+}
+
+// Sets the recency of the blocks with ids [0, num_blocks) to `round`, `num_rounds`
+// times over, which leaves `num_rounds` LBA entries for every block.  The blocks don't
+// need to exist for that.
+void write_recencies(log_serializer_t *ser, block_id_t num_blocks, int num_rounds) {
+    const block_id_t batch_size = 10000;
+    for (int round = 1; round <= num_rounds; ++round) {
+        for (block_id_t start = 0; start < num_blocks; start += batch_size) {
+            std::vector<index_write_op_t> write_ops;
+            for (block_id_t i = start; i < std::min(start + batch_size, num_blocks); ++i) {
+                write_ops.push_back(index_write_op_t(i, r_nullopt,
+                    make_optional(repli_timestamp_t{static_cast<uint64_t>(round)})));
+            }
+            new_mutex_in_line_t dummy_acq;
+            ser->index_write(&dummy_acq, []{ }, write_ops);
+        }
+    }
+}
+
+void check_recencies(log_serializer_t *ser, block_id_t num_blocks, int round) {
+    segmented_vector_t<repli_timestamp_t> recencies = ser->get_all_recencies(0, 1);
+    ASSERT_EQ(num_blocks, recencies.size());
+    for (block_id_t i = 0; i < num_blocks; ++i) {
+        ASSERT_EQ(static_cast<uint64_t>(round), recencies[i].longtime);
+    }
+}
+
+int64_t get_stat(perfmon_collection_t *collection, const char *name) {
+    void *ctx = collection->begin_stats();
+    collection->visit_stats(ctx);
+    ql::datum_t stats = collection->end_stats(ctx);
+    return stats.get_field("serializer").get_field(name).as_int();
+}
+
+/* Writes enough LBA entries that every LBA shard has a full extent with plenty of
+garbage (but not enough for the regular LBA GC), then restarts the serializer after
+compacting the LBA on shutdown, which should leave it with fewer LBA extents. */
+TPTEST(SerializerTest, LbaCompactionOnShutdown, 4) {
+    // 40000 live entries per shard, with two entries each.
+    const block_id_t num_blocks = 4 * 40000;
+    mock_file_opener_t file_opener;
+    log_serializer_t::create(&file_opener, log_serializer_t::static_config_t());
+
+    {
+        log_serializer_t ser(log_serializer_t::dynamic_config_t(), &file_opener,
+                             &get_global_perfmon_collection());
+        write_recencies(&ser, num_blocks, 2);
+    }
+
+    int64_t lba_extents_before;
+    {
+        perfmon_collection_t stats;
+        log_serializer_t::dynamic_config_t dynamic_config;
+        dynamic_config.compact_lba_on_shutdown = true;
+        log_serializer_t ser(dynamic_config, &file_opener, &stats);
+        check_recencies(&ser, num_blocks, 2);
+        lba_extents_before = get_stat(&stats, "serializer_lba_extents");
+    }
+
+    for (int i = 0; i < 2; ++i) {
+        perfmon_collection_t stats;
+        log_serializer_t ser(log_serializer_t::dynamic_config_t(), &file_opener,
+                             &stats);
+        check_recencies(&ser, num_blocks, 2);
+        ASSERT_LT(get_stat(&stats, "serializer_lba_extents"), lba_extents_before);
+    }
 }
 
 
@@ -51,7 +51,8 @@ struct make_sindex_read_t {
                                                  r_nullopt,
                                                  ql::datumspec_t(rng),
                                                  require_sindexes_t::NO)),
-                sorting_t::UNORDERED),
+                sorting_t::UNORDERED,
+                false /* is_scan */),
             profile_bool_t::PROFILE,
             read_mode_t::SINGLE);
     }
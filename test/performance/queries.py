@@ -78,6 +78,10 @@ table_queries = [
         "query": "r.db('test').table(table['name']).eq_join('id', r.db('test').table(table['name'])).zip()",
         "tag": "eq_join_zip"
     },
+    {
+        "query": "r.db('test').table(table['name']).limit(10000).eq_join('field1', r.db('test').table(table['name']), index='field1')",
+        "tag": "eq_join_sindex_10000"
+    },
     {
         "query": "r.db('test').table(table['name']).map(r.row['id'])",
         "tag": "map_id"
@@ -18,7 +18,8 @@ import driver, utils
 
 r = utils.import_python_driver()
 
-# We define 4 tables (small/normal cache with small/big documents
+# We define 6 tables (small/normal cache with small/big documents, and small documents
+# in a table with three shards)
 servers_settings = [
     {
         "cache_size": 1024,
@@ -40,6 +41,12 @@ tables = [
         "name": "bigdoc",
         "size_doc": "big",
         "ids": []
+    },
+    {
+        "name": "smalldoc_sharded",
+        "size_doc": "small",
+        "ids": [],
+        "shards": 3
     }
 ]
 
@@ -105,7 +112,7 @@ def init_tables(connection):
     r.db_create("test").run(connection)
 
     for table in tables:
-        r.db("test").table_create(table["name"]).run(connection)
+        r.db("test").table_create(table["name"], shards=table.get("shards", 1)).run(connection)
 
     for table in tables:
         r.db("test").table(table["name"]).index_create("field0").run(connection)